@@ -0,0 +1,264 @@
+/**
+ * @file overhead.c
+ * @brief Measures what CLarity itself costs per test: registration, dispatch, fixtures and printing.
+ *
+ * The results are written to standard output, or to the file given with `--output=PATH`, as a
+ * `# CLarity bench v1` header followed by one line per measurement: the benchmark, its parameter, the number of
+ * operations timed and the best time per operation in nanoseconds, separated by tabulations. The output of the
+ * runner itself goes to /dev/null or to a pipe while it is measured.
+ */
+#include <CLarity/clarity.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "printer.h"
+
+#define BENCH_HEADER "# CLarity bench v1\n"
+#define BENCH_DEFAULT_MAX_TESTS 1000000u
+#define BENCH_LIMIT_MAX_TESTS 10000000u
+#define BENCH_DISPATCH_TESTS 100000u
+#define BENCH_FIXTURES 8u
+#define BENCH_PRINTED_RESULTS 200000u
+#define BENCH_REPEATS 5
+
+static FILE *results;
+
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+
+static void report(const char *benchmark, const char *parameter, uint64_t operations, uint64_t best_ns) {
+	fprintf(results, "%s\t%s\t%llu\t%.2f\n", benchmark, parameter, (unsigned long long) operations,
+	        (double) best_ns / (double) operations);
+	fflush(results);
+}
+
+
+static void empty_test(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+}
+
+
+static int empty_fixture(void *data) {
+	(void) data;
+	return 0;
+}
+
+
+/**
+ * Where the output of the runner goes while it is measured: standard output is redirected to it.
+ */
+typedef struct sink_s {
+	int       saved_stdout;
+	int       pipe_fds[2];
+	pthread_t reader;
+} sink_t;
+
+
+static void *drain(void *data) {
+	sink_t *sink = data;
+	char   buffer[65536];
+	while (read(sink->pipe_fds[0], buffer, sizeof buffer) > 0)
+		;
+	return NULL;
+}
+
+
+static bool sink_open(sink_t *sink, bool to_pipe) {
+	int fd;
+	sink->pipe_fds[0] = -1;
+	if (to_pipe) {
+		if (pipe(sink->pipe_fds) < 0)
+			return false;
+		if (pthread_create(&sink->reader, NULL, drain, sink) != 0) {
+			close(sink->pipe_fds[0]);
+			close(sink->pipe_fds[1]);
+			return false;
+		}
+		fd = sink->pipe_fds[1];
+	} else if ((fd = open("/dev/null", O_WRONLY)) < 0) {
+		return false;
+	}
+
+	fflush(stdout);
+	sink->saved_stdout = dup(STDOUT_FILENO);
+	dup2(fd, STDOUT_FILENO);
+	close(fd);
+	return true;
+}
+
+
+static void sink_close(sink_t *sink) {
+	fflush(stdout);
+	dup2(sink->saved_stdout, STDOUT_FILENO);
+	close(sink->saved_stdout);
+	if (sink->pipe_fds[0] >= 0) {
+		pthread_join(sink->reader, NULL);
+		close(sink->pipe_fds[0]);
+	}
+}
+
+
+static clarity_suite_t *create_suite(size_t count, size_t fixtures) {
+	clarity_suite_t *suite = cl_create_suite("Overhead");
+	for (size_t i = 0; suite && i < fixtures; i++)
+		cl_suite_add_fixture(suite, cl_create_fixture(empty_fixture, NULL, empty_fixture, NULL));
+	for (size_t i = 0; suite && i < count; i++)
+		cl_add_test(suite, cl_create_test("empty", empty_test, NULL));
+	return suite;
+}
+
+
+/**
+ * Times `cl_create_test` and `cl_add_test`, for suites of 10^3 tests up to the largest requested.
+ */
+static void bench_registration(size_t max_tests) {
+	for (size_t count = 1000; count <= max_tests; count *= 10) {
+		uint64_t best    = UINT64_MAX;
+		int      repeats = count >= 1000000 ? 1 : BENCH_REPEATS;
+		for (int i = 0; i < repeats; i++) {
+			uint64_t         start   = now_ns();
+			clarity_suite_t *suite   = create_suite(count, 0);
+			uint64_t         elapsed = now_ns() - start;
+			cl_free_suite(suite);
+			if (elapsed < best)
+				best = elapsed;
+		}
+
+		char parameter[32];
+		snprintf(parameter, sizeof parameter, "%zu", count);
+		report("registration", parameter, count, best);
+	}
+}
+
+
+/**
+ * Times `cl_run_suite` over empty tests, each surrounded by a number of empty per-test fixtures. This includes
+ * printing the results to /dev/null, which `printer` measures on its own.
+ *
+ * @return The best time of a run, 0 if it could not be measured.
+ */
+static uint64_t bench_dispatch(size_t fixtures) {
+	uint64_t best = UINT64_MAX;
+	for (int i = 0; i < BENCH_REPEATS; i++) {
+		// A fresh suite every time, the results of a suite accumulate over its runs.
+		clarity_suite_t *suite = create_suite(BENCH_DISPATCH_TESTS, fixtures);
+		sink_t          sink;
+		if (!suite || !sink_open(&sink, false)) {
+			cl_free_suite(suite);
+			return 0;
+		}
+
+		uint64_t start = now_ns();
+		cl_run_suite(suite);
+		fflush(stdout);
+		uint64_t elapsed = now_ns() - start;
+		sink_close(&sink);
+		cl_free_suite(suite);
+		if (elapsed < best)
+			best = elapsed;
+	}
+
+	return best;
+}
+
+
+/**
+ * Times the printing of test results, passing and failing, to /dev/null or to a pipe drained by a thread.
+ */
+static void bench_printer(bool to_pipe) {
+	clarity_test_result_t passed = { .name = "empty", .passed = true };
+	clarity_test_result_t failed = {
+		.name          = "empty",
+		.error_message = "expected 1, got 2",
+		.file_name     = __FILE__,
+		.line_number   = __LINE__,
+	};
+
+	uint64_t best = UINT64_MAX;
+	for (int i = 0; i < BENCH_REPEATS; i++) {
+		sink_t sink;
+		if (!sink_open(&sink, to_pipe))
+			return;
+
+		uint64_t start = now_ns();
+		for (uint32_t j = 0; j < BENCH_PRINTED_RESULTS; j++)
+			cl_print_test_result(j % 16 ? &passed : &failed);
+		fflush(stdout);
+		uint64_t elapsed = now_ns() - start;
+		sink_close(&sink);
+		if (elapsed < best)
+			best = elapsed;
+	}
+	report("printer", to_pipe ? "pipe" : "/dev/null", BENCH_PRINTED_RESULTS, best);
+}
+
+
+static void usage(FILE *stream, const char *program) {
+	fprintf(stream,
+	        "Usage: %s [options]\n"
+	        "\n"
+	        "Options:\n"
+	        "  --max-tests=N  register suites of 10^3 tests up to N tests (default %u, at most %u)\n"
+	        "  --output=PATH  write the results to PATH instead of the standard output\n"
+	        "  --help         print this help\n",
+	        program, BENCH_DEFAULT_MAX_TESTS, BENCH_LIMIT_MAX_TESTS);
+}
+
+
+int main(int argc, char **argv) {
+	size_t     max_tests = BENCH_DEFAULT_MAX_TESTS;
+	const char *output   = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strncmp(argv[i], "--max-tests=", 12)) {
+			char *end;
+			max_tests = strtoull(argv[i] + 12, &end, 10);
+			if (*end || max_tests < 1000 || max_tests > BENCH_LIMIT_MAX_TESTS) {
+				fprintf(stderr, "CLarity: --max-tests expects a number between 1000 and %u\n", BENCH_LIMIT_MAX_TESTS);
+				return 2;
+			}
+		} else if (!strncmp(argv[i], "--output=", 9)) {
+			output = argv[i] + 9;
+		} else if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
+			usage(stdout, argv[0]);
+			return 0;
+		} else {
+			fprintf(stderr, "CLarity: unknown option '%s'\n", argv[i]);
+			usage(stderr, argv[0]);
+			return 2;
+		}
+	}
+
+	// The results must not follow standard output, which is redirected while the runner prints.
+	results = output ? fopen(output, "w") : fdopen(dup(STDOUT_FILENO), "w");
+	if (!results) {
+		fprintf(stderr, "CLarity: could not open '%s'\n", output ? output : "the standard output");
+		return 1;
+	}
+	fputs(BENCH_HEADER, results);
+
+	bench_registration(max_tests);
+	// A fixture costs what it adds to the dispatch of the tests, its setup and teardown counting as one.
+	uint64_t dispatch = bench_dispatch(0);
+	uint64_t fixtures = bench_dispatch(BENCH_FIXTURES);
+	if (dispatch) {
+		report("dispatch", "empty test", BENCH_DISPATCH_TESTS, dispatch);
+		if (fixtures)
+			report("fixture", "setup and teardown", BENCH_DISPATCH_TESTS * BENCH_FIXTURES,
+			       fixtures > dispatch ? fixtures - dispatch : 0);
+	}
+	bench_printer(false);
+	bench_printer(true);
+
+	return fclose(results) ? 1 : 0;
+}
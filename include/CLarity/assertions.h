@@ -0,0 +1,329 @@
+#ifndef CLARITY_INCLUDE_CLARITY_ASSERTIONS_H
+#define CLARITY_INCLUDE_CLARITY_ASSERTIONS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The environment variable capping the instruction set used by the comparison assertions:
+ * `scalar`, `sse2` or `avx2`. By default, they use the best one the processor supports.
+ */
+#define CL_SIMD_ENV "CLARITY_SIMD"
+
+/**
+ * @brief The environment variable overriding the directory of the snapshots.
+ *
+ * Without it, the snapshots of a test file live in a `snapshots` directory next to it.
+ */
+#define CL_SNAPSHOT_DIR_ENV "CLARITY_SNAPSHOT_DIR"
+
+/**
+ * @brief The environment variable which, when set to anything but `0`, makes the snapshot assertions record the
+ * output instead of comparing it.
+ */
+#define CL_UPDATE_SNAPSHOTS_ENV "CLARITY_UPDATE_SNAPSHOTS"
+
+/**
+ * @brief The environment variable multiplying the budgets of `cl_assert_cpu_time_below`, e.g. `1.5` on slower
+ * machines. It must be a positive number, the budgets are used as given otherwise.
+ */
+#define CL_PERF_SLACK_ENV "CLARITY_PERF_SLACK"
+
+/**
+ * @brief The runs of a region discarded before measuring it, to warm up the caches and the branch predictors.
+ */
+#define CL_CPU_TIME_WARMUP_RUNS 2
+
+/**
+ * @brief The most samples of a region measured by `cl_assert_cpu_time_below`.
+ */
+#define CL_CPU_TIME_SAMPLES 15
+
+/**
+ * @brief The fewest samples of a region measured by `cl_assert_cpu_time_below`, however slow it is.
+ */
+#define CL_CPU_TIME_MIN_SAMPLES 5
+
+/**
+ * @brief Type definition for a region of code measured by `cl_assert_cpu_time_below`.
+ *
+ * @param data the data given to the assertion
+ */
+typedef void (*clarity_region_fn_t)(void *data);
+
+/**
+ * @brief How far a floating point element may be from its expected value.
+ *
+ * An element matches if any of the tolerances accepts it. A zero tolerance is disabled, so a zeroed tolerance
+ * only accepts exactly equal elements. Two NaN match each other.
+ */
+typedef struct clarity_float_tolerance_s {
+	double   absolute; /**< The maximum absolute difference. */
+	double   relative; /**< The maximum difference relative to the larger magnitude of the two elements. */
+	uint64_t ulps;     /**< The maximum distance in units in the last place. */
+} clarity_float_tolerance_t;
+
+/**
+ * @brief Internal function behind `cl_assert_mem_eq`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_assert_mem_eq(clarity_test_t *test, const void *actual, const void *expected, size_t size,
+                        const char *file, size_t line);
+
+/**
+ * @brief Internal function behind `cl_assert_float_array_near`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_assert_float_array_near(clarity_test_t *test, const float *actual, const float *expected, size_t count,
+                                  clarity_float_tolerance_t tolerance, const char *file, size_t line);
+
+/**
+ * @brief Internal function behind `cl_assert_double_array_near`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_assert_double_array_near(clarity_test_t *test, const double *actual, const double *expected,
+                                   size_t count, clarity_float_tolerance_t tolerance, const char *file, size_t line);
+
+/**
+ * @brief Internal function behind `cl_assert_snapshot`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_assert_snapshot(clarity_test_t *test, const void *data, size_t size, const char *name, const char *file,
+                          size_t line);
+
+/**
+ * @brief Assert that two buffers hold the same bytes, or fail the test.
+ *
+ * The buffers are compared with the widest SIMD instructions the processor supports, so even large buffers
+ * are compared at memory bandwidth. On failure, the message gives the offset of the first difference, a hex
+ * dump of both buffers around it, and the number of bytes that differ.
+ *
+ * @param test the current test
+ * @param actual the buffer produced by the code under test
+ * @param expected the buffer it must be equal to
+ * @param size the number of bytes to compare
+ *
+ * @return true if the buffers are equal, so that the test can return early otherwise
+ */
+#define cl_assert_mem_eq(test, actual, expected, size) \
+    __cl_assert_mem_eq(test, actual, expected, size, __FILE__, __LINE__)
+
+/**
+ * @brief Assert that two arrays of floats are equal within a tolerance, or fail the test.
+ *
+ * On failure, the message gives the index of the first element out of tolerance, the elements around it,
+ * and the number of elements out of tolerance.
+ *
+ * @param test the current test
+ * @param actual the array produced by the code under test
+ * @param expected the array it must be close to
+ * @param count the number of elements to compare
+ * @param tolerance a `clarity_float_tolerance_t`, e.g. `(clarity_float_tolerance_t){ .ulps = 4 }`
+ *
+ * @return true if every element is within the tolerance, so that the test can return early otherwise
+ */
+#define cl_assert_float_array_near(test, actual, expected, count, tolerance) \
+    __cl_assert_float_array_near(test, actual, expected, count, tolerance, __FILE__, __LINE__)
+
+/**
+ * @brief Assert that two arrays of doubles are equal within a tolerance, or fail the test.
+ *
+ * @see cl_assert_float_array_near
+ */
+#define cl_assert_double_array_near(test, actual, expected, count, tolerance) \
+    __cl_assert_double_array_near(test, actual, expected, count, tolerance, __FILE__, __LINE__)
+
+/**
+ * @brief Assert that an output is identical to its recorded snapshot, or fail the test.
+ *
+ * The snapshot is stored in `<name>.snap`, with its hash and size in the `<name>.snap.hash` sidecar. While the
+ * sidecar is newer than the snapshot, a matching output is accepted on its hash alone, without reading the
+ * snapshot. Otherwise the snapshot is mapped and compared in full, and a failure is reported like
+ * `cl_assert_mem_eq` does.
+ *
+ * With `CLARITY_UPDATE_SNAPSHOTS=1`, differing or missing snapshots are rewritten from the output instead.
+ *
+ * @param test the current test
+ * @param data the output to check
+ * @param size the size of the output, in bytes
+ * @param name the name of the snapshot, which may contain `/` to organise snapshots in directories
+ *
+ * @return true if the output matches the snapshot, or the snapshot has been updated
+ */
+#define cl_assert_snapshot(test, data, size, name) \
+    __cl_assert_snapshot(test, data, size, name, __FILE__, __LINE__)
+
+/**
+ * @brief Internal function behind `cl_assert_cpu_time_below`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_assert_cpu_time_below(clarity_test_t *test, uint64_t budget_ns, clarity_region_fn_t fn, void *data,
+                                const char *file, size_t line);
+
+/**
+ * @brief Assert that a region of code takes less CPU time than a budget, or fail the test.
+ *
+ * @details
+ * The region is run `CL_CPU_TIME_WARMUP_RUNS` times first, then measured up to `CL_CPU_TIME_SAMPLES` times on
+ * the CPU clock of the calling thread, which other tests running in parallel do not disturb. A region too short
+ * for the clock is repeated within every sample. The median of the samples is compared against the budget,
+ * multiplied by `CLARITY_PERF_SLACK` when it is set, and a failure reports the distribution of the samples.
+ *
+ * A slow region is measured at least `CL_CPU_TIME_MIN_SAMPLES` times, but not more once about a quarter of a
+ * second has been measured.
+ *
+ * Example:
+ * ```
+ * cl_assert_cpu_time_below(t, 2000000, decode_frame, frame); // 2 ms
+ * ```
+ *
+ * @param test the current test
+ * @param budget_ns the CPU time a run of the region may take, in nanoseconds
+ * @param fn the region, a `clarity_region_fn_t`
+ * @param data the data to pass down to the region
+ *
+ * @return true if the region is within its budget, so that the test can return early otherwise
+ *
+ * @note The CPU time of the threads the region starts is not counted.
+ */
+#define cl_assert_cpu_time_below(test, budget_ns, fn, data) \
+    __cl_assert_cpu_time_below(test, budget_ns, fn, data, __FILE__, __LINE__)
+
+/**
+ * @brief The number of failed expectations a test keeps, unless told otherwise.
+ */
+#define CL_DEFAULT_MAX_EXPECTATIONS 100
+
+/**
+ * @brief Set the number of failed expectations a test keeps to report.
+ *
+ * The expectations failing once the test keeps that many are only counted, and reported as "+N more".
+ *
+ * @param test the test
+ * @param max the number of failed expectations kept, 0 for `CL_DEFAULT_MAX_EXPECTATIONS`
+ */
+void cl_test_set_max_expectations(clarity_test_t *test, size_t max);
+
+/**
+ * @brief Internal function behind `cl_expect` and `cl_expectf`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_expect(clarity_test_t *test, bool passed, const char *file, size_t line, const char *format, ...)
+	__attribute__((format(printf, 5, 6)));
+
+/**
+ * @brief Internal function behind `cl_expect_int_eq`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_expect_int_eq(clarity_test_t *test, int64_t actual, int64_t expected, const char *actual_text,
+                        const char *expected_text, const char *file, size_t line);
+
+/**
+ * @brief Internal function behind `cl_expect_uint_eq`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_expect_uint_eq(clarity_test_t *test, uint64_t actual, uint64_t expected, const char *actual_text,
+                         const char *expected_text, const char *file, size_t line);
+
+/**
+ * @brief Internal function behind `cl_expect_str_eq`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_expect_str_eq(clarity_test_t *test, const char *actual, const char *expected, const char *actual_text,
+                        const char *expected_text, const char *file, size_t line);
+
+/**
+ * @brief Internal function behind `cl_expect_near`.
+ *
+ * @warning This function must not be used directly.
+ */
+bool __cl_expect_near(clarity_test_t *test, double actual, double expected, double tolerance,
+                      const char *actual_text, const char *expected_text, const char *file, size_t line);
+
+/**
+ * @brief Check a condition without stopping the test, which fails once done if the condition was false.
+ *
+ * @details
+ * Unlike the assertions, the expectations do not overwrite each other: every failed expectation is kept, with
+ * its own message and line, and they are all reported at once when the test completes. A test checking a table
+ * of cases surfaces every broken case in a single run.
+ *
+ * The failed expectations are kept in the scratch memory of the test, up to `cl_test_set_max_expectations`,
+ * and may be recorded from several threads.
+ *
+ * Example:
+ * ```
+ * for (size_t i = 0; i < row_count; i++) {
+ *     cl_expectf(t, parse(rows[i].input) == rows[i].value, "row %zu: '%s'", i, rows[i].input);
+ *     cl_expect_int_eq(t, checksum(rows[i].input), rows[i].checksum);
+ * }
+ * ```
+ *
+ * @param test the current test
+ * @param condition the condition expected to be true
+ *
+ * @return the condition, for the test to skip what depends on it
+ */
+#define cl_expect(test, condition) \
+    __cl_expect(test, (condition), __FILE__, __LINE__, "expected %s", #condition)
+
+/**
+ * @brief Check a condition without stopping the test, with a `printf`-like message describing the failure.
+ *
+ * @see cl_expect
+ */
+#define cl_expectf(test, condition, ...) \
+    __cl_expect(test, (condition), __FILE__, __LINE__, __VA_ARGS__)
+
+/**
+ * @brief Check that two signed integers are equal without stopping the test.
+ *
+ * @see cl_expect
+ */
+#define cl_expect_int_eq(test, actual, expected) \
+    __cl_expect_int_eq(test, (int64_t) (actual), (int64_t) (expected), #actual, #expected, __FILE__, __LINE__)
+
+/**
+ * @brief Check that two unsigned integers are equal without stopping the test.
+ *
+ * @see cl_expect
+ */
+#define cl_expect_uint_eq(test, actual, expected) \
+    __cl_expect_uint_eq(test, (uint64_t) (actual), (uint64_t) (expected), #actual, #expected, __FILE__, __LINE__)
+
+/**
+ * @brief Check that two strings are equal without stopping the test, NULL only being equal to NULL.
+ *
+ * @see cl_expect
+ */
+#define cl_expect_str_eq(test, actual, expected) \
+    __cl_expect_str_eq(test, actual, expected, #actual, #expected, __FILE__, __LINE__)
+
+/**
+ * @brief Check that two numbers are at most a tolerance apart without stopping the test.
+ *
+ * @see cl_expect
+ */
+#define cl_expect_near(test, actual, expected, tolerance) \
+    __cl_expect_near(test, actual, expected, tolerance, #actual, #expected, __FILE__, __LINE__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_ASSERTIONS_H
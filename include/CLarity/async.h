@@ -0,0 +1,176 @@
+#ifndef CLARITY_INCLUDE_CLARITY_ASYNC_H
+#define CLARITY_INCLUDE_CLARITY_ASYNC_H
+
+#include <stdint.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The default time an asynchronous test may take before being failed, in milliseconds.
+ */
+#define CL_DEFAULT_ASYNC_TIMEOUT_MS 5000
+
+/**
+ * @brief The default number of asynchronous tests of a suite in flight at the same time.
+ */
+#define CL_DEFAULT_ASYNC_CONCURRENCY 256
+
+/**
+ * @brief The file descriptor is ready for reading.
+ */
+#define CL_ASYNC_READABLE 0x1u
+
+/**
+ * @brief The file descriptor is ready for writing.
+ */
+#define CL_ASYNC_WRITABLE 0x2u
+
+/**
+ * @brief The file descriptor has been closed by the peer or is in error.
+ *
+ * This event is always reported, it does not need to be requested.
+ */
+#define CL_ASYNC_HANGUP 0x4u
+
+/**
+ * @brief Opaque completion handle of a running asynchronous test.
+ *
+ * The handle is given to the test function and to every callback of the test. It stays valid until
+ * `cl_async_done` has been called, or until the test times out.
+ */
+typedef struct clarity_async_s clarity_async_t;
+
+/**
+ * @brief Type definition for an asynchronous test function.
+ *
+ * @details
+ * An asynchronous test starts its work, registers the file descriptors and timers it waits for, and returns.
+ * The test is running until `cl_async_done` is called, from the test function or from any of its callbacks.
+ * Failures are recorded with `cl_fail_test` and `cl_skip_test`, as usual, before calling `cl_async_done`.
+ *
+ * Example:
+ * ```
+ * void on_reply(clarity_test_t *t, clarity_async_t *async, int fd, uint32_t events, void *data) {
+ *     if (events & CL_ASYNC_HANGUP)
+ *         cl_fail_test(t, "connection closed");
+ *     cl_async_done(async);
+ * }
+ *
+ * void my_async_test(clarity_test_t *t, clarity_async_t *async, void *data) {
+ *     int fd = connect_and_send_request();
+ *     cl_async_watch_fd(async, fd, CL_ASYNC_READABLE, on_reply, NULL);
+ * }
+ * ```
+ *
+ * @param t A pointer to the clarity_test_t struct for the test being executed.
+ * @param async The completion handle of the test.
+ * @param data A pointer to arbitrary data that can be used by the test function.
+ */
+typedef void (*clarity_async_test_fn_t)(clarity_test_t *t, clarity_async_t *async, void *data);
+
+/**
+ * @brief Type definition for the callback of a watched file descriptor.
+ *
+ * @param t The test that registered the watch.
+ * @param async The completion handle of the test.
+ * @param fd The file descriptor that is ready.
+ * @param events The events that occurred, a combination of the `CL_ASYNC_*` flags.
+ * @param data The data given to `cl_async_watch_fd`.
+ */
+typedef void (*clarity_async_io_fn_t)(clarity_test_t *t, clarity_async_t *async, int fd, uint32_t events, void *data);
+
+/**
+ * @brief Type definition for the callback of a timer.
+ *
+ * @param t The test that registered the timer.
+ * @param async The completion handle of the test.
+ * @param data The data given to `cl_async_set_timer`.
+ */
+typedef void (*clarity_async_timer_fn_t)(clarity_test_t *t, clarity_async_t *async, void *data);
+
+/**
+ * @brief Create a new asynchronous test case.
+ *
+ * @details
+ * Asynchronous tests of a suite are driven by an event loop inside `cl_run_suite`: many of them can be in
+ * flight at once on a single thread, each one waiting for its file descriptors and timers. A test still
+ * running after `timeout_ms` milliseconds is failed. The per-test fixtures of the suite are run when the
+ * test starts and when it completes, so the fixtures of concurrent asynchronous tests interleave.
+ *
+ * @param name the name of the test case
+ * @param fn the function starting the test
+ * @param data the data to associate with the test case
+ * @param timeout_ms the time the test may take, in milliseconds, or 0 for `CL_DEFAULT_ASYNC_TIMEOUT_MS`
+ *
+ * @return a pointer to the new test case, or NULL if the allocation failed
+ *
+ * @see cl_suite_set_async_concurrency
+ */
+clarity_test_t *cl_create_async_test(const char *name, clarity_async_test_fn_t fn, void *data, uint32_t timeout_ms);
+
+/**
+ * @brief Wait for events on a file descriptor.
+ *
+ * @param async the completion handle of the test
+ * @param fd the file descriptor to watch, it must not already be watched by the test
+ * @param events the events to wait for, a combination of `CL_ASYNC_READABLE` and `CL_ASYNC_WRITABLE`
+ * @param fn the callback to call every time the file descriptor is ready
+ * @param data the data to pass down to the callback
+ *
+ * @return CL_SUCCESS, CL_ERROR_MEMORY, or CL_ERROR_IO if the file descriptor cannot be watched
+ *
+ * @note The watch stays active until `cl_async_unwatch_fd` is called or the test completes.
+ */
+clarity_status_t cl_async_watch_fd(clarity_async_t *async, int fd, uint32_t events, clarity_async_io_fn_t fn,
+                                   void *data);
+
+/**
+ * @brief Stop waiting for events on a file descriptor.
+ *
+ * @param async the completion handle of the test
+ * @param fd the file descriptor to stop watching
+ *
+ * @note This must be called before closing a watched file descriptor while the test keeps running.
+ */
+void cl_async_unwatch_fd(clarity_async_t *async, int fd);
+
+/**
+ * @brief Call a function once, after a delay.
+ *
+ * @param async the completion handle of the test
+ * @param delay_ms the delay, in milliseconds
+ * @param fn the callback to call
+ * @param data the data to pass down to the callback
+ *
+ * @return CL_SUCCESS or CL_ERROR_MEMORY
+ *
+ * @note Pending timers are cancelled when the test completes.
+ */
+clarity_status_t cl_async_set_timer(clarity_async_t *async, uint64_t delay_ms, clarity_async_timer_fn_t fn,
+                                    void *data);
+
+/**
+ * @brief Mark an asynchronous test as complete.
+ *
+ * @param async the completion handle of the test, it must not be used after this call
+ */
+void cl_async_done(clarity_async_t *async);
+
+/**
+ * @brief Set the number of asynchronous tests of a suite that can be in flight at the same time.
+ *
+ * @param suite the suite to configure
+ * @param max_in_flight the maximum number of tests in flight, `CL_DEFAULT_ASYNC_CONCURRENCY` by default
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL
+ */
+clarity_status_t cl_suite_set_async_concurrency(clarity_suite_t *suite, size_t max_in_flight);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_ASYNC_H
@@ -0,0 +1,100 @@
+#ifndef CLARITY_INCLUDE_CLARITY_BENCHMARK_H
+#define CLARITY_INCLUDE_CLARITY_BENCHMARK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The default significance level used to detect performance regressions.
+ */
+#define CL_DEFAULT_REGRESSION_ALPHA 0.01
+
+/**
+ * @brief The default minimum relative slowdown of the median reported as a regression (5%).
+ */
+#define CL_DEFAULT_REGRESSION_MIN_EFFECT 0.05
+
+/**
+ * @brief The minimum number of samples required on both sides to compare a test against its baseline.
+ */
+#define CL_BASELINE_MIN_SAMPLES 5
+
+/**
+ * @brief What a suite does with its baseline file when it is run.
+ */
+typedef enum clarity_baseline_mode_e {
+	CL_BASELINE_OFF,     /**< The baseline file is neither read nor written. */
+	CL_BASELINE_RECORD,  /**< The timing samples of the run are saved to the baseline file. */
+	CL_BASELINE_COMPARE, /**< The timing samples of the run are compared against the baseline file. */
+}            clarity_baseline_mode_t;
+
+/**
+ * @brief Create a new benchmark.
+ *
+ * @details
+ * A benchmark is a test case whose function is executed `samples` times in a row, each execution
+ * being timed separately. The benchmark stops early as soon as one execution fails or skips the test.
+ *
+ * Benchmarks are added to suites with `cl_add_test`, like any other test case, and their samples are
+ * the ones saved to and compared against the suite baseline.
+ *
+ * @param name the name of the benchmark
+ * @param fn the function to execute for every sample
+ * @param data the data to associate with the benchmark
+ * @param samples the number of samples to take, at least one
+ *
+ * @return a pointer to the new benchmark, or NULL if the allocation failed
+ *
+ * @see cl_suite_set_baseline
+ */
+clarity_test_t *cl_create_benchmark(const char *name, clarity_test_fn_t fn, void *data, uint32_t samples);
+
+/**
+ * @brief Attach a baseline file to a suite.
+ *
+ * @details
+ * The baseline file holds, for each test of the suite, the timing samples of a reference run.
+ * In `CL_BASELINE_RECORD` mode, `cl_run_suite` replaces the entries of the suite with the samples of
+ * the current run, keeping the entries of the other suites sharing the file. A malformed file is replaced.
+ *
+ * In `CL_BASELINE_COMPARE` mode, every test having at least `CL_BASELINE_MIN_SAMPLES` samples in both
+ * runs is compared against its baseline with a one-sided Mann-Whitney U test. A test is reported as
+ * failed when the slowdown is both significant and large enough (see `cl_suite_set_regression_threshold`).
+ * The failure message summarises both distributions.
+ * A missing or malformed baseline file is reported on stderr, and no test of the suite is compared.
+ *
+ * The mode can be overridden at run time with the `CLARITY_BASELINE_MODE` environment variable,
+ * set to `off`, `record` or `compare`, so that the same binary can record on one CI job and compare on another.
+ *
+ * @param suite the suite to attach the baseline to
+ * @param path the path of the baseline file, it must stay valid as long as the suite
+ * @param mode what to do with the baseline file
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL
+ *
+ * @see cl_create_benchmark, cl_suite_set_regression_threshold
+ */
+clarity_status_t cl_suite_set_baseline(clarity_suite_t *suite, const char *path, clarity_baseline_mode_t mode);
+
+/**
+ * @brief Configure how a suite detects performance regressions.
+ *
+ * @param suite the suite to configure
+ * @param alpha the significance level of the Mann-Whitney U test, `CL_DEFAULT_REGRESSION_ALPHA` by default
+ * @param min_effect the minimum relative increase of the median to report, `CL_DEFAULT_REGRESSION_MIN_EFFECT`
+ *                   by default (0.05 means 5% slower)
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL
+ */
+clarity_status_t cl_suite_set_regression_threshold(clarity_suite_t *suite, double alpha, double min_effect);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_BENCHMARK_H
@@ -0,0 +1,109 @@
+#ifndef CLARITY_INCLUDE_CLARITY_CACHE_H
+#define CLARITY_INCLUDE_CLARITY_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The environment variable overriding the directory of the fixture cache.
+ *
+ * Without it, the cache lives in `$XDG_CACHE_HOME/clarity`, or `$HOME/.cache/clarity`.
+ */
+#define CL_CACHE_DIR_ENV "CLARITY_CACHE_DIR"
+
+/**
+ * @brief What identifies a cached blob. Changing any part of the key invalidates the blob.
+ */
+typedef struct clarity_cache_key_s {
+	/**
+	 * @brief The name of the blob, e.g. `"unicode tables"`.
+	 */
+	const char *name;
+
+	/**
+	 * @brief The version of the format of the blob, to be bumped whenever the builder changes.
+	 */
+	uint32_t version;
+
+	/**
+	 * @brief A hash of the inputs of the builder, e.g. computed with `cl_cache_hash` over the source files.
+	 */
+	uint64_t input_hash;
+} clarity_cache_key_t;
+
+/**
+ * @brief A blob loaded by `cl_cache_load`, to be released with `cl_cache_release`.
+ */
+typedef struct clarity_blob_s {
+	const void *data; /**< The content of the blob, read-only. */
+	size_t     size;  /**< The size of the blob in bytes. */
+
+	void   *mapping;     /**< Private: the mapped cache file, or the built buffer if it could not be cached. */
+	size_t mapping_size; /**< Private: the size of the mapping, 0 for a built buffer. */
+} clarity_blob_t;
+
+/**
+ * @brief Function building a blob when it is not in the cache.
+ *
+ * @param size Receives the size of the built blob.
+ * @param data The data given to `cl_cache_load`.
+ *
+ * @return The blob, allocated with `malloc` and released by the framework, or NULL on failure.
+ */
+typedef void *(*clarity_cache_build_fn_t)(size_t *size, void *data);
+
+/**
+ * @brief Load a blob from the fixture cache, building it first if it is not cached yet.
+ *
+ * @details
+ * This is meant to be called from suite setups which spend most of their time generating or parsing the same
+ * data on every run. The first run calls the builder and stores its result in the cache directory. Later runs
+ * map the cached file read-only, without calling the builder nor parsing anything, so the blob must not contain
+ * pointers.
+ *
+ * The cache file is named after a hash of the whole key, so a blob built for another key is never used. Storing
+ * a blob removes the files left by the previous keys of the same name.
+ *
+ * When the cache directory cannot be written, the built blob is still returned, it is just not cached.
+ *
+ * @param key the key identifying the blob
+ * @param build the function building the blob if it is not cached
+ * @param data the data to pass down to the builder
+ * @param blob receives the blob
+ *
+ * @return CL_SUCCESS, or CL_ERROR_BUILD if the builder failed
+ */
+clarity_status_t cl_cache_load(const clarity_cache_key_t *key, clarity_cache_build_fn_t build, void *data,
+                               clarity_blob_t *blob);
+
+/**
+ * @brief Release a blob loaded by `cl_cache_load`.
+ *
+ * @param blob the blob to release, emptied by this function
+ */
+void cl_cache_release(clarity_blob_t *blob);
+
+/**
+ * @brief Hash bytes, to build the `input_hash` of a key.
+ *
+ * Hashes can be chained by passing the previous hash as the seed.
+ *
+ * @param data the bytes to hash
+ * @param size the number of bytes
+ * @param seed 0, or the hash of the previous inputs
+ *
+ * @return the 64 bits FNV-1a hash of the bytes
+ */
+uint64_t cl_cache_hash(const void *data, size_t size, uint64_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_CACHE_H
@@ -9,6 +9,16 @@ extern "C" {
 #include "clarity_types.h"
 #include "suite.h"
 #include "test.h"
+#include "benchmark.h"
+#include "async.h"
+#include "parallel.h"
+#include "clock.h"
+#include "trace.h"
+#include "stress.h"
+#include "concurrent.h"
+#include "cli.h"
+#include "cache.h"
+#include "assertions.h"
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,228 @@
+#ifndef CLARITY_INCLUDE_CLARITY_CLARITY_HPP
+#define CLARITY_INCLUDE_CLARITY_CLARITY_HPP
+
+/**
+ * @file clarity.hpp
+ * @brief C++17 helpers registering callables, typed tests and tables of cases as tests of the C suites.
+ *
+ * @details
+ * A test registered from C++ keeps its callable, with everything it captured, in the data of the test, which
+ * frees it with `cl_test_own_data`. The function of the test only calls it through a pointer of its exact type,
+ * so the body of the test is inlined into it, and specialized for every type of a typed test.
+ *
+ * Example:
+ * ```
+ * static constexpr struct { int input; int expected; } squares[] = { { 2, 4 }, { -3, 9 } };
+ *
+ * clarity::add_test(suite, "parses", [&parser](clarity_test_t *t) { ... });
+ * clarity::add_typed_tests(suite, "round trip", clarity::types<int, long, double>{},
+ *                          [](clarity_test_t *t, auto type) {
+ *                              using T = typename decltype(type)::type;
+ *                              ...
+ *                          });
+ * clarity::add_table_tests(suite, "square", squares, [](clarity_test_t *t, const auto &row) {
+ *     if (row.input * row.input != row.expected)
+ *         cl_fail_test(t, "wrong square");
+ * });
+ * ```
+ *
+ * The tests are named `name`, `name<type>` and `name[index]`, for `--test` patterns to select them.
+ */
+
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "clarity.h"
+
+namespace clarity {
+
+/**
+ * @brief The types a typed test is instantiated for.
+ */
+template <typename... Ts>
+struct types {};
+
+/**
+ * @brief The tag a typed test receives, naming the type of the instance as `type`.
+ */
+template <typename T>
+struct type_tag {
+	using type = T;
+};
+
+namespace detail {
+
+/**
+ * @brief The name of a type as the compiler spells it, without run-time type information.
+ */
+template <typename T>
+constexpr std::string_view type_name() {
+	std::string_view function = __PRETTY_FUNCTION__;
+	std::size_t      start    = function.find("T = ");
+	if (start == std::string_view::npos)
+		return "?";
+	start += 4;
+	std::size_t end = function.find_first_of(";]", start);
+	return function.substr(start, end == std::string_view::npos ? end : end - start);
+}
+
+/**
+ * @brief The data of a test registered from C++: its name and the callable running it, stored inline.
+ *
+ * An exception escaping the callable fails the test, its message being kept in the holder as long as the test.
+ */
+template <typename F>
+struct holder {
+	std::string name;
+	F           fn;
+	std::string failure;
+
+	static void run(clarity_test_t *test, void *data) {
+		holder *self = static_cast<holder *>(data);
+		try {
+			self->fn(test);
+		} catch (const std::exception &error) {
+			self->fail(test, error.what());
+		} catch (...) {
+			cl_fail_test(test, "uncaught exception");
+		}
+	}
+
+	void fail(clarity_test_t *test, const char *what) noexcept {
+		try {
+			failure = std::string("uncaught exception: ") + what;
+			cl_fail_test(test, failure.c_str());
+		} catch (...) {
+			cl_fail_test(test, "uncaught exception");
+		}
+	}
+
+	static void destroy(void *data) {
+		delete static_cast<holder *>(data);
+	}
+};
+
+template <typename F>
+clarity_test_t *create_test(std::string name, F &&fn) {
+	using holder_t = holder<std::decay_t<F>>;
+	holder_t *data = new (std::nothrow) holder_t{ std::move(name), std::forward<F>(fn), {} };
+	if (!data)
+		return nullptr;
+
+	clarity_test_t *test = cl_create_test(data->name.c_str(), holder_t::run, data);
+	if (test == nullptr) {
+		delete data;
+		return nullptr;
+	}
+	cl_test_own_data(test, holder_t::destroy);
+	return test;
+}
+
+inline clarity_status_t add(clarity_suite_t *suite, clarity_test_t *test) {
+	if (!test)
+		return CL_ERROR_MEMORY;
+
+	clarity_status_t status = cl_add_test(suite, test);
+	if (status != CL_SUCCESS)
+		cl_free_test(test);
+	return status;
+}
+
+} // namespace detail
+
+/**
+ * @brief Create a test running a callable, which receives the running test.
+ *
+ * @param name the name of the test, copied
+ * @param fn a callable taking a `clarity_test_t *`, moved or copied into the test with what it captured
+ *
+ * @return the test, to add to a suite, or nullptr if an allocation failed
+ */
+template <typename F>
+clarity_test_t *make_test(std::string name, F &&fn) {
+	static_assert(std::is_invocable_v<std::decay_t<F> &, clarity_test_t *>,
+	              "a test is a callable taking a clarity_test_t *");
+	return detail::create_test(std::move(name), std::forward<F>(fn));
+}
+
+/**
+ * @brief Add a test running a callable to a suite.
+ *
+ * @param suite the suite to add the test to
+ * @param name the name of the test, copied
+ * @param fn a callable taking a `clarity_test_t *`
+ *
+ * @return CL_SUCCESS, CL_ERROR_SUITE_NULL or CL_ERROR_MEMORY
+ */
+template <typename F>
+clarity_status_t add_test(clarity_suite_t *suite, std::string name, F &&fn) {
+	return detail::add(suite, make_test(std::move(name), std::forward<F>(fn)));
+}
+
+/**
+ * @brief Add a test per type to a suite, all running the same generic callable.
+ *
+ * The callable receives the running test and a `clarity::type_tag<T>`, and is instantiated for every type. The tests
+ * are named after the name and the type, as `name<int>`.
+ *
+ * @param suite the suite to add the tests to
+ * @param name the name of the tests
+ * @param list the types to instantiate the test for
+ * @param fn a generic callable taking a `clarity_test_t *` and a `clarity::type_tag<T>`
+ *
+ * @return CL_SUCCESS, or the error of the first test which could not be added, after which none is added
+ */
+template <typename... Ts, typename F>
+clarity_status_t add_typed_tests(clarity_suite_t *suite, const std::string &name, types<Ts...> list, F &&fn) {
+	(void) list;
+	clarity_status_t status = CL_SUCCESS;
+	auto             add    = [&](auto tag) {
+		if (status != CL_SUCCESS)
+			return;
+		using T = typename decltype(tag)::type;
+		std::string full = name + "<" + std::string(detail::type_name<T>()) + ">";
+		status = add_test(suite, std::move(full), [fn](clarity_test_t *test) { fn(test, type_tag<T>{}); });
+	};
+	(add(type_tag<Ts>{}), ...);
+	return status;
+}
+
+/**
+ * @brief Add a test per row of a table of cases to a suite, all running the same callable.
+ *
+ * The rows are not copied: the table, usually `static constexpr`, must outlive the suite. The tests are named
+ * after the name and the index of their row, as `name[0]`.
+ *
+ * @param suite the suite to add the tests to
+ * @param name the name of the tests
+ * @param rows the table, an array or a container of rows
+ * @param fn a callable taking a `clarity_test_t *` and a row
+ *
+ * @return CL_SUCCESS, or the error of the first test which could not be added, after which none is added
+ */
+template <typename Rows, typename F>
+clarity_status_t add_table_tests(clarity_suite_t *suite, const std::string &name, const Rows &rows, F &&fn) {
+	std::size_t index = 0;
+	for (const auto &row : rows) {
+		const auto      *entry  = &row;
+		clarity_status_t status = add_test(suite, name + "[" + std::to_string(index++) + "]",
+		                                   [fn, entry](clarity_test_t *test) { fn(test, *entry); });
+		if (status != CL_SUCCESS)
+			return status;
+	}
+	return CL_SUCCESS;
+}
+
+/**
+ * @brief Refuses a temporary table, which would not outlive the tests pointing into it.
+ */
+template <typename Rows, typename F>
+clarity_status_t add_table_tests(clarity_suite_t *suite, const std::string &name, const Rows &&rows, F &&fn) = delete;
+
+} // namespace clarity
+
+#endif //CLARITY_INCLUDE_CLARITY_CLARITY_HPP
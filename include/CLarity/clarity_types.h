@@ -1,6 +1,8 @@
 #ifndef CLARITY_INCLUDE_CLARITY_CLARITY_TYPES_H
 #define CLARITY_INCLUDE_CLARITY_CLARITY_TYPES_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -44,6 +46,21 @@ typedef struct clarity_test_s clarity_test_t;
  */
 typedef void (*clarity_test_fn_t)(clarity_test_t *t, void *data);
 
+/**
+ * @brief Type definition for a test generator.
+ *
+ * @details
+ * A generator creates the tests of a suite on demand, while the suite is running, so that huge
+ * generated suites never hold all their tests in memory at once. The generated test is released
+ * by the framework as soon as its result has been reported.
+ *
+ * @param index The index of the test to create, from 0 to the count given to `cl_suite_set_generator`.
+ * @param data The data given to `cl_suite_set_generator`.
+ *
+ * @return A test created with `cl_create_test`, or NULL if it could not be created.
+ */
+typedef clarity_test_t *(*clarity_test_generator_fn_t)(size_t index, void *data);
+
 /**
  * @brief The possible status codes returned by Clarity functions.
  */
@@ -51,6 +68,10 @@ typedef enum clarity_status_e {
 	CL_SUCCESS, /**< The operation succeeded. */
 	CL_ERROR_MEMORY, /**< There was an error allocating memory. */
 	CL_ERROR_SUITE_NULL, /**< The suite was NULL, no operation was performed. */
+	CL_ERROR_IO, /**< A file could not be read or written. */
+	CL_ERROR_BUILD, /**< The builder of a cached blob failed. */
+	CL_ERROR_CYCLE, /**< The dependency would make a test or a suite depend on itself. */
+	CL_ERROR_FORMAT, /**< A file was read, but was not in the expected format. */
 }            clarity_status_t;
 
 /**
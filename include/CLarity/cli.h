@@ -0,0 +1,143 @@
+#ifndef CLARITY_INCLUDE_CLARITY_CLI_H
+#define CLARITY_INCLUDE_CLARITY_CLI_H
+
+#include <stddef.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The environment variable naming the history file, when `--history` is not given.
+ */
+#define CL_HISTORY_ENV "CLARITY_HISTORY"
+
+/**
+ * @brief The environment variable naming the file to write the timeline of the run to, when `--trace` is not
+ * given.
+ */
+#define CL_TRACE_ENV "CLARITY_TRACE"
+
+/**
+ * @brief The environment variable giving a test binary started by `cl_driver_main` the descriptor to report its
+ * results on.
+ */
+#define CL_PROTOCOL_FD_ENV "CLARITY_PROTOCOL_FD"
+
+/**
+ * @brief The file listing the test binaries built by the project, one path per line, in the test build directory.
+ */
+#define CL_DRIVER_MANIFEST "clarity-tests.txt"
+
+/**
+ * @brief Run suites as directed by the command line of the test binary.
+ *
+ * @details
+ * This is meant to be called from `main`, with its arguments, after the suites have been created:
+ *
+ * ```
+ * int main(int argc, char **argv) {
+ *     clarity_suite_t *suites[] = { create_parser_suite(), create_codec_suite() };
+ *
+ *     int status = cl_main(argc, argv, suites, 2);
+ *     cl_free_suite(suites[0]);
+ *     cl_free_suite(suites[1]);
+ *     return status;
+ * }
+ * ```
+ *
+ * The following options are recognised:
+ * - `--test=PATTERN`: only run the tests whose name, or `suite/test` path, matches the glob pattern.
+ * - `--repeat=N`: repeat each selected test N times with `cl_stress_test`, instead of running the suites.
+ * - `--until-failure`: repeat each selected test until it fails, at most N times if `--repeat` is given.
+ * - `--concurrency=K`: run K copies of the test at once in every repetition.
+ * - `--pin`: pin each concurrent copy to a different core.
+ * - `--coordinator=ADDR`: serve the selected tests to workers, and print the report of their results.
+ * - `--worker=ADDR`: run the tests served by the coordinator listening on ADDR, until it has no more.
+ * - `--batch=N`: the number of tests a worker asks for at once.
+ * - `--worker-timeout=SECONDS`: how long the coordinator waits without any result nor new worker before reporting
+ *   the tests left as failed, 600 by default.
+ * - `--serve=ADDR`: run the suite setups once, then run the tests requested by `cl_client_main` until stopped.
+ * - `--budget=MS`: only run the tests most likely to fail which fit in MS milliseconds, see below.
+ * - `--history=PATH`: record the results to the history file PATH, `clarity-history.tsv` by default.
+ * - `--trace=PATH`: write a timeline of the run to PATH, in the Chrome trace event format, see `cl_trace_start`.
+ * - `--fail-fast`: stop the run at the first failure, as `--max-failures=1`.
+ * - `--max-failures=N`: stop the run after N failures, see `cl_set_max_failures`.
+ * - `--help`: print the usage of the binary.
+ *
+ * An address is `unix:PATH` or `tcp:HOST:PORT`. A worker must be the same binary as its coordinator, started
+ * with the same suites: tests are identified by their position. The tests in flight on a worker that goes away
+ * are given to another worker.
+ *
+ * A run given a history file, for instance the full nightly run, records the outcome and the duration of every
+ * test to it. A run given a budget reads the history, and ranks the selected tests by their likelihood of
+ * failing per second of run time: recent failures weigh more than older ones, and tests with fewer than three
+ * recorded runs are considered recent additions, likely to fail. The best ranked tests whose predicted
+ * durations fit in the budget run first, and no test starts once the budget has elapsed. Every test left out
+ * is reported as NOT RUN with the reason, and counted apart from the skipped tests.
+ *
+ * @param argc the number of arguments, as given to `main`
+ * @param argv the arguments, as given to `main`
+ * @param suites the suites of the binary
+ * @param suite_count the number of suites
+ *
+ * @return the exit status of the binary: 0 if every test passed, 1 if a test failed, 2 on a usage error
+ *
+ * @note The suites are not freed by this function.
+ */
+int cl_main(int argc, char **argv, clarity_suite_t **suites, size_t suite_count);
+
+/**
+ * @brief Run tests in a test binary started with `--serve`, as the `clarity-client` command does.
+ *
+ * @details
+ * The server keeps its suites set up between requests, so a request only pays for the per-test fixtures and the
+ * tests themselves. The results are printed as they arrive, like a local run would print them.
+ *
+ * The arguments are the address of the server, followed by these options:
+ * - `--test=PATTERN`: only run the tests whose name, or `suite/test` path, matches the glob pattern.
+ * - `--stop`: stop the server, which runs the suite teardowns before exiting.
+ * - `--help`: print the usage of the client.
+ *
+ * @param argc the number of arguments, as given to `main`
+ * @param argv the arguments, as given to `main`
+ *
+ * @return 0 if every requested test passed, 1 if a test failed, 2 if the server could not be reached
+ */
+int cl_client_main(int argc, char **argv);
+
+/**
+ * @brief Run many test binaries at once, and merge their results, as the `clarity-run` command does.
+ *
+ * @details
+ * The arguments are test binaries and directories, in which the executables whose name matches `--match` are test
+ * binaries, mixed with these options:
+ * - `--manifest=PATH`: run the binaries listed in PATH, one per line, such as the `CL_DRIVER_MANIFEST` the build
+ *   generates. Relative paths are relative to the directory of the manifest.
+ * - `--match=GLOB`: the names of the test binaries found in directories, `*test*` by default.
+ * - `--jobs=N`: run at most N binaries at once, one per core by default.
+ * - `--timeout=SECONDS`: kill a binary, and everything it started, once it has run for SECONDS.
+ * - `--verbose`: print the output of every binary, not only of the ones which failed.
+ * - `--help`: print the usage of the driver.
+ * The arguments after `--` are given to every binary.
+ *
+ * The output of a binary is captured, and printed at once when it finishes, so that the outputs of binaries
+ * running at the same time do not interleave. Meanwhile, the binary reports its suites and tests on the
+ * descriptor named by `CL_PROTOCOL_FD_ENV`, with the `wire.h` messages `cl_main` and `cl_run_suite` write as
+ * they print. The driver merges these into a single report: the outcome of every binary, the failed tests of the
+ * binaries which failed, and the totals of all the tests. As with any runner, a binary fails when it exits with an
+ * error, crashes or times out, whether its tests reported a failure or not.
+ *
+ * @param argc the number of arguments, as given to `main`
+ * @param argv the arguments, as given to `main`
+ *
+ * @return 0 if every binary passed, 1 if one failed, 2 on a usage error or if no binary was found
+ */
+int cl_driver_main(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_CLI_H
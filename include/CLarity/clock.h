@@ -0,0 +1,107 @@
+#ifndef CLARITY_INCLUDE_CLARITY_CLOCK_H
+#define CLARITY_INCLUDE_CLARITY_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opaque clock of a test, reading either the real time or a virtual time.
+ *
+ * @details
+ * Code under test which waits or schedules work takes a clock instead of reading the system time, and tests
+ * inject the clock of the test with `cl_test_clock`. A NULL clock is the real monotonic clock, so production
+ * code passes NULL.
+ *
+ * A virtual clock starts at 0 when the test starts, and only moves when the test waits: `cl_sleep` jumps
+ * straight to the end of the sleep, firing the timers due on the way in order, and an asynchronous test with
+ * nothing to wait for but timers jumps to the next one. A test retrying with a backoff of minutes runs
+ * instantly, and always in the same order.
+ */
+typedef struct clarity_clock_s clarity_clock_t;
+
+/**
+ * @brief Type definition for the callback of a timer of a clock.
+ *
+ * @param clock The clock the timer was registered on.
+ * @param data The data given to `cl_clock_add_timer`.
+ */
+typedef void (*clarity_clock_timer_fn_t)(clarity_clock_t *clock, void *data);
+
+/**
+ * @brief Read a clock.
+ *
+ * @param clock the clock, or NULL for the real clock
+ *
+ * @return the time in nanoseconds: the monotonic clock of the system for a real clock, the time elapsed in
+ * the test for a virtual clock
+ */
+uint64_t cl_now(const clarity_clock_t *clock);
+
+/**
+ * @brief Wait for a duration, running the timers of the clock which become due meanwhile.
+ *
+ * A virtual clock does not wait: it moves from one timer to the next and then to the end of the sleep.
+ *
+ * @param clock the clock, or NULL for the real clock
+ * @param ns the duration, in nanoseconds
+ */
+void cl_sleep(clarity_clock_t *clock, uint64_t ns);
+
+/**
+ * @brief Call a function once, when a clock reaches a delay from now.
+ *
+ * Timers run from `cl_sleep`, and from the event loop in asynchronous tests. Timers due at the same time run in
+ * the order they were registered, and the timers still pending when the test completes are dropped.
+ *
+ * @param clock the clock
+ * @param delay_ns the delay, in nanoseconds
+ * @param fn the callback to call
+ * @param data the data to pass down to the callback
+ * @param id receives the identifier of the timer, may be NULL
+ *
+ * @return CL_SUCCESS, or CL_ERROR_MEMORY
+ */
+clarity_status_t cl_clock_add_timer(clarity_clock_t *clock, uint64_t delay_ns, clarity_clock_timer_fn_t fn,
+                                    void *data, uint64_t *id);
+
+/**
+ * @brief Cancel a pending timer, does nothing if it already ran.
+ *
+ * @param clock the clock
+ * @param id the identifier given by `cl_clock_add_timer`
+ */
+void cl_clock_cancel_timer(clarity_clock_t *clock, uint64_t id);
+
+/**
+ * @brief Choose whether a test runs on a virtual clock, instead of the real one.
+ *
+ * The timers of `cl_async_set_timer` follow the clock of the test. The timeout of an asynchronous test is
+ * always measured in real time, and virtual time stands still while the test waits for file descriptors.
+ *
+ * @param test the test
+ * @param enabled true for a virtual clock, false for the real clock, the default
+ *
+ * @return CL_SUCCESS, or CL_ERROR_MEMORY
+ */
+clarity_status_t cl_test_use_virtual_time(clarity_test_t *test, bool enabled);
+
+/**
+ * @brief Get the clock of a test, to inject it into the code under test.
+ *
+ * @param test the test
+ *
+ * @return the clock of the test, valid until the test is freed, or NULL for the real clock when it could not
+ * be allocated
+ */
+clarity_clock_t *cl_test_clock(clarity_test_t *test);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_CLOCK_H
@@ -0,0 +1,68 @@
+#ifndef CLARITY_INCLUDE_CLARITY_CONCURRENT_H
+#define CLARITY_INCLUDE_CLARITY_CONCURRENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The time the threads of `cl_run_concurrently` have to finish, unless told otherwise.
+ */
+#define CL_DEFAULT_CONCURRENT_TIMEOUT_MS 10000
+
+/**
+ * @brief Type definition for the function run by every thread of `cl_run_concurrently`.
+ *
+ * @param t a test standing for the running test on this thread only, to fail, skip or allocate from
+ * @param thread the index of the thread, from 0 to the number of threads
+ * @param iteration the index of the iteration, from 0
+ * @param data the data given to `cl_run_concurrently`
+ */
+typedef void (*clarity_concurrent_fn_t)(clarity_test_t *t, size_t thread, uint64_t iteration, void *data);
+
+/**
+ * @brief Run a function on several threads at once, from a running test, to shake out races.
+ *
+ * @details
+ * The threads are released together by a start barrier, then each calls the function for every iteration.
+ * Each thread fails its own copy of the test, so its failures keep their message and their point; the threads
+ * stop at the first failure of any of them, or once the run is cancelled. The earliest failure is then recorded
+ * on the test, along with its thread, its iteration and the number of threads which failed.
+ *
+ * Threads still running after the timeout are left running, and the test fails: the data must outlive them.
+ *
+ * Example:
+ * ```
+ * static void push_pop(clarity_test_t *t, size_t thread, uint64_t iteration, void *data) {
+ *     if (!queue_push(data, thread) || !queue_pop(data))
+ *         cl_fail_test(t, "the queue lost an element");
+ * }
+ *
+ * void queue_test(clarity_test_t *t, void *data) {
+ *     cl_run_concurrently(t, push_pop, data, 8, 100000, 0);
+ * }
+ * ```
+ *
+ * @param test the running test
+ * @param fn the function to run
+ * @param data the data to pass down to the function
+ * @param threads the number of threads, 1 if 0
+ * @param iterations the number of times each thread calls the function
+ * @param timeout_ms the time the threads have to finish, 0 for `CL_DEFAULT_CONCURRENT_TIMEOUT_MS`
+ *
+ * @return true if every thread went through its iterations without failing, false otherwise, or if the threads
+ * could not be started, which fails the test
+ */
+bool cl_run_concurrently(clarity_test_t *test, clarity_concurrent_fn_t fn, void *data, size_t threads,
+                         uint64_t iterations, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_CONCURRENT_H
@@ -0,0 +1,91 @@
+#ifndef CLARITY_INCLUDE_CLARITY_PARALLEL_H
+#define CLARITY_INCLUDE_CLARITY_PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The amount of a resource meaning all of its capacity, to hold it exclusively.
+ */
+#define CL_RESOURCE_ALL UINT64_MAX
+
+/**
+ * @brief Run the tests of a suite concurrently, on a pool of threads.
+ *
+ * @details
+ * The tests are started in the order of the suite, but a test waiting for a resource is overtaken by the
+ * following tests which do not need any of its resources, so that no thread idles behind it while it cannot
+ * starve either. The per-test fixtures run on the thread of their test, so they must be thread-safe, and the
+ * results are reported in the order the tests finish.
+ *
+ * Asynchronous tests are not run by the pool: they run on the event loop of the suite once the pool is done.
+ * Isolated suites ignore this setting, their parallelism is the number of forked processes.
+ *
+ * @param suite The suite.
+ * @param jobs The number of tests running at the same time, 0 for the number of cores. 1, the default, runs
+ * the tests one after the other.
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL.
+ */
+clarity_status_t cl_suite_set_jobs(clarity_suite_t *suite, size_t jobs);
+
+/**
+ * @brief Declare a counted resource shared by the tests of a suite, such as memory or CPU slots.
+ *
+ * The tests running at the same time never need more than the capacity of a resource altogether. A resource
+ * which is needed without having been declared has a capacity of 1, which makes it an exclusive lock, e.g.
+ * for a port or a temporary directory.
+ *
+ * Example:
+ * ```
+ * cl_suite_add_resource(suite, "memory_gb", 32);
+ * cl_test_require(big_test, "memory_gb", 8);
+ * cl_test_require(server_test, "port 8080", 1);
+ * ```
+ *
+ * @param suite The suite.
+ * @param name The name of the resource, which must outlive the suite.
+ * @param capacity The amount available, replacing any previous declaration.
+ *
+ * @return CL_SUCCESS, CL_ERROR_SUITE_NULL if the suite is NULL, or CL_ERROR_MEMORY.
+ */
+clarity_status_t cl_suite_add_resource(clarity_suite_t *suite, const char *name, uint64_t capacity);
+
+/**
+ * @brief Declare an amount of a resource needed by every test of a suite.
+ *
+ * This adds to what each test requires with `cl_test_require`, the larger amount wins when both name the
+ * same resource.
+ *
+ * @param suite The suite.
+ * @param name The name of the resource, which must outlive the suite.
+ * @param amount The amount needed, or CL_RESOURCE_ALL to hold the resource exclusively.
+ *
+ * @return CL_SUCCESS, CL_ERROR_SUITE_NULL if the suite is NULL, or CL_ERROR_MEMORY.
+ */
+clarity_status_t cl_suite_require(clarity_suite_t *suite, const char *name, uint64_t amount);
+
+/**
+ * @brief Declare an amount of a resource needed by a test while it runs.
+ *
+ * A test needing more than the capacity of a resource fails without being run. A NULL test is ignored, as
+ * by `cl_add_test`.
+ *
+ * @param test The test.
+ * @param name The name of the resource, which must outlive the test.
+ * @param amount The amount needed, or CL_RESOURCE_ALL to hold the resource exclusively.
+ *
+ * @return CL_SUCCESS, or CL_ERROR_MEMORY.
+ */
+clarity_status_t cl_test_require(clarity_test_t *test, const char *name, uint64_t amount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_PARALLEL_H
@@ -0,0 +1,64 @@
+#ifndef CLARITY_INCLUDE_CLARITY_STRESS_H
+#define CLARITY_INCLUDE_CLARITY_STRESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief How a test is repeated by `cl_stress_test`.
+ */
+typedef struct clarity_stress_options_s {
+	/**
+	 * @brief The number of iterations to run.
+	 *
+	 * When `until_failure` is set, 0 means no limit: the test is repeated until it fails.
+	 */
+	uint64_t iterations;
+
+	/**
+	 * @brief Whether to stop after the first iteration having a failure.
+	 */
+	bool until_failure;
+
+	/**
+	 * @brief The number of copies of the test run concurrently in every iteration, 1 if 0.
+	 *
+	 * The copies run on threads created once, released together by a start barrier at every iteration.
+	 */
+	uint32_t concurrency;
+
+	/**
+	 * @brief Whether each concurrent copy must be pinned to a different core.
+	 */
+	bool pin_threads;
+} clarity_stress_options_t;
+
+/**
+ * @brief Repeat one test of a suite to shake out races and flaky failures.
+ *
+ * @details
+ * The suite setup is run once, then the test is run for every iteration, surrounded by the per-test fixtures
+ * of the suite. With a concurrency above 1, every iteration runs that many copies of the test at once, each with
+ * its own result, and the per-test fixtures run once around all the copies.
+ *
+ * Once done, a report gives the number of runs, the failure rate, and the first failure: its iteration, its copy
+ * and its message.
+ *
+ * @param suite the suite containing the test
+ * @param test_name the name of the test to repeat
+ * @param options how to repeat the test
+ *
+ * @return true if no run of the test failed, false otherwise or if the test does not exist.
+ */
+bool cl_stress_test(clarity_suite_t *suite, const char *test_name, const clarity_stress_options_t *options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_STRESS_H
@@ -87,6 +87,145 @@ void cl_free_suite(clarity_suite_t *suite);
  */
 clarity_status_t cl_add_test(clarity_suite_t *suite, clarity_test_t *test);
 
+/**
+ * @brief The default number of failures kept for the final summary of a streaming run.
+ */
+#define CL_DEFAULT_STREAM_MAX_FAILURES 64
+
+/**
+ * @brief The default number of slowest tests listed in the final summary of a streaming run.
+ */
+#define CL_DEFAULT_STREAM_MAX_SLOWEST 10
+
+/**
+ * @brief The number of tests run by each forked process of an isolated suite, unless told otherwise.
+ */
+#define CL_DEFAULT_ISOLATION_BATCH 1
+
+/**
+ * @brief The time a forked process of an isolated suite may run a test before it is killed, unless told otherwise.
+ */
+#define CL_DEFAULT_ISOLATION_TIMEOUT_MS 60000
+
+/**
+ * @brief The number of crashes after which a suite recovering from crashes stops, unless told otherwise.
+ */
+#define CL_DEFAULT_MAX_CRASHES 10
+
+/**
+ * @brief The time the tests in flight have to stop once a run is cancelled, unless told otherwise.
+ */
+#define CL_DEFAULT_CANCEL_GRACE_MS 5000
+
+/**
+ * @brief Register a generator creating tests on demand while the suite runs.
+ *
+ * @param suite the suite to register the generator for
+ * @param count the number of tests the generator creates
+ * @param fn the generator
+ * @param data the data to pass down to the generator
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL
+ *
+ * @note The generated tests are run after the tests added with `cl_add_test`, and are released as soon
+ *       as their result has been reported. A suite has at most one generator, registering another one
+ *       replaces it.
+ */
+clarity_status_t cl_suite_set_generator(clarity_suite_t *suite, size_t count, clarity_test_generator_fn_t fn,
+                                        void *data);
+
+/**
+ * @brief Enable or disable the streaming execution of a suite.
+ *
+ * @details
+ * In streaming mode, `cl_run_suite` releases every test as soon as its result has been reported, instead of
+ * keeping it until `cl_free_suite`. Only failures and skipped tests are printed while the suite runs.
+ * The results are aggregated into the suite counters, plus a bounded buffer holding the first `max_failures`
+ * failures and the `max_slowest` slowest tests, printed in the summary at the end of the run.
+ *
+ * Combined with `cl_suite_set_generator`, the memory used by a run no longer depends on the number of tests.
+ *
+ * @param suite the suite to configure
+ * @param enabled true to enable streaming execution
+ * @param max_failures the maximum number of failures kept for the summary, e.g. `CL_DEFAULT_STREAM_MAX_FAILURES`
+ * @param max_slowest the number of slowest tests listed in the summary, e.g. `CL_DEFAULT_STREAM_MAX_SLOWEST`
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL
+ *
+ * @note A streaming suite can only be run once, since its tests are gone after the run.
+ *
+ * @note A streaming suite never records its baseline, the samples of the released tests being gone.
+ */
+clarity_status_t cl_suite_set_streaming(clarity_suite_t *suite, bool enabled, size_t max_failures,
+                                        size_t max_slowest);
+
+/**
+ * @brief Enable or disable the isolation of the tests of a suite in forked processes.
+ *
+ * @details
+ * An isolated suite runs its setup once in the test process, then forks a child process from that state for
+ * every batch of `batch_size` tests. The children share the data loaded by the setup copy-on-write, run their
+ * tests with the per-test fixtures, send the results back and exit, so the tests can freely mutate the state of
+ * the suite without affecting each other. Up to `max_children` children run at the same time, and the results
+ * are printed as they come back.
+ *
+ * A test crashing its process is reported as failed, with the signal that killed it, and the rest of its batch
+ * is run in a new child. So is a test running for longer than the timeout of the suite, whose process is killed
+ * with SIGKILL, see `cl_suite_set_isolation_timeout`.
+ *
+ * @param suite the suite to configure
+ * @param enabled true to run the tests in forked processes
+ * @param batch_size the number of tests run by each child, e.g. `CL_DEFAULT_ISOLATION_BATCH`
+ * @param max_children the maximum number of children running at the same time, 0 for the number of cores
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL
+ *
+ * @note The state changed by the tests and the per-test fixtures is lost with the children, the suite teardown
+ *       only sees the state left by the setup. An isolated suite never records its baseline for the same reason.
+ */
+clarity_status_t cl_suite_set_isolation(clarity_suite_t *suite, bool enabled, size_t batch_size,
+                                        size_t max_children);
+
+/**
+ * @brief Set the time a test of an isolated suite may run before its process is killed.
+ *
+ * @details
+ * The timeout counts from the last message of the forked process, which reports when every test starts and
+ * ends, so it covers one test with its per-test fixtures. The test running when it expires is reported as
+ * failed, and the rest of its batch is run in a new child.
+ *
+ * @param suite the suite to configure
+ * @param timeout_ms the time a test may run, in milliseconds, or 0 for `CL_DEFAULT_ISOLATION_TIMEOUT_MS`
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL
+ *
+ * @see cl_suite_set_isolation
+ */
+clarity_status_t cl_suite_set_isolation_timeout(clarity_suite_t *suite, uint32_t timeout_ms);
+
+/**
+ * @brief Enable or disable the recovery of the tests of a suite which crash, without leaving the test process.
+ *
+ * @details
+ * This is a lighter alternative to `cl_suite_set_isolation` for suites of many small tests. While a test of the
+ * suite runs, a SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT raised by the test jumps back into the runner, from
+ * a stack of its own so that a stack overflow is caught too. The test is reported as failed with the signal, at
+ * the last point it marked, and the per-test teardowns run before the next test starts.
+ *
+ * A crash may leave the process in a corrupted state, such as a held lock or a broken heap: once `max_crashes`
+ * tests crashed, the remaining tests of the suite are reported as not run.
+ *
+ * @param suite the suite to configure
+ * @param enabled true to recover from crashes
+ * @param max_crashes the number of crashes after which the suite stops, 0 for `CL_DEFAULT_MAX_CRASHES`
+ *
+ * @return CL_SUCCESS, or CL_ERROR_SUITE_NULL if the suite is NULL
+ *
+ * @note Only the test functions are protected, not the fixtures nor the callbacks of asynchronous tests. Isolated
+ *       suites ignore this setting, their crashes are already contained in the forked processes.
+ */
+clarity_status_t cl_suite_set_crash_recovery(clarity_suite_t *suite, bool enabled, size_t max_crashes);
+
 /**
  * @brief Runs a test suite.
  * @param suite Pointer to the test suite to run.
@@ -96,6 +235,76 @@ clarity_status_t cl_add_test(clarity_suite_t *suite, clarity_test_t *test);
  */
 bool cl_run_suite(clarity_suite_t *suite);
 
+/**
+ * @brief Stop running tests once a number of them failed.
+ *
+ * @details
+ * When the limit is reached, no test starts anymore, in any suite: the remaining tests are counted as not run
+ * in the reports, without being printed, and the suites which did not start are not set up at all. The suites
+ * already running still run their teardowns. The tests in flight on the other workers, or on the event loop,
+ * see `cl_test_cancelled` return true and should return early. Asynchronous tests still in flight after the
+ * grace period are failed, and if a test function is still running then, the process exits with status 1,
+ * after printing the number of failures and of tests not run so far on stderr.
+ *
+ * Once the suites of the run are reported, the cancellation is lifted and the failures are counted from 0
+ * again, for the suites run next to start their tests. Setting a limit starts counting the failures from 0 too.
+ *
+ * @param max_failures the number of failures after which the run stops, 1 to stop at the first one, 0 for no
+ * limit, the default
+ * @param grace_ms the time the tests in flight have to stop, 0 for `CL_DEFAULT_CANCEL_GRACE_MS`
+ */
+void cl_set_max_failures(size_t max_failures, uint32_t grace_ms);
+
+/**
+ * @brief Declare that a suite only makes sense once another suite has passed.
+ *
+ * When the prerequisite suite has a failing test, or is itself skipped, the tests of the suite are reported
+ * as skipped without being run, and its fixtures are not called.
+ *
+ * @note The dependencies are declared from a single thread, before running the suites.
+ *
+ * @param suite the dependent suite
+ * @param prerequisite the suite which must pass first
+ *
+ * @return CL_SUCCESS, CL_ERROR_SUITE_NULL if a suite is NULL, CL_ERROR_CYCLE if the prerequisite already
+ * depends on the suite, or CL_ERROR_MEMORY
+ */
+clarity_status_t cl_suite_depends_on(clarity_suite_t *suite, clarity_suite_t *prerequisite);
+
+/**
+ * @brief Runs test suites, each after the suites it depends on.
+ *
+ * The suites run in the given order, except that a suite is moved after its prerequisites.
+ *
+ * @param suites The suites to run.
+ * @param count The number of suites.
+ *
+ * @return true if all the tests of all the suites passed or were skipped, false otherwise.
+ */
+bool cl_run_suites(clarity_suite_t **suites, size_t count);
+
+/**
+ * @brief Nest a suite in another one, so that they share the setup of the parent.
+ *
+ * The setup of the parent runs once before its own tests and the suites nested in it, and its teardown once
+ * after all of them. The per-test fixtures compose: the setups run from the outermost suite to the innermost,
+ * the teardowns the other way around. Every suite prints its own report, whose counters include the suites
+ * nested in it.
+ *
+ * @note The parent owns the child, which is freed with it by `cl_free_suite`. The child keeps its own
+ *       settings, its tests run on its own jobs and resources whatever those of its parent. Running the
+ *       child on its own still sets up its ancestors around it.
+ *
+ * @note The distributed, server and stress modes only run the tests of the suites given to them.
+ *
+ * @param parent the suite to nest the child in
+ * @param child the nested suite
+ *
+ * @return CL_SUCCESS, CL_ERROR_SUITE_NULL if a suite is NULL, CL_ERROR_CYCLE if the child already has a parent
+ * or contains the parent, or CL_ERROR_MEMORY
+ */
+clarity_status_t cl_suite_add_child(clarity_suite_t *parent, clarity_suite_t *child);
+
 /**
  * @brief Add a fixtures to the current suite.
  *
@@ -2,6 +2,7 @@
 #define CLARITY_INCLUDE_CLARITY_TEST_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "suite.h"
 #include "clarity_types.h"
@@ -46,6 +47,113 @@ void *cl_get_test_data(clarity_test_t *test);
  */
 void cl_free_test(clarity_test_t *test);
 
+/**
+ * @brief Declare that a test only makes sense once another test has passed.
+ *
+ * When the prerequisite fails or is skipped, the test is skipped without being run. The sequential and the
+ * parallel runners start a test once all its prerequisites are done, whatever their order in the suite. A
+ * prerequisite which is not selected by the run does not hold its dependents back.
+ *
+ * @note The prerequisite must be a test added to the same suite with `cl_add_test`, not a generated test.
+ *       Isolated suites and the distributed and server modes ignore the dependencies. The dependencies are
+ *       declared from a single thread, before running the suites.
+ *
+ * @param test the dependent test
+ * @param prerequisite the test which must pass first
+ *
+ * @return CL_SUCCESS, CL_ERROR_CYCLE if the prerequisite already depends on the test, or CL_ERROR_MEMORY
+ */
+clarity_status_t cl_test_depends_on(clarity_test_t *test, clarity_test_t *prerequisite);
+
+/**
+ * @brief Check whether the run of a test has been cancelled, for a long test to return early.
+ *
+ * A run is cancelled once it reached its maximum number of failures. The result of a test returning early
+ * is reported as usual, so a cancelled test usually skips itself.
+ *
+ * Example:
+ * ```
+ * for (size_t i = 0; i < 1000000; i++) {
+ *     if (cl_test_cancelled(t)) {
+ *         cl_skip_test(t, "cancelled");
+ *         return;
+ *     }
+ *     check_input(t, i);
+ * }
+ * ```
+ *
+ * @param test the running test
+ *
+ * @return true if the test should stop
+ *
+ * @see cl_set_max_failures
+ */
+bool cl_test_cancelled(const clarity_test_t *test);
+
+/**
+ * @brief Type definition for a cleanup registered by a test.
+ *
+ * @param data the data given to `cl_test_defer`
+ */
+typedef void (*clarity_cleanup_fn_t)(void *data);
+
+/**
+ * @brief Allocate scratch memory which lives until the test completes.
+ *
+ * @details
+ * The memory is bump-allocated from regions recycled by the thread running the tests, and it is all released
+ * at once when the test function returns, or when an asynchronous test completes, whether the test passed,
+ * failed or was skipped. Nothing needs to be freed by hand. The memory is not initialized.
+ *
+ * Example:
+ * ```
+ * void my_test(clarity_test_t *t, void *data) {
+ *     char *buffer = cl_test_alloc(t, 4096, 0);
+ *     FILE *file   = fopen("input.txt", "r");
+ *     cl_test_defer(t, (clarity_cleanup_fn_t) fclose, file);
+ *     if (!fgets(buffer, 4096, file))
+ *         cl_fail_test(t, "empty input");
+ * }
+ * ```
+ *
+ * @param test the running test
+ * @param size the size of the allocation, in bytes
+ * @param align the alignment of the allocation, a power of two, or 0 for the alignment of any type
+ *
+ * @return the memory, or NULL if the allocation failed or the alignment is not a power of two
+ *
+ * @note The allocator is not thread-safe: a test allocating from several threads must serialize the calls.
+ */
+void *cl_test_alloc(clarity_test_t *test, size_t size, size_t align);
+
+/**
+ * @brief Register a function to call when the test completes, whatever its result.
+ *
+ * Cleanups run in the reverse order of their registration, before the memory of `cl_test_alloc` is released,
+ * so they may use it.
+ *
+ * @param test the running test
+ * @param fn the function to call
+ * @param data the data to pass down to the function
+ *
+ * @return CL_SUCCESS, or CL_ERROR_MEMORY, in which case the function is called right away
+ */
+clarity_status_t cl_test_defer(clarity_test_t *test, clarity_cleanup_fn_t fn, void *data);
+
+/**
+ * @brief Hand the data of a test over to the test, to be freed along with it.
+ *
+ * The function is called with the data once, by `cl_free_test`, which also frees the generated and streamed
+ * tests as soon as they are reported. The copies of a test made to run it concurrently share its data without
+ * owning it.
+ *
+ * @param test the test owning its data
+ * @param fn the function freeing the data, or NULL for the test not to own its data anymore
+ *
+ * @return CL_SUCCESS, also when the test is NULL, as when its creation failed: the data is then still the caller's
+ */
+clarity_status_t cl_test_own_data(clarity_test_t *test, clarity_cleanup_fn_t fn);
+
 /**
  * @brief Internal function to mark a point in the test.
  *
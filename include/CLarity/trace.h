@@ -0,0 +1,43 @@
+#ifndef CLARITY_INCLUDE_CLARITY_TRACE_H
+#define CLARITY_INCLUDE_CLARITY_TRACE_H
+
+#include "clarity_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start recording a timeline of the runs.
+ *
+ * @details
+ * While recording, the runner records when each suite runs, its setup and teardown, each per-test fixture, each
+ * test and each report printed. Every thread records to a buffer of its own, without locks, so recording can
+ * be left on in CI. The timeline is written by `cl_trace_stop` in the Chrome trace event format, which
+ * Perfetto and `about:tracing` load, with one track per thread: the main thread and the workers of the
+ * parallel suites.
+ *
+ * `cl_main` records the timeline when given `--trace=PATH`, or when `CLARITY_TRACE` names a file.
+ *
+ * @note The tests of isolated suites run in forked processes, whose events are not recorded.
+ *
+ * @return CL_SUCCESS
+ */
+clarity_status_t cl_trace_start(void);
+
+/**
+ * @brief Stop recording, and write the timeline recorded since `cl_trace_start`.
+ *
+ * No test may be running when this function is called.
+ *
+ * @param path the file to write the timeline to, replaced if it exists
+ *
+ * @return CL_SUCCESS, or CL_ERROR_IO if the file could not be written
+ */
+clarity_status_t cl_trace_stop(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_CLARITY_TRACE_H
@@ -0,0 +1,72 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_ARENA_H
+#define CLARITY_INCLUDE_INTERNAL_ARENA_H
+
+#include <CLarity/clarity_types.h>
+#include <CLarity/test.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The size of the regions of the arenas, larger allocations get a region of their own.
+ */
+#define CL_ARENA_CHUNK_SIZE (64u * 1024u)
+
+/**
+ * @brief The number of released regions each thread keeps for the next tests.
+ */
+#define CL_ARENA_CACHED_CHUNKS 4
+
+/**
+ * @brief A region of an arena.
+ */
+typedef struct clarity_arena_chunk_s {
+	struct clarity_arena_chunk_s *next;   /**< The previous region of the arena. */
+	size_t                       size;    /**< The size of `data`. */
+	size_t                       used;    /**< The number of bytes of `data` handed out. */
+	max_align_t                  data[];  /**< The memory of the region. */
+} clarity_arena_chunk_t;
+
+/**
+ * @brief A cleanup registered by a test, allocated in its arena.
+ */
+typedef struct clarity_arena_cleanup_s {
+	clarity_cleanup_fn_t           fn;    /**< The function to call. */
+	void                           *data; /**< The data to pass to the function. */
+	struct clarity_arena_cleanup_s *next; /**< The cleanup registered before this one. */
+} clarity_arena_cleanup_t;
+
+/**
+ * @brief The scratch memory and the cleanups of a running test, empty when zeroed.
+ */
+typedef struct clarity_arena_s {
+	clarity_arena_chunk_t   *chunks;   /**< The regions, the current one first. */
+	clarity_arena_cleanup_t *cleanups; /**< The cleanups, the last registered first. */
+} clarity_arena_t;
+
+/**
+ * @brief Allocates memory from an arena, as `cl_test_alloc` does.
+ */
+void *cl_arena_alloc(clarity_arena_t *arena, size_t size, size_t align);
+
+/**
+ * @brief Registers a cleanup in an arena, as `cl_test_defer` does.
+ */
+clarity_status_t cl_arena_defer(clarity_arena_t *arena, clarity_cleanup_fn_t fn, void *data);
+
+/**
+ * @brief Runs the cleanups of an arena and releases its memory, leaving it empty.
+ *
+ * The regions of the default size go back to the cache of the calling thread.
+ *
+ * @param arena The arena.
+ */
+void cl_arena_reset(clarity_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_ARENA_H
@@ -0,0 +1,26 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_ASSERTIONS_H
+#define CLARITY_INCLUDE_INTERNAL_ASSERTIONS_H
+
+#include <CLarity/clarity_types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fails a test with a message describing where two buffers differ.
+ *
+ * The message starts with `heading`, followed by the offset of the first difference, the number of differing
+ * bytes, and a hex dump of both buffers around it. The heading is also the message if the full one cannot be
+ * allocated, so it must outlive the test.
+ */
+void cl_assert_fail_buffers(clarity_test_t *test, const char *file, size_t line, const char *heading,
+                            const unsigned char *actual, size_t actual_size, const unsigned char *expected,
+                            size_t expected_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_ASSERTIONS_H
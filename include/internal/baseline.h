@@ -0,0 +1,114 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_BASELINE_H
+#define CLARITY_INCLUDE_INTERNAL_BASELINE_H
+
+#include <CLarity/clarity_types.h>
+#include <CLarity/benchmark.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The timing samples saved for one test in a baseline file.
+ */
+typedef struct clarity_baseline_entry_s {
+	char     *suite;   /**< The name of the suite the test belongs to. */
+	char     *test;    /**< The name of the test. */
+	uint64_t *samples; /**< The samples, in nanoseconds. */
+	size_t   count;    /**< The number of samples. */
+} clarity_baseline_entry_t;
+
+/**
+ * @brief The content of a baseline file.
+ *
+ * @details
+ * A baseline file is a text file starting with a `# CLarity baseline v1` header, followed by one line
+ * per test: the suite name, the test name, the sample count and the comma separated samples, separated
+ * by tabulations. Tabulations, new lines and backslashes in names are escaped with a backslash.
+ */
+typedef struct clarity_baseline_s {
+	size_t                   count;    /**< The number of entries. */
+	size_t                   capacity; /**< The number of entries that fit without reallocation. */
+	clarity_baseline_entry_t *entries; /**< The entries, in file order. */
+} clarity_baseline_t;
+
+/**
+ * @brief Get the baseline mode of a suite, taking the `CLARITY_BASELINE_MODE` environment variable into account.
+ *
+ * @param suite The suite to get the mode of.
+ *
+ * @return The mode to use for this run, always `CL_BASELINE_OFF` if the suite has no baseline file.
+ */
+clarity_baseline_mode_t cl_baseline_effective_mode(const clarity_suite_t *suite);
+
+/**
+ * @brief Loads a baseline file.
+ *
+ * @param path The path of the file.
+ * @param baseline Receives the loaded baseline, an empty one if the file could not be opened or is malformed,
+ *                 or NULL if the allocation failed.
+ *
+ * @return CL_SUCCESS, CL_ERROR_IO if the file could not be opened, CL_ERROR_FORMAT if it is malformed, or
+ *         CL_ERROR_MEMORY.
+ */
+clarity_status_t cl_baseline_load(const char *path, clarity_baseline_t **baseline);
+
+/**
+ * @brief Loads the baseline a suite is compared against, warning on stderr if it is missing or malformed.
+ *
+ * @param suite The suite, in compare mode.
+ *
+ * @return The baseline, empty if there is nothing to compare against, or NULL if the allocation failed.
+ */
+clarity_baseline_t *cl_baseline_load_reference(const clarity_suite_t *suite);
+
+/**
+ * @brief Releases a baseline loaded with `cl_baseline_load`.
+ *
+ * @param baseline The baseline to release, may be NULL.
+ */
+void cl_baseline_free(clarity_baseline_t *baseline);
+
+/**
+ * @brief Looks for the entry of a test in a baseline.
+ *
+ * @param baseline The baseline to search.
+ * @param suite The name of the suite.
+ * @param test The name of the test.
+ *
+ * @return The entry, or NULL if the test is not part of the baseline.
+ */
+const clarity_baseline_entry_t *cl_baseline_find(const clarity_baseline_t *baseline, const char *suite,
+                                                 const char *test);
+
+/**
+ * @brief Compares the last run of a test against its baseline, and fails the test on a significant regression.
+ *
+ * @param baseline The baseline to compare against.
+ * @param suite The suite the test belongs to, giving the suite name and the regression threshold.
+ * @param test The test to compare.
+ *
+ * @return true if the test has been marked as failed by the comparison, false otherwise.
+ */
+bool cl_baseline_compare_test(const clarity_baseline_t *baseline, const clarity_suite_t *suite, clarity_test_t *test);
+
+/**
+ * @brief Saves the samples of the last run of a suite to its baseline file.
+ *
+ * The entries of the other suites already present in the file are preserved, the file is replaced atomically. A
+ * malformed file is replaced with the entries of the suite alone.
+ *
+ * @param suite The suite to record.
+ *
+ * @return CL_SUCCESS, CL_ERROR_MEMORY or CL_ERROR_IO.
+ */
+clarity_status_t cl_baseline_record_suite(const clarity_suite_t *suite);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_BASELINE_H
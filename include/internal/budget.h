@@ -0,0 +1,88 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_BUDGET_H
+#define CLARITY_INCLUDE_INTERNAL_BUDGET_H
+
+#include <CLarity/clarity_types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "options.h"
+#include "printer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The number of past runs of a test remembered by the history.
+ */
+#define CL_HISTORY_WINDOW 64
+
+/**
+ * @brief The history file used when the command line does not name one, nor the environment.
+ */
+#define CL_HISTORY_DEFAULT_PATH "clarity-history.tsv"
+
+/**
+ * @brief What the history remembers of a test.
+ */
+typedef struct clarity_history_entry_s {
+	char     *suite;       /**< The name of the suite the test belongs to. */
+	char     *test;        /**< The name of the test. */
+	uint32_t runs;         /**< The number of runs remembered, at most `CL_HISTORY_WINDOW`. */
+	uint64_t failures;     /**< One bit per remembered run, the latest in the lowest bit, set if it failed. */
+	uint64_t duration_ns;  /**< The moving average of the duration of the test. */
+} clarity_history_entry_t;
+
+/**
+ * @brief The state of a run recording its results to a history file, and possibly limited in time.
+ *
+ * @details
+ * A history file is a text file starting with a `# CLarity history v1` header, followed by one line per
+ * test: the suite name, the test name, the number of runs, the failure bits in hexadecimal and the average
+ * duration in nanoseconds, separated by tabulations. Names are escaped like in a baseline file.
+ */
+typedef struct clarity_budget_s {
+	const char              *path;        /**< The path of the history file. */
+	uint64_t                deadline_ns;  /**< The time after which no test starts, 0 for a full run. */
+	size_t                  count;        /**< The number of entries. */
+	size_t                  sorted;       /**< The number of entries loaded, sorted by name, before the new ones. */
+	size_t                  capacity;     /**< The number of entries that fit without reallocation. */
+	clarity_history_entry_t *entries;     /**< The entries, in file order. */
+} clarity_budget_t;
+
+/**
+ * @brief Runs suites as `cl_main` does, recording the results to the history file and, when a budget is given,
+ * only running the tests most likely to fail which fit in it.
+ *
+ * @param options The options of the command line, with a budget or a history file.
+ * @param suites The suites to run.
+ * @param count The number of suites.
+ *
+ * @return The exit status of the binary.
+ */
+int cl_budget_main(const clarity_options_t *options, clarity_suite_t **suites, size_t count);
+
+/**
+ * @brief Checks whether a test must not run, and marks it as not run if the budget ran out before it started.
+ *
+ * @param budget The budget of the run.
+ * @param test The test about to start.
+ *
+ * @return true if the test must be reported without running.
+ */
+bool cl_budget_stops(const clarity_budget_t *budget, clarity_test_t *test);
+
+/**
+ * @brief Records the result of a test which ran to the history.
+ *
+ * @param budget The budget of the run.
+ * @param suite The name of the suite of the test.
+ * @param result The result of the test, ignored if it was skipped.
+ */
+void cl_budget_record(clarity_budget_t *budget, const char *suite, const clarity_test_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_BUDGET_H
@@ -0,0 +1,94 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_CLOCK_H
+#define CLARITY_INCLUDE_INTERNAL_CLOCK_H
+
+#include <CLarity/clock.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A timer of a clock.
+ */
+typedef struct clarity_clock_timer_s {
+	uint64_t                 deadline_ns; /**< When the timer is due, on the clock. */
+	uint64_t                 id;          /**< The identifier of the timer, increasing with registration. */
+	clarity_clock_timer_fn_t fn;          /**< The callback of the timer. */
+	void                     *data;       /**< The data to pass to the callback. */
+	bool                     owns_data;   /**< Whether `data` is freed once the timer ran or was dropped. */
+} clarity_clock_timer_t;
+
+struct clarity_clock_s {
+	bool                  is_virtual;     /**< Whether the clock only moves when the test waits. */
+	uint64_t              now_ns;         /**< The current time of a virtual clock. */
+	uint64_t              next_id;        /**< The identifier of the next timer. */
+	size_t                timer_count;    /**< The number of pending timers. */
+	size_t                timer_capacity; /**< The number of timers that fit without reallocation. */
+	clarity_clock_timer_t *timers;        /**< The pending timers, by deadline then identifier. */
+};
+
+/**
+ * @brief Creates a clock.
+ *
+ * @param is_virtual Whether the clock is virtual.
+ *
+ * @return The new clock, or NULL if the allocation failed.
+ */
+clarity_clock_t *cl_clock_create(bool is_virtual);
+
+/**
+ * @brief Drops the pending timers of a clock, and rewinds a virtual clock to 0, before a test starts or once it
+ * completed.
+ *
+ * @param clock The clock.
+ * @param is_virtual Whether the clock is virtual from now on.
+ */
+void cl_clock_reset(clarity_clock_t *clock, bool is_virtual);
+
+/**
+ * @brief Releases a clock and its pending timers.
+ *
+ * @param clock The clock to release, may be NULL.
+ */
+void cl_clock_free(clarity_clock_t *clock);
+
+/**
+ * @brief Registers a timer, as `cl_clock_add_timer` does.
+ *
+ * @param owns_data Whether `data` must be freed once the timer ran or was dropped, if it could be registered.
+ */
+clarity_status_t cl_clock_schedule(clarity_clock_t *clock, uint64_t delay_ns, clarity_clock_timer_fn_t fn,
+                                   void *data, bool owns_data, uint64_t *id);
+
+/**
+ * @brief Get the number of pending timers of a clock.
+ */
+size_t cl_clock_pending(const clarity_clock_t *clock);
+
+/**
+ * @brief Get the deadline of the next timer of a clock, which must have one.
+ */
+uint64_t cl_clock_next_deadline(const clarity_clock_t *clock);
+
+/**
+ * @brief Runs the timers whose deadline has been reached, including those they register.
+ *
+ * @param clock The clock.
+ */
+void cl_clock_fire_due(clarity_clock_t *clock);
+
+/**
+ * @brief Moves a virtual clock to its next deadline, and runs the timers due then.
+ *
+ * @param clock The clock.
+ */
+void cl_clock_advance(clarity_clock_t *clock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_CLOCK_H
@@ -0,0 +1,85 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_DISTRIBUTED_H
+#define CLARITY_INCLUDE_INTERNAL_DISTRIBUTED_H
+
+#include <CLarity/clarity_types.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The number of tests a worker asks for at once, unless told otherwise.
+ */
+#define CL_DISTRIBUTED_DEFAULT_BATCH 8
+
+/**
+ * @brief The number of workers a test may take down before it is reported as failed instead of rescheduled.
+ */
+#define CL_DISTRIBUTED_MAX_ATTEMPTS 3
+
+/**
+ * @brief How long a worker keeps trying to reach a coordinator that is not listening yet.
+ */
+#define CL_DISTRIBUTED_CONNECT_TIMEOUT_MS 10000
+
+/**
+ * @brief How long the coordinator waits for a result, or a new worker, before failing the tests left, unless told
+ * otherwise.
+ */
+#define CL_DISTRIBUTED_DEFAULT_TIMEOUT_S 600
+
+/**
+ * @brief The version of the protocol between a coordinator and its workers.
+ */
+#define CL_DISTRIBUTED_PROTOCOL_VERSION 1
+
+/**
+ * @brief Serves the selected tests to workers, and prints the report of the run.
+ *
+ * @details
+ * The coordinator does not run any test nor fixture itself. It listens on the address, hands the selected
+ * tests out by batches to the workers that connect, and collects their results. The tests in flight on a
+ * worker that disconnects are given to another worker, until they have taken down
+ * `CL_DISTRIBUTED_MAX_ATTEMPTS` workers, in which case they are reported as failed.
+ *
+ * Once every test has a result, the workers are released and the suites are reported in registration order,
+ * exactly like a local run would. When no result comes and no worker connects for `timeout_s` seconds, the tests
+ * without a result are reported as failed, and the workers running them are disconnected.
+ *
+ * @param address The address to listen on, see `cl_socket_listen`.
+ * @param filter The glob pattern selecting the tests to run, or NULL for all.
+ * @param timeout_s How long to wait for the workers to make progress, in seconds.
+ * @param suites The suites of the test binary.
+ * @param suite_count The number of suites.
+ *
+ * @return The exit status of the test binary: 0 if every test passed, 1 on a failure, 2 on an error.
+ */
+int cl_distributed_coordinate(const char *address, const char *filter, uint32_t timeout_s, clarity_suite_t **suites,
+                              size_t suite_count);
+
+/**
+ * @brief Runs the tests handed out by a coordinator, until it has no more.
+ *
+ * @details
+ * The worker must be the same test binary as the coordinator, as tests are identified by their position.
+ * The suite setup of a suite runs before the first test the worker receives from it, and its teardown once the
+ * coordinator releases the worker. Every test runs with `cl_run_test`, surrounded by the per-test fixtures of its
+ * suite, and its result is sent back as soon as it is known.
+ *
+ * @param address The address of the coordinator, see `cl_socket_connect`.
+ * @param batch The number of tests to ask for at once.
+ * @param suites The suites of the test binary.
+ * @param suite_count The number of suites.
+ *
+ * @return The exit status of the worker: 0 once released by the coordinator, 1 if a fixture failed or the
+ * coordinator went away, 2 if the coordinator could not be reached or rejected the worker.
+ */
+int cl_distributed_work(const char *address, uint32_t batch, clarity_suite_t **suites, size_t suite_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_DISTRIBUTED_H
@@ -0,0 +1,125 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_EVENT_LOOP_H
+#define CLARITY_INCLUDE_INTERNAL_EVENT_LOOP_H
+
+#include <CLarity/async.h>
+#include <CLarity/clarity_types.h>
+#include <CLarity/clock.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief An epoll based event loop driving asynchronous tests.
+ */
+typedef struct clarity_event_loop_s clarity_event_loop_t;
+
+/**
+ * @brief Function called by the event loop when an asynchronous test completes.
+ *
+ * The result of the test is final when this function is called, and the test is no longer referenced by the loop
+ * once it returns. It is called once the loop is out of the callbacks of the test and of its clock, so that it
+ * may free the test.
+ *
+ * @param context The context given to `cl_event_loop_create`.
+ * @param test The test that completed.
+ * @param cookie The cookie given to `cl_event_loop_submit` for this test.
+ */
+typedef void (*clarity_event_loop_complete_fn_t)(void *context, clarity_test_t *test, void *cookie);
+
+/**
+ * @brief A file descriptor watched by an asynchronous test.
+ */
+typedef struct clarity_async_watch_s {
+	int                          fd;    /**< The watched file descriptor, -1 once unwatched. */
+	clarity_async_io_fn_t        fn;    /**< The callback of the watch. */
+	void                         *data; /**< The data to pass to the callback. */
+	struct clarity_async_s       *async; /**< The test owning the watch. */
+	struct clarity_async_watch_s *next; /**< The next watch of the same test. */
+} clarity_async_watch_t;
+
+/**
+ * @brief The state of an asynchronous test in flight.
+ */
+struct clarity_async_s {
+	clarity_event_loop_t   *loop;         /**< The loop driving the test. */
+	clarity_test_t         *test;         /**< The running test. */
+	void                   *cookie;       /**< The cookie given when the test was submitted. */
+	uint64_t               start_ns;      /**< When the test started. */
+	uint64_t               deadline_ns;   /**< When the test times out. */
+	size_t                 timers;        /**< The number of timers pending, excluding the timeout. */
+	size_t                 watched;       /**< The number of file descriptors watched. */
+	clarity_async_watch_t  *watches;      /**< The file descriptors watched by the test. */
+	bool                   done;          /**< Whether the test completed. */
+	struct clarity_async_s *next_done;    /**< The next completed test waiting to be reported and released. */
+	clarity_clock_t        *clock;        /**< The clock of the test, or NULL if it never asked for one. */
+	struct clarity_async_s *next_clocked; /**< The next test of the loop with a clock. */
+};
+
+/**
+ * @brief Creates an event loop.
+ *
+ * @param max_in_flight The maximum number of tests in flight, used as a hint by the caller.
+ * @param complete The function to call when a test completes.
+ * @param context The context passed down to `complete`.
+ *
+ * @return The new loop, or NULL if the loop could not be created.
+ */
+clarity_event_loop_t *cl_event_loop_create(size_t max_in_flight, clarity_event_loop_complete_fn_t complete,
+                                           void *context);
+
+/**
+ * @brief Starts an asynchronous test on the loop.
+ *
+ * The start function of the test is called before this function returns. The test may complete right away,
+ * in which case the completion function has been called too.
+ *
+ * @param loop The loop.
+ * @param test The asynchronous test to start.
+ * @param cookie A value passed back to the completion function.
+ *
+ * @return CL_SUCCESS, or CL_ERROR_MEMORY if the test could not be started.
+ */
+clarity_status_t cl_event_loop_submit(clarity_event_loop_t *loop, clarity_test_t *test, void *cookie);
+
+/**
+ * @brief Get the number of tests currently in flight.
+ */
+size_t cl_event_loop_in_flight(const clarity_event_loop_t *loop);
+
+/**
+ * @brief Get the maximum number of tests the loop should have in flight.
+ */
+size_t cl_event_loop_capacity(const clarity_event_loop_t *loop);
+
+/**
+ * @brief Waits for the next events, and dispatches them.
+ *
+ * This dispatches one batch of file descriptor events, then every timer that expired.
+ *
+ * @param loop The loop.
+ */
+void cl_event_loop_run_once(clarity_event_loop_t *loop);
+
+/**
+ * @brief Runs the loop until no test is in flight anymore.
+ *
+ * @param loop The loop.
+ */
+void cl_event_loop_drain(clarity_event_loop_t *loop);
+
+/**
+ * @brief Releases a loop, which must not have any test in flight.
+ *
+ * @param loop The loop to release, may be NULL.
+ */
+void cl_event_loop_free(clarity_event_loop_t *loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_EVENT_LOOP_H
@@ -0,0 +1,34 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_FILES_H
+#define CLARITY_INCLUDE_INTERNAL_FILES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Creates a directory and its missing parents.
+ *
+ * @param path The directory, modified during the call but restored before returning.
+ *
+ * @return true if the directory exists afterwards.
+ */
+bool cl_files_make_directory(char *path);
+
+/**
+ * @brief Replaces the content of a file with a header followed by data.
+ *
+ * The content is written to a temporary file renamed over `path`, so that a concurrent reader only ever sees
+ * a complete file.
+ *
+ * @return true if the file has been replaced.
+ */
+bool cl_files_replace(const char *path, const void *header, size_t header_size, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_FILES_H
@@ -0,0 +1,30 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_ISOLATION_H
+#define CLARITY_INCLUDE_INTERNAL_ISOLATION_H
+
+#include <stdbool.h>
+#include "runner.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Runs the selected tests of an isolated suite in processes forked from the current state.
+ *
+ * The suite setup must already have run. Every child runs a batch of tests with their per-test fixtures, and the
+ * parent reports the results as they come back.
+ *
+ * @param run The current run.
+ *
+ * @return false if a per-test fixture reported an error or no child could be started, in which case the run
+ * must be aborted.
+ *
+ * @see cl_suite_set_isolation
+ */
+bool cl_isolation_run_tests(clarity_run_t *run);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_ISOLATION_H
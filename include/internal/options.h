@@ -0,0 +1,58 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_OPTIONS_H
+#define CLARITY_INCLUDE_INTERNAL_OPTIONS_H
+
+#include <CLarity/stress.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The options given on the command line of a test binary.
+ *
+ * @see cl_main
+ */
+typedef struct clarity_options_s {
+	const char               *filter; /**< The glob pattern selecting the tests to run, or NULL for all. */
+	bool                     stress;  /**< Whether the selected tests must be repeated instead of run once. */
+	clarity_stress_options_t stress_options; /**< How to repeat the selected tests. */
+	const char               *coordinator; /**< The address to serve the selected tests on, or NULL. */
+	const char               *worker;  /**< The address of the coordinator to run tests for, or NULL. */
+	uint32_t                 batch;   /**< The number of tests a worker asks for at once. */
+	uint32_t                 worker_timeout_s; /**< How long the coordinator waits for the workers to progress. */
+	const char               *serve;  /**< The address to serve requests from clients on, or NULL. */
+	uint64_t                 budget_ms; /**< The time budget of the run in milliseconds, 0 for a full run. */
+	const char               *history; /**< The history file given on the command line, or NULL. */
+	const char               *trace;  /**< The file to write the timeline of the run to, or NULL. */
+	size_t                   max_failures; /**< The failures after which the run stops, 0 for no limit. */
+	bool                     help;    /**< Whether the usage has been requested. */
+} clarity_options_t;
+
+/**
+ * @brief Parses the command line of a test binary.
+ *
+ * @param options Receives the options.
+ * @param argc The number of arguments.
+ * @param argv The arguments, the first one being the name of the program.
+ *
+ * @return true on success, false if an argument is invalid, after printing why to standard error.
+ */
+bool cl_options_parse(clarity_options_t *options, int argc, char **argv);
+
+/**
+ * @brief Prints the usage of a test binary.
+ *
+ * @param stream The stream to print to.
+ * @param program The name of the program.
+ */
+void cl_options_usage(FILE *stream, const char *program);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_OPTIONS_H
@@ -0,0 +1,30 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_PARALLEL_H
+#define CLARITY_INCLUDE_INTERNAL_PARALLEL_H
+
+#include <stdbool.h>
+#include "runner.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Runs the selected tests of a suite on a pool of threads, within the capacities of their resources.
+ *
+ * The suite setup must already have run. The threads run the tests with their per-test fixtures, and the calling
+ * thread reports the results as they come back. The asynchronous tests are started once the pool is done.
+ *
+ * @param run The current run.
+ *
+ * @return false if a per-test fixture reported an error or no thread could be started, in which case the run
+ * must be aborted.
+ *
+ * @see cl_suite_set_jobs
+ */
+bool cl_parallel_run_tests(clarity_run_t *run);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_PARALLEL_H
@@ -9,6 +9,8 @@ extern "C" {
 #include <stdlib.h>
 #include <stdbool.h>
 
+struct clarity_stream_s;
+
 /**
 * @brief Represents the result of running a single test.
 */
@@ -45,12 +47,34 @@ typedef struct clarity_test_result_s {
      */
 	bool skipped;
 
+	/**
+	 * @brief Indicates if the test was not run at all, because it did not fit in the time budget of the run, or
+	 * because its suite stopped after too many crashes.
+	 *
+	 * A test which was not run is also skipped.
+	 */
+	bool not_run;
+
 	/**
 	 * @brief If the test failed, this contains the error message.
 	 *
 	 * If the test passed, this should be `NULL`.
 	 */
 	const char *error_message;
+
+	/**
+	 * @brief The wall-clock time spent running the test function, in nanoseconds.
+	 *
+	 * For benchmarks, this is the total time spent taking all the samples.
+	 */
+	uint64_t duration_ns;
+
+	/**
+	 * @brief The time the test waited for its resources once a thread was free to run it, in nanoseconds.
+	 *
+	 * @see cl_suite_set_jobs
+	 */
+	uint64_t resource_wait_ns;
 } clarity_test_result_t;
 
 /**
@@ -70,8 +94,31 @@ typedef struct clarity_suite_report_s {
 	uint32_t   failed_tests;    /**< The number of failed tests in the suite. */
 	uint32_t   skipped_tests;   /**< The number of skipped tests in the suite. */
 	uint32_t   succeeded_tests; /**< The number of succeeded tests in the suite. */
+	uint32_t   not_run_tests;   /**< The number of tests which were not run, not counted as skipped. */
 } clarity_suite_report_t;
 
+/**
+ * @brief Structure representing the report of a stress run of one test.
+ *
+ * @note
+ * This struct is intended for internal use and should not be exposed to end-users.
+ */
+typedef struct clarity_stress_report_s {
+	const char *suite;                  /**< The name of the suite of the test. */
+	const char *name;                   /**< The name of the test. */
+	uint32_t   concurrency;             /**< The number of copies run in every iteration. */
+	uint64_t   iterations;              /**< The number of iterations run. */
+	uint64_t   runs;                    /**< The number of runs of the test, over all iterations and copies. */
+	uint64_t   failures;                /**< The number of failed runs. */
+	uint64_t   skips;                   /**< The number of skipped runs. */
+	uint64_t   duration_ns;             /**< The time spent in the stress run. */
+	uint64_t   first_failed_iteration;  /**< The iteration of the first failure, counting from 1, or 0 if none. */
+	uint32_t   first_failed_copy;       /**< The copy that failed first in that iteration. */
+	const char *first_error_message;    /**< The message of the first failure. */
+	const char *first_file_name;        /**< The file of the first failure. */
+	size_t     first_line_number;       /**< The line of the first failure. */
+} clarity_stress_report_t;
+
 /**
  * @brief Prints the result of a single test to standard output.
  *
@@ -135,6 +182,40 @@ void cl_print_suite_name(const char *name);
  */
 void cl_print_suite_report(clarity_suite_report_t *report);
 
+/**
+ * @brief Prints the report of a stress run.
+ *
+ * @details
+ * The report gives the number of iterations and runs, the failure rate, and describes the first failure.
+ *
+ * @param report The report to print.
+ *
+ * @note This function is intended for internal use only.
+ */
+void cl_print_stress_report(const clarity_stress_report_t *report);
+
+/**
+ * @brief Prints the summary of a streaming run: the slowest tests and the failures kept.
+ *
+ * @details
+ * Failures that did not fit in the bounded buffer of the run are only counted, as "+N more".
+ *
+ * @param stream The interesting results of the run, sorted with `cl_stream_finish`.
+ *
+ * @note This function is intended for internal use only.
+ */
+void cl_print_stream_summary(const struct clarity_stream_s *stream);
+
+/**
+ * @brief Prints why a run stopped early and how many tests it did not run.
+ *
+ * @param failures The number of failures which stopped the run, its limit.
+ * @param not_run The number of tests which were not run since, in all the suites.
+ *
+ * @note This function is intended for internal use only.
+ */
+void cl_print_cancellation(size_t failures, size_t not_run);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,45 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_PROTOCOL_H
+#define CLARITY_INCLUDE_INTERNAL_PROTOCOL_H
+
+#include "printer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The version of the protocol between a test binary and `cl_driver_main`.
+ */
+#define CL_PROTOCOL_VERSION 1
+
+/**
+ * @brief Reports the start of a suite to the driver, if the binary was started by one.
+ *
+ * @details
+ * A test binary started by `cl_driver_main` finds the descriptor to report on in `CL_PROTOCOL_FD_ENV`. The
+ * protocol is made of `wire.h` messages, written as the run prints them: `HELLO <version>` before anything else,
+ * `SUITE <name>` when a suite starts, `RESULT <result>` for every test printed, and
+ * `END <name> <total> <succeeded> <failed> <skipped> <not run>` with the report of the suite. A nested suite is
+ * reported between the `SUITE` and the `END` of its parent, whose report includes it.
+ *
+ * Only the process which found the descriptor reports on it, the processes it forks stay quiet.
+ *
+ * @param name The name of the suite.
+ */
+void cl_protocol_suite(const char *name);
+
+/**
+ * @brief Reports the result of a test to the driver, if the binary was started by one.
+ */
+void cl_protocol_result(const clarity_test_result_t *result);
+
+/**
+ * @brief Reports the end of a suite, with its report, to the driver, if the binary was started by one.
+ */
+void cl_protocol_end(const clarity_suite_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_PROTOCOL_H
@@ -0,0 +1,31 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_RECOVERY_H
+#define CLARITY_INCLUDE_INTERNAL_RECOVERY_H
+
+#include <CLarity/clarity_types.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Runs a test as `cl_run_test` does, recovering from the signals raised if the test function crashes.
+ *
+ * The signal handlers are installed on first use, for the whole process, and run on an alternate stack set up
+ * for each thread running tests. Outside of this function, the handlers give the signals back to the handlers
+ * they replaced.
+ *
+ * @param test The test to run.
+ *
+ * @return true if the test crashed, in which case its result is a failure naming the signal, at the last point
+ * marked by the test.
+ *
+ * @see cl_suite_set_crash_recovery
+ */
+bool cl_recovery_run_test(clarity_test_t *test);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_RECOVERY_H
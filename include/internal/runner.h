@@ -0,0 +1,161 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_RUNNER_H
+#define CLARITY_INCLUDE_INTERNAL_RUNNER_H
+
+#include <CLarity/clarity_types.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "baseline.h"
+#include "event_loop.h"
+#include "printer.h"
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The state of one execution of a suite.
+ *
+ * A run is created by `cl_run_suite` and lives until the suite report has been printed.
+ */
+typedef struct clarity_run_s {
+	clarity_suite_t        *suite;    /**< The suite being run. */
+	const char             *filter;   /**< The glob pattern selecting the tests to run, or NULL for all. */
+	clarity_suite_report_t report;    /**< The counters of the run. */
+	clarity_baseline_t     *baseline; /**< The baseline to compare against, or NULL. */
+	clarity_stream_t       *stream;   /**< The interesting results of a streaming run, or NULL. */
+	clarity_event_loop_t   *loop;     /**< The loop driving the asynchronous tests, created on first use. */
+	bool                   aborted;   /**< Whether a fixture of an asynchronous test reported an error. */
+	struct clarity_budget_s *budget;  /**< The time budget and history of the run, or NULL. */
+	atomic_size_t          crashes;   /**< The number of tests which crashed and were recovered from. */
+} clarity_run_t;
+
+/**
+ * @brief Runs a suite, restricted to the tests matching a filter.
+ *
+ * This is `cl_run_suite`, with the test selection of the command line. A suite without any matching test
+ * is not run at all, its fixtures are not called and it is not printed.
+ *
+ * @param suite The suite to run.
+ * @param filter The glob pattern selecting the tests to run, or NULL for all.
+ *
+ * @return true if all the selected tests passed, false otherwise.
+ */
+bool cl_runner_run_suite(clarity_suite_t *suite, const char *filter);
+
+/**
+ * @brief Runs suites, each after the suites it depends on, restricted to the tests matching a filter.
+ *
+ * @param suites The suites to run.
+ * @param count The number of suites.
+ * @param filter The glob pattern selecting the tests to run, or NULL for all.
+ * @param budget The time budget and history of the run, or NULL.
+ *
+ * @return true if all the selected tests passed or were skipped, false otherwise.
+ */
+bool cl_runner_run_suites(clarity_suite_t **suites, size_t count, const char *filter,
+                          struct clarity_budget_s *budget);
+
+/**
+ * @brief Checks whether a test is selected by a filter.
+ *
+ * @param pattern The glob pattern, matched against the test name and against `suite/test`, or NULL.
+ * @param suite_name The name of the suite of the test.
+ * @param test_name The name of the test.
+ *
+ * @return true if the pattern is NULL or matches the test.
+ */
+bool cl_runner_matches(const char *pattern, const char *suite_name, const char *test_name);
+
+/**
+ * @brief Runs the per-test fixture setups of the suite, before a test.
+ *
+ * @param run The current run.
+ *
+ * @return false if a fixture reported an error, in which case the run must be aborted.
+ */
+bool cl_runner_setup_test(clarity_run_t *run);
+
+/**
+ * @brief Finalises the result of a test, and runs the per-test fixture teardowns of the suite.
+ *
+ * The result is compared against the baseline of the run, if any.
+ *
+ * @param run The current run.
+ * @param test The test that has been run.
+ * @param result Receives the final result of the test.
+ *
+ * @return false if a fixture reported an error, in which case the run must be aborted.
+ */
+bool cl_runner_finish_test(clarity_run_t *run, clarity_test_t *test, clarity_test_result_t *result);
+
+/**
+ * @brief Runs one test of a suite, surrounded by the per-test fixtures of the suite.
+ *
+ * The result is compared against the baseline of the run, if any.
+ *
+ * @param run The current run.
+ * @param test The test to run.
+ * @param result Receives the result of the test, failed if a per-test setup reported an error.
+ *
+ * @return false if a fixture reported an error, in which case the run must be aborted.
+ */
+bool cl_runner_run_test(clarity_run_t *run, clarity_test_t *test, clarity_test_result_t *result);
+
+/**
+ * @brief Runs a test of the suite and reports it, or starts it if it is asynchronous.
+ *
+ * @param run The current run.
+ * @param test The test to run.
+ * @param slot The slot of the test in the suite, or NULL if the test is owned by the run.
+ *
+ * @return false if the run must be aborted.
+ */
+bool cl_runner_execute(clarity_run_t *run, clarity_test_t *test, clarity_test_t **slot);
+
+/**
+ * @brief Checks whether a test must be reported as not run, because it was left out of the time budget, the
+ * budget ran out before it could start, or its suite stopped after too many crashes.
+ */
+bool cl_runner_unscheduled(clarity_run_t *run, clarity_test_t *test);
+
+/**
+ * @brief Runs a test after its pending prerequisites, or skips it if one of them did not pass.
+ *
+ * @param run The current run.
+ * @param test The test to run.
+ * @param slot The slot of the test in the suite, or NULL if the test is owned by the run.
+ *
+ * @return false if the run must be aborted.
+ *
+ * @see cl_test_depends_on
+ */
+bool cl_runner_execute_in_order(clarity_run_t *run, clarity_test_t *test, clarity_test_t **slot);
+
+/**
+ * @brief Reports the result of a test: prints it and updates the counters of the run.
+ *
+ * In a streaming run, passing tests are not printed and interesting results are copied,
+ * so the test can be released as soon as this function returns.
+ *
+ * @param run The current run.
+ * @param result The result to report.
+ */
+void cl_runner_report_test(clarity_run_t *run, const clarity_test_result_t *result);
+
+/**
+ * @brief Releases a test once it has been reported, if the run owns it.
+ *
+ * Generated tests are always released, tests of the suite only in a streaming run.
+ *
+ * @param run The current run.
+ * @param test The test that has been reported.
+ * @param slot The slot of the test in the suite, or NULL for a generated test.
+ */
+void cl_runner_release_test(clarity_run_t *run, clarity_test_t *test, clarity_test_t **slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_RUNNER_H
@@ -0,0 +1,40 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_SERVER_H
+#define CLARITY_INCLUDE_INTERNAL_SERVER_H
+
+#include <CLarity/clarity_types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief How long the client keeps trying to reach a server that is still starting.
+ */
+#define CL_SERVER_CONNECT_TIMEOUT_MS 2000
+
+/**
+ * @brief Keeps the suites set up, and runs the tests requested by clients until told to stop.
+ *
+ * @details
+ * The suite setups all run once, before the server starts listening. Clients are then served one at a time:
+ * each request runs the tests matching a filter, surrounded by the per-test fixtures of their suite, and
+ * streams their results back. A stop request runs the suite teardowns and returns.
+ *
+ * The protocol is made of `wire.h` messages. A client sends `RUN <filter>`, an empty filter selecting every
+ * test, or `STOP`. The server answers `SUITE <name>` before the first selected test of a suite, `RESULT <result>`
+ * for every test, `END` after the last test of a suite, and `DONE` once the request is complete.
+ *
+ * @param address The address to listen on, see `cl_socket_listen`.
+ * @param suites The suites of the test binary.
+ * @param suite_count The number of suites.
+ *
+ * @return The exit status of the test binary: 0 once stopped, 1 if a suite teardown failed, 2 on an error.
+ */
+int cl_server_serve(const char *address, clarity_suite_t **suites, size_t suite_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_SERVER_H
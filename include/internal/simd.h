@@ -0,0 +1,68 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_SIMD_H
+#define CLARITY_INCLUDE_INTERNAL_SIMD_H
+
+#include <CLarity/assertions.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The instruction sets the comparison kernels can use.
+ */
+typedef enum clarity_simd_level_e {
+	CL_SIMD_SCALAR,
+	CL_SIMD_SSE2,
+	CL_SIMD_AVX2,
+} clarity_simd_level_t;
+
+/**
+ * @brief The instruction set used by the comparison kernels.
+ *
+ * This is the best one supported by the processor, capped by `CLARITY_SIMD`, detected on first use.
+ */
+clarity_simd_level_t cl_simd_level(void);
+
+/**
+ * @brief Finds the first byte differing between two buffers.
+ *
+ * @return The offset of the first difference, or `size` if the buffers are equal.
+ */
+size_t cl_simd_mismatch_bytes(const unsigned char *a, const unsigned char *b, size_t size);
+
+/**
+ * @brief Counts the bytes differing between two buffers.
+ */
+size_t cl_simd_count_bytes(const unsigned char *a, const unsigned char *b, size_t size);
+
+/**
+ * @brief Finds the first pair of floats which are not equal, nor within an absolute or relative tolerance.
+ *
+ * This is a fast filter: the elements it stops at must still be checked against the full tolerance.
+ *
+ * @return The index of the first such pair, or `count` if there is none.
+ */
+size_t cl_simd_mismatch_floats(const float *a, const float *b, size_t count, float absolute, float relative);
+
+/**
+ * @brief Finds the first pair of doubles which are not equal, nor within an absolute or relative tolerance.
+ *
+ * @see cl_simd_mismatch_floats
+ */
+size_t cl_simd_mismatch_doubles(const double *a, const double *b, size_t count, double absolute, double relative);
+
+/**
+ * @brief Hashes a buffer at memory bandwidth.
+ *
+ * The buffer is consumed by four independent lanes of 64 bits, following the structure of XXH64, so that the
+ * processor overlaps their multiplications. The hash is stable across runs, processors and SIMD levels.
+ */
+uint64_t cl_simd_hash(const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_SIMD_H
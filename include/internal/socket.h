@@ -0,0 +1,42 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_SOCKET_H
+#define CLARITY_INCLUDE_INTERNAL_SOCKET_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opens a listening socket.
+ *
+ * @param address `unix:PATH` for a Unix socket, or `tcp:HOST:PORT` (or `HOST:PORT`) for a TCP socket.
+ * An empty host listens on every interface. An existing Unix socket file is replaced.
+ *
+ * @return The socket, or -1 on error, after printing why to standard error.
+ */
+int cl_socket_listen(const char *address);
+
+/**
+ * @brief Connects to a listening socket.
+ *
+ * @param address The address, in the format of `cl_socket_listen`.
+ * @param timeout_ms How long to retry while nobody listens on the address yet.
+ *
+ * @return The socket, or -1 on error, after printing why to standard error.
+ */
+int cl_socket_connect(const char *address, unsigned timeout_ms);
+
+/**
+ * @brief Closes a socket opened by `cl_socket_listen`, and removes its file if it is a Unix socket.
+ *
+ * @param fd The socket.
+ * @param address The address given to `cl_socket_listen`.
+ */
+void cl_socket_close_listener(int fd, const char *address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_SOCKET_H
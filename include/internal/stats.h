@@ -0,0 +1,70 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_STATS_H
+#define CLARITY_INCLUDE_INTERNAL_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Summary of a distribution of timing samples.
+ *
+ * All values are expressed in nanoseconds.
+ */
+typedef struct clarity_sample_summary_s {
+	size_t count;  /**< The number of samples. */
+	double min;    /**< The smallest sample. */
+	double median; /**< The median of the samples. */
+	double p90;    /**< The 90th percentile of the samples. */
+	double max;    /**< The largest sample. */
+	double mean;   /**< The arithmetic mean of the samples. */
+} clarity_sample_summary_t;
+
+/**
+ * @brief Computes the summary of a set of samples.
+ *
+ * @param samples The samples to summarise, they are not modified.
+ * @param count The number of samples.
+ *
+ * @return The summary of the samples, with all fields set to zero if `count` is zero.
+ */
+clarity_sample_summary_t cl_stats_summarise(const uint64_t *samples, size_t count);
+
+/**
+ * @brief Formats a summary as `n=.. min=.. median=.. p90=.. max=..`.
+ *
+ * @param summary The summary to format.
+ * @param buffer The buffer receiving the text.
+ * @param size The size of `buffer`.
+ *
+ * @return `buffer`, for convenience.
+ */
+char *cl_stats_format_summary(const clarity_sample_summary_t *summary, char *buffer, size_t size);
+
+/**
+ * @brief Runs a one-sided Mann-Whitney U test.
+ *
+ * @details
+ * Tests the hypothesis that the samples in `current` tend to be larger than the ones in `baseline`.
+ * Ties are given their average rank, and the p-value is computed with the tie-corrected normal
+ * approximation of the U distribution, including a continuity correction.
+ *
+ * @param baseline The reference samples.
+ * @param n_baseline The number of reference samples.
+ * @param current The samples to compare against the reference.
+ * @param n_current The number of samples to compare.
+ * @param u Receives the U statistic of `current`, may be NULL.
+ *
+ * @return The one-sided p-value, or 1 if the test could not be run (empty or allocation failure).
+ */
+double cl_stats_mann_whitney(const uint64_t *baseline, size_t n_baseline, const uint64_t *current, size_t n_current,
+                             double *u);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_STATS_H
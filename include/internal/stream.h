@@ -0,0 +1,81 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_STREAM_H
+#define CLARITY_INCLUDE_INTERNAL_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "printer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A copy of a test result kept after the test itself has been released.
+ *
+ * All the strings are owned by the entry.
+ */
+typedef struct clarity_stream_entry_s {
+	char     *name;          /**< The name of the test. */
+	char     *file_name;     /**< The file of the last mark point, may be NULL. */
+	char     *error_message; /**< The failure message, may be NULL. */
+	size_t   line_number;    /**< The line of the last mark point. */
+	uint64_t duration_ns;    /**< The duration of the test. */
+} clarity_stream_entry_t;
+
+/**
+ * @brief The bounded set of "interesting" results kept by a streaming run.
+ *
+ * @details
+ * A streaming run does not keep the tests it has reported. Instead, the first `max_failures` failures
+ * and the `max_slowest` slowest tests are copied here, so that memory use does not depend on the number
+ * of tests in the suite. Failures beyond the limit are only counted.
+ */
+typedef struct clarity_stream_s {
+	size_t                 max_failures;     /**< The maximum number of failures kept. */
+	size_t                 failure_count;    /**< The number of failures kept. */
+	size_t                 dropped_failures; /**< The number of failures that did not fit. */
+	clarity_stream_entry_t *failures;        /**< The failures kept, in report order. */
+
+	size_t                 max_slowest;   /**< The maximum number of slow tests kept. */
+	size_t                 slowest_count; /**< The number of slow tests kept. */
+	clarity_stream_entry_t *slowest;      /**< A min-heap on the duration of the slowest tests. */
+} clarity_stream_t;
+
+/**
+ * @brief Creates the aggregator of a streaming run.
+ *
+ * @param max_failures The maximum number of failures to keep.
+ * @param max_slowest The maximum number of slow tests to keep.
+ *
+ * @return The new aggregator, or NULL if the allocation failed.
+ */
+clarity_stream_t *cl_stream_create(size_t max_failures, size_t max_slowest);
+
+/**
+ * @brief Keeps a copy of a result if it is interesting.
+ *
+ * @param stream The aggregator.
+ * @param result The result to consider, it is not referenced after the call.
+ */
+void cl_stream_record(clarity_stream_t *stream, const clarity_test_result_t *result);
+
+/**
+ * @brief Sorts the slowest tests by decreasing duration, for printing.
+ *
+ * @param stream The aggregator. No result must be recorded after this call.
+ */
+void cl_stream_finish(clarity_stream_t *stream);
+
+/**
+ * @brief Releases an aggregator and all the entries it holds.
+ *
+ * @param stream The aggregator to release, may be NULL.
+ */
+void cl_stream_free(clarity_stream_t *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_STREAM_H
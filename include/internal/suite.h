@@ -4,6 +4,8 @@
 #include <CLarity/clarity.h>
 #include <CLarity/suite.h>
 #include <CLarity/clarity_types.h>
+#include <CLarity/benchmark.h>
+#include "test.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -67,6 +69,175 @@ struct clarity_suite_s {
 	 * Multiple fixtures groups can be added to a suite, but each fixtures group can only have one setup and one teardown function.
 	 */
 	clarity_fixture_t **fixtures;
+
+	/**
+	 * @brief The path of the baseline file of the suite, or NULL if the suite has none.
+	 *
+	 * @see cl_suite_set_baseline
+	 */
+	const char *baseline_path;
+
+	/**
+	 * @brief What to do with the baseline file when the suite is run.
+	 */
+	clarity_baseline_mode_t baseline_mode;
+
+	/**
+	 * @brief The significance level used to report a test as slower than its baseline.
+	 */
+	double regression_alpha;
+
+	/**
+	 * @brief The minimum relative increase of the median duration reported as a regression.
+	 */
+	double regression_min_effect;
+
+	/**
+	 * @brief The generator creating tests on demand, or NULL if the suite has none.
+	 *
+	 * @see cl_suite_set_generator
+	 */
+	clarity_test_generator_fn_t generator;
+
+	/**
+	 * @brief The data to pass to the generator.
+	 */
+	void *generator_data;
+
+	/**
+	 * @brief The number of tests the generator creates.
+	 */
+	size_t generated_count;
+
+	/**
+	 * @brief Whether tests are released as soon as they are reported.
+	 *
+	 * @see cl_suite_set_streaming
+	 */
+	bool streaming;
+
+	/**
+	 * @brief The maximum number of failures kept for the summary of a streaming run.
+	 */
+	size_t stream_max_failures;
+
+	/**
+	 * @brief The number of slowest tests listed in the summary of a streaming run.
+	 */
+	size_t stream_max_slowest;
+
+	/**
+	 * @brief The maximum number of asynchronous tests of the suite in flight at the same time.
+	 *
+	 * @see cl_suite_set_async_concurrency
+	 */
+	size_t async_concurrency;
+
+	/**
+	 * @brief Whether the tests run in processes forked from the suite once it is set up.
+	 *
+	 * @see cl_suite_set_isolation
+	 */
+	bool isolated;
+
+	/**
+	 * @brief The number of tests run by each forked process.
+	 */
+	size_t isolation_batch;
+
+	/**
+	 * @brief The maximum number of forked processes running at the same time, 0 for the number of cores.
+	 */
+	size_t isolation_children;
+
+	/**
+	 * @brief The time a forked process may stay silent before it is killed, in milliseconds.
+	 *
+	 * @see cl_suite_set_isolation_timeout
+	 */
+	uint32_t isolation_timeout_ms;
+
+	/**
+	 * @brief Whether the tests which crash are recovered from, in the test process.
+	 *
+	 * @see cl_suite_set_crash_recovery
+	 */
+	bool crash_recovery;
+
+	/**
+	 * @brief The number of crashes after which the remaining tests of the suite are not run.
+	 */
+	size_t max_crashes;
+
+	/**
+	 * @brief The number of tests running at the same time, 0 for the number of cores.
+	 *
+	 * @see cl_suite_set_jobs
+	 */
+	size_t jobs;
+
+	/**
+	 * @brief The capacities of the resources declared by the suite.
+	 *
+	 * @see cl_suite_add_resource
+	 */
+	clarity_resource_need_t *resources;
+
+	/**
+	 * @brief The number of entries in `resources`.
+	 */
+	size_t resource_count;
+
+	/**
+	 * @brief The resources needed by every test of the suite.
+	 *
+	 * @see cl_suite_require
+	 */
+	clarity_resource_need_t *needs;
+
+	/**
+	 * @brief The number of entries in `needs`.
+	 */
+	size_t need_count;
+
+	/**
+	 * @brief The suites which must pass before this one runs.
+	 *
+	 * @see cl_suite_depends_on
+	 */
+	clarity_suite_t **prerequisites;
+
+	/**
+	 * @brief The number of entries in `prerequisites`.
+	 */
+	size_t prerequisite_count;
+
+	/**
+	 * @brief The last traversal of the dependencies which visited the suite, to detect cycles.
+	 */
+	uint64_t visit;
+
+	/**
+	 * @brief The outcome of the last run of the suite, for its dependents.
+	 */
+	clarity_outcome_t outcome;
+
+	/**
+	 * @brief The suite this one is nested in, or NULL for a root suite.
+	 *
+	 * @see cl_suite_add_child
+	 */
+	clarity_suite_t *parent;
+
+	/**
+	 * @brief The suites nested in this one, run after its own tests.
+	 */
+	clarity_suite_t **children;
+
+	/**
+	 * @brief The number of entries in `children`.
+	 */
+	size_t child_count;
 };
 
 /**
@@ -2,12 +2,57 @@
 #define CLARITY_INCLUDE_INTERNAL_TEST_H
 
 #include <CLarity/clarity_types.h>
+#include <CLarity/async.h>
+#include <CLarity/clock.h>
+#include <CLarity/parallel.h>
+#include <stdatomic.h>
+#include "arena.h"
 #include "printer.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief An amount of a named resource, needed by a test or declared as the capacity of a suite.
+ */
+typedef struct clarity_resource_need_s {
+	const char *name;   /**< The name of the resource. */
+	uint64_t   amount;  /**< The amount, CL_RESOURCE_ALL for all of it. */
+} clarity_resource_need_t;
+
+/**
+ * @brief A failed expectation, kept by its test until the run of the test completes.
+ */
+typedef struct clarity_expectation_s {
+	struct clarity_expectation_s *next;
+	const char                   *file;
+	size_t                       line;
+	char                         message[];
+} clarity_expectation_t;
+
+/**
+ * @brief The failed expectations of a running test, oldest first.
+ */
+typedef struct clarity_expectation_log_s {
+	clarity_expectation_t *first;
+	clarity_expectation_t *last;
+	size_t                count;   /**< The number of expectations kept. */
+	size_t                dropped; /**< The number of expectations failed once the log was full. */
+	size_t                max;     /**< The number of expectations kept at most, 0 for the default. */
+} clarity_expectation_log_t;
+
+/**
+ * @brief Where a test or a suite stands with respect to its dependents.
+ */
+typedef enum clarity_outcome_e {
+	CL_OUTCOME_NONE,       /**< Not part of the current run, it does not hold its dependents back. */
+	CL_OUTCOME_PENDING,    /**< Selected by the current run, not started yet. */
+	CL_OUTCOME_RUNNING,    /**< Started and not reported yet. */
+	CL_OUTCOME_PASSED,     /**< Passed, its dependents may run. */
+	CL_OUTCOME_NOT_PASSED, /**< Failed or skipped, its dependents are skipped. */
+} clarity_outcome_t;
+
 /**
  * @brief Structure representing a test.
  *
@@ -57,6 +102,127 @@ struct clarity_test_s {
      * `clarity_test_result_t` struct returned by `cl_run_test()`, but should not modify any fields of this struct directly.
      */
 	clarity_test_result_t result;
+
+	/**
+	 * @brief The number of samples to take when the test is a benchmark.
+	 *
+	 * Ordinary tests have this field set to 0, and are executed only once.
+	 *
+	 * @see cl_create_benchmark
+	 */
+	uint32_t samples;
+
+	/**
+	 * @brief The duration of each execution of a benchmark, in nanoseconds.
+	 *
+	 * This array has room for `samples` values, and is NULL for ordinary tests.
+	 */
+	uint64_t *sample_ns;
+
+	/**
+	 * @brief The number of valid values in `sample_ns`.
+	 */
+	size_t sample_count;
+
+	/**
+	 * @brief A message built by the framework and owned by the test, if any.
+	 *
+	 * When set, `result.error_message` points to it. It is released by `cl_free_test`.
+	 */
+	char *owned_message;
+
+	/**
+	 * @brief The function starting the test, if it is an asynchronous test.
+	 *
+	 * Asynchronous tests have a NULL `test_fn`, and are driven by an event loop.
+	 *
+	 * @see cl_create_async_test
+	 */
+	clarity_async_test_fn_t async_fn;
+
+	/**
+	 * @brief The time an asynchronous test may take before being failed, in milliseconds.
+	 */
+	uint32_t timeout_ms;
+
+	/**
+	 * @brief The resources the test needs while it runs.
+	 *
+	 * @see cl_test_require
+	 */
+	clarity_resource_need_t *needs;
+
+	/**
+	 * @brief The number of entries in `needs`.
+	 */
+	size_t need_count;
+
+	/**
+	 * @brief The tests which must pass before this one runs.
+	 *
+	 * @see cl_test_depends_on
+	 */
+	clarity_test_t **prerequisites;
+
+	/**
+	 * @brief The number of entries in `prerequisites`.
+	 */
+	size_t prerequisite_count;
+
+	/**
+	 * @brief The number of tests depending on this one, which keep it alive in a streaming run.
+	 */
+	size_t dependent_count;
+
+	/**
+	 * @brief The outcome of the test in the current or last run, for its dependents.
+	 */
+	clarity_outcome_t outcome;
+
+	/**
+	 * @brief The last traversal of the dependencies which visited the test, to detect cycles.
+	 */
+	uint64_t visit;
+
+	/**
+	 * @brief Whether the test runs on a virtual clock.
+	 *
+	 * @see cl_test_use_virtual_time
+	 */
+	bool virtual_time;
+
+	/**
+	 * @brief The clock of the test, created on first use.
+	 */
+	clarity_clock_t *clock;
+
+	/**
+	 * @brief The scratch memory and the cleanups of the running test.
+	 *
+	 * @see cl_test_alloc
+	 */
+	clarity_arena_t arena;
+
+	/**
+	 * @brief The function freeing the user data with the test, or NULL if the test does not own its data.
+	 *
+	 * @see cl_test_own_data
+	 */
+	clarity_cleanup_fn_t free_data;
+
+	/**
+	 * @brief Serializes the failures recorded from several threads.
+	 *
+	 * @see cl_test_record
+	 */
+	atomic_flag result_lock;
+
+	/**
+	 * @brief The failed expectations of the running test, reported together once it completes.
+	 *
+	 * @see cl_test_flush_expectations
+	 */
+	clarity_expectation_log_t expectations;
 };
 
 /**
@@ -74,6 +240,140 @@ struct clarity_test_s {
  */
 clarity_test_result_t cl_run_test(clarity_test_t *test);
 
+/**
+ * @brief Resets the result of a test, so that it can be run again.
+ *
+ * @param test The test to reset.
+ */
+void cl_test_reset_result(clarity_test_t *test);
+
+/**
+ * @brief Creates an independent copy of a test, with a fresh result.
+ *
+ * The copy shares the name and the data of the original test, and must be freed with `cl_free_test`.
+ *
+ * @param test The test to copy.
+ *
+ * @return The copy, or NULL if the allocation failed.
+ */
+clarity_test_t *cl_test_clone(const clarity_test_t *test);
+
+/**
+ * @brief Get the timing samples of the last run of a test.
+ *
+ * Benchmarks have one sample per execution, ordinary tests have a single sample: their duration.
+ *
+ * @param test The test to get the samples from.
+ * @param count Receives the number of samples.
+ *
+ * @return A pointer to the samples, in nanoseconds, owned by the test.
+ */
+const uint64_t *cl_test_samples(const clarity_test_t *test, size_t *count);
+
+/**
+ * @brief Formats a message owned by the test and makes it the result message.
+ *
+ * This is used by the framework to report failures whose message is built at run time.
+ * The previous owned message, if any, is released.
+ *
+ * @param test The test to set the message of.
+ * @param format A `printf`-like format string.
+ *
+ * @return true if the message has been set, false if the allocation failed.
+ */
+bool cl_test_set_message(clarity_test_t *test, const char *format, ...)
+	__attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Records a failure or a skip of a test, safely from any thread.
+ *
+ * The point, the outcome and the message are recorded together, under the lock of the result, so threads
+ * failing the same test at once never mix the message of one with the point of another.
+ *
+ * @param test The test.
+ * @param file The file of the failure, or NULL for the point marked last by the calling thread, if any.
+ * @param line The line of the failure.
+ * @param skipped Whether the test is skipped rather than failed.
+ * @param message The message, not owned by the test.
+ * @param owned A message allocated with `malloc` handed over to the test, replacing `message`, or NULL.
+ */
+void cl_test_record(clarity_test_t *test, const char *file, size_t line, bool skipped, const char *message,
+                    char *owned);
+
+/**
+ * @brief Takes the lock of the result of a test, which serializes what threads record on it.
+ */
+void cl_test_lock(clarity_test_t *test);
+
+/**
+ * @brief Releases the lock of the result of a test.
+ */
+void cl_test_unlock(clarity_test_t *test);
+
+/**
+ * @brief Fails a test with all its failed expectations at once, and empties its log.
+ *
+ * The failure keeps the message and the point of an earlier failure of the test, if it had one, and lists the
+ * expectations after it. This is called whenever a run of the test completes, before its scratch memory is
+ * released.
+ *
+ * @param test The test, whose threads are all done.
+ */
+void cl_test_flush_expectations(clarity_test_t *test);
+
+/**
+ * @brief Empties the log of failed expectations of a test, without reporting them.
+ *
+ * @param test The test, whose threads are all done.
+ */
+void cl_test_clear_expectations(clarity_test_t *test);
+
+/**
+ * @brief Records the outcome of a test from its result, for its dependents.
+ */
+void cl_test_settle(clarity_test_t *test, const clarity_test_result_t *result);
+
+/**
+ * @brief Finds the first prerequisite of a test which did not pass.
+ *
+ * @return The prerequisite holding the test back, or NULL if none does.
+ */
+const clarity_test_t *cl_test_failed_prerequisite(const clarity_test_t *test);
+
+/**
+ * @brief Skips a test because one of its prerequisites did not pass.
+ */
+void cl_test_skip_for_prerequisite(clarity_test_t *test, const clarity_test_t *prerequisite);
+
+/**
+ * @brief Cancels the running tests, or lifts the cancellation.
+ *
+ * @param deadline_ns When the tests still running must be stopped, on the monotonic clock, or 0 to lift the
+ * cancellation.
+ *
+ * @see cl_test_cancelled
+ */
+void cl_test_cancel_all(uint64_t deadline_ns);
+
+/**
+ * @brief Get the time at which the tests still running after a cancellation must be stopped.
+ *
+ * @return The deadline, or 0 if the tests are not cancelled.
+ */
+uint64_t cl_test_cancel_deadline(void);
+
+/**
+ * @brief Sets the amount of a resource in a list of needs, adding the resource if the list does not name it.
+ *
+ * @param needs The list, reallocated as needed.
+ * @param count The number of entries in the list.
+ * @param name The name of the resource.
+ * @param amount The amount, which replaces the previous one.
+ *
+ * @return CL_SUCCESS, or CL_ERROR_MEMORY.
+ */
+clarity_status_t cl_resource_needs_set(clarity_resource_need_t **needs, size_t *count, const char *name,
+                                       uint64_t amount);
 
 #ifdef __cplusplus
 }
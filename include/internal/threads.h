@@ -0,0 +1,68 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_THREADS_H
+#define CLARITY_INCLUDE_INTERNAL_THREADS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Function executed by every member of a gang.
+ *
+ * @param context The context given to `cl_gang_create`.
+ * @param index The index of the member running the function, from 0 to the size of the gang.
+ */
+typedef void (*clarity_gang_fn_t)(void *context, size_t index);
+
+/**
+ * @brief A fixed group of threads running the same function in lock step.
+ *
+ * @details
+ * The members of a gang are created once, and then released together by a start barrier every time the gang
+ * is run, so that they all hit the code under test at the same moment. This maximises the chances of
+ * exposing races, and avoids paying the thread creation for every round.
+ */
+typedef struct clarity_gang_s clarity_gang_t;
+
+/**
+ * @brief Creates a gang.
+ *
+ * @param size The number of members.
+ * @param pin Whether each member must be pinned to a different core, among the cores the process may use.
+ * @param fn The function executed by the members.
+ * @param context The context passed down to `fn`.
+ *
+ * @return The new gang, or NULL if the threads could not be created.
+ */
+clarity_gang_t *cl_gang_create(size_t size, bool pin, clarity_gang_fn_t fn, void *context);
+
+/**
+ * @brief Runs one round: releases all the members together, and waits for all of them to return.
+ *
+ * @param gang The gang.
+ */
+void cl_gang_run(clarity_gang_t *gang);
+
+/**
+ * @brief Stops and joins the members of a gang, and releases it.
+ *
+ * @param gang The gang to release, may be NULL.
+ */
+void cl_gang_free(clarity_gang_t *gang);
+
+/**
+ * @brief Pins the calling thread to one of the cores the process may use.
+ *
+ * @param index The index of the thread, cores are assigned round robin.
+ *
+ * @return true if the thread has been pinned.
+ */
+bool cl_thread_pin(size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_THREADS_H
@@ -0,0 +1,42 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_TIMING_H
+#define CLARITY_INCLUDE_INTERNAL_TIMING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return The current value of the monotonic clock, in nanoseconds.
+ *
+ * @note The origin of the clock is unspecified, only differences between two readings are meaningful.
+ */
+uint64_t cl_timing_now_ns(void);
+
+/**
+ * @brief Reads the CPU clock of the calling thread.
+ *
+ * @return The CPU time the calling thread has used, in nanoseconds.
+ */
+uint64_t cl_timing_thread_cpu_ns(void);
+
+/**
+ * @brief Formats a duration in a human readable way (`ns`, `us`, `ms` or `s`).
+ *
+ * @param ns The duration to format, in nanoseconds.
+ * @param buffer The buffer receiving the formatted duration.
+ * @param size The size of `buffer`.
+ *
+ * @return `buffer`, for convenience.
+ */
+char *cl_timing_format(double ns, char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_TIMING_H
@@ -0,0 +1,55 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_TRACE_H
+#define CLARITY_INCLUDE_INTERNAL_TRACE_H
+
+#include <CLarity/trace.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The number of events in each block of the buffer of a thread.
+ */
+#define CL_TRACE_BLOCK_EVENTS 1024
+
+/**
+ * @brief The size of the names copied into the events, longer names are truncated.
+ */
+#define CL_TRACE_NAME_SIZE 64
+
+/**
+ * @brief A span of time recorded by a thread.
+ */
+typedef struct clarity_trace_event_s {
+	uint64_t   start_ns;                 /**< When the span started, on the monotonic clock. */
+	uint64_t   duration_ns;              /**< How long the span lasted. */
+	const char *category;                /**< The kind of span, a string literal. */
+	const char *label;                   /**< What the span does to its subject, a string literal, or NULL. */
+	char       name[CL_TRACE_NAME_SIZE]; /**< The name of the suite or test of the span. */
+} clarity_trace_event_t;
+
+/**
+ * @brief Reads the clock at the start of a span.
+ *
+ * @return The time in nanoseconds, or 0 when no timeline is being recorded.
+ */
+uint64_t cl_trace_now(void);
+
+/**
+ * @brief Records a span which ends now, to the buffer of the calling thread.
+ *
+ * Does nothing if the span was started while no timeline was being recorded, or if the buffer cannot grow.
+ *
+ * @param start_ns What `cl_trace_now` returned at the start of the span.
+ * @param category The kind of span: "suite", "fixture", "test" or "report".
+ * @param label What the span does to its subject, such as "setup", or NULL.
+ * @param name The name of the suite or test of the span, copied.
+ */
+void cl_trace_span(uint64_t start_ns, const char *category, const char *label, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_TRACE_H
@@ -0,0 +1,152 @@
+#ifndef CLARITY_INCLUDE_INTERNAL_WIRE_H
+#define CLARITY_INCLUDE_INTERNAL_WIRE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include "printer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The maximum number of fields in a message.
+ */
+#define CL_WIRE_MAX_FIELDS 16
+
+/**
+ * @brief A growable byte buffer, used to build and receive messages.
+ */
+typedef struct clarity_buffer_s {
+	char   *data;     /**< The bytes of the buffer. */
+	size_t length;    /**< The number of bytes used. */
+	size_t capacity;  /**< The number of bytes allocated. */
+	size_t consumed;  /**< The number of bytes at the start of the buffer already handed out as lines. */
+} clarity_buffer_t;
+
+/**
+ * @brief Appends bytes to a buffer.
+ *
+ * @return false if the allocation failed.
+ */
+bool cl_buffer_append(clarity_buffer_t *buffer, const void *data, size_t length);
+
+/**
+ * @brief Releases the memory of a buffer, and empties it.
+ */
+void cl_buffer_free(clarity_buffer_t *buffer);
+
+/**
+ * @brief Reads the bytes available on a file descriptor into a buffer.
+ *
+ * @return The number of bytes read, 0 at the end of the stream, or -1 on error.
+ */
+ssize_t cl_buffer_fill(clarity_buffer_t *buffer, int fd);
+
+/**
+ * @brief Takes the next complete line of a buffer.
+ *
+ * The returned line is NUL terminated in place, without its new line, and stays valid until the next
+ * `cl_buffer_fill` or `cl_buffer_append` on the buffer.
+ *
+ * @return The line, or NULL if the buffer does not hold a complete line.
+ */
+char *cl_buffer_next_line(clarity_buffer_t *buffer);
+
+/**
+ * @brief Writes the whole content of a buffer to a file descriptor, and empties it.
+ *
+ * The buffer is emptied even if the write fails, as the peer is gone by then.
+ *
+ * @return false if the write failed.
+ */
+bool cl_buffer_flush(clarity_buffer_t *buffer, int fd);
+
+/**
+ * @brief Starts a message of the given type.
+ *
+ * @details
+ * A message is a single line of tab separated fields, the first one being the message type. Tabulations,
+ * new lines and backslashes inside fields are escaped with a backslash.
+ */
+bool cl_wire_begin(clarity_buffer_t *buffer, const char *type);
+
+/**
+ * @brief Adds a text field to the current message. A NULL text is sent as an empty field.
+ */
+bool cl_wire_add_string(clarity_buffer_t *buffer, const char *text);
+
+/**
+ * @brief Adds a number field to the current message.
+ */
+bool cl_wire_add_u64(clarity_buffer_t *buffer, uint64_t value);
+
+/**
+ * @brief Ends the current message.
+ */
+bool cl_wire_end(clarity_buffer_t *buffer);
+
+/**
+ * @brief Splits a message into its fields, unescaping them in place.
+ *
+ * @param line The message, as returned by `cl_buffer_next_line`.
+ * @param fields Receives the fields, the first one being the message type.
+ * @param max The number of fields that fit in `fields`.
+ *
+ * @return The number of fields.
+ */
+size_t cl_wire_split(char *line, char **fields, size_t max);
+
+/**
+ * @brief Parses a number field.
+ *
+ * @return The number, or 0 if the field is not a number.
+ */
+uint64_t cl_wire_u64(const char *field);
+
+/**
+ * @brief Writes text to a stream, escaped as a field.
+ */
+void cl_wire_fputs_escaped(FILE *stream, const char *text);
+
+/**
+ * @brief Unescapes a field into a new string.
+ *
+ * @param text The escaped field.
+ * @param length The length of the escaped field.
+ *
+ * @return The unescaped copy, to be freed by the caller, or NULL if the allocation failed.
+ */
+char *cl_wire_unescape(const char *text, size_t length);
+
+/**
+ * @brief Adds the fields describing a test result to the current message.
+ *
+ * The fields are, in order: the test name, the status (`P`, `F`, `S`, or `N` for a test not run), the duration
+ * in nanoseconds, the line number, the file name and the message.
+ */
+bool cl_wire_add_result(clarity_buffer_t *buffer, const clarity_test_result_t *result);
+
+/**
+ * @brief The number of fields added by `cl_wire_add_result`.
+ */
+#define CL_WIRE_RESULT_FIELDS 6
+
+/**
+ * @brief Reads a test result from the fields written by `cl_wire_add_result`.
+ *
+ * The strings of the result point into the fields. Empty file names and messages are read as NULL.
+ *
+ * @param fields The fields of the result.
+ * @param result Receives the result.
+ */
+void cl_wire_read_result(char **fields, clarity_test_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLARITY_INCLUDE_INTERNAL_WIRE_H
@@ -0,0 +1,163 @@
+#include "arena.h"
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "test.h"
+
+/**
+ * @brief The regions released on a thread, reused by the next tests running on it.
+ */
+typedef struct clarity_arena_cache_s {
+	size_t                count;
+	clarity_arena_chunk_t *chunks[CL_ARENA_CACHED_CHUNKS];
+} clarity_arena_cache_t;
+
+static pthread_key_t  cache_key;
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+static bool           cache_ready;
+
+
+static void __cl_arena_cache_free(void *data) {
+	clarity_arena_cache_t *cache = data;
+	while (cache->count)
+		free(cache->chunks[--cache->count]);
+	free(cache);
+}
+
+
+static void __cl_arena_cache_init(void) {
+	cache_ready = pthread_key_create(&cache_key, __cl_arena_cache_free) == 0;
+}
+
+
+/**
+ * @brief Get the cache of the calling thread, created on first use.
+ *
+ * @return The cache, or NULL if it could not be created, in which case regions are not recycled.
+ */
+static clarity_arena_cache_t *__cl_arena_cache(void) {
+	pthread_once(&cache_once, __cl_arena_cache_init);
+	if (!cache_ready)
+		return NULL;
+
+	clarity_arena_cache_t *cache = pthread_getspecific(cache_key);
+	if (!cache && (cache = calloc(1, sizeof(*cache))) && pthread_setspecific(cache_key, cache) != 0) {
+		free(cache);
+		cache = NULL;
+	}
+	return cache;
+}
+
+
+/**
+ * @brief Get a region holding at least a number of bytes, from the cache when it has the default size.
+ */
+static clarity_arena_chunk_t *__cl_arena_chunk(size_t size) {
+	if (size <= CL_ARENA_CHUNK_SIZE) {
+		clarity_arena_cache_t *cache = __cl_arena_cache();
+		if (cache && cache->count)
+			return cache->chunks[--cache->count];
+		size = CL_ARENA_CHUNK_SIZE;
+	}
+	if (size > SIZE_MAX - sizeof(clarity_arena_chunk_t))
+		return NULL;
+
+	clarity_arena_chunk_t *chunk = malloc(sizeof(*chunk) + size);
+	if (!chunk)
+		return NULL;
+	chunk->size = size;
+	chunk->used = 0;
+	return chunk;
+}
+
+
+/**
+ * @brief Hands out memory from a region, if it has enough room left.
+ */
+static void *__cl_arena_take(clarity_arena_chunk_t *chunk, size_t size, size_t align) {
+	uintptr_t base   = (uintptr_t) chunk->data;
+	size_t    offset = (size_t) (((base + chunk->used + align - 1) & ~(uintptr_t) (align - 1)) - base);
+	if (offset > chunk->size || size > chunk->size - offset)
+		return NULL;
+
+	chunk->used = offset + size;
+	return (char *) chunk->data + offset;
+}
+
+
+void *cl_arena_alloc(clarity_arena_t *arena, size_t size, size_t align) {
+	if (!align)
+		align = alignof(max_align_t);
+	if (align & (align - 1))
+		return NULL;
+
+	void *memory;
+	if (arena->chunks && (memory = __cl_arena_take(arena->chunks, size, align)))
+		return memory;
+
+	// The region must have room for the worst padding, which is none up to the alignment of its data.
+	size_t padding = align > alignof(max_align_t) ? align - 1 : 0;
+	if (size > SIZE_MAX - padding)
+		return NULL;
+	clarity_arena_chunk_t *chunk = __cl_arena_chunk(size + padding);
+	if (!chunk)
+		return NULL;
+
+	// A large allocation gets a region of its own, the current region keeps serving the small ones.
+	if (chunk->size > CL_ARENA_CHUNK_SIZE && arena->chunks) {
+		chunk->next         = arena->chunks->next;
+		arena->chunks->next = chunk;
+	} else {
+		chunk->next   = arena->chunks;
+		arena->chunks = chunk;
+	}
+	return __cl_arena_take(chunk, size, align);
+}
+
+
+clarity_status_t cl_arena_defer(clarity_arena_t *arena, clarity_cleanup_fn_t fn, void *data) {
+	clarity_arena_cleanup_t *cleanup = cl_arena_alloc(arena, sizeof(*cleanup), 0);
+	if (!cleanup) {
+		fn(data);
+		return CL_ERROR_MEMORY;
+	}
+
+	cleanup->fn     = fn;
+	cleanup->data   = data;
+	cleanup->next   = arena->cleanups;
+	arena->cleanups = cleanup;
+	return CL_SUCCESS;
+}
+
+
+void cl_arena_reset(clarity_arena_t *arena) {
+	// A cleanup may register other ones, they run too.
+	while (arena->cleanups) {
+		clarity_arena_cleanup_t *cleanup = arena->cleanups;
+		arena->cleanups = cleanup->next;
+		cleanup->fn(cleanup->data);
+	}
+
+	clarity_arena_cache_t *cache = arena->chunks ? __cl_arena_cache() : NULL;
+	while (arena->chunks) {
+		clarity_arena_chunk_t *chunk = arena->chunks;
+		arena->chunks = chunk->next;
+		if (cache && chunk->size == CL_ARENA_CHUNK_SIZE && cache->count < CL_ARENA_CACHED_CHUNKS) {
+			chunk->used = 0;
+			cache->chunks[cache->count++] = chunk;
+		} else {
+			free(chunk);
+		}
+	}
+}
+
+
+void *cl_test_alloc(clarity_test_t *test, size_t size, size_t align) {
+	return cl_arena_alloc(&test->arena, size, align);
+}
+
+
+clarity_status_t cl_test_defer(clarity_test_t *test, clarity_cleanup_fn_t fn, void *data) {
+	return cl_arena_defer(&test->arena, fn, data);
+}
@@ -0,0 +1,255 @@
+#include <CLarity/assertions.h>
+#include <CLarity/test.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "assertions.h"
+#include "simd.h"
+#include "test.h"
+
+#define CL_DUMP_ROW 16
+#define CL_CONTEXT_ELEMENTS 3
+
+/**
+ * @brief The operations comparing the elements of an array of floating point type.
+ */
+typedef struct clarity_array_kind_s {
+	size_t elem_size;
+	int    digits;
+
+	size_t (*mismatch)(const void *a, const void *b, size_t count, const clarity_float_tolerance_t *tolerance);
+	bool   (*near)(const void *a, const void *b, size_t index, const clarity_float_tolerance_t *tolerance);
+	double (*get)(const void *array, size_t index);
+} clarity_array_kind_t;
+
+
+/**
+ * @brief Fails the test with a message built in a memory stream, or with a fixed message if it cannot be built.
+ */
+static void __cl_assert_fail(clarity_test_t *test, const char *file, size_t line, char *text, size_t len,
+                             const char *fallback) {
+	if (text && len) {
+		cl_test_record(test, file, line, false, NULL, text);
+		return;
+	}
+	cl_test_record(test, file, line, false, fallback, NULL);
+	free(text);
+}
+
+
+static void __cl_dump_row(FILE *stream, const char *label, const unsigned char *bytes, size_t start, size_t end) {
+	fprintf(stream, "\n  %-8s +0x%08zx:", label, start);
+	for (size_t i = start; i < end; i++)
+		fprintf(stream, " %02x", bytes[i]);
+}
+
+
+void cl_assert_fail_buffers(clarity_test_t *test, const char *file, size_t line, const char *heading,
+                            const unsigned char *actual, size_t actual_size, const unsigned char *expected,
+                            size_t expected_size) {
+	const unsigned char *a      = actual;
+	const unsigned char *b      = expected;
+	size_t              common  = actual_size < expected_size ? actual_size : expected_size;
+	size_t              longest = actual_size > expected_size ? actual_size : expected_size;
+
+	size_t first     = cl_simd_mismatch_bytes(a, b, common);
+	size_t differing = cl_simd_count_bytes(a + first, b + first, common - first) + longest - common;
+	char   *text     = NULL;
+	size_t len       = 0;
+	FILE   *stream   = open_memstream(&text, &len);
+	if (stream) {
+		fprintf(stream, "%s at offset %zu (%zu of %zu bytes differ", heading, first, differing, longest);
+		if (actual_size != expected_size)
+			fprintf(stream, ", %zu bytes instead of %zu", actual_size, expected_size);
+		fputc(')', stream);
+
+		// The row holding the difference, with one row of context on each side.
+		size_t row   = first / CL_DUMP_ROW * CL_DUMP_ROW;
+		size_t start = row >= CL_DUMP_ROW ? row - CL_DUMP_ROW : 0;
+		size_t stop  = row + 2 * CL_DUMP_ROW < longest ? row + 2 * CL_DUMP_ROW : longest;
+		for (size_t at = start; at < stop; at += CL_DUMP_ROW) {
+			size_t end        = at + CL_DUMP_ROW < stop ? at + CL_DUMP_ROW : stop;
+			size_t actual_end = end < actual_size ? end : actual_size;
+			size_t common_end = end < common ? end : common;
+			__cl_dump_row(stream, "actual", a, at, actual_end);
+			__cl_dump_row(stream, "expected", b, at, end < expected_size ? end : expected_size);
+			if (at < common_end && memcmp(a + at, b + at, common_end - at) != 0) {
+				while (a[common_end - 1] == b[common_end - 1])
+					common_end--;
+				fprintf(stream, "\n  %-8s  %10s ", "", "");
+				for (size_t i = at; i < common_end; i++)
+					fputs(a[i] != b[i] ? " ^^" : "   ", stream);
+			}
+		}
+		fclose(stream);
+	}
+
+	__cl_assert_fail(test, file, line, text, len, heading);
+}
+
+
+bool __cl_assert_mem_eq(clarity_test_t *test, const void *actual, const void *expected, size_t size,
+                        const char *file, size_t line) {
+	if (actual == expected || cl_simd_mismatch_bytes(actual, expected, size) == size)
+		return true;
+
+	cl_assert_fail_buffers(test, file, line, "buffers differ", actual, size, expected, size);
+	return false;
+}
+
+
+/**
+ * @brief Maps the bits of a float to an integer ordered like the floats themselves, so that the distance between
+ * two mapped values is the number of representable floats between them.
+ */
+static int64_t __cl_float_order(float value) {
+	int32_t bits;
+	memcpy(&bits, &value, sizeof bits);
+	return bits < 0 ? (int64_t) INT32_MIN - bits : bits;
+}
+
+
+static bool __cl_float_near(const void *a, const void *b, size_t index, const clarity_float_tolerance_t *tolerance) {
+	float x = ((const float *) a)[index];
+	float y = ((const float *) b)[index];
+
+	if (isnan(x) || isnan(y))
+		return isnan(x) && isnan(y);
+
+	// Same single precision arithmetic as the kernels, which must never accept an element rejected here.
+	float diff = fabsf(x - y);
+	if (x == y || diff <= (float) tolerance->absolute
+	    || diff <= (float) tolerance->relative * fmaxf(fabsf(x), fabsf(y)))
+		return true;
+
+	if (!tolerance->ulps || isinf(x) || isinf(y))
+		return false;
+
+	int64_t distance = __cl_float_order(x) - __cl_float_order(y);
+	return (uint64_t) (distance < 0 ? -distance : distance) <= tolerance->ulps;
+}
+
+
+static size_t __cl_float_mismatch(const void *a, const void *b, size_t count,
+                                  const clarity_float_tolerance_t *tolerance) {
+	return cl_simd_mismatch_floats(a, b, count, (float) tolerance->absolute, (float) tolerance->relative);
+}
+
+
+static double __cl_float_get(const void *array, size_t index) {
+	return ((const float *) array)[index];
+}
+
+
+/**
+ * @brief Maps the bits of a double to an unsigned integer ordered like the doubles themselves.
+ */
+static uint64_t __cl_double_order(double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof bits);
+	uint64_t zero = UINT64_C(1) << 63;
+	return bits & zero ? zero - (bits & ~zero) : zero + bits;
+}
+
+
+static bool __cl_double_near(const void *a, const void *b, size_t index,
+                             const clarity_float_tolerance_t *tolerance) {
+	double x = ((const double *) a)[index];
+	double y = ((const double *) b)[index];
+
+	if (isnan(x) || isnan(y))
+		return isnan(x) && isnan(y);
+
+	double diff = fabs(x - y);
+	if (x == y || diff <= tolerance->absolute || diff <= tolerance->relative * fmax(fabs(x), fabs(y)))
+		return true;
+
+	if (!tolerance->ulps || isinf(x) || isinf(y))
+		return false;
+
+	uint64_t ox = __cl_double_order(x);
+	uint64_t oy = __cl_double_order(y);
+	return (ox > oy ? ox - oy : oy - ox) <= tolerance->ulps;
+}
+
+
+static size_t __cl_double_mismatch(const void *a, const void *b, size_t count,
+                                   const clarity_float_tolerance_t *tolerance) {
+	return cl_simd_mismatch_doubles(a, b, count, tolerance->absolute, tolerance->relative);
+}
+
+
+static double __cl_double_get(const void *array, size_t index) {
+	return ((const double *) array)[index];
+}
+
+
+static const clarity_array_kind_t __cl_float_kind = {
+	.elem_size = sizeof(float),
+	.digits    = 9,
+	.mismatch  = __cl_float_mismatch,
+	.near      = __cl_float_near,
+	.get       = __cl_float_get,
+};
+
+static const clarity_array_kind_t __cl_double_kind = {
+	.elem_size = sizeof(double),
+	.digits    = 17,
+	.mismatch  = __cl_double_mismatch,
+	.near      = __cl_double_near,
+	.get       = __cl_double_get,
+};
+
+
+static bool __cl_assert_array_near(clarity_test_t *test, const clarity_array_kind_t *kind, const void *actual,
+                                   const void *expected, size_t count, const clarity_float_tolerance_t *tolerance,
+                                   const char *file, size_t line) {
+	const char *a         = actual;
+	const char *b         = expected;
+	size_t     first      = count;
+	size_t     mismatches = 0;
+
+	// The kernel skips the elements that are trivially close, the rest goes through the full tolerance.
+	for (size_t i = 0; i < count; i++) {
+		i += kind->mismatch(a + i * kind->elem_size, b + i * kind->elem_size, count - i, tolerance);
+		if (i < count && !kind->near(a, b, i, tolerance)) {
+			if (!mismatches)
+				first = i;
+			mismatches++;
+		}
+	}
+	if (!mismatches)
+		return true;
+
+	char   *text   = NULL;
+	size_t len     = 0;
+	FILE   *stream = open_memstream(&text, &len);
+	if (stream) {
+		fprintf(stream, "arrays differ at index %zu (%zu of %zu elements out of tolerance)", first, mismatches,
+		        count);
+
+		size_t start = first > CL_CONTEXT_ELEMENTS ? first - CL_CONTEXT_ELEMENTS : 0;
+		size_t stop  = count - first > CL_CONTEXT_ELEMENTS ? first + CL_CONTEXT_ELEMENTS + 1 : count;
+		for (size_t i = start; i < stop; i++) {
+			fprintf(stream, "\n  %c [%zu] actual %.*g, expected %.*g", kind->near(a, b, i, tolerance) ? ' ' : '>',
+			        i, kind->digits, kind->get(a, i), kind->digits, kind->get(b, i));
+		}
+		fclose(stream);
+	}
+
+	__cl_assert_fail(test, file, line, text, len, "arrays differ");
+	return false;
+}
+
+
+bool __cl_assert_float_array_near(clarity_test_t *test, const float *actual, const float *expected, size_t count,
+                                  clarity_float_tolerance_t tolerance, const char *file, size_t line) {
+	return __cl_assert_array_near(test, &__cl_float_kind, actual, expected, count, &tolerance, file, line);
+}
+
+
+bool __cl_assert_double_array_near(clarity_test_t *test, const double *actual, const double *expected,
+                                   size_t count, clarity_float_tolerance_t tolerance, const char *file, size_t line) {
+	return __cl_assert_array_near(test, &__cl_double_kind, actual, expected, count, &tolerance, file, line);
+}
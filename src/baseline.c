@@ -0,0 +1,253 @@
+#include "baseline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+#include "suite.h"
+#include "test.h"
+#include "wire.h"
+
+#define CL_BASELINE_HEADER "# CLarity baseline v1"
+#define CL_BASELINE_MODE_ENV "CLARITY_BASELINE_MODE"
+
+
+static void __cl_baseline_write_entry(FILE *file, const char *suite, const char *test, const uint64_t *samples,
+                                      size_t count) {
+	cl_wire_fputs_escaped(file, suite);
+	fputc('\t', file);
+	cl_wire_fputs_escaped(file, test);
+	fprintf(file, "\t%zu\t", count);
+	for (size_t i = 0; i < count; i++)
+		fprintf(file, i ? ",%llu" : "%llu", (unsigned long long) samples[i]);
+	fputc('\n', file);
+}
+
+
+static clarity_baseline_entry_t *__cl_baseline_append(clarity_baseline_t *baseline) {
+	if (baseline->count >= baseline->capacity) {
+		size_t                   new_capacity = baseline->capacity ? baseline->capacity * 2 : 16;
+		clarity_baseline_entry_t *entries     = realloc(baseline->entries, new_capacity * sizeof(*entries));
+		if (!entries)
+			return NULL;
+		baseline->entries  = entries;
+		baseline->capacity = new_capacity;
+	}
+
+	clarity_baseline_entry_t *entry = &baseline->entries[baseline->count++];
+	memset(entry, 0, sizeof(*entry));
+	return entry;
+}
+
+
+static bool __cl_baseline_parse_line(clarity_baseline_t *baseline, const char *line) {
+	const char *suite_end = strchr(line, '\t');
+	if (!suite_end)
+		return false;
+	const char *test_end = strchr(suite_end + 1, '\t');
+	if (!test_end)
+		return false;
+
+	char   *end;
+	size_t count = strtoull(test_end + 1, &end, 10);
+	if (end == test_end + 1 || *end != '\t' || !count)
+		return false;
+
+	clarity_baseline_entry_t *entry = __cl_baseline_append(baseline);
+	if (!entry)
+		return false;
+	entry->suite   = cl_wire_unescape(line, (size_t) (suite_end - line));
+	entry->test    = cl_wire_unescape(suite_end + 1, (size_t) (test_end - suite_end - 1));
+	entry->samples = calloc(count, sizeof(*entry->samples));
+	if (!entry->suite || !entry->test || !entry->samples)
+		return false;
+
+	const char *cursor = end + 1;
+	for (size_t i = 0; i < count; i++) {
+		entry->samples[i] = strtoull(cursor, &end, 10);
+		if (end == cursor)
+			return false;
+		entry->count++;
+		cursor = *end == ',' ? end + 1 : end;
+	}
+	return true;
+}
+
+
+clarity_baseline_mode_t cl_baseline_effective_mode(const clarity_suite_t *suite) {
+	if (!suite->baseline_path)
+		return CL_BASELINE_OFF;
+
+	const char *env = getenv(CL_BASELINE_MODE_ENV);
+	if (env) {
+		if (!strcmp(env, "off"))
+			return CL_BASELINE_OFF;
+		if (!strcmp(env, "record"))
+			return CL_BASELINE_RECORD;
+		if (!strcmp(env, "compare"))
+			return CL_BASELINE_COMPARE;
+	}
+	return suite->baseline_mode;
+}
+
+
+clarity_status_t cl_baseline_load(const char *path, clarity_baseline_t **baseline) {
+	*baseline = calloc(1, sizeof(**baseline));
+	if (!*baseline)
+		return CL_ERROR_MEMORY;
+
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return CL_ERROR_IO;
+
+	char    *line = NULL;
+	size_t  size  = 0;
+	ssize_t len;
+	bool    ok    = true;
+	while (ok && (len = getline(&line, &size, file)) >= 0) {
+		if (len && line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (!len || line[0] == '#')
+			continue;
+		ok = __cl_baseline_parse_line(*baseline, line);
+	}
+	free(line);
+	fclose(file);
+
+	if (ok)
+		return CL_SUCCESS;
+	// Nothing of a malformed file is trusted, the entries parsed before the error included.
+	cl_baseline_free(*baseline);
+	*baseline = calloc(1, sizeof(**baseline));
+	return *baseline ? CL_ERROR_FORMAT : CL_ERROR_MEMORY;
+}
+
+
+clarity_baseline_t *cl_baseline_load_reference(const clarity_suite_t *suite) {
+	clarity_baseline_t *baseline;
+	clarity_status_t   status = cl_baseline_load(suite->baseline_path, &baseline);
+	if (status == CL_ERROR_IO)
+		fprintf(stderr, "CLarity: no baseline at '%s', the benchmarks of suite '%s' are not compared\n",
+		        suite->baseline_path, suite->name);
+	else if (status == CL_ERROR_FORMAT)
+		fprintf(stderr, "CLarity: the baseline '%s' is malformed, the benchmarks of suite '%s' are not compared\n",
+		        suite->baseline_path, suite->name);
+	return baseline;
+}
+
+
+void cl_baseline_free(clarity_baseline_t *baseline) {
+	if (!baseline)
+		return;
+
+	for (size_t i = 0; i < baseline->count; i++) {
+		free(baseline->entries[i].suite);
+		free(baseline->entries[i].test);
+		free(baseline->entries[i].samples);
+	}
+	free(baseline->entries);
+	free(baseline);
+}
+
+
+const clarity_baseline_entry_t *cl_baseline_find(const clarity_baseline_t *baseline, const char *suite,
+                                                 const char *test) {
+	for (size_t i = 0; i < baseline->count; i++) {
+		const clarity_baseline_entry_t *entry = &baseline->entries[i];
+		if (!strcmp(entry->suite, suite) && !strcmp(entry->test, test))
+			return entry;
+	}
+	return NULL;
+}
+
+
+bool cl_baseline_compare_test(const clarity_baseline_t *baseline, const clarity_suite_t *suite, clarity_test_t *test) {
+	if (!test->result.passed || test->result.skipped)
+		return false;
+
+	const clarity_baseline_entry_t *entry = cl_baseline_find(baseline, suite->name, test->name);
+	if (!entry || entry->count < CL_BASELINE_MIN_SAMPLES)
+		return false;
+
+	size_t         count;
+	const uint64_t *samples = cl_test_samples(test, &count);
+	if (count < CL_BASELINE_MIN_SAMPLES)
+		return false;
+
+	double                   u;
+	double                   p        = cl_stats_mann_whitney(entry->samples, entry->count, samples, count, &u);
+	clarity_sample_summary_t old_dist = cl_stats_summarise(entry->samples, entry->count);
+	clarity_sample_summary_t new_dist = cl_stats_summarise(samples, count);
+	if (old_dist.median <= 0)
+		return false;
+
+	double effect = new_dist.median / old_dist.median - 1;
+	if (p >= suite->regression_alpha || effect < suite->regression_min_effect)
+		return false;
+
+	char old_text[160], new_text[160];
+	test->result.passed      = false;
+	test->result.file_name   = NULL;
+	test->result.line_number = 0;
+	if (!cl_test_set_message(test,
+	                         "performance regression: median +%.1f%% (min effect %.1f%%), p=%.2g (U=%.0f, alpha=%.2g)\n"
+	                         "\tbaseline: %s\n"
+	                         "\tcurrent:  %s",
+	                         effect * 100, suite->regression_min_effect * 100, p, u, suite->regression_alpha,
+	                         cl_stats_format_summary(&old_dist, old_text, sizeof old_text),
+	                         cl_stats_format_summary(&new_dist, new_text, sizeof new_text)))
+		test->result.error_message = "performance regression";
+	return true;
+}
+
+
+clarity_status_t cl_baseline_record_suite(const clarity_suite_t *suite) {
+	clarity_baseline_t *baseline;
+	clarity_status_t   status = cl_baseline_load(suite->baseline_path, &baseline);
+	if (status == CL_ERROR_MEMORY)
+		return CL_ERROR_MEMORY;
+	if (status == CL_ERROR_FORMAT)
+		fprintf(stderr, "CLarity: the baseline '%s' is malformed, it is replaced\n", suite->baseline_path);
+
+	size_t tmp_len = strlen(suite->baseline_path) + sizeof ".tmp";
+	char   *tmp    = malloc(tmp_len);
+	if (!tmp) {
+		cl_baseline_free(baseline);
+		return CL_ERROR_MEMORY;
+	}
+	snprintf(tmp, tmp_len, "%s.tmp", suite->baseline_path);
+
+	FILE *file = fopen(tmp, "w");
+	if (!file) {
+		free(tmp);
+		cl_baseline_free(baseline);
+		return CL_ERROR_IO;
+	}
+
+	fprintf(file, "%s\n", CL_BASELINE_HEADER);
+	for (size_t i = 0; i < baseline->count; i++) {
+		const clarity_baseline_entry_t *entry = &baseline->entries[i];
+		if (strcmp(entry->suite, suite->name) != 0)
+			__cl_baseline_write_entry(file, entry->suite, entry->test, entry->samples, entry->count);
+	}
+
+	for (size_t i = 0; i < suite->test_count; i++) {
+		const clarity_test_t *test = suite->tests[i];
+		if (!test || test->result.skipped)
+			continue;
+
+		size_t         count;
+		const uint64_t *samples = cl_test_samples(test, &count);
+		if (count)
+			__cl_baseline_write_entry(file, suite->name, test->name, samples, count);
+	}
+	cl_baseline_free(baseline);
+
+	bool written = !ferror(file);
+	written &= fclose(file) == 0;
+	written = written && rename(tmp, suite->baseline_path) == 0;
+	if (!written)
+		remove(tmp);
+	free(tmp);
+
+	return written ? CL_SUCCESS : CL_ERROR_IO;
+}
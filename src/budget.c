@@ -0,0 +1,489 @@
+#include "budget.h"
+#include <CLarity/cli.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "files.h"
+#include "runner.h"
+#include "suite.h"
+#include "test.h"
+#include "timing.h"
+#include "wire.h"
+
+#define CL_HISTORY_HEADER "# CLarity history v1\n"
+
+/**
+ * @brief The weight of a run relative to the run after it, so that recent failures count more.
+ */
+#define CL_HISTORY_DECAY 0.8
+
+/**
+ * @brief The failures and runs assumed before the first one, which keep a short history from being definitive.
+ */
+#define CL_HISTORY_PRIOR_FAILURES 0.1
+#define CL_HISTORY_PRIOR_RUNS 1.0
+
+/**
+ * @brief A test with fewer runs than this is recent, and likely to fail at least as much as a coin flip.
+ */
+#define CL_HISTORY_NEW_RUNS 3
+#define CL_HISTORY_NEW_LIKELIHOOD 0.5
+
+/**
+ * @brief The duration assumed for a test when no test has a history yet.
+ */
+#define CL_HISTORY_UNKNOWN_NS 1000000
+
+/**
+ * @brief The cost of starting a test, added to its duration so that instant tests do not get infinite scores.
+ */
+#define CL_HISTORY_OVERHEAD_NS 10000
+
+/**
+ * @brief A test which may run within the budget.
+ */
+typedef struct clarity_candidate_s {
+	clarity_suite_t *suite;
+	clarity_test_t  *test;
+	size_t          position;   /**< The position of the test in its suite. */
+	size_t          root;       /**< The index of the suite given to the run that contains the test. */
+	double          likelihood; /**< The estimated probability that the test fails. */
+	uint64_t        predicted;  /**< The predicted duration of the test, in nanoseconds. */
+	double          score;      /**< The likelihood of a failure per second spent running the test. */
+	size_t          rank;       /**< The position of the test in the schedule. */
+} clarity_candidate_t;
+
+typedef struct clarity_candidates_s {
+	clarity_candidate_t *items;
+	size_t              count;
+	size_t              capacity;
+} clarity_candidates_t;
+
+
+static int __cl_history_compare(const void *a, const void *b) {
+	const clarity_history_entry_t *x = a;
+	const clarity_history_entry_t *y = b;
+	int                           by_suite = strcmp(x->suite, y->suite);
+	return by_suite ? by_suite : strcmp(x->test, y->test);
+}
+
+
+static clarity_history_entry_t *__cl_history_append(clarity_budget_t *budget, char *suite, char *test) {
+	if (suite && test && budget->count >= budget->capacity) {
+		size_t                  new_capacity = budget->capacity ? budget->capacity * 2 : 64;
+		clarity_history_entry_t *entries     = realloc(budget->entries, new_capacity * sizeof(*entries));
+		if (entries) {
+			budget->entries  = entries;
+			budget->capacity = new_capacity;
+		}
+	}
+	if (!suite || !test || budget->count >= budget->capacity) {
+		free(suite);
+		free(test);
+		return NULL;
+	}
+
+	clarity_history_entry_t *entry = &budget->entries[budget->count++];
+	*entry = (clarity_history_entry_t){ .suite = suite, .test = test };
+	return entry;
+}
+
+
+static bool __cl_history_parse_line(clarity_budget_t *budget, const char *line) {
+	const char *suite_end = strchr(line, '\t');
+	const char *test_end  = suite_end ? strchr(suite_end + 1, '\t') : NULL;
+	if (!test_end)
+		return false;
+
+	char     *end;
+	uint64_t runs = strtoull(test_end + 1, &end, 10);
+	if (end == test_end + 1 || *end != '\t' || runs > CL_HISTORY_WINDOW)
+		return false;
+	const char *field    = end + 1;
+	uint64_t   failures = strtoull(field, &end, 16);
+	if (end == field || *end != '\t')
+		return false;
+	field                = end + 1;
+	uint64_t   duration = strtoull(field, &end, 10);
+	if (end == field || *end)
+		return false;
+
+	clarity_history_entry_t *entry = __cl_history_append(budget,
+	                                                     cl_wire_unescape(line, (size_t) (suite_end - line)),
+	                                                     cl_wire_unescape(suite_end + 1,
+	                                                                      (size_t) (test_end - suite_end - 1)));
+	if (!entry)
+		return false;
+	entry->runs        = (uint32_t) runs;
+	entry->failures    = failures;
+	entry->duration_ns = duration;
+	return true;
+}
+
+
+static void __cl_history_clear(clarity_budget_t *budget) {
+	for (size_t i = 0; i < budget->count; i++) {
+		free(budget->entries[i].suite);
+		free(budget->entries[i].test);
+	}
+	free(budget->entries);
+	budget->entries  = NULL;
+	budget->count    = 0;
+	budget->sorted   = 0;
+	budget->capacity = 0;
+}
+
+
+/**
+ * @brief Loads the history file, sorted so that the tests are found by a binary search.
+ */
+static bool __cl_history_load(clarity_budget_t *budget) {
+	FILE *file = fopen(budget->path, "r");
+	if (!file)
+		return true;
+
+	char    *line = NULL;
+	size_t  size  = 0;
+	ssize_t len;
+	bool    ok    = true;
+	while (ok && (len = getline(&line, &size, file)) >= 0) {
+		if (len && line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (!len || line[0] == '#')
+			continue;
+		ok = __cl_history_parse_line(budget, line);
+	}
+	free(line);
+	fclose(file);
+
+	if (!ok) {
+		__cl_history_clear(budget);
+		return false;
+	}
+	if (budget->count)
+		qsort(budget->entries, budget->count, sizeof(*budget->entries), __cl_history_compare);
+	budget->sorted = budget->count;
+	return true;
+}
+
+
+static bool __cl_history_save(const clarity_budget_t *budget) {
+	char   *text   = NULL;
+	size_t len     = 0;
+	FILE   *stream = open_memstream(&text, &len);
+	if (!stream)
+		return false;
+
+	for (size_t i = 0; i < budget->count; i++) {
+		const clarity_history_entry_t *entry = &budget->entries[i];
+		cl_wire_fputs_escaped(stream, entry->suite);
+		fputc('\t', stream);
+		cl_wire_fputs_escaped(stream, entry->test);
+		fprintf(stream, "\t%u\t%llx\t%llu\n", entry->runs, (unsigned long long) entry->failures,
+		        (unsigned long long) entry->duration_ns);
+	}
+	bool written = !fclose(stream)
+	               && cl_files_replace(budget->path, CL_HISTORY_HEADER, strlen(CL_HISTORY_HEADER), text, len);
+	free(text);
+	return written;
+}
+
+
+/**
+ * @brief Finds the entry of a test, in the sorted entries loaded from the file or among the ones added since.
+ */
+static clarity_history_entry_t *__cl_history_find(clarity_budget_t *budget, const char *suite, const char *test) {
+	clarity_history_entry_t key    = { .suite = (char *) suite, .test = (char *) test };
+	clarity_history_entry_t *found = budget->sorted ? bsearch(&key, budget->entries, budget->sorted, sizeof(key),
+	                                                          __cl_history_compare) : NULL;
+	for (size_t i = budget->sorted; !found && i < budget->count; i++) {
+		if (!__cl_history_compare(&key, &budget->entries[i]))
+			found = &budget->entries[i];
+	}
+	return found;
+}
+
+
+/**
+ * @brief Estimates the probability that a test fails, from its recent runs.
+ */
+static double __cl_history_likelihood(const clarity_history_entry_t *entry) {
+	double failed = CL_HISTORY_PRIOR_FAILURES;
+	double total  = CL_HISTORY_PRIOR_RUNS;
+	double weight = 1;
+
+	for (uint32_t i = 0; entry && i < entry->runs; i++) {
+		if (entry->failures & (UINT64_C(1) << i))
+			failed += weight;
+		total  += weight;
+		weight *= CL_HISTORY_DECAY;
+	}
+
+	double likelihood = failed / total;
+	if ((!entry || entry->runs < CL_HISTORY_NEW_RUNS) && likelihood < CL_HISTORY_NEW_LIKELIHOOD)
+		likelihood = CL_HISTORY_NEW_LIKELIHOOD;
+	return likelihood;
+}
+
+
+static int __cl_compare_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+	return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief The duration assumed for the tests without a history: the median of the known ones.
+ */
+static uint64_t __cl_history_typical_duration(const clarity_budget_t *budget) {
+	uint64_t *durations = malloc((budget->count ? budget->count : 1) * sizeof(*durations));
+	size_t   known      = 0;
+	if (!durations)
+		return CL_HISTORY_UNKNOWN_NS;
+
+	for (size_t i = 0; i < budget->count; i++) {
+		if (budget->entries[i].runs)
+			durations[known++] = budget->entries[i].duration_ns;
+	}
+	uint64_t typical = CL_HISTORY_UNKNOWN_NS;
+	if (known) {
+		qsort(durations, known, sizeof(*durations), __cl_compare_u64);
+		typical = durations[known / 2];
+	}
+	free(durations);
+	return typical;
+}
+
+
+static bool __cl_candidates_collect(clarity_candidates_t *candidates, clarity_suite_t *suite, size_t root,
+                                    const char *filter) {
+	for (size_t i = 0; i < suite->test_count; i++) {
+		clarity_test_t *test = suite->tests[i];
+		if (!test || !cl_runner_matches(filter, suite->name, test->name))
+			continue;
+
+		if (candidates->count >= candidates->capacity) {
+			size_t              new_capacity = candidates->capacity ? candidates->capacity * 2 : 64;
+			clarity_candidate_t *items       = realloc(candidates->items, new_capacity * sizeof(*items));
+			if (!items)
+				return false;
+			candidates->items    = items;
+			candidates->capacity = new_capacity;
+		}
+		candidates->items[candidates->count++] = (clarity_candidate_t){
+			.suite = suite, .test = test, .position = i, .root = root,
+		};
+	}
+	for (size_t i = 0; i < suite->child_count; i++) {
+		if (!__cl_candidates_collect(candidates, suite->children[i], root, filter))
+			return false;
+	}
+	return true;
+}
+
+
+static int __cl_candidate_by_score(const void *a, const void *b) {
+	const clarity_candidate_t *x = *(const clarity_candidate_t *const *) a;
+	const clarity_candidate_t *y = *(const clarity_candidate_t *const *) b;
+	if (x->score != y->score)
+		return x->score < y->score ? 1 : -1;
+	return x < y ? -1 : x > y;
+}
+
+
+static int __cl_candidate_by_rank(const void *a, const void *b) {
+	const clarity_candidate_t *x = a;
+	const clarity_candidate_t *y = b;
+	return (x->rank > y->rank) - (x->rank < y->rank);
+}
+
+
+static void __cl_budget_not_run(clarity_test_t *test, bool described, const char *fallback) {
+	test->result.skipped = true;
+	test->result.not_run = true;
+	if (!described)
+		test->result.error_message = fallback;
+}
+
+
+/**
+ * @brief Moves the tests of each suite in the order of the schedule, in the slots they already occupy.
+ *
+ * The candidates are in collection order, so the tests of a suite are contiguous and by increasing position.
+ */
+static bool __cl_budget_reorder_tests(clarity_candidates_t *candidates) {
+	clarity_candidate_t *group = malloc((candidates->count ? candidates->count : 1) * sizeof(*group));
+	if (!group)
+		return false;
+
+	for (size_t start = 0, end; start < candidates->count; start = end) {
+		clarity_suite_t *suite = candidates->items[start].suite;
+		for (end = start; end < candidates->count && candidates->items[end].suite == suite; end++)
+			;
+
+		memcpy(group, &candidates->items[start], (end - start) * sizeof(*group));
+		qsort(group, end - start, sizeof(*group), __cl_candidate_by_rank);
+		for (size_t i = start; i < end; i++)
+			suite->tests[candidates->items[i].position] = group[i - start].test;
+	}
+	free(group);
+	return true;
+}
+
+
+/**
+ * @brief Orders the suites given to the run by the best ranked test they contain, stable for equal ranks.
+ */
+static void __cl_budget_order_suites(const clarity_candidates_t *candidates, clarity_suite_t **suites,
+                                     clarity_suite_t **ordered, size_t count, size_t *best) {
+	for (size_t i = 0; i < count; i++)
+		best[i] = SIZE_MAX;
+	for (size_t i = 0; i < candidates->count; i++) {
+		const clarity_candidate_t *candidate = &candidates->items[i];
+		if (candidate->rank < best[candidate->root])
+			best[candidate->root] = candidate->rank;
+	}
+
+	// An insertion sort keeps the suites with equal ranks in their order, and there are few suites.
+	size_t *index = best + count;
+	for (size_t i = 0; i < count; i++) {
+		size_t j = i;
+		while (j > 0 && best[index[j - 1]] > best[i]) {
+			index[j] = index[j - 1];
+			j--;
+		}
+		index[j] = i;
+	}
+	for (size_t i = 0; i < count; i++)
+		ordered[i] = suites[index[i]];
+}
+
+
+/**
+ * @brief Ranks the selected tests by score, keeps the best ones which fit in the budget and marks the others as
+ * not run.
+ */
+static bool __cl_budget_schedule(clarity_budget_t *budget, const clarity_options_t *options,
+                                 clarity_suite_t **suites, clarity_suite_t **ordered, size_t count) {
+	clarity_candidates_t candidates = { 0 };
+	clarity_candidate_t  **by_score = NULL;
+	size_t               *best      = malloc((count ? count : 1) * 2 * sizeof(*best));
+	bool                 scheduled  = best != NULL;
+
+	for (size_t i = 0; scheduled && i < count; i++)
+		scheduled = !suites[i] || __cl_candidates_collect(&candidates, suites[i], i, options->filter);
+	if (scheduled)
+		scheduled = (by_score = malloc((candidates.count ? candidates.count : 1) * sizeof(*by_score))) != NULL;
+	if (!scheduled) {
+		free(candidates.items);
+		free(best);
+		return false;
+	}
+
+	uint64_t typical = __cl_history_typical_duration(budget);
+	for (size_t i = 0; i < candidates.count; i++) {
+		clarity_candidate_t           *candidate = &candidates.items[i];
+		const clarity_history_entry_t *entry     = __cl_history_find(budget, candidate->suite->name,
+		                                                             candidate->test->name);
+		candidate->likelihood = __cl_history_likelihood(entry);
+		candidate->predicted  = entry && entry->runs ? entry->duration_ns : typical;
+		candidate->score      = candidate->likelihood / (double) (candidate->predicted + CL_HISTORY_OVERHEAD_NS);
+		by_score[i]           = candidate;
+	}
+	qsort(by_score, candidates.count, sizeof(*by_score), __cl_candidate_by_score);
+
+	uint64_t left     = options->budget_ms * UINT64_C(1000000);
+	uint64_t planned  = 0;
+	size_t   selected = 0;
+	for (size_t i = 0; i < candidates.count; i++) {
+		clarity_candidate_t *candidate = by_score[i];
+		candidate->rank                = i;
+		if (candidate->predicted <= left) {
+			left    -= candidate->predicted;
+			planned += candidate->predicted;
+			selected++;
+			continue;
+		}
+
+		// A smaller test further down the schedule may still fit in what is left.
+		char predicted[32], remaining[32];
+		bool described = cl_test_set_message(
+			candidate->test, "predicted to take %s, only %s of the budget left (failure likelihood %.1f%%)",
+			cl_timing_format((double) candidate->predicted, predicted, sizeof predicted),
+			cl_timing_format((double) left, remaining, sizeof remaining), candidate->likelihood * 100);
+		__cl_budget_not_run(candidate->test, described, "the test does not fit in the time budget");
+	}
+
+	char budget_text[32], planned_text[32];
+	printf("CLarity: running %zu of %zu tests, predicted to take %s of the %s budget\n", selected,
+	       candidates.count, cl_timing_format((double) planned, planned_text, sizeof planned_text),
+	       cl_timing_format((double) options->budget_ms * 1e6, budget_text, sizeof budget_text));
+
+	scheduled = __cl_budget_reorder_tests(&candidates);
+	__cl_budget_order_suites(&candidates, suites, ordered, count, best);
+	free(by_score);
+	free(candidates.items);
+	free(best);
+	return scheduled;
+}
+
+
+bool cl_budget_stops(const clarity_budget_t *budget, clarity_test_t *test) {
+	if (test->result.not_run)
+		return true;
+	if (!budget || !budget->deadline_ns || cl_timing_now_ns() < budget->deadline_ns)
+		return false;
+
+	bool described = cl_test_set_message(test, "the time budget ran out before the test could start");
+	__cl_budget_not_run(test, described, "the time budget ran out");
+	return true;
+}
+
+
+void cl_budget_record(clarity_budget_t *budget, const char *suite, const clarity_test_result_t *result) {
+	if (result->skipped)
+		return;
+
+	clarity_history_entry_t *entry = __cl_history_find(budget, suite, result->name);
+	if (!entry)
+		entry = __cl_history_append(budget, strdup(suite), strdup(result->name));
+	if (!entry)
+		return;
+
+	entry->failures    = entry->failures << 1 | !result->passed;
+	entry->duration_ns = entry->runs ? (entry->duration_ns * 3 + result->duration_ns) / 4 : result->duration_ns;
+	if (entry->runs < CL_HISTORY_WINDOW)
+		entry->runs++;
+}
+
+
+int cl_budget_main(const clarity_options_t *options, clarity_suite_t **suites, size_t count) {
+	const char       *env   = getenv(CL_HISTORY_ENV);
+	clarity_budget_t budget = { .path = options->history ? options->history
+	                                                     : env && *env ? env : CL_HISTORY_DEFAULT_PATH };
+
+	if (!__cl_history_load(&budget))
+		fprintf(stderr, "CLarity: ignoring the malformed history file '%s'\n", budget.path);
+
+	clarity_suite_t **ordered = suites;
+	if (options->budget_ms) {
+		budget.deadline_ns = cl_timing_now_ns() + options->budget_ms * UINT64_C(1000000);
+		ordered            = malloc((count ? count : 1) * sizeof(*ordered));
+		if (!ordered || !__cl_budget_schedule(&budget, options, suites, ordered, count)) {
+			fprintf(stderr, "CLarity: could not schedule the tests within the budget\n");
+			free(ordered);
+			__cl_history_clear(&budget);
+			return 1;
+		}
+	}
+
+	bool passed = cl_runner_run_suites(ordered, count, options->filter, &budget);
+	if (!__cl_history_save(&budget))
+		fprintf(stderr, "CLarity: could not write the history file '%s'\n", budget.path);
+
+	if (ordered != suites)
+		free(ordered);
+	__cl_history_clear(&budget);
+	return passed ? 0 : 1;
+}
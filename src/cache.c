@@ -0,0 +1,204 @@
+#include <CLarity/cache.h>
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "files.h"
+
+#define CL_CACHE_MAGIC "CLCACHE1"
+#define CL_CACHE_FNV_OFFSET 0xcbf29ce484222325ULL
+#define CL_CACHE_FNV_PRIME 0x100000001b3ULL
+#define CL_CACHE_MAX_PATH 4096
+#define CL_CACHE_MAX_STEM 48
+
+/**
+ * @brief The header of a cache file, followed by the blob.
+ *
+ * The header fills a whole cache line, so the blob is suitably aligned for any type.
+ */
+typedef struct clarity_cache_header_s {
+	char     magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t input_hash;
+	uint64_t key_hash;
+	uint64_t size;
+	char     padding[24];
+} clarity_cache_header_t;
+
+static_assert(sizeof(clarity_cache_header_t) == 64, "the cache header must keep the blob aligned");
+
+
+uint64_t cl_cache_hash(const void *data, size_t size, uint64_t seed) {
+	const unsigned char *bytes = data;
+	uint64_t            hash   = seed ? seed : CL_CACHE_FNV_OFFSET;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= CL_CACHE_FNV_PRIME;
+	}
+	return hash;
+}
+
+
+static uint64_t __cl_cache_key_hash(const clarity_cache_key_t *key) {
+	uint64_t hash = cl_cache_hash(key->name, strlen(key->name), 0);
+	hash          = cl_cache_hash(&key->version, sizeof key->version, hash);
+	return cl_cache_hash(&key->input_hash, sizeof key->input_hash, hash);
+}
+
+
+static bool __cl_cache_directory(char *path, size_t size) {
+	const char *dir  = getenv(CL_CACHE_DIR_ENV);
+	const char *xdg  = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	int        len;
+
+	if (dir && *dir)
+		len = snprintf(path, size, "%s", dir);
+	else if (xdg && *xdg)
+		len = snprintf(path, size, "%s/clarity", xdg);
+	else if (home && *home)
+		len = snprintf(path, size, "%s/.cache/clarity", home);
+	else
+		return false;
+
+	return len > 0 && (size_t) len < size && cl_files_make_directory(path);
+}
+
+
+/**
+ * @brief Builds the stem shared by the cache files of every key of a name: the readable part of the name
+ * and a hash of the whole name, so that names differing only by their unreadable characters do not collide.
+ */
+static void __cl_cache_stem(const char *name, char *stem, size_t size) {
+	size_t len = 0;
+	for (const char *c = name; *c && len < CL_CACHE_MAX_STEM && len + 1 < size; c++) {
+		bool readable = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9')
+		                || *c == '-' || *c == '_';
+		stem[len++] = readable ? *c : '_';
+	}
+	snprintf(stem + len, size - len, "-%08" PRIx32 "-", (uint32_t) cl_cache_hash(name, strlen(name), 0));
+}
+
+
+static bool __cl_cache_map(const char *path, const clarity_cache_key_t *key, uint64_t key_hash,
+                           clarity_blob_t *blob) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	void        *mapping = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && (size_t) info.st_size >= sizeof(clarity_cache_header_t))
+		mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+		return false;
+
+	const clarity_cache_header_t *header = mapping;
+	bool valid = !memcmp(header->magic, CL_CACHE_MAGIC, sizeof header->magic)
+	             && header->version == key->version
+	             && header->input_hash == key->input_hash
+	             && header->key_hash == key_hash
+	             && header->size == (uint64_t) info.st_size - sizeof(*header);
+	if (!valid) {
+		munmap(mapping, (size_t) info.st_size);
+		return false;
+	}
+
+	blob->data         = (const char *) mapping + sizeof(*header);
+	blob->size         = (size_t) header->size;
+	blob->mapping      = mapping;
+	blob->mapping_size = (size_t) info.st_size;
+	return true;
+}
+
+
+/**
+ * @brief Removes the blobs of the other keys of a name.
+ *
+ * Only the names ending in `.blob` are removed, the temporary files of the processes writing a blob are theirs.
+ */
+static void __cl_cache_remove_stale(const char *dir, const char *stem, const char *current) {
+	DIR *entries = opendir(dir);
+	if (!entries)
+		return;
+
+	size_t        stem_len = strlen(stem);
+	size_t        ext_len  = strlen(".blob");
+	struct dirent *entry;
+	while ((entry = readdir(entries))) {
+		size_t len = strlen(entry->d_name);
+		if (strncmp(entry->d_name, stem, stem_len) != 0 || !strcmp(entry->d_name, current) ||
+		    len < stem_len + ext_len || strcmp(entry->d_name + len - ext_len, ".blob") != 0)
+			continue;
+
+		char path[CL_CACHE_MAX_PATH];
+		if (snprintf(path, sizeof path, "%s/%s", dir, entry->d_name) < (int) sizeof path)
+			unlink(path);
+	}
+	closedir(entries);
+}
+
+
+static bool __cl_cache_store(const char *path, const clarity_cache_key_t *key, uint64_t key_hash,
+                             const void *data, size_t size) {
+	clarity_cache_header_t header;
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, CL_CACHE_MAGIC, sizeof header.magic);
+	header.version    = key->version;
+	header.input_hash = key->input_hash;
+	header.key_hash   = key_hash;
+	header.size       = size;
+
+	return cl_files_replace(path, &header, sizeof header, data, size);
+}
+
+
+clarity_status_t cl_cache_load(const clarity_cache_key_t *key, clarity_cache_build_fn_t build, void *data,
+                               clarity_blob_t *blob) {
+	memset(blob, 0, sizeof(*blob));
+
+	uint64_t key_hash = __cl_cache_key_hash(key);
+	char     dir[CL_CACHE_MAX_PATH];
+	char     stem[CL_CACHE_MAX_STEM + 16];
+	char     name[CL_CACHE_MAX_STEM + 40];
+	char     path[CL_CACHE_MAX_PATH];
+
+	__cl_cache_stem(key->name, stem, sizeof stem);
+	snprintf(name, sizeof name, "%s%016" PRIx64 ".blob", stem, key_hash);
+	bool cacheable = __cl_cache_directory(dir, sizeof dir)
+	                 && snprintf(path, sizeof path, "%s/%s", dir, name) < (int) sizeof path;
+
+	if (cacheable && __cl_cache_map(path, key, key_hash, blob))
+		return CL_SUCCESS;
+
+	size_t size   = 0;
+	void   *built = build(&size, data);
+	if (!built)
+		return CL_ERROR_BUILD;
+
+	if (cacheable && __cl_cache_store(path, key, key_hash, built, size))
+		__cl_cache_remove_stale(dir, stem, name);
+
+	blob->data    = built;
+	blob->size    = size;
+	blob->mapping = built;
+	return CL_SUCCESS;
+}
+
+
+void cl_cache_release(clarity_blob_t *blob) {
+	if (blob->mapping_size)
+		munmap(blob->mapping, blob->mapping_size);
+	else
+		free(blob->mapping);
+	memset(blob, 0, sizeof(*blob));
+}
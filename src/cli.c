@@ -0,0 +1,83 @@
+#include <CLarity/cli.h>
+#include <CLarity/stress.h>
+#include <CLarity/trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "budget.h"
+#include "distributed.h"
+#include "options.h"
+#include "runner.h"
+#include "server.h"
+#include "suite.h"
+#include "test.h"
+
+
+static int __cl_main_stress(const clarity_options_t *options, clarity_suite_t **suites, size_t suite_count) {
+	if (!options->filter) {
+		fprintf(stderr, "CLarity: --repeat and --until-failure need --test to select the tests to repeat\n");
+		return 2;
+	}
+
+	size_t selected = 0;
+	bool   passed   = true;
+	for (size_t i = 0; i < suite_count; i++) {
+		clarity_suite_t *suite = suites[i];
+		for (size_t j = 0; suite && j < suite->test_count; j++) {
+			clarity_test_t *test = suite->tests[j];
+			if (!test || !cl_runner_matches(options->filter, suite->name, test->name))
+				continue;
+
+			selected++;
+			passed &= cl_stress_test(suite, test->name, &options->stress_options);
+		}
+	}
+
+	if (!selected) {
+		fprintf(stderr, "CLarity: no test matches '%s'\n", options->filter);
+		return 2;
+	}
+	return passed ? 0 : 1;
+}
+
+
+static int __cl_main_run(const clarity_options_t *options, clarity_suite_t **suites, size_t suite_count) {
+	if (options->stress)
+		return __cl_main_stress(options, suites, suite_count);
+	if (options->coordinator)
+		return cl_distributed_coordinate(options->coordinator, options->filter, options->worker_timeout_s, suites,
+		                                 suite_count);
+	if (options->worker)
+		return cl_distributed_work(options->worker, options->batch, suites, suite_count);
+	if (options->serve)
+		return cl_server_serve(options->serve, suites, suite_count);
+	if (options->budget_ms || options->history)
+		return cl_budget_main(options, suites, suite_count);
+
+	return cl_runner_run_suites(suites, suite_count, options->filter, NULL) ? 0 : 1;
+}
+
+
+int cl_main(int argc, char **argv, clarity_suite_t **suites, size_t suite_count) {
+	const char        *program = argc > 0 ? argv[0] : "clarity";
+	clarity_options_t options;
+
+	if (!cl_options_parse(&options, argc, argv)) {
+		cl_options_usage(stderr, program);
+		return 2;
+	}
+	if (options.help) {
+		cl_options_usage(stdout, program);
+		return 0;
+	}
+
+	if (options.max_failures)
+		cl_set_max_failures(options.max_failures, 0);
+
+	const char *trace = options.trace ? options.trace : getenv(CL_TRACE_ENV);
+	if (trace && *trace)
+		cl_trace_start();
+	int status = __cl_main_run(&options, suites, suite_count);
+	if (trace && *trace && cl_trace_stop(trace) != CL_SUCCESS)
+		fprintf(stderr, "CLarity: could not write the timeline to '%s'\n", trace);
+	return status;
+}
@@ -0,0 +1,142 @@
+#include <CLarity/cli.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "printer.h"
+#include "server.h"
+#include "socket.h"
+#include "wire.h"
+
+typedef struct clarity_client_s {
+	int                    fd;
+	clarity_buffer_t       input;
+	clarity_buffer_t       output;
+	char                   *suite_name; /**< The name of the suite being reported. */
+	clarity_suite_report_t report;
+	bool                   passed;
+} clarity_client_t;
+
+
+static void __cl_client_usage(FILE *stream, const char *program) {
+	fprintf(stream,
+	        "Usage: %s ADDR [options]\n"
+	        "\n"
+	        "Runs tests in the test binary serving on ADDR (unix:PATH or tcp:HOST:PORT) with --serve.\n"
+	        "\n"
+	        "Options:\n"
+	        "  --test=PATTERN     only run the tests whose name or suite/name matches the glob PATTERN\n"
+	        "  --stop             stop the server, running the suite teardowns\n"
+	        "  --help             print this help\n",
+	        program);
+}
+
+
+static void __cl_client_result(clarity_client_t *client, char **fields, size_t field_count) {
+	if (field_count != 1 + CL_WIRE_RESULT_FIELDS)
+		return;
+
+	clarity_test_result_t result;
+	cl_wire_read_result(fields + 1, &result);
+	cl_print_test_result(&result);
+
+	client->report.total_tests++;
+	if (result.not_run)
+		client->report.not_run_tests++;
+	else if (result.skipped)
+		client->report.skipped_tests++;
+	else if (result.passed)
+		client->report.succeeded_tests++;
+	else
+		client->report.failed_tests++;
+}
+
+
+/**
+ * @brief Prints the messages of the server until the request is complete.
+ *
+ * @return The exit status of the client.
+ */
+static int __cl_client_receive(clarity_client_t *client) {
+	for (;;) {
+		char *line = cl_buffer_next_line(&client->input);
+		if (!line) {
+			if (cl_buffer_fill(&client->input, client->fd) <= 0) {
+				fprintf(stderr, "CLarity: lost the connection to the server\n");
+				return 2;
+			}
+			continue;
+		}
+
+		char   *fields[CL_WIRE_MAX_FIELDS];
+		size_t field_count = cl_wire_split(line, fields, CL_WIRE_MAX_FIELDS);
+		if (!strcmp(fields[0], "SUITE") && field_count == 2) {
+			free(client->suite_name);
+			client->suite_name = strdup(fields[1]);
+			memset(&client->report, 0, sizeof client->report);
+			client->report.name = client->suite_name;
+			cl_print_suite_name(fields[1]);
+		} else if (!strcmp(fields[0], "RESULT")) {
+			__cl_client_result(client, fields, field_count);
+		} else if (!strcmp(fields[0], "END")) {
+			cl_print_suite_report(&client->report);
+			client->passed &= client->report.failed_tests == 0;
+		} else if (!strcmp(fields[0], "DONE")) {
+			return client->passed ? 0 : 1;
+		} else if (!strcmp(fields[0], "ERROR") && field_count == 2) {
+			fprintf(stderr, "CLarity: the server rejected the request: %s\n", fields[1]);
+			return 2;
+		}
+	}
+}
+
+
+int cl_client_main(int argc, char **argv) {
+	const char *program = argc > 0 ? argv[0] : "clarity-client";
+	const char *address = NULL;
+	const char *filter  = NULL;
+	bool       stop     = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
+			__cl_client_usage(stdout, program);
+			return 0;
+		} else if (!strncmp(argv[i], "--test=", 7)) {
+			filter = argv[i] + 7;
+		} else if (!strcmp(argv[i], "--stop")) {
+			stop = true;
+		} else if (argv[i][0] != '-' && !address) {
+			address = argv[i];
+		} else {
+			fprintf(stderr, "CLarity: unknown option '%s'\n", argv[i]);
+			__cl_client_usage(stderr, program);
+			return 2;
+		}
+	}
+	if (!address) {
+		__cl_client_usage(stderr, program);
+		return 2;
+	}
+
+	clarity_client_t client;
+	memset(&client, 0, sizeof client);
+	client.passed = true;
+	client.fd     = cl_socket_connect(address, CL_SERVER_CONNECT_TIMEOUT_MS);
+	if (client.fd < 0)
+		return 2;
+
+	bool written = stop ? cl_wire_begin(&client.output, "STOP")
+	                    : cl_wire_begin(&client.output, "RUN") && cl_wire_add_string(&client.output, filter);
+	written      = written && cl_wire_end(&client.output);
+
+	int exit_status = 2;
+	if (written && cl_buffer_flush(&client.output, client.fd))
+		exit_status = __cl_client_receive(&client);
+
+	close(client.fd);
+	cl_buffer_free(&client.input);
+	cl_buffer_free(&client.output);
+	free(client.suite_name);
+	return exit_status;
+}
@@ -0,0 +1,221 @@
+#include "clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "test.h"
+#include "timing.h"
+
+/**
+ * @brief Checks whether a timer runs before another one.
+ */
+static bool __cl_clock_timer_before(const clarity_clock_timer_t *a, const clarity_clock_timer_t *b) {
+	if (a->deadline_ns != b->deadline_ns)
+		return a->deadline_ns < b->deadline_ns;
+	return a->id < b->id;
+}
+
+
+/**
+ * @brief Removes the next timer of a clock.
+ *
+ * The timers are kept from the last to run to the next one, so that the next one is popped from the end.
+ */
+static clarity_clock_timer_t __cl_clock_pop(clarity_clock_t *clock) {
+	return clock->timers[--clock->timer_count];
+}
+
+
+/**
+ * @brief Runs a timer which has been popped, and releases its data if it owns it.
+ */
+static void __cl_clock_run(clarity_clock_t *clock, clarity_clock_timer_t timer) {
+	timer.fn(clock, timer.data);
+	if (timer.owns_data)
+		free(timer.data);
+}
+
+
+/**
+ * @brief Sleeps on the monotonic clock until a time read by `cl_timing_now_ns`.
+ */
+static void __cl_clock_sleep_until(uint64_t deadline_ns) {
+	struct timespec ts = {
+		.tv_sec  = (time_t) (deadline_ns / 1000000000u),
+		.tv_nsec = (long) (deadline_ns % 1000000000u),
+	};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL))
+		;
+}
+
+
+clarity_clock_t *cl_clock_create(bool is_virtual) {
+	clarity_clock_t *clock = calloc(1, sizeof(*clock));
+	if (!clock)
+		return NULL;
+
+	clock->is_virtual = is_virtual;
+	return clock;
+}
+
+
+void cl_clock_reset(clarity_clock_t *clock, bool is_virtual) {
+	while (clock->timer_count) {
+		clarity_clock_timer_t timer = __cl_clock_pop(clock);
+		if (timer.owns_data)
+			free(timer.data);
+	}
+	clock->is_virtual = is_virtual;
+	clock->now_ns     = 0;
+}
+
+
+void cl_clock_free(clarity_clock_t *clock) {
+	if (!clock)
+		return;
+
+	cl_clock_reset(clock, false);
+	free(clock->timers);
+	free(clock);
+}
+
+
+clarity_status_t cl_clock_schedule(clarity_clock_t *clock, uint64_t delay_ns, clarity_clock_timer_fn_t fn,
+                                   void *data, bool owns_data, uint64_t *id) {
+	if (clock->timer_count >= clock->timer_capacity) {
+		size_t                new_capacity = clock->timer_capacity ? clock->timer_capacity * 2 : 16;
+		clarity_clock_timer_t *timers      = realloc(clock->timers, new_capacity * sizeof(*timers));
+		if (!timers)
+			return CL_ERROR_MEMORY;
+		clock->timers         = timers;
+		clock->timer_capacity = new_capacity;
+	}
+
+	clarity_clock_timer_t timer = {
+		.deadline_ns = cl_now(clock) + delay_ns,
+		.id          = ++clock->next_id,
+		.fn          = fn,
+		.data        = data,
+		.owns_data   = owns_data,
+	};
+
+	// Binary search for the first timer running before the new one, everything from there moves up.
+	size_t low  = 0;
+	size_t high = clock->timer_count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (__cl_clock_timer_before(&clock->timers[middle], &timer))
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	memmove(&clock->timers[low + 1], &clock->timers[low], (clock->timer_count - low) * sizeof(*clock->timers));
+	clock->timers[low] = timer;
+	clock->timer_count++;
+
+	if (id)
+		*id = timer.id;
+	return CL_SUCCESS;
+}
+
+
+size_t cl_clock_pending(const clarity_clock_t *clock) {
+	return clock->timer_count;
+}
+
+
+uint64_t cl_clock_next_deadline(const clarity_clock_t *clock) {
+	return clock->timers[clock->timer_count - 1].deadline_ns;
+}
+
+
+void cl_clock_fire_due(clarity_clock_t *clock) {
+	uint64_t now = cl_now(clock);
+	while (clock->timer_count && cl_clock_next_deadline(clock) <= now)
+		__cl_clock_run(clock, __cl_clock_pop(clock));
+}
+
+
+void cl_clock_advance(clarity_clock_t *clock) {
+	if (!clock->is_virtual || !clock->timer_count)
+		return;
+
+	uint64_t next = cl_clock_next_deadline(clock);
+	if (next > clock->now_ns)
+		clock->now_ns = next;
+	cl_clock_fire_due(clock);
+}
+
+
+uint64_t cl_now(const clarity_clock_t *clock) {
+	if (clock && clock->is_virtual)
+		return clock->now_ns;
+	return cl_timing_now_ns();
+}
+
+
+void cl_sleep(clarity_clock_t *clock, uint64_t ns) {
+	uint64_t target = cl_now(clock) + ns;
+	if (!clock) {
+		__cl_clock_sleep_until(target);
+		return;
+	}
+
+	if (clock->is_virtual) {
+		while (clock->timer_count && cl_clock_next_deadline(clock) <= target)
+			cl_clock_advance(clock);
+		if (target > clock->now_ns)
+			clock->now_ns = target;
+		return;
+	}
+
+	for (;;) {
+		cl_clock_fire_due(clock);
+		if (cl_timing_now_ns() >= target)
+			return;
+
+		uint64_t wake = target;
+		if (clock->timer_count && cl_clock_next_deadline(clock) < wake)
+			wake = cl_clock_next_deadline(clock);
+		__cl_clock_sleep_until(wake);
+	}
+}
+
+
+clarity_status_t cl_clock_add_timer(clarity_clock_t *clock, uint64_t delay_ns, clarity_clock_timer_fn_t fn,
+                                    void *data, uint64_t *id) {
+	return cl_clock_schedule(clock, delay_ns, fn, data, false, id);
+}
+
+
+void cl_clock_cancel_timer(clarity_clock_t *clock, uint64_t id) {
+	for (size_t i = 0; i < clock->timer_count; i++) {
+		if (clock->timers[i].id != id)
+			continue;
+
+		if (clock->timers[i].owns_data)
+			free(clock->timers[i].data);
+		memmove(&clock->timers[i], &clock->timers[i + 1], (clock->timer_count - i - 1) * sizeof(*clock->timers));
+		clock->timer_count--;
+		return;
+	}
+}
+
+
+clarity_status_t cl_test_use_virtual_time(clarity_test_t *test, bool enabled) {
+	if (!test)
+		return CL_SUCCESS;
+
+	test->virtual_time = enabled;
+	if (test->clock)
+		test->clock->is_virtual = enabled;
+	else if (enabled && !(test->clock = cl_clock_create(true)))
+		return CL_ERROR_MEMORY;
+	return CL_SUCCESS;
+}
+
+
+clarity_clock_t *cl_test_clock(clarity_test_t *test) {
+	if (!test->clock)
+		test->clock = cl_clock_create(test->virtual_time);
+	return test->clock;
+}
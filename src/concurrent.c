@@ -0,0 +1,310 @@
+#include <CLarity/concurrent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "test.h"
+
+/**
+ * @brief The state shared by the threads of `cl_run_concurrently`.
+ *
+ * It is released by the last of its users, which is not the caller when threads outlive the timeout.
+ */
+typedef struct clarity_concurrent_s {
+	clarity_concurrent_fn_t fn;
+	void                    *data;
+	uint64_t                iterations;
+	size_t                  threads;
+	clarity_test_t          *test;
+	atomic_bool             stop;
+
+	pthread_mutex_t   creating;
+	pthread_barrier_t start;
+	bool              started;
+
+	pthread_mutex_t lock;
+	pthread_cond_t  finished_cond;
+	size_t          finished;
+	size_t          references;
+
+	clarity_test_t **copies;
+	uint64_t       *failed_at; /**< The iteration each thread failed at. */
+	pthread_t      *handles;
+} clarity_concurrent_t;
+
+typedef struct clarity_concurrent_member_s {
+	clarity_concurrent_t *shared;
+	size_t               index;
+} clarity_concurrent_member_t;
+
+
+static void __cl_concurrent_free(clarity_concurrent_t *shared) {
+	for (size_t i = 0; i < shared->threads; i++)
+		cl_free_test(shared->copies[i]);
+	if (shared->started)
+		pthread_barrier_destroy(&shared->start);
+	pthread_mutex_destroy(&shared->creating);
+	pthread_mutex_destroy(&shared->lock);
+	pthread_cond_destroy(&shared->finished_cond);
+	free(shared->copies);
+	free(shared->failed_at);
+	free(shared->handles);
+	free(shared);
+}
+
+
+static void __cl_concurrent_release(clarity_concurrent_t *shared) {
+	pthread_mutex_lock(&shared->lock);
+	bool last = --shared->references == 0;
+	pthread_mutex_unlock(&shared->lock);
+	if (last)
+		__cl_concurrent_free(shared);
+}
+
+
+static void *__cl_concurrent_main(void *arg) {
+	clarity_concurrent_member_t member = *(clarity_concurrent_member_t *) arg;
+	clarity_concurrent_t        *shared = member.shared;
+	clarity_test_t              *copy   = shared->copies[member.index];
+
+	free(arg);
+	// Wait for all the threads to be created, the barrier is only valid once they all exist.
+	pthread_mutex_lock(&shared->creating);
+	pthread_mutex_unlock(&shared->creating);
+	if (shared->started) {
+		pthread_barrier_wait(&shared->start);
+		for (uint64_t i = 0; i < shared->iterations && !atomic_load_explicit(&shared->stop, memory_order_relaxed);
+		     i++) {
+			shared->fn(copy, member.index, i, shared->data);
+			cl_test_flush_expectations(copy);
+			cl_arena_reset(&copy->arena);
+			if (!copy->result.passed || copy->result.skipped) {
+				shared->failed_at[member.index] = i;
+				atomic_store(&shared->stop, true);
+			}
+			if (cl_test_cancelled(shared->test))
+				atomic_store(&shared->stop, true);
+		}
+	}
+
+	pthread_mutex_lock(&shared->lock);
+	shared->finished++;
+	pthread_cond_signal(&shared->finished_cond);
+	pthread_mutex_unlock(&shared->lock);
+	__cl_concurrent_release(shared);
+	return NULL;
+}
+
+
+static clarity_concurrent_t *__cl_concurrent_create(clarity_test_t *test, clarity_concurrent_fn_t fn, void *data,
+                                                    size_t threads, uint64_t iterations) {
+	clarity_concurrent_t *shared = calloc(1, sizeof(*shared));
+	if (!shared)
+		return NULL;
+
+	shared->fn         = fn;
+	shared->data       = data;
+	shared->iterations = iterations;
+	shared->threads    = threads;
+	shared->test       = test;
+	shared->references = 1;
+	atomic_init(&shared->stop, false);
+	pthread_mutex_init(&shared->creating, NULL);
+	pthread_mutex_init(&shared->lock, NULL);
+	// The timeout is measured on the monotonic clock, which a change of the system time does not move.
+	pthread_condattr_t attributes;
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&shared->finished_cond, &attributes);
+	pthread_condattr_destroy(&attributes);
+
+	shared->copies    = calloc(threads, sizeof(*shared->copies));
+	shared->failed_at = calloc(threads, sizeof(*shared->failed_at));
+	shared->handles   = calloc(threads, sizeof(*shared->handles));
+	bool ready = shared->copies && shared->failed_at && shared->handles;
+	for (size_t i = 0; ready && i < threads; i++)
+		ready = (shared->copies[i] = cl_test_clone(test)) != NULL;
+	if (!ready) {
+		__cl_concurrent_free(shared);
+		return NULL;
+	}
+	return shared;
+}
+
+
+/**
+ * @brief Starts the threads, which wait on the start barrier.
+ *
+ * @return The number of threads started, all of them or none.
+ */
+static size_t __cl_concurrent_start(clarity_concurrent_t *shared) {
+	size_t created = 0;
+
+	pthread_mutex_lock(&shared->creating);
+	for (; created < shared->threads; created++) {
+		clarity_concurrent_member_t *member = malloc(sizeof(*member));
+		if (!member)
+			break;
+		member->shared = shared;
+		member->index  = created;
+
+		pthread_mutex_lock(&shared->lock);
+		shared->references++;
+		pthread_mutex_unlock(&shared->lock);
+		if (pthread_create(&shared->handles[created], NULL, __cl_concurrent_main, member) != 0) {
+			shared->references--;
+			free(member);
+			break;
+		}
+	}
+
+	// Without all of its threads, the run does not start: the ones created leave right away.
+	shared->started = created == shared->threads &&
+	                  pthread_barrier_init(&shared->start, NULL, (unsigned) shared->threads) == 0;
+	pthread_mutex_unlock(&shared->creating);
+
+	if (!shared->started) {
+		for (size_t i = 0; i < created; i++)
+			pthread_join(shared->handles[i], NULL);
+		return 0;
+	}
+	return created;
+}
+
+
+/**
+ * @brief Waits for the threads to finish, until the timeout.
+ *
+ * @return The number of threads which did not finish.
+ */
+static size_t __cl_concurrent_wait(clarity_concurrent_t *shared, uint32_t timeout_ms) {
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec  += timeout_ms / 1000;
+	deadline.tv_nsec += (long) (timeout_ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&shared->lock);
+	while (shared->finished < shared->threads) {
+		if (pthread_cond_timedwait(&shared->finished_cond, &shared->lock, &deadline) == ETIMEDOUT)
+			break;
+	}
+	size_t running = shared->threads - shared->finished;
+	pthread_mutex_unlock(&shared->lock);
+
+	// The threads which are stuck keep running on their own, the others are joined.
+	atomic_store(&shared->stop, true);
+	for (size_t i = 0; i < shared->threads; i++) {
+		if (running)
+			pthread_detach(shared->handles[i]);
+		else
+			pthread_join(shared->handles[i], NULL);
+	}
+	return running;
+}
+
+
+/**
+ * @brief Formats a message to hand over to a test.
+ *
+ * @return The message, allocated with `malloc`, or NULL if the allocation failed.
+ */
+static char *__cl_concurrent_format(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+
+static char *__cl_concurrent_format(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+	char *text = len < 0 ? NULL : malloc((size_t) len + 1);
+	if (!text)
+		return NULL;
+
+	va_start(args, format);
+	vsnprintf(text, (size_t) len + 1, format, args);
+	va_end(args);
+	return text;
+}
+
+
+/**
+ * @brief Records the earliest failure of the threads on the test, or their skip if none failed.
+ *
+ * @return Whether no thread failed.
+ */
+static bool __cl_concurrent_collect(clarity_concurrent_t *shared) {
+	size_t failures = 0;
+	size_t first    = shared->threads;
+	size_t skipped  = shared->threads;
+
+	for (size_t i = 0; i < shared->threads; i++) {
+		const clarity_test_result_t *result = &shared->copies[i]->result;
+		if (result->passed && !result->skipped)
+			continue;
+		if (result->passed) {
+			if (skipped == shared->threads)
+				skipped = i;
+			continue;
+		}
+
+		failures++;
+		if (first == shared->threads || shared->failed_at[i] < shared->failed_at[first])
+			first = i;
+	}
+
+	if (!failures) {
+		if (skipped < shared->threads) {
+			const clarity_test_result_t *result = &shared->copies[skipped]->result;
+			cl_test_record(shared->test, result->file_name, result->line_number, true, result->error_message, NULL);
+		}
+		return true;
+	}
+
+	const clarity_test_result_t *result  = &shared->copies[first]->result;
+	const char                  *message = result->error_message ? result->error_message : "failed";
+	unsigned long long          at       = (unsigned long long) shared->failed_at[first];
+	char                        *text;
+	if (failures > 1)
+		text = __cl_concurrent_format("thread %zu, iteration %llu: %s (%zu threads failed)", first, at, message,
+		                              failures);
+	else
+		text = __cl_concurrent_format("thread %zu, iteration %llu: %s", first, at, message);
+	cl_test_record(shared->test, result->file_name, result->line_number, false, "a thread failed", text);
+	return false;
+}
+
+
+bool cl_run_concurrently(clarity_test_t *test, clarity_concurrent_fn_t fn, void *data, size_t threads,
+                         uint64_t iterations, uint32_t timeout_ms) {
+	if (!test || !fn)
+		return false;
+	if (!threads)
+		threads = 1;
+	if (!timeout_ms)
+		timeout_ms = CL_DEFAULT_CONCURRENT_TIMEOUT_MS;
+
+	clarity_concurrent_t *shared = __cl_concurrent_create(test, fn, data, threads, iterations);
+	if (!shared || !__cl_concurrent_start(shared)) {
+		if (shared)
+			__cl_concurrent_release(shared);
+		cl_test_record(test, NULL, 0, false, "could not start the threads of the concurrent run", NULL);
+		return false;
+	}
+
+	// The copies of the threads which are stuck may still change, the others are left alone.
+	size_t stuck  = __cl_concurrent_wait(shared, timeout_ms);
+	bool   passed = !stuck && __cl_concurrent_collect(shared);
+	if (stuck)
+		cl_test_record(test, NULL, 0, false, "the threads did not finish in time",
+		               __cl_concurrent_format("%zu of %zu threads did not finish within %u ms", stuck, threads,
+		                                      timeout_ms));
+	__cl_concurrent_release(shared);
+	return passed;
+}
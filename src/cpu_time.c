@@ -0,0 +1,77 @@
+#include <CLarity/assertions.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+#include "test.h"
+#include "timing.h"
+
+/**
+ * @brief The CPU time a sample should last at least, for the resolution and the cost of the clock not to matter.
+ */
+#define CL_CPU_TIME_MIN_SAMPLE_NS 100000u
+
+/**
+ * @brief The CPU time after which a slow region is not sampled anymore, once it has its fewest samples.
+ */
+#define CL_CPU_TIME_MAX_TOTAL_NS 250000000u
+
+
+/**
+ * @brief Get the factor applied to the budgets, from the environment.
+ */
+static double __cl_cpu_time_slack(void) {
+	const char *env = getenv(CL_PERF_SLACK_ENV);
+	if (!env || !*env)
+		return 1;
+
+	char   *end;
+	double slack = strtod(env, &end);
+	return *end || !(slack > 0) ? 1 : slack;
+}
+
+
+/**
+ * @brief Runs a region a number of times, and measures the CPU time it took.
+ */
+static uint64_t __cl_cpu_time_measure(clarity_region_fn_t fn, void *data, uint64_t runs) {
+	uint64_t start = cl_timing_thread_cpu_ns();
+	for (uint64_t i = 0; i < runs; i++)
+		fn(data);
+	return cl_timing_thread_cpu_ns() - start;
+}
+
+
+bool __cl_assert_cpu_time_below(clarity_test_t *test, uint64_t budget_ns, clarity_region_fn_t fn, void *data,
+                                const char *file, size_t line) {
+	// The first warm-up run tells how many runs a sample needs to outlast the resolution of the clock.
+	uint64_t first = __cl_cpu_time_measure(fn, data, 1);
+	for (int i = 1; i < CL_CPU_TIME_WARMUP_RUNS; i++)
+		__cl_cpu_time_measure(fn, data, 1);
+	uint64_t runs = first >= CL_CPU_TIME_MIN_SAMPLE_NS ? 1 : CL_CPU_TIME_MIN_SAMPLE_NS / (first ? first : 1);
+
+	uint64_t samples[CL_CPU_TIME_SAMPLES];
+	uint64_t total = 0;
+	size_t   count = 0;
+	while (count < CL_CPU_TIME_SAMPLES && (count < CL_CPU_TIME_MIN_SAMPLES || total < CL_CPU_TIME_MAX_TOTAL_NS)) {
+		uint64_t elapsed = __cl_cpu_time_measure(fn, data, runs);
+		total           += elapsed;
+		samples[count++] = elapsed / runs;
+	}
+
+	clarity_sample_summary_t summary = cl_stats_summarise(samples, count);
+	double                   slack   = __cl_cpu_time_slack();
+	double                   budget  = (double) budget_ns * slack;
+	if (summary.median <= budget)
+		return true;
+
+	char distribution[160], limit[32], text[256];
+	cl_stats_format_summary(&summary, distribution, sizeof distribution);
+	cl_timing_format(budget, limit, sizeof limit);
+	if (slack != 1)
+		snprintf(text, sizeof text, "CPU time above its budget of %s (slack %g): %s", limit, slack, distribution);
+	else
+		snprintf(text, sizeof text, "CPU time above its budget of %s: %s", limit, distribution);
+	cl_test_record(test, file, line, false, "CPU time above its budget", strdup(text));
+	return false;
+}
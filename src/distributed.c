@@ -0,0 +1,650 @@
+#define _GNU_SOURCE
+#include "distributed.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "runner.h"
+#include "socket.h"
+#include "suite.h"
+#include "test.h"
+#include "timing.h"
+#include "wire.h"
+
+/**
+ * @brief A test to run somewhere, as seen by the coordinator.
+ */
+typedef struct clarity_work_item_s {
+	size_t                suite;    /**< The position of the suite in the suites of the binary. */
+	size_t                test;     /**< The position of the test in its suite, generated tests coming last. */
+	char                  *name;    /**< The name of the test. */
+	uint32_t              attempts; /**< The number of workers lost while running the test. */
+	bool                  done;     /**< Whether the result of the test is known. */
+	clarity_test_result_t result;   /**< The result of the test, owning its file name and message. */
+} clarity_work_item_t;
+
+/**
+ * @brief A worker connected to the coordinator.
+ */
+typedef struct clarity_remote_worker_s {
+	int              fd;
+	clarity_buffer_t input;
+	clarity_buffer_t output;
+	bool             greeted;  /**< Whether the worker said hello. */
+	bool             lost;     /**< Whether the worker must be disconnected. */
+	uint32_t         wanted;   /**< The number of tests the worker is waiting for. */
+	size_t           *running; /**< The items handed to the worker and not reported yet. */
+	size_t           running_count;
+	size_t           running_capacity;
+} clarity_remote_worker_t;
+
+typedef struct clarity_coordinator_s {
+	clarity_suite_t         **suites;
+	size_t                  suite_count;
+	clarity_work_item_t     *items;
+	size_t                  item_count;
+	size_t                  item_capacity;
+	size_t                  done_count;
+	size_t                  *pending; /**< The items waiting for a worker, the next one last. */
+	size_t                  pending_count;
+	clarity_remote_worker_t **workers;
+	size_t                  worker_count;
+	size_t                  worker_capacity;
+	uint32_t                timeout_s;
+	uint64_t                progress_ns; /**< When the last result came, or the last worker connected. */
+} clarity_coordinator_t;
+
+
+static bool __cl_coordinator_add_item(clarity_coordinator_t *coordinator, size_t suite, size_t test,
+                                      const char *name) {
+	if (coordinator->item_count >= coordinator->item_capacity) {
+		size_t              new_capacity = coordinator->item_capacity ? coordinator->item_capacity * 2 : 64;
+		clarity_work_item_t *items       = realloc(coordinator->items, new_capacity * sizeof(*items));
+		if (!items)
+			return false;
+		coordinator->items         = items;
+		coordinator->item_capacity = new_capacity;
+	}
+
+	clarity_work_item_t *item = &coordinator->items[coordinator->item_count];
+	memset(item, 0, sizeof(*item));
+	item->suite = suite;
+	item->test  = test;
+	item->name  = strdup(name);
+	if (!item->name)
+		return false;
+
+	coordinator->item_count++;
+	return true;
+}
+
+
+static bool __cl_coordinator_collect(clarity_coordinator_t *coordinator, const char *filter) {
+	for (size_t i = 0; i < coordinator->suite_count; i++) {
+		clarity_suite_t *suite = coordinator->suites[i];
+		if (!suite)
+			continue;
+
+		for (size_t j = 0; j < suite->test_count; j++) {
+			clarity_test_t *test = suite->tests[j];
+			if (!test || !cl_runner_matches(filter, suite->name, test->name))
+				continue;
+			if (!__cl_coordinator_add_item(coordinator, i, j, test->name))
+				return false;
+		}
+
+		// Generators are deterministic, the coordinator only creates the tests to know their names.
+		for (size_t j = 0; j < suite->generated_count; j++) {
+			clarity_test_t *test = suite->generator(j, suite->generator_data);
+			const char     *name = test ? test->name : "generated test";
+			bool           added = true;
+			if (!test || cl_runner_matches(filter, suite->name, name))
+				added = __cl_coordinator_add_item(coordinator, i, suite->test_count + j, name);
+			cl_free_test(test);
+			if (!added)
+				return false;
+		}
+	}
+
+	coordinator->pending = malloc((coordinator->item_count + 1) * sizeof(*coordinator->pending));
+	if (!coordinator->pending)
+		return false;
+	for (size_t i = 0; i < coordinator->item_count; i++)
+		coordinator->pending[i] = coordinator->item_count - 1 - i;
+	coordinator->pending_count = coordinator->item_count;
+	return true;
+}
+
+
+static void __cl_coordinator_complete(clarity_coordinator_t *coordinator, clarity_work_item_t *item,
+                                      const clarity_test_result_t *result) {
+	item->result               = *result;
+	item->result.name          = item->name;
+	item->result.file_name     = result->file_name ? strdup(result->file_name) : NULL;
+	item->result.error_message = result->error_message ? strdup(result->error_message) : NULL;
+	if (!item->result.passed && !item->result.error_message)
+		item->result.error_message = strdup("the result of the test could not be stored");
+	item->done = true;
+	coordinator->done_count++;
+	coordinator->progress_ns = cl_timing_now_ns();
+}
+
+
+static void __cl_coordinator_send(clarity_remote_worker_t *worker) {
+	if (!worker->lost && !cl_buffer_flush(&worker->output, worker->fd))
+		worker->lost = true;
+}
+
+
+static void __cl_coordinator_dispatch(clarity_coordinator_t *coordinator, clarity_remote_worker_t *worker) {
+	if (worker->lost || !worker->wanted || !coordinator->pending_count)
+		return;
+
+	size_t count = worker->wanted < coordinator->pending_count ? worker->wanted : coordinator->pending_count;
+	if (worker->running_count + count > worker->running_capacity) {
+		size_t new_capacity = worker->running_count + count;
+		size_t *running     = realloc(worker->running, new_capacity * sizeof(*running));
+		if (!running) {
+			worker->lost = true;
+			return;
+		}
+		worker->running          = running;
+		worker->running_capacity = new_capacity;
+	}
+
+	bool written = true;
+	for (size_t i = 0; i < count; i++) {
+		size_t              index = coordinator->pending[--coordinator->pending_count];
+		clarity_work_item_t *item = &coordinator->items[index];
+
+		worker->running[worker->running_count++] = index;
+		written = written
+		          && cl_wire_begin(&worker->output, "RUN")
+		          && cl_wire_add_u64(&worker->output, index)
+		          && cl_wire_add_u64(&worker->output, item->suite)
+		          && cl_wire_add_u64(&worker->output, item->test)
+		          && cl_wire_add_string(&worker->output, item->name)
+		          && cl_wire_end(&worker->output);
+	}
+	written = written && cl_wire_begin(&worker->output, "END") && cl_wire_end(&worker->output);
+
+	worker->wanted = 0;
+	if (!written)
+		worker->lost = true;
+	__cl_coordinator_send(worker);
+}
+
+
+static void __cl_coordinator_dispatch_all(clarity_coordinator_t *coordinator) {
+	for (size_t i = 0; i < coordinator->worker_count && coordinator->pending_count; i++)
+		__cl_coordinator_dispatch(coordinator, coordinator->workers[i]);
+}
+
+
+static void __cl_coordinator_reject(clarity_remote_worker_t *worker, const char *reason) {
+	if (cl_wire_begin(&worker->output, "ERROR") && cl_wire_add_string(&worker->output, reason)
+	    && cl_wire_end(&worker->output))
+		__cl_coordinator_send(worker);
+	worker->lost = true;
+}
+
+
+static void __cl_coordinator_receive_result(clarity_coordinator_t *coordinator, clarity_remote_worker_t *worker,
+                                            char **fields, size_t field_count) {
+	if (field_count != 2 + CL_WIRE_RESULT_FIELDS) {
+		__cl_coordinator_reject(worker, "malformed result");
+		return;
+	}
+
+	size_t index = (size_t) cl_wire_u64(fields[1]);
+	for (size_t i = 0; i < worker->running_count; i++) {
+		if (worker->running[i] != index)
+			continue;
+
+		worker->running[i] = worker->running[--worker->running_count];
+		clarity_test_result_t result;
+		cl_wire_read_result(fields + 2, &result);
+		__cl_coordinator_complete(coordinator, &coordinator->items[index], &result);
+		return;
+	}
+	__cl_coordinator_reject(worker, "result of a test that was not handed to this worker");
+}
+
+
+static void __cl_coordinator_receive(clarity_coordinator_t *coordinator, clarity_remote_worker_t *worker) {
+	char *line;
+	while (!worker->lost && (line = cl_buffer_next_line(&worker->input))) {
+		char   *fields[CL_WIRE_MAX_FIELDS];
+		size_t field_count = cl_wire_split(line, fields, CL_WIRE_MAX_FIELDS);
+
+		if (!strcmp(fields[0], "HELLO")) {
+			if (field_count != 3 || cl_wire_u64(fields[1]) != CL_DISTRIBUTED_PROTOCOL_VERSION)
+				__cl_coordinator_reject(worker, "unsupported protocol version");
+			else if (cl_wire_u64(fields[2]) != coordinator->suite_count)
+				__cl_coordinator_reject(worker, "the worker does not have the suites of the coordinator");
+			else
+				worker->greeted = true;
+		} else if (!worker->greeted) {
+			__cl_coordinator_reject(worker, "expected HELLO");
+		} else if (!strcmp(fields[0], "GET") && field_count == 2) {
+			uint64_t wanted = cl_wire_u64(fields[1]);
+			worker->wanted  = wanted ? (wanted < UINT32_MAX ? (uint32_t) wanted : UINT32_MAX) : 1;
+			__cl_coordinator_dispatch(coordinator, worker);
+		} else if (!strcmp(fields[0], "RESULT")) {
+			__cl_coordinator_receive_result(coordinator, worker, fields, field_count);
+		} else {
+			__cl_coordinator_reject(worker, "unknown message");
+		}
+	}
+}
+
+
+static void __cl_coordinator_accept(clarity_coordinator_t *coordinator, int listener) {
+	int fd = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+	if (fd < 0)
+		return;
+
+	if (coordinator->worker_count >= coordinator->worker_capacity) {
+		size_t                  new_capacity = coordinator->worker_capacity ? coordinator->worker_capacity * 2 : 8;
+		clarity_remote_worker_t **workers    = realloc(coordinator->workers, new_capacity * sizeof(*workers));
+		if (!workers) {
+			close(fd);
+			return;
+		}
+		coordinator->workers         = workers;
+		coordinator->worker_capacity = new_capacity;
+	}
+
+	clarity_remote_worker_t *worker = calloc(1, sizeof(*worker));
+	if (!worker) {
+		close(fd);
+		return;
+	}
+	worker->fd = fd;
+	coordinator->workers[coordinator->worker_count++] = worker;
+	coordinator->progress_ns = cl_timing_now_ns();
+}
+
+
+static void __cl_coordinator_free_worker(clarity_remote_worker_t *worker) {
+	close(worker->fd);
+	cl_buffer_free(&worker->input);
+	cl_buffer_free(&worker->output);
+	free(worker->running);
+	free(worker);
+}
+
+
+/**
+ * @brief Disconnects a worker, and gives its tests in flight back to the other workers.
+ */
+static void __cl_coordinator_lose(clarity_coordinator_t *coordinator, clarity_remote_worker_t *worker) {
+	for (size_t i = 0; i < worker->running_count; i++) {
+		size_t              index = worker->running[i];
+		clarity_work_item_t *item = &coordinator->items[index];
+
+		if (++item->attempts < CL_DISTRIBUTED_MAX_ATTEMPTS) {
+			coordinator->pending[coordinator->pending_count++] = index;
+			continue;
+		}
+
+		char message[128];
+		snprintf(message, sizeof message, "the test took down %u workers without reporting a result",
+		         item->attempts);
+		clarity_test_result_t result = { .passed = false, .error_message = message };
+		__cl_coordinator_complete(coordinator, item, &result);
+	}
+	__cl_coordinator_free_worker(worker);
+}
+
+
+/**
+ * @brief Fails the tests without a result once the workers made no progress for the timeout.
+ *
+ * The workers still running tests are stuck in them, they are disconnected rather than given the tests again.
+ */
+static void __cl_coordinator_expire(clarity_coordinator_t *coordinator) {
+	char message[128];
+	snprintf(message, sizeof message, "no worker reported a result within %u s", coordinator->timeout_s);
+	clarity_test_result_t result = { .passed = false, .error_message = message };
+
+	for (size_t i = 0; i < coordinator->worker_count; i++) {
+		clarity_remote_worker_t *worker = coordinator->workers[i];
+		for (size_t j = 0; j < worker->running_count; j++)
+			__cl_coordinator_complete(coordinator, &coordinator->items[worker->running[j]], &result);
+		if (worker->running_count)
+			worker->lost = true;
+		worker->running_count = 0;
+	}
+	while (coordinator->pending_count)
+		__cl_coordinator_complete(coordinator, &coordinator->items[coordinator->pending[--coordinator->pending_count]],
+		                          &result);
+}
+
+
+/**
+ * @brief The time left before the timeout, in milliseconds for `poll`.
+ */
+static int __cl_coordinator_time_left(const clarity_coordinator_t *coordinator) {
+	uint64_t elapsed_ms = (cl_timing_now_ns() - coordinator->progress_ns) / 1000000u;
+	uint64_t timeout_ms = (uint64_t) coordinator->timeout_s * 1000u;
+	if (elapsed_ms >= timeout_ms)
+		return 0;
+	return timeout_ms - elapsed_ms < INT32_MAX ? (int) (timeout_ms - elapsed_ms) : INT32_MAX;
+}
+
+
+static bool __cl_coordinator_poll(clarity_coordinator_t *coordinator, int listener) {
+	struct pollfd *fds = malloc((coordinator->worker_count + 1) * sizeof(*fds));
+	if (!fds)
+		return false;
+
+	fds[0] = (struct pollfd){ .fd = listener, .events = POLLIN };
+	for (size_t i = 0; i < coordinator->worker_count; i++)
+		fds[i + 1] = (struct pollfd){ .fd = coordinator->workers[i]->fd, .events = POLLIN };
+
+	size_t count = coordinator->worker_count;
+	int    ready = poll(fds, count + 1, __cl_coordinator_time_left(coordinator));
+	if (ready < 0) {
+		free(fds);
+		return errno == EINTR;
+	}
+	if (!ready && !__cl_coordinator_time_left(coordinator))
+		__cl_coordinator_expire(coordinator);
+
+	for (size_t i = 0; i < count; i++) {
+		clarity_remote_worker_t *worker = coordinator->workers[i];
+		if (!fds[i + 1].revents)
+			continue;
+		if (cl_buffer_fill(&worker->input, worker->fd) <= 0)
+			worker->lost = true;
+		__cl_coordinator_receive(coordinator, worker);
+	}
+	if (fds[0].revents & POLLIN)
+		__cl_coordinator_accept(coordinator, listener);
+	free(fds);
+
+	size_t kept = 0;
+	for (size_t i = 0; i < coordinator->worker_count; i++) {
+		clarity_remote_worker_t *worker = coordinator->workers[i];
+		if (worker->lost)
+			__cl_coordinator_lose(coordinator, worker);
+		else
+			coordinator->workers[kept++] = worker;
+	}
+	coordinator->worker_count = kept;
+
+	__cl_coordinator_dispatch_all(coordinator);
+	return true;
+}
+
+
+static bool __cl_coordinator_report(clarity_coordinator_t *coordinator) {
+	bool   passed = true;
+	size_t next   = 0;
+
+	for (size_t i = 0; i < coordinator->suite_count; i++) {
+		clarity_suite_t *suite = coordinator->suites[i];
+		if (next >= coordinator->item_count || coordinator->items[next].suite != i)
+			continue;
+
+		clarity_run_t run;
+		memset(&run, 0, sizeof run);
+		run.suite       = suite;
+		run.report.name = suite->name;
+		if (suite->streaming)
+			run.stream = cl_stream_create(suite->stream_max_failures, suite->stream_max_slowest);
+
+		cl_print_suite_name(suite->name);
+		for (; next < coordinator->item_count && coordinator->items[next].suite == i; next++)
+			cl_runner_report_test(&run, &coordinator->items[next].result);
+
+		if (run.stream) {
+			cl_stream_finish(run.stream);
+			cl_print_stream_summary(run.stream);
+			cl_stream_free(run.stream);
+		}
+		cl_print_suite_report(&run.report);
+		passed &= run.report.failed_tests == 0;
+	}
+	return passed;
+}
+
+
+static void __cl_coordinator_free(clarity_coordinator_t *coordinator) {
+	for (size_t i = 0; i < coordinator->worker_count; i++) {
+		clarity_remote_worker_t *worker = coordinator->workers[i];
+		if (cl_wire_begin(&worker->output, "DONE") && cl_wire_end(&worker->output))
+			__cl_coordinator_send(worker);
+		__cl_coordinator_free_worker(worker);
+	}
+	for (size_t i = 0; i < coordinator->item_count; i++) {
+		clarity_work_item_t *item = &coordinator->items[i];
+		free(item->name);
+		free((char *) item->result.file_name);
+		free((char *) item->result.error_message);
+	}
+	free(coordinator->workers);
+	free(coordinator->items);
+	free(coordinator->pending);
+}
+
+
+int cl_distributed_coordinate(const char *address, const char *filter, uint32_t timeout_s, clarity_suite_t **suites,
+                              size_t suite_count) {
+	clarity_coordinator_t coordinator;
+	memset(&coordinator, 0, sizeof coordinator);
+	coordinator.suites      = suites;
+	coordinator.suite_count = suite_count;
+	coordinator.timeout_s   = timeout_s;
+	coordinator.progress_ns = cl_timing_now_ns();
+
+	if (!__cl_coordinator_collect(&coordinator, filter)) {
+		fprintf(stderr, "CLarity: could not list the tests to distribute\n");
+		__cl_coordinator_free(&coordinator);
+		return 2;
+	}
+
+	int listener = -1;
+	if (coordinator.item_count) {
+		listener = cl_socket_listen(address);
+		if (listener < 0) {
+			__cl_coordinator_free(&coordinator);
+			return 2;
+		}
+	}
+
+	bool polling = true;
+	while (polling && coordinator.done_count < coordinator.item_count)
+		polling = __cl_coordinator_poll(&coordinator, listener);
+
+	bool passed = polling && __cl_coordinator_report(&coordinator);
+	__cl_coordinator_free(&coordinator);
+	if (listener >= 0)
+		cl_socket_close_listener(listener, address);
+
+	if (!polling) {
+		fprintf(stderr, "CLarity: the coordinator stopped waiting for workers: %s\n", strerror(errno));
+		return 2;
+	}
+	return passed ? 0 : 1;
+}
+
+
+/**
+ * @brief The state of a worker, one run per suite of the binary.
+ */
+typedef struct clarity_local_worker_s {
+	clarity_suite_t  **suites;
+	size_t           suite_count;
+	clarity_run_t    *runs;
+	bool             *set_up;  /**< Whether the suite setup has run, and so the teardown must run. */
+	bool             *broken;  /**< Whether the suite setup reported an error. */
+	int              fd;
+	clarity_buffer_t input;
+	clarity_buffer_t output;
+} clarity_local_worker_t;
+
+
+static bool __cl_worker_prepare_suite(clarity_local_worker_t *worker, size_t index) {
+	clarity_suite_t *suite = worker->suites[index];
+	if (worker->set_up[index] || worker->broken[index])
+		return !worker->broken[index];
+
+	int status = 0;
+	if (cl_fixture_run_setup(suite->suite_fixture, &status) && status) {
+		worker->broken[index] = true;
+		return false;
+	}
+
+	clarity_run_t *run = &worker->runs[index];
+	run->suite       = suite;
+	run->report.name = suite->name;
+	// Recording needs every sample of the suite at once, which no single worker has.
+	if (cl_baseline_effective_mode(suite) == CL_BASELINE_COMPARE)
+		run->baseline = cl_baseline_load_reference(suite);
+	worker->set_up[index] = true;
+	return true;
+}
+
+
+static clarity_test_t *__cl_worker_find_test(clarity_suite_t *suite, size_t position, bool *owned) {
+	*owned = false;
+	if (position < suite->test_count)
+		return suite->tests[position];
+	if (position - suite->test_count >= suite->generated_count)
+		return NULL;
+
+	*owned = true;
+	return suite->generator(position - suite->test_count, suite->generator_data);
+}
+
+
+/**
+ * @brief Runs a test handed out by the coordinator, and sends its result back.
+ *
+ * @return false if the worker must stop, because a fixture failed or the coordinator is gone.
+ */
+static bool __cl_worker_run(clarity_local_worker_t *worker, char **fields) {
+	uint64_t       index       = cl_wire_u64(fields[1]);
+	size_t         suite_index = (size_t) cl_wire_u64(fields[2]);
+	size_t         position    = (size_t) cl_wire_u64(fields[3]);
+	const char     *name       = fields[4];
+	clarity_test_t *test       = NULL;
+	bool           owned       = false;
+	bool           state       = true;
+
+	clarity_test_result_t result = { .name = name, .passed = false };
+	if (suite_index < worker->suite_count && worker->suites[suite_index])
+		test = __cl_worker_find_test(worker->suites[suite_index], position, &owned);
+
+	if (!test || strcmp(test->name, name) != 0) {
+		result.error_message = "the worker does not have this test, it must be the same binary as the coordinator";
+	} else if (!__cl_worker_prepare_suite(worker, suite_index)) {
+		result.error_message = "the suite setup reported an error on the worker";
+	} else {
+		cl_test_reset_result(test);
+		state = cl_runner_run_test(&worker->runs[suite_index], test, &result);
+	}
+
+	// A failed send is noticed by the next read, which may still find the coordinator releasing the worker.
+	bool written = cl_wire_begin(&worker->output, "RESULT")
+	               && cl_wire_add_u64(&worker->output, index)
+	               && cl_wire_add_result(&worker->output, &result)
+	               && cl_wire_end(&worker->output);
+	if (written)
+		cl_buffer_flush(&worker->output, worker->fd);
+	if (owned)
+		cl_free_test(test);
+	return state && written;
+}
+
+
+static bool __cl_worker_request(clarity_local_worker_t *worker, uint32_t batch) {
+	if (!cl_wire_begin(&worker->output, "GET") || !cl_wire_add_u64(&worker->output, batch)
+	    || !cl_wire_end(&worker->output))
+		return false;
+
+	// The coordinator closes the connection once every test has a result, the reply to this may be DONE.
+	cl_buffer_flush(&worker->output, worker->fd);
+	return true;
+}
+
+
+static int __cl_worker_loop(clarity_local_worker_t *worker, uint32_t batch) {
+	bool greeted = cl_wire_begin(&worker->output, "HELLO")
+	               && cl_wire_add_u64(&worker->output, CL_DISTRIBUTED_PROTOCOL_VERSION)
+	               && cl_wire_add_u64(&worker->output, worker->suite_count)
+	               && cl_wire_end(&worker->output);
+	if (!greeted || !__cl_worker_request(worker, batch))
+		return 1;
+
+	for (;;) {
+		char *line = cl_buffer_next_line(&worker->input);
+		if (!line) {
+			if (cl_buffer_fill(&worker->input, worker->fd) <= 0) {
+				fprintf(stderr, "CLarity: lost the connection to the coordinator\n");
+				return 1;
+			}
+			continue;
+		}
+
+		char   *fields[CL_WIRE_MAX_FIELDS];
+		size_t field_count = cl_wire_split(line, fields, CL_WIRE_MAX_FIELDS);
+		if (!strcmp(fields[0], "RUN") && field_count == 5) {
+			if (!__cl_worker_run(worker, fields))
+				return 1;
+		} else if (!strcmp(fields[0], "END")) {
+			if (!__cl_worker_request(worker, batch))
+				return 1;
+		} else if (!strcmp(fields[0], "DONE")) {
+			return 0;
+		} else if (!strcmp(fields[0], "ERROR") && field_count == 2) {
+			fprintf(stderr, "CLarity: the coordinator rejected the worker: %s\n", fields[1]);
+			return 2;
+		} else {
+			fprintf(stderr, "CLarity: unexpected message from the coordinator\n");
+			return 1;
+		}
+	}
+}
+
+
+int cl_distributed_work(const char *address, uint32_t batch, clarity_suite_t **suites, size_t suite_count) {
+	clarity_local_worker_t worker;
+	memset(&worker, 0, sizeof worker);
+	worker.suites      = suites;
+	worker.suite_count = suite_count;
+	worker.runs        = calloc(suite_count + 1, sizeof(*worker.runs));
+	worker.set_up      = calloc(suite_count + 1, sizeof(*worker.set_up));
+	worker.broken      = calloc(suite_count + 1, sizeof(*worker.broken));
+
+	int exit_status = 2;
+	if (worker.runs && worker.set_up && worker.broken) {
+		worker.fd = cl_socket_connect(address, CL_DISTRIBUTED_CONNECT_TIMEOUT_MS);
+		if (worker.fd >= 0) {
+			exit_status = __cl_worker_loop(&worker, batch ? batch : CL_DISTRIBUTED_DEFAULT_BATCH);
+			close(worker.fd);
+		}
+	}
+
+	for (size_t i = suite_count; worker.set_up && i-- > 0;) {
+		if (!worker.set_up[i])
+			continue;
+
+		int status = 0;
+		if (cl_fixture_run_teardown(suites[i]->suite_fixture, &status) && status && !exit_status)
+			exit_status = 1;
+		cl_baseline_free(worker.runs[i].baseline);
+	}
+
+	cl_buffer_free(&worker.input);
+	cl_buffer_free(&worker.output);
+	free(worker.runs);
+	free(worker.set_up);
+	free(worker.broken);
+	return exit_status;
+}
@@ -0,0 +1,603 @@
+#define _GNU_SOURCE
+#include <CLarity/cli.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "printer.h"
+#include "protocol.h"
+#include "timing.h"
+#include "wire.h"
+
+/**
+ * @brief How often the driver looks for binaries which exited while something they started keeps their output open.
+ */
+#define CL_DRIVER_TICK_MS 100
+
+/**
+ * @brief The names of the test binaries found in directories, unless told otherwise.
+ */
+#define CL_DRIVER_DEFAULT_MATCH "*test*"
+
+/**
+ * @brief A test binary, from the moment it is found to its outcome.
+ */
+typedef struct clarity_binary_s {
+	char                   *path;
+	pid_t                  pid;         /**< The process running the binary, 0 when it is not running. */
+	int                    output_fd;   /**< The read end of its standard output and error, or -1. */
+	int                    protocol_fd; /**< The read end of the descriptor it reports on, or -1. */
+	clarity_buffer_t       output;
+	clarity_buffer_t       protocol;
+	uint64_t               start_ns;
+	bool                   timed_out;
+	char                   **suites;    /**< The names of the suites started and not ended, innermost last. */
+	size_t                 depth;
+	size_t                 capacity;
+	clarity_suite_report_t report;      /**< The sum of the reports of its outermost suites. */
+	clarity_buffer_t       failures;    /**< The failed tests, one per line. */
+	bool                   passed;
+} clarity_binary_t;
+
+typedef struct clarity_driver_s {
+	clarity_binary_t *binaries;
+	size_t           count;
+	size_t           capacity;
+	const char       *match;
+	size_t           jobs;
+	uint32_t         timeout_s;
+	bool             verbose;
+	char             **argv;    /**< The arguments of the binaries, the first one being the binary itself. */
+	size_t           next;      /**< The first binary not started yet. */
+	size_t           running;
+} clarity_driver_t;
+
+
+static void __cl_driver_usage(FILE *stream, const char *program) {
+	fprintf(stream,
+	        "Usage: %s [options] PATH... [-- ARGS]\n"
+	        "\n"
+	        "Runs the CLarity test binaries at PATH, or in the directories at PATH, in parallel, and merges their\n"
+	        "results. The ARGS are given to every binary.\n"
+	        "\n"
+	        "Options:\n"
+	        "  --manifest=PATH    run the binaries listed in PATH, one per line, such as %s\n"
+	        "  --match=GLOB       the names of the binaries in directories, %s by default\n"
+	        "  --jobs=N           run at most N binaries at once, one per core by default\n"
+	        "  --timeout=SECONDS  kill a binary which runs for longer than SECONDS\n"
+	        "  --verbose          print the output of every binary, not only of the ones which failed\n"
+	        "  --help             print this help\n",
+	        program, CL_DRIVER_MANIFEST, CL_DRIVER_DEFAULT_MATCH);
+}
+
+
+static bool __cl_driver_add(clarity_driver_t *driver, const char *path) {
+	if (driver->count == driver->capacity) {
+		size_t           capacity = driver->capacity ? driver->capacity * 2 : 16;
+		clarity_binary_t *binaries = realloc(driver->binaries, capacity * sizeof(*binaries));
+		if (!binaries)
+			return false;
+		driver->binaries = binaries;
+		driver->capacity = capacity;
+	}
+
+	clarity_binary_t *binary = &driver->binaries[driver->count];
+	memset(binary, 0, sizeof(*binary));
+	binary->path        = strdup(path);
+	binary->output_fd   = -1;
+	binary->protocol_fd = -1;
+	if (!binary->path)
+		return false;
+	driver->count++;
+	return true;
+}
+
+
+static int __cl_driver_compare_names(const void *a, const void *b) {
+	return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+
+/**
+ * @brief Adds the executables of a directory whose name matches the pattern, sorted by name.
+ */
+static bool __cl_driver_scan(clarity_driver_t *driver, const char *directory) {
+	DIR *dir = opendir(directory);
+	if (!dir) {
+		fprintf(stderr, "CLarity: could not open the directory '%s': %s\n", directory, strerror(errno));
+		return false;
+	}
+
+	char          **names   = NULL;
+	size_t        count     = 0;
+	size_t        capacity  = 0;
+	bool          state     = true;
+	struct dirent *entry;
+	while (state && (entry = readdir(dir))) {
+		if (entry->d_name[0] == '.' || fnmatch(driver->match, entry->d_name, 0) != 0)
+			continue;
+		if (count == capacity) {
+			capacity     = capacity ? capacity * 2 : 16;
+			char **grown = realloc(names, capacity * sizeof(*names));
+			state        = grown != NULL;
+			names        = grown ? grown : names;
+		}
+		if (state)
+			state = (names[count++] = strdup(entry->d_name)) != NULL;
+	}
+	closedir(dir);
+
+	if (state)
+		qsort(names, count, sizeof(*names), __cl_driver_compare_names);
+	for (size_t i = 0; i < count; i++) {
+		char        *path = NULL;
+		struct stat info;
+		if (state && names[i] && asprintf(&path, "%s/%s", directory, names[i]) >= 0) {
+			if (stat(path, &info) == 0 && S_ISREG(info.st_mode) && access(path, X_OK) == 0)
+				state = __cl_driver_add(driver, path);
+		} else {
+			state = false;
+		}
+		free(path);
+		free(names[i]);
+	}
+	free(names);
+	return state;
+}
+
+
+/**
+ * @brief Adds the binaries listed in a manifest, skipping empty lines and comments.
+ */
+static bool __cl_driver_read_manifest(clarity_driver_t *driver, const char *manifest) {
+	FILE *file = fopen(manifest, "r");
+	if (!file) {
+		fprintf(stderr, "CLarity: could not open the manifest '%s': %s\n", manifest, strerror(errno));
+		return false;
+	}
+
+	const char *slash     = strrchr(manifest, '/');
+	int        dir_length = slash ? (int) (slash - manifest) : 1;
+	const char *directory = slash ? manifest : ".";
+	char       *line      = NULL;
+	size_t     size       = 0;
+	ssize_t    length;
+	bool       state      = true;
+	while (state && (length = getline(&line, &size, file)) >= 0) {
+		while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+			line[--length] = '\0';
+		if (!length || line[0] == '#')
+			continue;
+
+		char *path = NULL;
+		if (line[0] == '/')
+			state = __cl_driver_add(driver, line);
+		else if (asprintf(&path, "%.*s/%s", dir_length, directory, line) >= 0)
+			state = __cl_driver_add(driver, path);
+		else
+			state = false;
+		free(path);
+	}
+	free(line);
+	fclose(file);
+	return state;
+}
+
+
+static bool __cl_driver_parse_number(const char *text, unsigned long max, unsigned long *value) {
+	char *end;
+	errno  = 0;
+	*value = strtoul(text, &end, 10);
+	return !errno && *text && !*end && *value && *value <= max;
+}
+
+
+/**
+ * @brief Parses the command line into the driver.
+ *
+ * @return 0 to run the binaries, 1 if the usage was printed on request, 2 on a usage error.
+ */
+static int __cl_driver_parse(clarity_driver_t *driver, int argc, char **argv) {
+	const char    *program = argc > 0 ? argv[0] : "clarity-run";
+	unsigned long value;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg  = argv[i];
+		bool       valid = true;
+		if (!strcmp(arg, "--")) {
+			driver->argv = argv + i;
+			break;
+		} else if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+			__cl_driver_usage(stdout, program);
+			return 1;
+		} else if (!strncmp(arg, "--manifest=", 11)) {
+			if (!__cl_driver_read_manifest(driver, arg + 11))
+				return 2;
+		} else if (!strncmp(arg, "--match=", 8)) {
+			driver->match = arg + 8;
+		} else if (!strncmp(arg, "--jobs=", 7)) {
+			valid = __cl_driver_parse_number(arg + 7, 4096, &value);
+			driver->jobs = (size_t) value;
+		} else if (!strncmp(arg, "--timeout=", 10)) {
+			valid = __cl_driver_parse_number(arg + 10, UINT32_MAX, &value);
+			driver->timeout_s = (uint32_t) value;
+		} else if (!strcmp(arg, "--verbose")) {
+			driver->verbose = true;
+		} else if (arg[0] == '-') {
+			fprintf(stderr, "CLarity: unknown option '%s'\n", arg);
+			__cl_driver_usage(stderr, program);
+			return 2;
+		} else {
+			struct stat info;
+			if (stat(arg, &info) == 0 && S_ISDIR(info.st_mode)) {
+				if (!__cl_driver_scan(driver, arg))
+					return 2;
+			} else if (!__cl_driver_add(driver, arg)) {
+				return 2;
+			}
+		}
+
+		if (!valid) {
+			fprintf(stderr, "CLarity: invalid value in '%s'\n", arg);
+			return 2;
+		}
+	}
+
+	if (!driver->count) {
+		fprintf(stderr, "CLarity: no test binary found\n");
+		__cl_driver_usage(stderr, program);
+		return 2;
+	}
+	return 0;
+}
+
+
+static bool __cl_driver_push_suite(clarity_binary_t *binary, const char *name) {
+	if (binary->depth == binary->capacity) {
+		size_t capacity = binary->capacity ? binary->capacity * 2 : 4;
+		char   **suites = realloc(binary->suites, capacity * sizeof(*suites));
+		if (!suites)
+			return false;
+		binary->suites   = suites;
+		binary->capacity = capacity;
+	}
+	char *copy = strdup(name);
+	if (!copy)
+		return false;
+	binary->suites[binary->depth++] = copy;
+	return true;
+}
+
+
+static void __cl_driver_end_suite(clarity_binary_t *binary, char **fields) {
+	if (!binary->depth)
+		return;
+	free(binary->suites[--binary->depth]);
+
+	// The report of a suite includes the suites nested in it, only the outermost ones add up.
+	if (binary->depth)
+		return;
+	binary->report.total_tests     += (uint32_t) cl_wire_u64(fields[2]);
+	binary->report.succeeded_tests += (uint32_t) cl_wire_u64(fields[3]);
+	binary->report.failed_tests    += (uint32_t) cl_wire_u64(fields[4]);
+	binary->report.skipped_tests   += (uint32_t) cl_wire_u64(fields[5]);
+	binary->report.not_run_tests   += (uint32_t) cl_wire_u64(fields[6]);
+}
+
+
+static void __cl_driver_record_failure(clarity_binary_t *binary, char **fields) {
+	clarity_test_result_t result;
+	cl_wire_read_result(fields, &result);
+	if (result.passed || result.skipped)
+		return;
+
+	// Only the first line of the message is listed, the output of the binary has the rest.
+	const char *suite   = binary->depth ? binary->suites[binary->depth - 1] : NULL;
+	const char *message = result.error_message ? result.error_message : "failed";
+	int        length   = (int) strcspn(message, "\n");
+	const char *file    = result.file_name ? strrchr(result.file_name, '/') : NULL;
+	char       *line    = NULL;
+	int        len;
+	file = file ? file + 1 : result.file_name;
+	if (file)
+		len = asprintf(&line, "[%s%s%s] %.*s (%s:%zu)\n", suite ? suite : "", suite ? "/" : "", result.name,
+		               length, message, file, result.line_number);
+	else
+		len = asprintf(&line, "[%s%s%s] %.*s\n", suite ? suite : "", suite ? "/" : "", result.name, length,
+		               message);
+	if (len >= 0)
+		cl_buffer_append(&binary->failures, line, (size_t) len);
+	free(line);
+}
+
+
+static void __cl_driver_receive(clarity_binary_t *binary) {
+	char *line;
+	while ((line = cl_buffer_next_line(&binary->protocol))) {
+		char   *fields[CL_WIRE_MAX_FIELDS];
+		size_t field_count = cl_wire_split(line, fields, CL_WIRE_MAX_FIELDS);
+		if (!strcmp(fields[0], "SUITE") && field_count == 2)
+			__cl_driver_push_suite(binary, fields[1]);
+		else if (!strcmp(fields[0], "RESULT") && field_count == 1 + CL_WIRE_RESULT_FIELDS)
+			__cl_driver_record_failure(binary, fields + 1);
+		else if (!strcmp(fields[0], "END") && field_count == 7)
+			__cl_driver_end_suite(binary, fields);
+	}
+}
+
+
+/**
+ * @brief Reads what is available on a descriptor of a binary, and closes it at the end of the stream.
+ */
+static void __cl_driver_read(clarity_binary_t *binary, int *fd, clarity_buffer_t *buffer) {
+	if (*fd < 0)
+		return;
+
+	ssize_t len;
+	while ((len = cl_buffer_fill(buffer, *fd)) > 0)
+		continue;
+	if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+		close(*fd);
+		*fd = -1;
+	}
+	if (buffer == &binary->protocol)
+		__cl_driver_receive(binary);
+}
+
+
+static bool __cl_driver_spawn(clarity_driver_t *driver, clarity_binary_t *binary) {
+	int output[2], protocol[2];
+	if (pipe2(output, O_CLOEXEC) != 0)
+		return false;
+	if (pipe2(protocol, O_CLOEXEC) != 0) {
+		close(output[0]);
+		close(output[1]);
+		return false;
+	}
+
+	driver->argv[0] = binary->path;
+	fflush(stdout);
+	fflush(stderr);
+	pid_t pid = fork();
+	if (pid == 0) {
+		// The binary and everything it starts form a group, which a timeout kills at once.
+		setpgid(0, 0);
+		int null = open("/dev/null", O_RDONLY);
+		if (null >= 0)
+			dup2(null, STDIN_FILENO);
+		dup2(output[1], STDOUT_FILENO);
+		dup2(output[1], STDERR_FILENO);
+		fcntl(protocol[1], F_SETFD, 0);
+
+		char fd[16];
+		snprintf(fd, sizeof fd, "%d", protocol[1]);
+		setenv(CL_PROTOCOL_FD_ENV, fd, 1);
+		execv(binary->path, driver->argv);
+		fprintf(stderr, "CLarity: could not run '%s': %s\n", binary->path, strerror(errno));
+		_exit(127);
+	}
+
+	close(output[1]);
+	close(protocol[1]);
+	if (pid < 0) {
+		close(output[0]);
+		close(protocol[0]);
+		return false;
+	}
+
+	setpgid(pid, pid);
+	fcntl(output[0], F_SETFL, O_NONBLOCK);
+	fcntl(protocol[0], F_SETFL, O_NONBLOCK);
+	binary->pid         = pid;
+	binary->output_fd   = output[0];
+	binary->protocol_fd = protocol[0];
+	binary->start_ns    = cl_timing_now_ns();
+	driver->running++;
+	return true;
+}
+
+
+/**
+ * @brief Decides the outcome of a binary which exited, and prints it with its output if needed.
+ */
+static void __cl_driver_finish(clarity_driver_t *driver, clarity_binary_t *binary, int status) {
+	char message[256];
+	if (binary->timed_out)
+		snprintf(message, sizeof message, "timed out after %u s", driver->timeout_s);
+	else if (WIFSIGNALED(status))
+		snprintf(message, sizeof message, "killed by signal %d (%s)", WTERMSIG(status), strsignal(WTERMSIG(status)));
+	else if (WEXITSTATUS(status) && binary->report.failed_tests)
+		snprintf(message, sizeof message, "%u of %u tests failed", binary->report.failed_tests,
+		         binary->report.total_tests);
+	else if (WEXITSTATUS(status) && binary->depth)
+		snprintf(message, sizeof message, "exited with status %d in suite '%s'", WEXITSTATUS(status),
+		         binary->suites[binary->depth - 1]);
+	else if (WEXITSTATUS(status))
+		snprintf(message, sizeof message, "exited with status %d", WEXITSTATUS(status));
+	else
+		message[0] = '\0';
+
+	// Like for any test runner, the exit status of the binary is its verdict, which its own checks may decide.
+	clarity_test_result_t result = {
+		.name          = binary->path,
+		.passed        = !message[0],
+		.duration_ns   = cl_timing_now_ns() - binary->start_ns,
+		.error_message = message,
+	};
+	binary->passed = result.passed;
+
+	if (!result.passed || driver->verbose)
+		fwrite(binary->output.data + binary->output.consumed, 1, binary->output.length - binary->output.consumed,
+		       stdout);
+	cl_print_test_result(&result);
+	fflush(stdout);
+
+	cl_buffer_free(&binary->output);
+	cl_buffer_free(&binary->protocol);
+	while (binary->depth)
+		free(binary->suites[--binary->depth]);
+	free(binary->suites);
+	binary->suites = NULL;
+	binary->pid    = 0;
+	driver->running--;
+}
+
+
+/**
+ * @brief Collects a binary if it exited, reading what it left in its pipes.
+ */
+static void __cl_driver_collect(clarity_driver_t *driver, clarity_binary_t *binary) {
+	// Until its pipes are closed, the binary is either running or left processes behind which hold them.
+	bool closed = binary->output_fd < 0 && binary->protocol_fd < 0;
+	int  status = 0;
+	pid_t pid;
+	do {
+		pid = waitpid(binary->pid, &status, closed ? 0 : WNOHANG);
+	} while (pid < 0 && errno == EINTR);
+	if (pid == 0)
+		return;
+
+	__cl_driver_read(binary, &binary->output_fd, &binary->output);
+	__cl_driver_read(binary, &binary->protocol_fd, &binary->protocol);
+	if (binary->output_fd >= 0)
+		close(binary->output_fd);
+	if (binary->protocol_fd >= 0)
+		close(binary->protocol_fd);
+	binary->output_fd   = -1;
+	binary->protocol_fd = -1;
+	__cl_driver_finish(driver, binary, status);
+}
+
+
+static void __cl_driver_poll(clarity_driver_t *driver, struct pollfd *fds) {
+	nfds_t count = 0;
+	for (size_t i = 0; i < driver->next; i++) {
+		const clarity_binary_t *binary = &driver->binaries[i];
+		if (binary->output_fd >= 0)
+			fds[count++] = (struct pollfd){ .fd = binary->output_fd, .events = POLLIN };
+		if (binary->protocol_fd >= 0)
+			fds[count++] = (struct pollfd){ .fd = binary->protocol_fd, .events = POLLIN };
+	}
+	if (count)
+		poll(fds, count, CL_DRIVER_TICK_MS);
+
+	uint64_t now = cl_timing_now_ns();
+	for (size_t i = 0; i < driver->next; i++) {
+		clarity_binary_t *binary = &driver->binaries[i];
+		if (!binary->pid)
+			continue;
+
+		__cl_driver_read(binary, &binary->output_fd, &binary->output);
+		__cl_driver_read(binary, &binary->protocol_fd, &binary->protocol);
+		if (driver->timeout_s && !binary->timed_out && now - binary->start_ns >= driver->timeout_s * 1000000000ull) {
+			binary->timed_out = true;
+			kill(-binary->pid, SIGKILL);
+			kill(binary->pid, SIGKILL);
+		}
+		__cl_driver_collect(driver, binary);
+	}
+}
+
+
+static void __cl_driver_run(clarity_driver_t *driver, struct pollfd *fds) {
+	while (driver->next < driver->count || driver->running) {
+		while (driver->running < driver->jobs && driver->next < driver->count) {
+			clarity_binary_t *binary = &driver->binaries[driver->next++];
+			if (__cl_driver_spawn(driver, binary))
+				continue;
+
+			char message[256];
+			snprintf(message, sizeof message, "could not be started: %s", strerror(errno));
+			clarity_test_result_t result = { .name = binary->path, .error_message = message };
+			cl_print_test_result(&result);
+		}
+		__cl_driver_poll(driver, fds);
+	}
+}
+
+
+/**
+ * @brief Prints the failed tests of all the binaries, and the totals of the run.
+ *
+ * @return Whether every binary passed.
+ */
+static bool __cl_driver_report(const clarity_driver_t *driver, const char *title) {
+	clarity_suite_report_t totals = { 0 };
+	size_t                 failed = 0;
+	bool                   listed = false;
+
+	for (size_t i = 0; i < driver->count; i++) {
+		const clarity_binary_t *binary = &driver->binaries[i];
+		totals.total_tests     += binary->report.total_tests;
+		totals.succeeded_tests += binary->report.succeeded_tests;
+		totals.failed_tests    += binary->report.failed_tests;
+		totals.skipped_tests   += binary->report.skipped_tests;
+		totals.not_run_tests   += binary->report.not_run_tests;
+		failed                 += !binary->passed;
+
+		if (binary->passed || !binary->failures.length)
+			continue;
+		if (!listed)
+			printf("Failed tests:\n");
+		listed = true;
+		printf("  %s\n", binary->path);
+		const char *line = binary->failures.data;
+		const char *end  = binary->failures.data + binary->failures.length;
+		while (line < end) {
+			const char *next = memchr(line, '\n', (size_t) (end - line));
+			printf("    %.*s\n", (int) (next - line), line);
+			line = next + 1;
+		}
+	}
+
+	char name[128];
+	snprintf(name, sizeof name, "%s, %zu failed", title, failed);
+	totals.name = name;
+	cl_print_suite_report(&totals);
+	return failed == 0;
+}
+
+
+int cl_driver_main(int argc, char **argv) {
+	clarity_driver_t driver;
+	memset(&driver, 0, sizeof driver);
+	driver.match = CL_DRIVER_DEFAULT_MATCH;
+
+	int  parsed = __cl_driver_parse(&driver, argc, argv);
+	char *args[] = { NULL, NULL };
+	if (!driver.argv)
+		driver.argv = args;
+	if (!driver.jobs) {
+		long cores  = sysconf(_SC_NPROCESSORS_ONLN);
+		driver.jobs = cores > 0 ? (size_t) cores : 1;
+	}
+
+	int           exit_status = parsed == 1 ? 0 : 2;
+	struct pollfd *fds        = parsed ? NULL : malloc(2 * driver.jobs * sizeof(*fds));
+	if (fds) {
+		char title[96];
+		snprintf(title, sizeof title, "%zu test binaries, %zu at once", driver.count,
+		         driver.jobs < driver.count ? driver.jobs : driver.count);
+		cl_print_suite_name(title);
+		__cl_driver_run(&driver, fds);
+
+		snprintf(title, sizeof title, "%zu test binaries", driver.count);
+		exit_status = __cl_driver_report(&driver, title) ? 0 : 1;
+	}
+
+	for (size_t i = 0; i < driver.count; i++) {
+		free(driver.binaries[i].path);
+		cl_buffer_free(&driver.binaries[i].failures);
+	}
+	free(driver.binaries);
+	free(fds);
+	return exit_status;
+}
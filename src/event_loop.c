@@ -0,0 +1,517 @@
+#include "event_loop.h"
+#include "arena.h"
+#include "clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "test.h"
+#include "timing.h"
+#include "trace.h"
+
+#define CL_EVENT_LOOP_BATCH 64
+
+typedef struct clarity_loop_timer_s {
+	uint64_t                 deadline_ns;
+	uint64_t                 sequence;
+	clarity_async_t          *async;
+	clarity_async_timer_fn_t fn; /**< NULL for the timeout of the test. */
+	void                     *data;
+} clarity_loop_timer_t;
+
+struct clarity_event_loop_s {
+	int                              epoll_fd;
+	size_t                           max_in_flight;
+	size_t                           in_flight;
+	clarity_event_loop_complete_fn_t complete;
+	void                             *context;
+
+	size_t               timer_count;
+	size_t               timer_capacity;
+	uint64_t             next_sequence;
+	clarity_loop_timer_t *timers;
+
+	clarity_async_t *done;      /**< The completed tests, in the order they completed. */
+	clarity_async_t **done_tail;
+	clarity_async_t *clocked; /**< The tests with a clock, including completed ones not released yet. */
+};
+
+/**
+ * @brief A timer of an asynchronous test running on a virtual clock, registered on the clock of the test.
+ */
+typedef struct clarity_async_clock_timer_s {
+	clarity_async_t          *async;
+	clarity_async_timer_fn_t fn;
+	void                     *data;
+} clarity_async_clock_timer_t;
+
+
+static bool __cl_timer_before(const clarity_loop_timer_t *a, const clarity_loop_timer_t *b) {
+	if (a->deadline_ns != b->deadline_ns)
+		return a->deadline_ns < b->deadline_ns;
+	return a->sequence < b->sequence;
+}
+
+
+static void __cl_timer_sift_down(clarity_event_loop_t *loop, size_t i) {
+	for (;;) {
+		size_t first = i;
+		size_t left  = 2 * i + 1;
+		size_t right = left + 1;
+		if (left < loop->timer_count && __cl_timer_before(&loop->timers[left], &loop->timers[first]))
+			first = left;
+		if (right < loop->timer_count && __cl_timer_before(&loop->timers[right], &loop->timers[first]))
+			first = right;
+		if (first == i)
+			return;
+
+		clarity_loop_timer_t tmp = loop->timers[i];
+		loop->timers[i]     = loop->timers[first];
+		loop->timers[first] = tmp;
+		i = first;
+	}
+}
+
+
+static bool __cl_timer_push(clarity_event_loop_t *loop, clarity_loop_timer_t timer) {
+	if (loop->timer_count >= loop->timer_capacity) {
+		size_t               new_capacity = loop->timer_capacity ? loop->timer_capacity * 2 : 64;
+		clarity_loop_timer_t *timers      = realloc(loop->timers, new_capacity * sizeof(*timers));
+		if (!timers)
+			return false;
+		loop->timers         = timers;
+		loop->timer_capacity = new_capacity;
+	}
+
+	timer.sequence = loop->next_sequence++;
+	size_t i = loop->timer_count++;
+	loop->timers[i] = timer;
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (!__cl_timer_before(&loop->timers[i], &loop->timers[parent]))
+			break;
+		clarity_loop_timer_t tmp = loop->timers[i];
+		loop->timers[i]      = loop->timers[parent];
+		loop->timers[parent] = tmp;
+		i = parent;
+	}
+	return true;
+}
+
+
+static clarity_loop_timer_t __cl_timer_pop(clarity_event_loop_t *loop) {
+	clarity_loop_timer_t top = loop->timers[0];
+	loop->timers[0] = loop->timers[--loop->timer_count];
+	__cl_timer_sift_down(loop, 0);
+	return top;
+}
+
+
+static uint64_t __cl_event_loop_now(const clarity_event_loop_t *loop) {
+	(void) loop;
+	return cl_timing_now_ns();
+}
+
+
+static void __cl_async_complete(clarity_async_t *async) {
+	if (async->done)
+		return;
+
+	clarity_event_loop_t *loop = async->loop;
+	async->done = true;
+	if (async->test->clock)
+		cl_clock_reset(async->test->clock, async->test->virtual_time);
+	for (clarity_async_watch_t *watch = async->watches; watch; watch = watch->next) {
+		if (watch->fd >= 0)
+			epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, watch->fd, NULL);
+	}
+
+	async->test->result.duration_ns = __cl_event_loop_now(loop) - async->start_ns;
+	// The span starts on the same clock as the test, if the timeline is still being recorded.
+	cl_trace_span(cl_trace_now() ? async->start_ns : 0, "async", NULL, async->test->name);
+	cl_test_flush_expectations(async->test);
+	cl_arena_reset(&async->test->arena);
+	loop->in_flight--;
+
+	// The test may complete from a timer its clock is running, which must not see the test freed under it.
+	async->next_done = NULL;
+	if (loop->done)
+		*loop->done_tail = async;
+	else
+		loop->done = async;
+	loop->done_tail = &async->next_done;
+}
+
+
+/**
+ * @brief Completes a test that has nothing left to wait for.
+ *
+ * Nothing could ever call `cl_async_done` for such a test, waiting for its timeout would only waste time.
+ */
+static void __cl_async_check_stalled(clarity_async_t *async) {
+	if (async->done || async->watched || async->timers || (async->clock && cl_clock_pending(async->clock)))
+		return;
+
+	clarity_test_t *test = async->test;
+	if (test->result.passed && !test->result.skipped) {
+		test->result.passed    = false;
+		test->result.file_name = NULL;
+		test->result.error_message = "the test has nothing left to wait for, but did not call cl_async_done";
+	}
+	__cl_async_complete(async);
+}
+
+
+/**
+ * @brief Lets the loop drive the timers of the clock of a test, once the test has one.
+ *
+ * The clock is created on first use, which may be in the test function itself.
+ */
+static void __cl_async_track_clock(clarity_async_t *async) {
+	if (async->clock || async->done || !async->test->clock)
+		return;
+
+	clarity_event_loop_t *loop = async->loop;
+	async->clock        = async->test->clock;
+	async->next_clocked = loop->clocked;
+	loop->clocked       = async;
+}
+
+
+/**
+ * @brief Reports the completed tests and releases them, once nothing runs on their behalf anymore.
+ */
+static void __cl_event_loop_release_done(clarity_event_loop_t *loop) {
+	if (!loop->done)
+		return;
+
+	size_t kept = 0;
+	for (size_t i = 0; i < loop->timer_count; i++) {
+		if (!loop->timers[i].async->done)
+			loop->timers[kept++] = loop->timers[i];
+	}
+	loop->timer_count = kept;
+	for (size_t i = kept / 2; i-- > 0;)
+		__cl_timer_sift_down(loop, i);
+
+	for (clarity_async_t **link = &loop->clocked; *link;) {
+		if ((*link)->done)
+			*link = (*link)->next_clocked;
+		else
+			link = &(*link)->next_clocked;
+	}
+
+	while (loop->done) {
+		clarity_async_t *async = loop->done;
+		loop->done = async->next_done;
+
+		if (loop->complete)
+			loop->complete(loop->context, async->test, async->cookie);
+
+		while (async->watches) {
+			clarity_async_watch_t *watch = async->watches;
+			async->watches = watch->next;
+			free(watch);
+		}
+		free(async);
+	}
+}
+
+
+clarity_event_loop_t *cl_event_loop_create(size_t max_in_flight, clarity_event_loop_complete_fn_t complete,
+                                           void *context) {
+	clarity_event_loop_t *loop = calloc(1, sizeof(*loop));
+	if (!loop)
+		return NULL;
+
+	loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (loop->epoll_fd < 0) {
+		free(loop);
+		return NULL;
+	}
+	loop->max_in_flight = max_in_flight ? max_in_flight : 1;
+	loop->complete      = complete;
+	loop->context       = context;
+
+	return loop;
+}
+
+
+clarity_status_t cl_event_loop_submit(clarity_event_loop_t *loop, clarity_test_t *test, void *cookie) {
+	clarity_async_t *async = calloc(1, sizeof(*async));
+	if (!async)
+		return CL_ERROR_MEMORY;
+
+	async->loop        = loop;
+	async->test        = test;
+	async->cookie      = cookie;
+	async->start_ns    = __cl_event_loop_now(loop);
+	async->deadline_ns = async->start_ns + (uint64_t) test->timeout_ms * 1000000u;
+
+	clarity_loop_timer_t timeout = { .deadline_ns = async->deadline_ns, .async = async };
+	if (!__cl_timer_push(loop, timeout)) {
+		free(async);
+		return CL_ERROR_MEMORY;
+	}
+	loop->in_flight++;
+
+	if (test->clock)
+		cl_clock_reset(test->clock, test->virtual_time);
+	__cl_async_track_clock(async);
+
+	if (test->result.skipped)
+		__cl_async_complete(async);
+	else
+		test->async_fn(test, async, test->user_data);
+	__cl_async_track_clock(async);
+	__cl_async_check_stalled(async);
+	__cl_event_loop_release_done(loop);
+
+	return CL_SUCCESS;
+}
+
+
+size_t cl_event_loop_in_flight(const clarity_event_loop_t *loop) {
+	return loop->in_flight;
+}
+
+
+size_t cl_event_loop_capacity(const clarity_event_loop_t *loop) {
+	return loop->max_in_flight;
+}
+
+
+/**
+ * @brief Computes the time to wait for file descriptor events, in milliseconds, -1 to wait forever.
+ *
+ * A test on a virtual clock which only waits for timers does not wait at all: its clock jumps to the next one.
+ */
+static int __cl_event_loop_timeout(const clarity_event_loop_t *loop) {
+	bool     has_deadline = loop->timer_count > 0;
+	uint64_t deadline     = has_deadline ? loop->timers[0].deadline_ns : 0;
+	uint64_t cancel       = cl_test_cancel_deadline();
+	if (cancel && loop->in_flight && (!has_deadline || cancel < deadline)) {
+		deadline     = cancel;
+		has_deadline = true;
+	}
+	for (clarity_async_t *async = loop->clocked; async; async = async->next_clocked) {
+		if (async->done || !cl_clock_pending(async->clock))
+			continue;
+		if (async->clock->is_virtual) {
+			if (!async->watched)
+				return 0;
+			continue;
+		}
+
+		uint64_t next = cl_clock_next_deadline(async->clock);
+		if (!has_deadline || next < deadline)
+			deadline = next;
+		has_deadline = true;
+	}
+	if (!has_deadline)
+		return -1;
+
+	uint64_t now = __cl_event_loop_now(loop);
+	return deadline <= now ? 0 : (int) ((deadline - now + 999999u) / 1000000u);
+}
+
+
+/**
+ * @brief Runs the timers of the clocks of the tests: the due ones of real clocks, and the next ones of the
+ * virtual clocks whose test does not wait for anything else.
+ */
+static void __cl_event_loop_run_clocks(clarity_event_loop_t *loop) {
+	for (clarity_async_t *async = loop->clocked; async; async = async->next_clocked) {
+		if (async->done)
+			continue;
+
+		if (!async->clock->is_virtual)
+			cl_clock_fire_due(async->clock);
+		else if (!async->watched)
+			cl_clock_advance(async->clock);
+		__cl_async_check_stalled(async);
+	}
+}
+
+
+/**
+ * @brief Fails the tests in flight once the grace period of a cancelled run is over.
+ */
+static void __cl_event_loop_stop_cancelled(clarity_event_loop_t *loop) {
+	uint64_t deadline = cl_test_cancel_deadline();
+	if (!deadline || !loop->in_flight || __cl_event_loop_now(loop) < deadline)
+		return;
+
+	// Every test in flight has exactly one timer without a function, its timeout.
+	for (size_t i = 0; i < loop->timer_count; i++) {
+		clarity_async_t *async = loop->timers[i].async;
+		if (loop->timers[i].fn || async->done)
+			continue;
+
+		clarity_test_t *test = async->test;
+		test->result.passed        = false;
+		test->result.skipped       = false;
+		test->result.file_name     = NULL;
+		test->result.error_message = "did not stop within the grace period after the run was cancelled";
+		__cl_async_complete(async);
+	}
+}
+
+
+void cl_event_loop_run_once(clarity_event_loop_t *loop) {
+	int timeout_ms = __cl_event_loop_timeout(loop);
+
+	struct epoll_event events[CL_EVENT_LOOP_BATCH];
+	int                count = epoll_wait(loop->epoll_fd, events, CL_EVENT_LOOP_BATCH, timeout_ms);
+	for (int i = 0; i < count; i++) {
+		clarity_async_watch_t *watch = events[i].data.ptr;
+		if (watch->fd < 0 || watch->async->done)
+			continue;
+
+		uint32_t flags = 0;
+		if (events[i].events & EPOLLIN)
+			flags |= CL_ASYNC_READABLE;
+		if (events[i].events & EPOLLOUT)
+			flags |= CL_ASYNC_WRITABLE;
+		if (events[i].events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR))
+			flags |= CL_ASYNC_HANGUP;
+
+		watch->fn(watch->async->test, watch->async, watch->fd, flags, watch->data);
+		__cl_async_check_stalled(watch->async);
+	}
+
+	uint64_t now = __cl_event_loop_now(loop);
+	while (loop->timer_count && loop->timers[0].deadline_ns <= now) {
+		clarity_loop_timer_t timer = __cl_timer_pop(loop);
+		clarity_async_t      *async = timer.async;
+		if (async->done)
+			continue;
+
+		if (timer.fn) {
+			async->timers--;
+			timer.fn(async->test, async, timer.data);
+			__cl_async_check_stalled(async);
+		} else {
+			clarity_test_t *test = async->test;
+			test->result.passed    = false;
+			test->result.file_name = NULL;
+			if (!cl_test_set_message(test, "timed out after %u ms", test->timeout_ms))
+				test->result.error_message = "timed out";
+			__cl_async_complete(async);
+		}
+	}
+
+	__cl_event_loop_run_clocks(loop);
+	__cl_event_loop_stop_cancelled(loop);
+	__cl_event_loop_release_done(loop);
+}
+
+
+void cl_event_loop_drain(clarity_event_loop_t *loop) {
+	while (loop->in_flight)
+		cl_event_loop_run_once(loop);
+}
+
+
+void cl_event_loop_free(clarity_event_loop_t *loop) {
+	if (!loop)
+		return;
+
+	close(loop->epoll_fd);
+	free(loop->timers);
+	free(loop);
+}
+
+
+clarity_status_t cl_async_watch_fd(clarity_async_t *async, int fd, uint32_t events, clarity_async_io_fn_t fn,
+                                   void *data) {
+	clarity_async_watch_t *watch = calloc(1, sizeof(*watch));
+	if (!watch)
+		return CL_ERROR_MEMORY;
+
+	watch->fd    = fd;
+	watch->fn    = fn;
+	watch->data  = data;
+	watch->async = async;
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof event);
+	event.data.ptr = watch;
+	event.events   = EPOLLRDHUP;
+	if (events & CL_ASYNC_READABLE)
+		event.events |= EPOLLIN;
+	if (events & CL_ASYNC_WRITABLE)
+		event.events |= EPOLLOUT;
+	if (epoll_ctl(async->loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		free(watch);
+		return CL_ERROR_IO;
+	}
+
+	watch->next    = async->watches;
+	async->watches = watch;
+	async->watched++;
+	return CL_SUCCESS;
+}
+
+
+void cl_async_unwatch_fd(clarity_async_t *async, int fd) {
+	for (clarity_async_watch_t *watch = async->watches; watch; watch = watch->next) {
+		if (watch->fd == fd) {
+			epoll_ctl(async->loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+			// The watch is released with the test, an event for it may still be pending in the current batch.
+			watch->fd = -1;
+			async->watched--;
+			return;
+		}
+	}
+}
+
+
+/**
+ * @brief Runs a timer of an asynchronous test registered on its virtual clock.
+ */
+static void __cl_async_clock_timer(clarity_clock_t *clock, void *data) {
+	(void) clock;
+	clarity_async_clock_timer_t *timer = data;
+	clarity_async_t             *async = timer->async;
+
+	async->timers--;
+	timer->fn(async->test, async, timer->data);
+	__cl_async_check_stalled(async);
+}
+
+
+clarity_status_t cl_async_set_timer(clarity_async_t *async, uint64_t delay_ms, clarity_async_timer_fn_t fn,
+                                    void *data) {
+	if (async->clock && async->clock->is_virtual) {
+		clarity_async_clock_timer_t *timer = malloc(sizeof(*timer));
+		if (!timer)
+			return CL_ERROR_MEMORY;
+
+		*timer = (clarity_async_clock_timer_t){ .async = async, .fn = fn, .data = data };
+		if (cl_clock_schedule(async->clock, delay_ms * 1000000u, __cl_async_clock_timer, timer, true, NULL)
+		    != CL_SUCCESS) {
+			free(timer);
+			return CL_ERROR_MEMORY;
+		}
+		async->timers++;
+		return CL_SUCCESS;
+	}
+
+	clarity_loop_timer_t timer = {
+		.deadline_ns = __cl_event_loop_now(async->loop) + delay_ms * 1000000u,
+		.async       = async,
+		.fn          = fn,
+		.data        = data,
+	};
+	if (!__cl_timer_push(async->loop, timer))
+		return CL_ERROR_MEMORY;
+
+	async->timers++;
+	return CL_SUCCESS;
+}
+
+
+void cl_async_done(clarity_async_t *async) {
+	__cl_async_complete(async);
+}
@@ -0,0 +1,153 @@
+#include <CLarity/assertions.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+
+void cl_test_set_max_expectations(clarity_test_t *test, size_t max) {
+	if (test)
+		test->expectations.max = max;
+}
+
+
+/**
+ * @brief Keeps a failed expectation in the log of its test, or counts it if the log is full.
+ *
+ * The message is formatted before taking the lock, which only guards the links of the log and its counters.
+ */
+static void __cl_expect_log(clarity_test_t *test, const char *file, size_t line, const char *format, va_list args) {
+	clarity_expectation_log_t *log = &test->expectations;
+	size_t                    max  = log->max ? log->max : CL_DEFAULT_MAX_EXPECTATIONS;
+
+	va_list copy;
+	va_copy(copy, args);
+	int len = vsnprintf(NULL, 0, format, copy);
+	va_end(copy);
+	clarity_expectation_t *expectation = len < 0 ? NULL : malloc(sizeof(*expectation) + (size_t) len + 1);
+	if (expectation) {
+		vsnprintf(expectation->message, (size_t) len + 1, format, args);
+		expectation->next = NULL;
+		expectation->file = file;
+		expectation->line = line;
+	}
+
+	cl_test_lock(test);
+	bool kept = expectation && log->count < max;
+	if (!kept) {
+		log->dropped++;
+	} else {
+		if (log->last)
+			log->last->next = expectation;
+		else
+			log->first = expectation;
+		log->last = expectation;
+		log->count++;
+	}
+	cl_test_unlock(test);
+	if (!kept)
+		free(expectation);
+}
+
+
+bool __cl_expect(clarity_test_t *test, bool passed, const char *file, size_t line, const char *format, ...) {
+	if (passed)
+		return true;
+
+	va_list args;
+	va_start(args, format);
+	__cl_expect_log(test, file, line, format, args);
+	va_end(args);
+	return false;
+}
+
+
+bool __cl_expect_int_eq(clarity_test_t *test, int64_t actual, int64_t expected, const char *actual_text,
+                        const char *expected_text, const char *file, size_t line) {
+	return __cl_expect(test, actual == expected, file, line, "expected %s == %s, got %" PRId64 " and %" PRId64,
+	                   actual_text, expected_text, actual, expected);
+}
+
+
+bool __cl_expect_uint_eq(clarity_test_t *test, uint64_t actual, uint64_t expected, const char *actual_text,
+                         const char *expected_text, const char *file, size_t line) {
+	return __cl_expect(test, actual == expected, file, line, "expected %s == %s, got %" PRIu64 " and %" PRIu64,
+	                   actual_text, expected_text, actual, expected);
+}
+
+
+bool __cl_expect_str_eq(clarity_test_t *test, const char *actual, const char *expected, const char *actual_text,
+                        const char *expected_text, const char *file, size_t line) {
+	bool equal = actual && expected ? !strcmp(actual, expected) : actual == expected;
+	if (equal)
+		return true;
+	return __cl_expect(test, false, file, line, "expected %s == %s, got %s%s%s and %s%s%s", actual_text,
+	                   expected_text, actual ? "\"" : "", actual ? actual : "NULL", actual ? "\"" : "",
+	                   expected ? "\"" : "", expected ? expected : "NULL", expected ? "\"" : "");
+}
+
+
+bool __cl_expect_near(clarity_test_t *test, double actual, double expected, double tolerance,
+                      const char *actual_text, const char *expected_text, const char *file, size_t line) {
+	return __cl_expect(test, fabs(actual - expected) <= tolerance, file, line,
+	                   "expected %s within %.17g of %s, got %.17g and %.17g", actual_text, tolerance, expected_text,
+	                   actual, expected);
+}
+
+
+void cl_test_flush_expectations(clarity_test_t *test) {
+	clarity_expectation_log_t *log = &test->expectations;
+	if (!log->count && !log->dropped)
+		return;
+
+	const clarity_expectation_t *first  = log->first;
+	const clarity_test_result_t *result = &test->result;
+	bool                        failed  = !result->passed;
+	size_t                      total   = log->count + log->dropped;
+	char                        *text   = NULL;
+	size_t                      len     = 0;
+	FILE                        *stream = open_memstream(&text, &len);
+	if (stream) {
+		// An earlier failure stays first, the expectations are listed after it.
+		if (failed)
+			fprintf(stream, "%s\n  ", result->error_message ? result->error_message : "failed");
+		fprintf(stream, "%zu expectation%s failed", total, total == 1 ? "" : "s");
+		for (const clarity_expectation_t *expectation = first; expectation; expectation = expectation->next) {
+			const char *name = strrchr(expectation->file, '/');
+			fprintf(stream, "\n  %s:%zu: %s", name ? name + 1 : expectation->file, expectation->line,
+			        expectation->message);
+		}
+		if (log->dropped)
+			fprintf(stream, "\n  +%zu more", log->dropped);
+		if (fclose(stream) != 0) {
+			free(text);
+			text = NULL;
+		}
+	}
+
+	if (failed)
+		cl_test_record(test, result->file_name, result->line_number, false, result->error_message, text);
+	else
+		cl_test_record(test, first ? first->file : NULL, first ? first->line : 0, false, "expectations failed",
+		               text);
+	// A test cannot hide its failed expectations by skipping itself.
+	test->result.skipped = false;
+
+	cl_test_clear_expectations(test);
+}
+
+
+void cl_test_clear_expectations(clarity_test_t *test) {
+	clarity_expectation_log_t *log = &test->expectations;
+	while (log->first) {
+		clarity_expectation_t *expectation = log->first;
+		log->first = expectation->next;
+		free(expectation);
+	}
+	log->last    = NULL;
+	log->count   = 0;
+	log->dropped = 0;
+}
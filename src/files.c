@@ -0,0 +1,40 @@
+#include "files.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CL_FILES_MAX_PATH 4096
+
+
+bool cl_files_make_directory(char *path) {
+	for (char *slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+		*slash = '\0';
+		bool made = mkdir(path, 0755) == 0 || errno == EEXIST;
+		*slash = '/';
+		if (!made)
+			return false;
+	}
+	return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+
+bool cl_files_replace(const char *path, const void *header, size_t header_size, const void *data, size_t size) {
+	char temporary[CL_FILES_MAX_PATH];
+	if (snprintf(temporary, sizeof temporary, "%s.%d.tmp", path, (int) getpid()) >= (int) sizeof temporary)
+		return false;
+
+	FILE *file = fopen(temporary, "wb");
+	if (!file)
+		return false;
+
+	bool written = (!header_size || fwrite(header, header_size, 1, file) == 1)
+	               && (!size || fwrite(data, size, 1, file) == 1);
+	written &= fclose(file) == 0;
+	if (!written || rename(temporary, path) != 0) {
+		unlink(temporary);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,357 @@
+#define _GNU_SOURCE
+#include "isolation.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "suite.h"
+#include "test.h"
+#include "timing.h"
+#include "wire.h"
+
+/**
+ * @brief A forked process running a batch of tests.
+ */
+typedef struct clarity_child_s {
+	pid_t            pid;
+	int              fd;         /**< The read end of the pipe the child reports on. */
+	clarity_buffer_t input;
+	size_t           *positions; /**< The positions in the suite of the tests of the batch. */
+	size_t           count;      /**< The number of tests in the batch. */
+	size_t           next;       /**< The index in the batch of the first test not reported yet. */
+	char             *current;   /**< The name of the test started and not reported yet, or NULL. */
+	uint64_t         heard_ns;   /**< When the child last reported anything, or was forked. */
+	bool             killed;     /**< Whether the child was killed for staying silent past the timeout. */
+} clarity_child_t;
+
+typedef struct clarity_isolation_s {
+	clarity_run_t   *run;
+	size_t          total;       /**< The number of tests of the suite, generated tests included. */
+	size_t          next;        /**< The position of the first test never handed to a child. */
+	size_t          *retry;      /**< The positions of the tests to hand out again, after a crash. */
+	size_t          retry_count;
+	clarity_child_t *children;
+	size_t          max_children;
+	size_t          active;
+} clarity_isolation_t;
+
+
+static clarity_test_t *__cl_isolation_resolve(clarity_suite_t *suite, size_t position, bool *owned) {
+	*owned = position >= suite->test_count;
+	if (*owned)
+		return suite->generator(position - suite->test_count, suite->generator_data);
+	return suite->tests[position];
+}
+
+
+static void __cl_isolation_send(clarity_buffer_t *output, int fd, const char *type, size_t index,
+                                const char *name, const clarity_test_result_t *result) {
+	bool written = cl_wire_begin(output, type)
+	               && cl_wire_add_u64(output, index)
+	               && (!name || cl_wire_add_string(output, name))
+	               && (!result || cl_wire_add_result(output, result))
+	               && cl_wire_end(output);
+	if (written)
+		cl_buffer_flush(output, fd);
+}
+
+
+/**
+ * @brief The body of a child: runs its batch, reports every test on the pipe, and exits.
+ */
+static _Noreturn void __cl_isolation_child(clarity_run_t *run, const clarity_child_t *child, int fd) {
+	clarity_suite_t  *suite = run->suite;
+	clarity_buffer_t output = { 0 };
+	int              status = 0;
+
+	for (size_t i = 0; i < child->count; i++) {
+		bool           owned;
+		clarity_test_t *test = __cl_isolation_resolve(suite, child->positions[i], &owned);
+		if (test && !cl_runner_matches(run->filter, suite->name, test->name)) {
+			if (owned)
+				cl_free_test(test);
+			continue;
+		}
+		if (!test && !owned)
+			continue;
+
+		// The parent learns which test was running if the process dies before reporting it.
+		__cl_isolation_send(&output, fd, "START", i, test ? test->name : "generated test", NULL);
+
+		clarity_test_result_t result = {
+			.name          = "generated test",
+			.error_message = "the generator did not return a test",
+		};
+		bool state = true;
+		if (test && cl_runner_unscheduled(run, test))
+			result = test->result;
+		else if (test)
+			state = cl_runner_run_test(run, test, &result);
+		__cl_isolation_send(&output, fd, "RESULT", i, NULL, &result);
+		if (owned)
+			cl_free_test(test);
+
+		if (!state) {
+			__cl_isolation_send(&output, fd, "ABORT", i, NULL, NULL);
+			status = 1;
+			break;
+		}
+	}
+	if (!status)
+		__cl_isolation_send(&output, fd, "END", child->count, NULL, NULL);
+
+	fflush(stdout);
+	fflush(stderr);
+	_exit(status);
+}
+
+
+static bool __cl_isolation_has_work(const clarity_isolation_t *isolation) {
+	return isolation->retry_count || isolation->next < isolation->total;
+}
+
+
+static bool __cl_isolation_spawn(clarity_isolation_t *isolation, clarity_child_t *child) {
+	size_t batch = isolation->run->suite->isolation_batch;
+
+	child->count = 0;
+	child->next  = 0;
+	while (child->count < batch && isolation->retry_count)
+		child->positions[child->count++] = isolation->retry[--isolation->retry_count];
+	while (child->count < batch && isolation->next < isolation->total)
+		child->positions[child->count++] = isolation->next++;
+
+	int fds[2];
+	if (pipe2(fds, O_CLOEXEC) != 0)
+		return false;
+
+	// Anything buffered would otherwise be printed again by the child.
+	fflush(stdout);
+	fflush(stderr);
+	pid_t pid = fork();
+	if (pid == 0) {
+		close(fds[0]);
+		__cl_isolation_child(isolation->run, child, fds[1]);
+	}
+
+	close(fds[1]);
+	if (pid < 0) {
+		close(fds[0]);
+		for (size_t i = child->count; i-- > 0;)
+			isolation->retry[isolation->retry_count++] = child->positions[i];
+		return false;
+	}
+
+	child->pid      = pid;
+	child->fd       = fds[0];
+	child->heard_ns = cl_timing_now_ns();
+	child->killed   = false;
+	isolation->active++;
+	return true;
+}
+
+
+static void __cl_isolation_report(clarity_isolation_t *isolation, clarity_child_t *child,
+                                  const clarity_test_result_t *result) {
+	clarity_run_t   *run     = isolation->run;
+	clarity_suite_t *suite   = run->suite;
+	size_t          position = child->positions[child->next];
+
+	cl_runner_report_test(run, result);
+	if (position < suite->test_count && suite->tests[position])
+		cl_runner_release_test(run, suite->tests[position], &suite->tests[position]);
+
+	free(child->current);
+	child->current = NULL;
+	child->next++;
+}
+
+
+static void __cl_isolation_receive(clarity_isolation_t *isolation, clarity_child_t *child) {
+	char *line;
+	while ((line = cl_buffer_next_line(&child->input))) {
+		char   *fields[CL_WIRE_MAX_FIELDS];
+		size_t field_count = cl_wire_split(line, fields, CL_WIRE_MAX_FIELDS);
+		size_t index       = field_count > 1 ? (size_t) cl_wire_u64(fields[1]) : 0;
+		if (!strcmp(fields[0], "END")) {
+			child->next = child->count;
+			continue;
+		}
+		if (!strcmp(fields[0], "ABORT")) {
+			isolation->run->aborted = true;
+			continue;
+		}
+		if (field_count < 2 || index >= child->count || index < child->next)
+			continue;
+
+		// The tests skipped by the filter are not reported, the next message is about a later test.
+		child->next = index;
+		if (!strcmp(fields[0], "START") && field_count == 3) {
+			free(child->current);
+			child->current = strdup(fields[2]);
+		} else if (!strcmp(fields[0], "RESULT") && field_count == 2 + CL_WIRE_RESULT_FIELDS) {
+			clarity_test_result_t result;
+			cl_wire_read_result(fields + 2, &result);
+			__cl_isolation_report(isolation, child, &result);
+		}
+	}
+}
+
+
+/**
+ * @brief Collects a child which closed its pipe, and deals with the tests it did not report.
+ */
+static void __cl_isolation_reap(clarity_isolation_t *isolation, clarity_child_t *child) {
+	int status = 0;
+	while (waitpid(child->pid, &status, 0) < 0 && errno == EINTR)
+		continue;
+	close(child->fd);
+	cl_buffer_free(&child->input);
+	isolation->active--;
+
+	bool finished = child->next >= child->count && !child->current;
+	if (!finished && !isolation->run->aborted) {
+		char message[128];
+		if (child->killed)
+			snprintf(message, sizeof message, "the test did not finish within %u ms, its process was killed",
+			         isolation->run->suite->isolation_timeout_ms);
+		else if (WIFSIGNALED(status))
+			snprintf(message, sizeof message, "the test process was killed by signal %d (%s)", WTERMSIG(status),
+			         strsignal(WTERMSIG(status)));
+		else
+			snprintf(message, sizeof message, "the test process exited with status %d before reporting the test",
+			         WEXITSTATUS(status));
+
+		// Without a started test, the process died while picking the next one, which is the culprit.
+		size_t                position = child->positions[child->next];
+		clarity_suite_t       *suite   = isolation->run->suite;
+		clarity_test_result_t result   = {
+			.name          = child->current ? child->current : "generated test",
+			.error_message = message,
+		};
+		if (!child->current && position < suite->test_count && suite->tests[position])
+			result.name = suite->tests[position]->name;
+		__cl_isolation_report(isolation, child, &result);
+
+		for (size_t i = child->count; i-- > child->next;)
+			isolation->retry[isolation->retry_count++] = child->positions[i];
+	}
+
+	free(child->current);
+	child->current = NULL;
+	child->pid     = 0;
+}
+
+
+/**
+ * @brief The time left before the first child still running is past its timeout, in milliseconds for `poll`.
+ */
+static int __cl_isolation_time_left(const clarity_isolation_t *isolation, uint64_t now) {
+	uint64_t timeout = (uint64_t) isolation->run->suite->isolation_timeout_ms * 1000000u;
+	int      left    = -1;
+	for (size_t i = 0; i < isolation->max_children; i++) {
+		const clarity_child_t *child = &isolation->children[i];
+		if (!child->pid || child->killed)
+			continue;
+
+		uint64_t child_left = now - child->heard_ns < timeout ? timeout - (now - child->heard_ns) : 0;
+		int      ms         = (int) ((child_left + 999999u) / 1000000u);
+		if (left < 0 || ms < left)
+			left = ms;
+	}
+	return left;
+}
+
+
+static bool __cl_isolation_poll(clarity_isolation_t *isolation, struct pollfd *fds) {
+	size_t count = 0;
+	for (size_t i = 0; i < isolation->max_children; i++) {
+		if (isolation->children[i].pid)
+			fds[count++] = (struct pollfd){ .fd = isolation->children[i].fd, .events = POLLIN };
+	}
+	if (poll(fds, count, __cl_isolation_time_left(isolation, cl_timing_now_ns())) < 0)
+		return errno == EINTR;
+
+	uint64_t now     = cl_timing_now_ns();
+	uint64_t timeout = (uint64_t) isolation->run->suite->isolation_timeout_ms * 1000000u;
+	for (size_t i = 0, j = 0; i < isolation->max_children; i++) {
+		clarity_child_t *child = &isolation->children[i];
+		if (!child->pid)
+			continue;
+		if (!fds[j++].revents) {
+			// A silent child is stuck in its test, the pipe it closes when killed gets it reaped.
+			if (!child->killed && now - child->heard_ns >= timeout) {
+				kill(child->pid, SIGKILL);
+				child->killed = true;
+			}
+			continue;
+		}
+
+		ssize_t len = cl_buffer_fill(&child->input, child->fd);
+		if (len > 0)
+			child->heard_ns = now;
+		__cl_isolation_receive(isolation, child);
+		if (len <= 0)
+			__cl_isolation_reap(isolation, child);
+	}
+	return true;
+}
+
+
+static bool __cl_isolation_loop(clarity_isolation_t *isolation, struct pollfd *fds) {
+	clarity_run_t *run = isolation->run;
+
+	while (isolation->active || (!run->aborted && __cl_isolation_has_work(isolation))) {
+		for (size_t i = 0; i < isolation->max_children && !run->aborted && __cl_isolation_has_work(isolation); i++) {
+			if (isolation->children[i].pid)
+				continue;
+			if (!__cl_isolation_spawn(isolation, &isolation->children[i])) {
+				// Without any child left to wait for, nothing will free the resources a fork needs.
+				if (!isolation->active) {
+					fprintf(stderr, "CLarity: could not fork a test process: %s\n", strerror(errno));
+					return false;
+				}
+				break;
+			}
+		}
+
+		if (isolation->active && !__cl_isolation_poll(isolation, fds))
+			return false;
+	}
+	return !run->aborted;
+}
+
+
+bool cl_isolation_run_tests(clarity_run_t *run) {
+	clarity_suite_t     *suite = run->suite;
+	clarity_isolation_t isolation;
+	memset(&isolation, 0, sizeof isolation);
+
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	isolation.run          = run;
+	isolation.total        = suite->test_count + suite->generated_count;
+	isolation.max_children = suite->isolation_children ? suite->isolation_children : (cores > 0 ? (size_t) cores : 1);
+	isolation.children     = calloc(isolation.max_children, sizeof(*isolation.children));
+	isolation.retry        = malloc((isolation.total + 1) * sizeof(*isolation.retry));
+	struct pollfd *fds     = malloc(isolation.max_children * sizeof(*fds));
+
+	bool ready = isolation.children && isolation.retry && fds;
+	for (size_t i = 0; ready && i < isolation.max_children; i++) {
+		isolation.children[i].positions = malloc(suite->isolation_batch * sizeof(size_t));
+		ready                           = isolation.children[i].positions != NULL;
+	}
+
+	bool completed = ready && __cl_isolation_loop(&isolation, fds);
+
+	for (size_t i = 0; isolation.children && i < isolation.max_children; i++)
+		free(isolation.children[i].positions);
+	free(isolation.children);
+	free(isolation.retry);
+	free(fds);
+	return completed;
+}
@@ -0,0 +1,137 @@
+#include "options.h"
+#include "distributed.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char *__cl_option_value(const char *arg, const char *name) {
+	size_t len = strlen(name);
+	if (strncmp(arg, name, len) != 0 || arg[len] != '=')
+		return NULL;
+	return arg + len + 1;
+}
+
+
+static bool __cl_option_parse_u64(const char *name, const char *value, uint64_t *out) {
+	char *end;
+	if (!*value || *value == '-') {
+		fprintf(stderr, "CLarity: %s expects a positive number\n", name);
+		return false;
+	}
+	*out = strtoull(value, &end, 10);
+	if (*end) {
+		fprintf(stderr, "CLarity: %s expects a positive number, got '%s'\n", name, value);
+		return false;
+	}
+	return true;
+}
+
+
+bool cl_options_parse(clarity_options_t *options, int argc, char **argv) {
+	memset(options, 0, sizeof(*options));
+	options->stress_options.concurrency = 1;
+	options->batch                      = CL_DISTRIBUTED_DEFAULT_BATCH;
+	options->worker_timeout_s           = CL_DISTRIBUTED_DEFAULT_TIMEOUT_S;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value;
+		uint64_t   number;
+
+		if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+			options->help = true;
+		} else if ((value = __cl_option_value(arg, "--test"))) {
+			options->filter = value;
+		} else if ((value = __cl_option_value(arg, "--repeat"))) {
+			if (!__cl_option_parse_u64("--repeat", value, &number))
+				return false;
+			options->stress                    = true;
+			options->stress_options.iterations = number;
+		} else if (!strcmp(arg, "--until-failure")) {
+			options->stress                       = true;
+			options->stress_options.until_failure = true;
+		} else if ((value = __cl_option_value(arg, "--concurrency"))) {
+			if (!__cl_option_parse_u64("--concurrency", value, &number) || !number || number > UINT32_MAX) {
+				fprintf(stderr, "CLarity: --concurrency expects a number of copies between 1 and %u\n", UINT32_MAX);
+				return false;
+			}
+			options->stress_options.concurrency = (uint32_t) number;
+		} else if (!strcmp(arg, "--pin")) {
+			options->stress_options.pin_threads = true;
+		} else if ((value = __cl_option_value(arg, "--coordinator"))) {
+			options->coordinator = value;
+		} else if ((value = __cl_option_value(arg, "--worker"))) {
+			options->worker = value;
+		} else if ((value = __cl_option_value(arg, "--serve"))) {
+			options->serve = value;
+		} else if ((value = __cl_option_value(arg, "--budget"))) {
+			if (!__cl_option_parse_u64("--budget", value, &number) || !number || number > UINT64_MAX / 1000000) {
+				fprintf(stderr, "CLarity: --budget expects a positive number of milliseconds\n");
+				return false;
+			}
+			options->budget_ms = number;
+		} else if ((value = __cl_option_value(arg, "--history"))) {
+			options->history = value;
+		} else if ((value = __cl_option_value(arg, "--trace"))) {
+			options->trace = value;
+		} else if (!strcmp(arg, "--fail-fast")) {
+			options->max_failures = 1;
+		} else if ((value = __cl_option_value(arg, "--max-failures"))) {
+			if (!__cl_option_parse_u64("--max-failures", value, &number) || !number || number > SIZE_MAX) {
+				fprintf(stderr, "CLarity: --max-failures expects a positive number of failures\n");
+				return false;
+			}
+			options->max_failures = (size_t) number;
+		} else if ((value = __cl_option_value(arg, "--batch"))) {
+			if (!__cl_option_parse_u64("--batch", value, &number) || !number || number > UINT32_MAX) {
+				fprintf(stderr, "CLarity: --batch expects a number of tests between 1 and %u\n", UINT32_MAX);
+				return false;
+			}
+			options->batch = (uint32_t) number;
+		} else if ((value = __cl_option_value(arg, "--worker-timeout"))) {
+			if (!__cl_option_parse_u64("--worker-timeout", value, &number) || !number || number > UINT32_MAX / 1000) {
+				fprintf(stderr, "CLarity: --worker-timeout expects a positive number of seconds\n");
+				return false;
+			}
+			options->worker_timeout_s = (uint32_t) number;
+		} else {
+			fprintf(stderr, "CLarity: unknown option '%s'\n", arg);
+			return false;
+		}
+	}
+
+	bool budget = options->budget_ms || options->history;
+	if (!!options->coordinator + !!options->worker + !!options->serve + options->stress + budget > 1) {
+		fprintf(stderr, "CLarity: --coordinator, --worker, --serve, --budget or --history and the stress options "
+		                "cannot be combined\n");
+		return false;
+	}
+	return true;
+}
+
+
+void cl_options_usage(FILE *stream, const char *program) {
+	fprintf(stream,
+	        "Usage: %s [options]\n"
+	        "\n"
+	        "Options:\n"
+	        "  --test=PATTERN     only run the tests whose name or suite/name matches the glob PATTERN\n"
+	        "  --repeat=N         repeat each selected test N times instead of running the suites\n"
+	        "  --until-failure    repeat each selected test until it fails (at most N times with --repeat)\n"
+	        "  --concurrency=K    run K copies of the repeated test at once, released together\n"
+	        "  --pin              pin each concurrent copy to a different core\n"
+	        "  --coordinator=ADDR serve the selected tests to workers on ADDR and report their results\n"
+	        "  --worker=ADDR      run the tests served by the coordinator at ADDR\n"
+	        "  --batch=N          number of tests a worker asks for at once (default %d)\n"
+	        "  --worker-timeout=S fail the tests left once no worker reported anything for S seconds (default %d)\n"
+	        "  --serve=ADDR       set the suites up once, then run the tests requested by clarity-client on ADDR\n"
+	        "  --budget=MS        only run the tests most likely to fail that fit in MS milliseconds\n"
+	        "  --history=PATH     record the results to the history file PATH, which --budget reads\n"
+	        "  --trace=PATH       write a timeline of the run to PATH, for Perfetto or about:tracing\n"
+	        "  --fail-fast        stop the run at the first failure\n"
+	        "  --max-failures=N   stop the run after N failures, the remaining tests are reported as not run\n"
+	        "  --help             print this help\n"
+	        "\n"
+	        "ADDR is unix:PATH or tcp:HOST:PORT.\n",
+	        program, CL_DISTRIBUTED_DEFAULT_BATCH, CL_DISTRIBUTED_DEFAULT_TIMEOUT_S);
+}
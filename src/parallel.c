@@ -0,0 +1,470 @@
+#include "parallel.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "suite.h"
+#include "test.h"
+#include "timing.h"
+
+/**
+ * @brief The number of tests per thread resolved ahead of the running ones, among which a blocked test can be
+ * overtaken.
+ */
+#define CL_PARALLEL_LOOKAHEAD 16
+
+/**
+ * @brief A resource of the run, with what the running tests hold of it.
+ */
+typedef struct clarity_pool_resource_s {
+	const char *name;
+	uint64_t   capacity;
+	uint64_t   in_use;
+	bool       reserved; /**< Whether an earlier blocked test needs it, during a scheduling pass. */
+} clarity_pool_resource_t;
+
+typedef struct clarity_pool_need_s {
+	size_t   resource; /**< The index of the resource in the pool. */
+	uint64_t amount;
+} clarity_pool_need_t;
+
+/**
+ * @brief A test going through the pool: pending, then running, then waiting to be reported.
+ */
+typedef struct clarity_job_s {
+	clarity_test_t        *test;
+	clarity_test_t        **slot;         /**< The slot of the test in the suite, or NULL for a generated test. */
+	clarity_pool_need_t   *needs;         /**< What the test needs of each resource, suite needs included. */
+	size_t                need_count;
+	bool                  excess;         /**< Whether the test needs more of a resource than its capacity. */
+	const clarity_test_t  *blocked_by;    /**< The prerequisite which did not pass, if the test is skipped. */
+	uint64_t              blocked_since;  /**< When a free thread first had to skip the test, 0 if never. */
+	bool                  state;          /**< false if a per-test fixture reported an error. */
+	clarity_test_result_t result;
+	struct clarity_job_s  *next;
+} clarity_job_t;
+
+typedef struct clarity_job_list_s {
+	clarity_job_t *head;
+	clarity_job_t **tail;
+	size_t        count;
+} clarity_job_list_t;
+
+typedef struct clarity_pool_s {
+	clarity_run_t           *run;
+	pthread_mutex_t         lock;
+	pthread_cond_t          work;      /**< Signalled when a pending test may have become startable. */
+	pthread_cond_t          finished;  /**< Signalled when a test is ready to be reported or a thread left. */
+	clarity_pool_resource_t *resources;
+	size_t                  resource_count;
+	size_t                  total;     /**< The number of tests of the suite, generated tests included. */
+	size_t                  next;      /**< The position of the first test not resolved yet. */
+	size_t                  lookahead;
+	bool                    ordered;   /**< Whether tests of the suite depend on others, all of them are resolved. */
+	clarity_job_list_t      pending;
+	clarity_job_list_t      done;
+	clarity_job_list_t      deferred;  /**< The tests run in order once the pool is done, asynchronous ones included. */
+	size_t                  workers;   /**< The number of threads still running. */
+	size_t                  running;   /**< The number of tests being run by the threads. */
+	bool                    aborted;
+} clarity_pool_t;
+
+
+static void __cl_job_list_init(clarity_job_list_t *list) {
+	list->head  = NULL;
+	list->tail  = &list->head;
+	list->count = 0;
+}
+
+
+static void __cl_job_list_push(clarity_job_list_t *list, clarity_job_t *job) {
+	job->next   = NULL;
+	*list->tail = job;
+	list->tail  = &job->next;
+	list->count++;
+}
+
+
+static clarity_job_t *__cl_job_list_pop(clarity_job_list_t *list) {
+	clarity_job_t *job = list->head;
+	if (!job)
+		return NULL;
+
+	list->head = job->next;
+	if (!list->head)
+		list->tail = &list->head;
+	list->count--;
+	return job;
+}
+
+
+static void __cl_job_free(clarity_pool_t *pool, clarity_job_t *job, bool release) {
+	if (release && job->test)
+		cl_runner_release_test(pool->run, job->test, job->slot);
+	free(job->needs);
+	free(job);
+}
+
+
+/**
+ * @brief Finds a resource of the pool, adding it as an exclusive lock if the suite did not declare it.
+ *
+ * @return The index of the resource, or SIZE_MAX if the allocation failed.
+ */
+static size_t __cl_pool_resource(clarity_pool_t *pool, const char *name) {
+	for (size_t i = 0; i < pool->resource_count; i++) {
+		if (!strcmp(pool->resources[i].name, name))
+			return i;
+	}
+
+	clarity_pool_resource_t *grown = realloc(pool->resources, (pool->resource_count + 1) * sizeof(*grown));
+	if (!grown)
+		return SIZE_MAX;
+	grown[pool->resource_count] = (clarity_pool_resource_t){ .name = name, .capacity = 1 };
+	pool->resources             = grown;
+	return pool->resource_count++;
+}
+
+
+static bool __cl_job_add_needs(clarity_pool_t *pool, clarity_job_t *job, const clarity_resource_need_t *needs,
+                               size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		size_t resource = __cl_pool_resource(pool, needs[i].name);
+		if (resource == SIZE_MAX)
+			return false;
+
+		uint64_t capacity = pool->resources[resource].capacity;
+		uint64_t amount   = needs[i].amount == CL_RESOURCE_ALL ? capacity : needs[i].amount;
+
+		size_t j = 0;
+		while (j < job->need_count && job->needs[j].resource != resource)
+			j++;
+		if (j == job->need_count) {
+			clarity_pool_need_t *grown = realloc(job->needs, (job->need_count + 1) * sizeof(*grown));
+			if (!grown)
+				return false;
+			job->needs    = grown;
+			job->needs[j] = (clarity_pool_need_t){ .resource = resource, .amount = 0 };
+			job->need_count++;
+		}
+		if (amount > job->needs[j].amount)
+			job->needs[j].amount = amount;
+	}
+	return true;
+}
+
+
+/**
+ * @brief Resolves the needs of a job against the resources of the pool.
+ */
+static bool __cl_job_prepare(clarity_pool_t *pool, clarity_job_t *job) {
+	clarity_suite_t *suite = pool->run->suite;
+	if (!__cl_job_add_needs(pool, job, suite->needs, suite->need_count)
+	    || !__cl_job_add_needs(pool, job, job->test->needs, job->test->need_count))
+		return false;
+
+	// Such a test can never start, it is failed as soon as a thread picks it up.
+	for (size_t i = 0; i < job->need_count && !job->excess; i++) {
+		const clarity_pool_resource_t *resource = &pool->resources[job->needs[i].resource];
+		if (job->needs[i].amount <= resource->capacity)
+			continue;
+
+		job->excess              = true;
+		job->test->result.passed = false;
+		if (!cl_test_set_message(job->test, "the test needs %" PRIu64 " of resource '%s', which only has %" PRIu64,
+		                         job->needs[i].amount, resource->name, resource->capacity))
+			job->test->result.error_message = "the test needs more of a resource than its capacity";
+	}
+	return true;
+}
+
+
+/**
+ * @brief Resolves the next tests of the suite into pending jobs, up to the lookahead.
+ *
+ * Must be called with the lock held.
+ */
+static void __cl_pool_fill(clarity_pool_t *pool) {
+	clarity_suite_t *suite = pool->run->suite;
+
+	// A prerequisite may come after its dependents, the suite tests are all resolved so that it is not out of reach.
+	while (!pool->aborted && pool->next < pool->total
+	       && (pool->pending.count < pool->lookahead || (pool->ordered && pool->next < suite->test_count))) {
+		size_t         position = pool->next++;
+		clarity_test_t **slot   = NULL;
+		clarity_test_t *test;
+
+		if (position < suite->test_count) {
+			slot = &suite->tests[position];
+			test = *slot;
+			if (!test || !cl_runner_matches(pool->run->filter, suite->name, test->name))
+				continue;
+		} else {
+			test = suite->generator(position - suite->test_count, suite->generator_data);
+			if (test && !cl_runner_matches(pool->run->filter, suite->name, test->name)) {
+				cl_free_test(test);
+				continue;
+			}
+		}
+
+		clarity_job_t *job = calloc(1, sizeof(*job));
+		if (job) {
+			job->test = test;
+			job->slot = slot;
+		}
+		if (!job || (test && !test->async_fn && !__cl_job_prepare(pool, job))) {
+			if (job)
+				free(job->needs);
+			free(job);
+			if (!slot)
+				cl_free_test(test);
+			pool->aborted = true;
+			return;
+		}
+
+		if (!test) {
+			job->result = (clarity_test_result_t){
+				.name          = "generated test",
+				.error_message = "the generator did not return a test",
+			};
+			__cl_job_list_push(&pool->done, job);
+			pthread_cond_signal(&pool->finished);
+		} else if (test->async_fn) {
+			__cl_job_list_push(&pool->deferred, job);
+		} else {
+			__cl_job_list_push(&pool->pending, job);
+		}
+	}
+}
+
+
+static bool __cl_job_fits(const clarity_pool_t *pool, const clarity_job_t *job) {
+	for (size_t i = 0; i < job->need_count; i++) {
+		const clarity_pool_resource_t *resource = &pool->resources[job->needs[i].resource];
+		if (resource->reserved || resource->in_use + job->needs[i].amount > resource->capacity)
+			return false;
+	}
+	return true;
+}
+
+
+/**
+ * @brief Checks whether the prerequisites of a job are settled, and records the first one which did not pass.
+ */
+static bool __cl_job_ready(clarity_job_t *job) {
+	const clarity_test_t *test = job->test;
+	for (size_t i = 0; i < test->prerequisite_count; i++) {
+		clarity_outcome_t outcome = test->prerequisites[i]->outcome;
+		if (outcome == CL_OUTCOME_PENDING || outcome == CL_OUTCOME_RUNNING)
+			return false;
+	}
+	job->blocked_by = cl_test_failed_prerequisite(test);
+	return true;
+}
+
+
+/**
+ * @brief Takes the first pending job which can start now, and acquires its resources.
+ *
+ * A blocked job reserves its resources for the rest of the pass: the jobs after it may overtake it, but only
+ * with resources it does not need, so that it cannot be starved. A job waiting for its prerequisites reserves
+ * nothing, and a job skipped because of one needs nothing.
+ *
+ * Must be called with the lock held.
+ *
+ * @return The job, or NULL if every pending job is blocked.
+ */
+static clarity_job_t *__cl_pool_take(clarity_pool_t *pool) {
+	for (size_t i = 0; i < pool->resource_count; i++)
+		pool->resources[i].reserved = false;
+
+	clarity_job_t *previous = NULL;
+	for (clarity_job_t *job = pool->pending.head; job; previous = job, job = job->next) {
+		if (!__cl_job_ready(job))
+			continue;
+		bool acquires = !job->excess && !job->blocked_by;
+		if (acquires && !__cl_job_fits(pool, job)) {
+			for (size_t i = 0; i < job->need_count; i++)
+				pool->resources[job->needs[i].resource].reserved = true;
+			if (!job->blocked_since)
+				job->blocked_since = cl_timing_now_ns();
+			continue;
+		}
+
+		if (previous)
+			previous->next = job->next;
+		else
+			pool->pending.head = job->next;
+		if (pool->pending.tail == &job->next)
+			pool->pending.tail = previous ? &previous->next : &pool->pending.head;
+		pool->pending.count--;
+		pool->running++;
+		job->test->outcome = CL_OUTCOME_RUNNING;
+
+		for (size_t i = 0; acquires && i < job->need_count; i++)
+			pool->resources[job->needs[i].resource].in_use += job->needs[i].amount;
+		return job;
+	}
+	return NULL;
+}
+
+
+static void __cl_job_run(clarity_pool_t *pool, clarity_job_t *job) {
+	clarity_test_t *test = job->test;
+
+	if (job->blocked_by)
+		cl_test_skip_for_prerequisite(test, job->blocked_by);
+	if (job->excess || job->blocked_by || cl_runner_unscheduled(pool->run, test)) {
+		job->result = test->result;
+		job->state  = true;
+		return;
+	}
+
+	test->result.resource_wait_ns = job->blocked_since ? cl_timing_now_ns() - job->blocked_since : 0;
+	job->result                   = test->result;
+	job->state                    = cl_runner_run_test(pool->run, test, &job->result);
+}
+
+
+static void *__cl_pool_worker(void *arg) {
+	clarity_pool_t *pool = arg;
+
+	pthread_mutex_lock(&pool->lock);
+	while (!pool->aborted) {
+		__cl_pool_fill(pool);
+		clarity_job_t *job = __cl_pool_take(pool);
+		if (!job) {
+			if (!pool->pending.count && pool->next >= pool->total)
+				break;
+			if (!pool->running && pool->pending.count) {
+				// Nothing runs and nothing can start: the prerequisites left are asynchronous tests, they all
+				// run in order once the pool is done.
+				for (clarity_job_t *waiting; (waiting = __cl_job_list_pop(&pool->pending));)
+					__cl_job_list_push(&pool->deferred, waiting);
+				pthread_cond_broadcast(&pool->work);
+				continue;
+			}
+			pthread_cond_wait(&pool->work, &pool->lock);
+			continue;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+		__cl_job_run(pool, job);
+		pthread_mutex_lock(&pool->lock);
+
+		for (size_t i = 0; !job->excess && !job->blocked_by && i < job->need_count; i++)
+			pool->resources[job->needs[i].resource].in_use -= job->needs[i].amount;
+		cl_test_settle(job->test, &job->result);
+		pool->running--;
+		pool->aborted |= !job->state;
+		__cl_job_list_push(&pool->done, job);
+		pthread_cond_signal(&pool->finished);
+		pthread_cond_broadcast(&pool->work);
+	}
+
+	pool->workers--;
+	pthread_cond_broadcast(&pool->work);
+	pthread_cond_signal(&pool->finished);
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+
+/**
+ * @brief Reports the finished jobs until every thread has left.
+ */
+static void __cl_pool_report(clarity_pool_t *pool) {
+	pthread_mutex_lock(&pool->lock);
+	while (pool->workers || pool->done.count) {
+		clarity_job_t *job = __cl_job_list_pop(&pool->done);
+		if (!job) {
+			pthread_cond_wait(&pool->finished, &pool->lock);
+			continue;
+		}
+
+		// Printing and releasing happen on this thread only, the printer and the stream are not thread-safe.
+		pthread_mutex_unlock(&pool->lock);
+		cl_runner_report_test(pool->run, &job->result);
+		__cl_job_free(pool, job, true);
+		pthread_mutex_lock(&pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+
+bool cl_parallel_run_tests(clarity_run_t *run) {
+	clarity_suite_t *suite = run->suite;
+	clarity_pool_t  pool;
+	memset(&pool, 0, sizeof pool);
+	pool.run   = run;
+	pool.total = suite->test_count + suite->generated_count;
+	__cl_job_list_init(&pool.pending);
+	__cl_job_list_init(&pool.done);
+	__cl_job_list_init(&pool.deferred);
+
+	size_t jobs = suite->jobs;
+	if (!jobs) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		jobs       = cores > 0 ? (size_t) cores : 1;
+	}
+	pool.lookahead = jobs * CL_PARALLEL_LOOKAHEAD;
+	for (size_t i = 0; i < suite->test_count && !pool.ordered; i++)
+		pool.ordered = suite->tests[i] && suite->tests[i]->prerequisite_count;
+
+	for (size_t i = 0; i < suite->resource_count; i++) {
+		size_t resource = __cl_pool_resource(&pool, suite->resources[i].name);
+		if (resource == SIZE_MAX) {
+			free(pool.resources);
+			return false;
+		}
+		pool.resources[resource].capacity = suite->resources[i].amount;
+	}
+
+	pthread_t *threads = calloc(jobs, sizeof(*threads));
+	if (!threads) {
+		free(pool.resources);
+		return false;
+	}
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.work, NULL);
+	pthread_cond_init(&pool.finished, NULL);
+
+	size_t started = 0;
+	pthread_mutex_lock(&pool.lock);
+	for (; started < jobs; started++) {
+		if (pthread_create(&threads[started], NULL, __cl_pool_worker, &pool) != 0)
+			break;
+		pool.workers++;
+	}
+	pthread_mutex_unlock(&pool.lock);
+	if (!started)
+		fprintf(stderr, "CLarity: could not start the threads of suite '%s'\n", suite->name);
+
+	__cl_pool_report(&pool);
+	for (size_t i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	bool completed = started && !pool.aborted;
+	for (clarity_job_t *job; (job = __cl_job_list_pop(&pool.deferred));) {
+		// A suite test may already have run, as the prerequisite of an earlier one.
+		if (completed && (!job->slot || job->test->outcome == CL_OUTCOME_PENDING))
+			completed = cl_runner_execute_in_order(run, job->test, job->slot);
+		else if (!job->slot)
+			cl_free_test(job->test);
+		__cl_job_free(&pool, job, false);
+	}
+	for (clarity_job_t *job; (job = __cl_job_list_pop(&pool.pending));) {
+		if (!job->slot)
+			cl_free_test(job->test);
+		__cl_job_free(&pool, job, false);
+	}
+
+	pthread_cond_destroy(&pool.finished);
+	pthread_cond_destroy(&pool.work);
+	pthread_mutex_destroy(&pool.lock);
+	free(pool.resources);
+	return completed;
+}
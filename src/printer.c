@@ -1,6 +1,9 @@
 #include "printer.h"
 #include <stdio.h>
 #include <string.h>
+#include "protocol.h"
+#include "stream.h"
+#include "timing.h"
 
 #define CL_TEST_SEPARATOR_CHAR '='
 #define CL_SUITE_SEPARATOR_CHAR '*'
@@ -80,40 +83,117 @@ static void __cl_write_box(const char *text, char border, size_t width, bool ena
 
 
 void cl_print_test_result(clarity_test_result_t *result) {
+	cl_protocol_result(result);
 	if (result->skipped || !result->passed)
 		__cl_print_line_separator(CL_TEST_SEPARATOR_CHAR, CL_TEST_SEPARATOR_LENGTH);
 
 	const char *word;
-	if (result->skipped)
+	if (result->not_run)
+		word = "NOT RUN";
+	else if (result->skipped)
 		word = "SKIP";
 	else
 		word = result->passed ? "PASS" : "FAIL";
-	printf("[%s] =====> %s\n", result->name, word);
+	printf("[%s] =====> %s", result->name, word);
+	if (result->resource_wait_ns)
+		printf(" (waited %.3f ms for resources)", (double) result->resource_wait_ns / 1e6);
+	putchar('\n');
 	if (result->passed && !result->skipped)
 		return;
 
 	printf("%s%s\n", CL_TEST_INDENTATION_STR, result->error_message);
-	printf("%sFile: %s:%zu\n", CL_TEST_INDENTATION_STR, result->file_name, result->line_number);
+	if (result->file_name)
+		printf("%sFile: %s:%zu\n", CL_TEST_INDENTATION_STR, result->file_name, result->line_number);
 	__cl_print_line_separator(CL_TEST_SEPARATOR_CHAR, CL_TEST_SEPARATOR_LENGTH);
 }
 
 
 void cl_print_suite_name(const char *name) {
+	cl_protocol_suite(name);
 	__cl_write_box(name, CL_SUITE_SEPARATOR_CHAR, CL_SUITE_SEPARATOR_LENGTH, true);
 }
 
 void cl_print_suite_report(clarity_suite_report_t *report) {
+	cl_protocol_end(report);
 	__cl_write_box(report->name, CL_SUITE_SEPARATOR_CHAR, CL_SUITE_REPORT_LENGTH, true);
 
 	int spacing = 5;
 
 	char text[CL_SUITE_REPORT_LENGTH];
-	snprintf(text, sizeof text,
+	int  len = snprintf(text, sizeof text,
 			 "Total: %-*d Succeeded: %-*d Failed: %-*d Skipped: %-*d",
 			 spacing, report->total_tests,
 			 spacing, report->succeeded_tests,
 			 spacing, report->failed_tests,
 			 spacing, report->skipped_tests);
+	if (report->not_run_tests && len > 0 && (size_t) len < sizeof text)
+		snprintf(text + len, sizeof text - (size_t) len, " Not run: %-*d", spacing, report->not_run_tests);
 
 	__cl_write_box(text, CL_SUITE_SEPARATOR_CHAR, CL_SUITE_REPORT_LENGTH, false);
-}
\ No newline at end of file
+}
+
+
+void cl_print_stream_summary(const clarity_stream_t *stream) {
+	char duration[32];
+
+	if (stream->slowest_count) {
+		__cl_print_line_separator(CL_TEST_SEPARATOR_CHAR, CL_TEST_SEPARATOR_LENGTH);
+		printf("Slowest tests:\n");
+		for (size_t i = 0; i < stream->slowest_count; i++) {
+			const clarity_stream_entry_t *entry = &stream->slowest[i];
+			printf("%s[%s] %s\n", CL_TEST_INDENTATION_STR, entry->name,
+			       cl_timing_format((double) entry->duration_ns, duration, sizeof duration));
+		}
+	}
+
+	if (stream->failure_count) {
+		__cl_print_line_separator(CL_TEST_SEPARATOR_CHAR, CL_TEST_SEPARATOR_LENGTH);
+		printf("Failures:\n");
+		for (size_t i = 0; i < stream->failure_count; i++) {
+			const clarity_stream_entry_t *entry = &stream->failures[i];
+			printf("%s[%s] %s\n", CL_TEST_INDENTATION_STR, entry->name, entry->error_message);
+			if (entry->file_name)
+				printf("%s%sFile: %s:%zu\n", CL_TEST_INDENTATION_STR, CL_TEST_INDENTATION_STR, entry->file_name,
+				       entry->line_number);
+		}
+		if (stream->dropped_failures)
+			printf("%s+%zu more\n", CL_TEST_INDENTATION_STR, stream->dropped_failures);
+	}
+
+	if (stream->slowest_count || stream->failure_count)
+		__cl_print_line_separator(CL_TEST_SEPARATOR_CHAR, CL_TEST_SEPARATOR_LENGTH);
+}
+
+
+void cl_print_stress_report(const clarity_stress_report_t *report) {
+	char text[CL_SUITE_REPORT_LENGTH];
+	char duration[32];
+
+	snprintf(text, sizeof text, "Stress: %s / %s", report->suite, report->name);
+	__cl_write_box(text, CL_SUITE_SEPARATOR_CHAR, CL_SUITE_REPORT_LENGTH, true);
+
+	double rate = report->runs ? 100.0 * (double) report->failures / (double) report->runs : 0;
+	snprintf(text, sizeof text, "Iterations: %llu x %u   Runs: %llu   Failed: %llu (%.4g%%)   Skipped: %llu   in %s",
+	         (unsigned long long) report->iterations, report->concurrency, (unsigned long long) report->runs,
+	         (unsigned long long) report->failures, rate, (unsigned long long) report->skips,
+	         cl_timing_format((double) report->duration_ns, duration, sizeof duration));
+	__cl_write_box(text, CL_SUITE_SEPARATOR_CHAR, CL_SUITE_REPORT_LENGTH, false);
+
+	if (!report->first_failed_iteration)
+		return;
+
+	printf("First failure at iteration %llu, copy %u:\n", (unsigned long long) report->first_failed_iteration,
+	       report->first_failed_copy);
+	printf("%s%s\n", CL_TEST_INDENTATION_STR, report->first_error_message);
+	if (report->first_file_name)
+		printf("%sFile: %s:%zu\n", CL_TEST_INDENTATION_STR, report->first_file_name, report->first_line_number);
+	__cl_print_line_separator(CL_SUITE_SEPARATOR_CHAR, CL_SUITE_REPORT_LENGTH);
+}
+
+
+void cl_print_cancellation(size_t failures, size_t not_run) {
+	char text[CL_SUITE_REPORT_LENGTH];
+	snprintf(text, sizeof text, "Stopped after %zu failure%s, %zu test%s not run", failures,
+	         failures == 1 ? "" : "s", not_run, not_run == 1 ? "" : "s");
+	__cl_write_box(text, CL_SUITE_SEPARATOR_CHAR, CL_SUITE_REPORT_LENGTH, true);
+}
@@ -0,0 +1,98 @@
+#include "protocol.h"
+#include <CLarity/cli.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "wire.h"
+
+static int              protocol_fd = -1;
+static pid_t            owner;
+static pthread_once_t   protocol_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t  protocol_lock = PTHREAD_MUTEX_INITIALIZER;
+static clarity_buffer_t output;
+
+
+/**
+ * @brief Sends a complete message, and stops reporting if the driver is gone.
+ */
+static void __cl_protocol_flush(bool written) {
+	if (!written || !cl_buffer_flush(&output, protocol_fd)) {
+		protocol_fd = -1;
+		cl_buffer_free(&output);
+	}
+}
+
+
+static void __cl_protocol_init(void) {
+	const char *env = getenv(CL_PROTOCOL_FD_ENV);
+	if (!env || !*env)
+		return;
+
+	// The programs the binary runs in turn did not get the descriptor from the driver.
+	char *end;
+	long fd = strtol(env, &end, 10);
+	unsetenv(CL_PROTOCOL_FD_ENV);
+	struct stat info;
+	if (*end || fd < 0 || fstat((int) fd, &info) != 0 || !S_ISFIFO(info.st_mode))
+		return;
+
+	fcntl((int) fd, F_SETFD, FD_CLOEXEC);
+	protocol_fd = (int) fd;
+	owner       = getpid();
+	__cl_protocol_flush(cl_wire_begin(&output, "HELLO") && cl_wire_add_u64(&output, CL_PROTOCOL_VERSION)
+	                    && cl_wire_end(&output));
+}
+
+
+/**
+ * @brief Get whether the calling process reports to a driver, and lock the protocol if it does.
+ */
+static bool __cl_protocol_acquire(void) {
+	pthread_once(&protocol_once, __cl_protocol_init);
+	if (protocol_fd < 0 || getpid() != owner)
+		return false;
+
+	pthread_mutex_lock(&protocol_lock);
+	if (protocol_fd >= 0)
+		return true;
+	pthread_mutex_unlock(&protocol_lock);
+	return false;
+}
+
+
+void cl_protocol_suite(const char *name) {
+	if (!__cl_protocol_acquire())
+		return;
+
+	__cl_protocol_flush(cl_wire_begin(&output, "SUITE") && cl_wire_add_string(&output, name)
+	                    && cl_wire_end(&output));
+	pthread_mutex_unlock(&protocol_lock);
+}
+
+
+void cl_protocol_result(const clarity_test_result_t *result) {
+	if (!__cl_protocol_acquire())
+		return;
+
+	__cl_protocol_flush(cl_wire_begin(&output, "RESULT") && cl_wire_add_result(&output, result)
+	                    && cl_wire_end(&output));
+	pthread_mutex_unlock(&protocol_lock);
+}
+
+
+void cl_protocol_end(const clarity_suite_report_t *report) {
+	if (!__cl_protocol_acquire())
+		return;
+
+	__cl_protocol_flush(cl_wire_begin(&output, "END")
+	                    && cl_wire_add_string(&output, report->name)
+	                    && cl_wire_add_u64(&output, report->total_tests)
+	                    && cl_wire_add_u64(&output, report->succeeded_tests)
+	                    && cl_wire_add_u64(&output, report->failed_tests)
+	                    && cl_wire_add_u64(&output, report->skipped_tests)
+	                    && cl_wire_add_u64(&output, report->not_run_tests)
+	                    && cl_wire_end(&output));
+	pthread_mutex_unlock(&protocol_lock);
+}
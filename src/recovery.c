@@ -0,0 +1,124 @@
+#include "recovery.h"
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "clock.h"
+#include "test.h"
+#include "timing.h"
+
+#define CL_RECOVERY_STACK_SIZE (64u * 1024u)
+
+static const int recovered_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+
+static struct sigaction previous_actions[sizeof recovered_signals / sizeof *recovered_signals];
+static pthread_once_t   install_once = PTHREAD_ONCE_INIT;
+static bool             installed;
+static pthread_key_t    stack_key;
+
+/**
+ * @brief Where the test running on the thread jumps back to when it crashes, NULL outside of a test.
+ */
+static _Thread_local sigjmp_buf *volatile recovery_point;
+static _Thread_local bool                 stack_ready;
+
+
+static void __cl_recovery_handler(int signal_number) {
+	sigjmp_buf *point = recovery_point;
+	if (point) {
+		recovery_point = NULL;
+		siglongjmp(*point, signal_number);
+	}
+
+	// Not a test of a recovering suite: the signal is delivered again to the handler this one replaced, once
+	// this handler returns and unblocks it.
+	for (size_t i = 0; i < sizeof recovered_signals / sizeof *recovered_signals; i++) {
+		if (recovered_signals[i] == signal_number)
+			sigaction(signal_number, &previous_actions[i], NULL);
+	}
+	raise(signal_number);
+}
+
+
+static void __cl_recovery_free_stack(void *data) {
+	stack_t disabled = { .ss_flags = SS_DISABLE };
+	sigaltstack(&disabled, NULL);
+	free(data);
+}
+
+
+static void __cl_recovery_install(void) {
+	if (pthread_key_create(&stack_key, __cl_recovery_free_stack) != 0)
+		return;
+
+	struct sigaction action;
+	memset(&action, 0, sizeof action);
+	action.sa_handler = __cl_recovery_handler;
+	action.sa_flags   = SA_ONSTACK;
+	sigemptyset(&action.sa_mask);
+	for (size_t i = 0; i < sizeof recovered_signals / sizeof *recovered_signals; i++)
+		sigaction(recovered_signals[i], &action, &previous_actions[i]);
+	installed = true;
+}
+
+
+/**
+ * @brief Gives the calling thread an alternate signal stack, so that a stack overflow can be recovered from.
+ *
+ * A stack already set up by the program is kept.
+ */
+static bool __cl_recovery_prepare_thread(void) {
+	if (stack_ready)
+		return true;
+
+	stack_t current;
+	if (sigaltstack(NULL, &current) == 0 && !(current.ss_flags & SS_DISABLE)) {
+		stack_ready = true;
+		return true;
+	}
+
+	size_t  size  = SIGSTKSZ > CL_RECOVERY_STACK_SIZE ? SIGSTKSZ : CL_RECOVERY_STACK_SIZE;
+	stack_t stack = { .ss_sp = malloc(size), .ss_size = size };
+	if (!stack.ss_sp || sigaltstack(&stack, NULL) != 0) {
+		free(stack.ss_sp);
+		return false;
+	}
+	pthread_setspecific(stack_key, stack.ss_sp);
+	stack_ready = true;
+	return true;
+}
+
+
+bool cl_recovery_run_test(clarity_test_t *test) {
+	pthread_once(&install_once, __cl_recovery_install);
+	if (!installed || !__cl_recovery_prepare_thread()) {
+		cl_run_test(test);
+		return false;
+	}
+
+	uint64_t   start = cl_timing_now_ns();
+	sigjmp_buf point;
+	int        signal_number = sigsetjmp(point, 1);
+	if (!signal_number) {
+		recovery_point = &point;
+		cl_run_test(test);
+		recovery_point = NULL;
+		return false;
+	}
+
+	// The test did not return: what cl_run_test would have done after it is done here. It may have crashed
+	// while recording a failure, holding the lock of its result.
+	atomic_flag_clear(&test->result_lock);
+	test->result.duration_ns = cl_timing_now_ns() - start;
+	test->result.passed      = false;
+	test->result.skipped     = false;
+	if (!cl_test_set_message(test, "the test crashed with signal %d (%s)", signal_number, strsignal(signal_number)))
+		test->result.error_message = "the test crashed";
+	if (test->clock)
+		cl_clock_reset(test->clock, test->virtual_time);
+	cl_test_flush_expectations(test);
+	cl_arena_reset(&test->arena);
+	return true;
+}
@@ -0,0 +1,721 @@
+#include <CLarity/suite.h>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "budget.h"
+#include "isolation.h"
+#include "parallel.h"
+#include "recovery.h"
+#include "runner.h"
+#include "suite.h"
+#include "test.h"
+#include "timing.h"
+#include "trace.h"
+
+/**
+ * @brief The failures after which a run is cancelled, counted across all the suites.
+ */
+static atomic_size_t max_failures;
+static atomic_size_t failures;
+static uint32_t      grace_ms;
+static atomic_uint   generation;     /**< Changes with the settings, for a watchdog to know it is stale. */
+static atomic_size_t running;        /**< The test functions currently running, on any thread. */
+static atomic_size_t cancelled_tests; /**< The tests not run since the cancellation, not reported yet. */
+
+
+bool cl_runner_matches(const char *pattern, const char *suite_name, const char *test_name) {
+	if (!pattern)
+		return true;
+	if (fnmatch(pattern, test_name, 0) == 0)
+		return true;
+
+	char path[512];
+	snprintf(path, sizeof path, "%s/%s", suite_name, test_name);
+	return fnmatch(pattern, path, 0) == 0;
+}
+
+
+/**
+ * @brief Runs the setup of a fixture as `cl_fixture_run_setup` does, recording it to the timeline.
+ */
+static bool __cl_runner_fixture_setup(clarity_fixture_t *fixture, const char *label, const clarity_suite_t *suite,
+                                      int *status) {
+	uint64_t trace = cl_trace_now();
+	bool     ran   = cl_fixture_run_setup(fixture, status);
+	if (ran)
+		cl_trace_span(trace, "fixture", label, suite->name);
+	return ran;
+}
+
+
+/**
+ * @brief Runs the teardown of a fixture as `cl_fixture_run_teardown` does, recording it to the timeline.
+ */
+static bool __cl_runner_fixture_teardown(clarity_fixture_t *fixture, const char *label,
+                                         const clarity_suite_t *suite, int *status) {
+	uint64_t trace = cl_trace_now();
+	bool     ran   = cl_fixture_run_teardown(fixture, status);
+	if (ran)
+		cl_trace_span(trace, "fixture", label, suite->name);
+	return ran;
+}
+
+
+/**
+ * @brief Runs the per-test setups of a suite, after those of the suites it is nested in.
+ */
+static bool __cl_runner_setup_fixtures(const clarity_suite_t *suite) {
+	int status = 0;
+
+	if (suite->parent && !__cl_runner_setup_fixtures(suite->parent))
+		return false;
+	for (size_t j = 0; j < suite->fixture_count; j++) {
+		if (__cl_runner_fixture_setup(suite->fixtures[j], "setup", suite, &status)) {
+			if (status) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+bool cl_runner_setup_test(clarity_run_t *run) {
+	return __cl_runner_setup_fixtures(run->suite);
+}
+
+
+bool cl_runner_finish_test(clarity_run_t *run, clarity_test_t *test, clarity_test_result_t *result) {
+	clarity_suite_t *suite = run->suite;
+	int             status = 0;
+
+	if (run->baseline)
+		cl_baseline_compare_test(run->baseline, suite, test);
+	*result = test->result;
+
+	bool state = true;
+	for (const clarity_suite_t *level = suite; level; level = level->parent) {
+		for (int64_t j = (int64_t) (level->fixture_count - 1); j >= 0; j--) {
+			if (__cl_runner_fixture_teardown(level->fixtures[j], "teardown", level, &status) && status)
+				state = false;
+		}
+	}
+	return state;
+}
+
+
+bool cl_runner_run_test(clarity_run_t *run, clarity_test_t *test, clarity_test_result_t *result) {
+	if (!cl_runner_setup_test(run)) {
+		// The callers report the result whatever the state, the test did not run.
+		*result               = test->result;
+		result->passed        = false;
+		result->error_message = "a per-test setup reported an error";
+		return false;
+	}
+
+	atomic_fetch_add(&running, 1);
+	if (run->suite->crash_recovery && !run->suite->isolated) {
+		if (cl_recovery_run_test(test))
+			atomic_fetch_add(&run->crashes, 1);
+	} else {
+		cl_run_test(test);
+	}
+	atomic_fetch_sub(&running, 1);
+	return cl_runner_finish_test(run, test, result);
+}
+
+
+void cl_set_max_failures(size_t max, uint32_t grace) {
+	atomic_fetch_add(&generation, 1);
+	grace_ms = grace ? grace : CL_DEFAULT_CANCEL_GRACE_MS;
+	atomic_store(&failures, 0);
+	atomic_store(&cancelled_tests, 0);
+	atomic_store(&max_failures, max);
+	cl_test_cancel_all(0);
+}
+
+
+/**
+ * @brief Exits the process if test functions are still running once the grace period of a cancellation is over.
+ *
+ * The tests cannot be interrupted safely, and the run cannot report while they hold their suites.
+ */
+static void *__cl_runner_watchdog(void *data) {
+	unsigned int    watched = (unsigned int) (uintptr_t) data;
+	struct timespec delay   = { .tv_sec = grace_ms / 1000, .tv_nsec = (long) (grace_ms % 1000) * 1000000L };
+	while (nanosleep(&delay, &delay) != 0)
+		;
+
+	size_t stuck = atomic_load(&running);
+	if (stuck && atomic_load(&generation) == watched) {
+		// The suites will never report, the summary of the cancellation is all that is left of the run.
+		size_t count   = atomic_load(&failures);
+		size_t not_run = atomic_load(&cancelled_tests);
+		fflush(stdout);
+		fprintf(stderr, "CLarity: stopped after %zu failure%s, %zu test%s not run so far\n", count,
+		        count == 1 ? "" : "s", not_run, not_run == 1 ? "" : "s");
+		fprintf(stderr, "CLarity: %zu test%s did not stop within %u ms of the cancellation, exiting\n", stuck,
+		        stuck == 1 ? "" : "s", grace_ms);
+		_exit(1);
+	}
+	return NULL;
+}
+
+
+/**
+ * @brief Counts a failure, and cancels the run when it reaches the maximum number of failures.
+ */
+static void __cl_runner_count_failure(void) {
+	size_t max = atomic_load(&max_failures);
+	if (!max || atomic_fetch_add(&failures, 1) + 1 != max)
+		return;
+
+	cl_test_cancel_all(cl_timing_now_ns() + (uint64_t) grace_ms * 1000000u);
+	pthread_t      watchdog;
+	pthread_attr_t attributes;
+	if (pthread_attr_init(&attributes) != 0)
+		return;
+	pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+	pthread_create(&watchdog, &attributes, __cl_runner_watchdog, (void *) (uintptr_t) atomic_load(&generation));
+	pthread_attr_destroy(&attributes);
+}
+
+
+/**
+ * @brief Checks whether the run was cancelled, and marks the test as not run if so.
+ */
+static bool __cl_runner_cancelled(clarity_test_t *test) {
+	if (!cl_test_cancel_deadline())
+		return false;
+
+	size_t count = atomic_load(&failures);
+	test->result.skipped = true;
+	test->result.not_run = true;
+	if (!cl_test_set_message(test, "the run stopped after %zu failures", count))
+		test->result.error_message = "the run stopped after too many failures";
+	return true;
+}
+
+
+void cl_runner_report_test(clarity_run_t *run, const clarity_test_result_t *result) {
+	// The tests left out by a cancellation would bury the failures which caused it.
+	bool cancelled = result->not_run && cl_test_cancel_deadline();
+	if (cancelled)
+		atomic_fetch_add(&cancelled_tests, 1);
+	else if (!result->passed && !result->skipped)
+		__cl_runner_count_failure();
+
+	if (!cancelled && (!run->stream || !result->passed || result->skipped)) {
+		uint64_t trace = cl_trace_now();
+		cl_print_test_result((clarity_test_result_t *) result);
+		cl_trace_span(trace, "report", NULL, result->name);
+	}
+	if (run->stream)
+		cl_stream_record(run->stream, result);
+
+	if (run->budget)
+		cl_budget_record(run->budget, run->suite->name, result);
+
+	run->report.total_tests++;
+	if (result->not_run)
+		run->report.not_run_tests++;
+	else if (result->skipped)
+		run->report.skipped_tests++;
+	else if (result->passed)
+		run->report.succeeded_tests++;
+	else
+		run->report.failed_tests++;
+}
+
+
+void cl_runner_release_test(clarity_run_t *run, clarity_test_t *test, clarity_test_t **slot) {
+	// Dependents read the outcome of their prerequisites, which must outlive them.
+	if (slot && (!run->stream || test->dependent_count))
+		return;
+
+	cl_free_test(test);
+	if (slot)
+		*slot = NULL;
+}
+
+
+static void __cl_runner_async_complete(void *context, clarity_test_t *test, void *cookie) {
+	clarity_run_t         *run = context;
+	clarity_test_result_t result;
+
+	if (!cl_runner_finish_test(run, test, &result))
+		run->aborted = true;
+	cl_test_settle(test, &result);
+	cl_runner_report_test(run, &result);
+	cl_runner_release_test(run, test, cookie);
+}
+
+
+static bool __cl_runner_start_async_test(clarity_run_t *run, clarity_test_t *test, clarity_test_t **slot) {
+	if (!run->loop) {
+		run->loop = cl_event_loop_create(run->suite->async_concurrency, __cl_runner_async_complete, run);
+		if (!run->loop)
+			return false;
+	}
+
+	while (!run->aborted && cl_event_loop_in_flight(run->loop) >= cl_event_loop_capacity(run->loop))
+		cl_event_loop_run_once(run->loop);
+	if (run->aborted || !cl_runner_setup_test(run))
+		return false;
+
+	if (cl_event_loop_submit(run->loop, test, slot) != CL_SUCCESS) {
+		clarity_test_result_t result;
+		test->result.passed        = false;
+		test->result.error_message = "could not start the asynchronous test";
+		bool state = cl_runner_finish_test(run, test, &result);
+		cl_test_settle(test, &result);
+		cl_runner_report_test(run, &result);
+		cl_runner_release_test(run, test, slot);
+		return state;
+	}
+	return !run->aborted;
+}
+
+
+/**
+ * @brief Checks whether the suite of a run recovered from so many crashes that it must stop, and marks the test
+ * as not run if so.
+ */
+static bool __cl_runner_crashed_too_often(clarity_run_t *run, clarity_test_t *test) {
+	const clarity_suite_t *suite   = run->suite;
+	size_t                crashes = atomic_load(&run->crashes);
+	if (!suite->crash_recovery || suite->isolated || crashes < suite->max_crashes)
+		return false;
+
+	test->result.skipped = true;
+	test->result.not_run = true;
+	if (!cl_test_set_message(test, "the suite stopped after %zu crashes, the process may be corrupted", crashes))
+		test->result.error_message = "the suite stopped after too many crashes";
+	return true;
+}
+
+
+bool cl_runner_unscheduled(clarity_run_t *run, clarity_test_t *test) {
+	if (__cl_runner_cancelled(test))
+		return true;
+	if (run->budget && cl_budget_stops(run->budget, test))
+		return true;
+	return __cl_runner_crashed_too_often(run, test);
+}
+
+
+bool cl_runner_execute(clarity_run_t *run, clarity_test_t *test, clarity_test_t **slot) {
+	test->outcome = CL_OUTCOME_RUNNING;
+	if (cl_runner_unscheduled(run, test)) {
+		clarity_test_result_t result = test->result;
+		cl_test_settle(test, &result);
+		cl_runner_report_test(run, &result);
+		cl_runner_release_test(run, test, slot);
+		return true;
+	}
+	if (test->async_fn)
+		return __cl_runner_start_async_test(run, test, slot);
+
+	clarity_test_result_t result;
+	bool                  state = cl_runner_run_test(run, test, &result);
+	cl_test_settle(test, &result);
+	cl_runner_report_test(run, &result);
+	cl_runner_release_test(run, test, slot);
+	return state;
+}
+
+
+static clarity_test_t **__cl_runner_slot(clarity_suite_t *suite, const clarity_test_t *test) {
+	for (size_t i = 0; i < suite->test_count; i++) {
+		if (suite->tests[i] == test)
+			return &suite->tests[i];
+	}
+	return NULL;
+}
+
+
+bool cl_runner_execute_in_order(clarity_run_t *run, clarity_test_t *test, clarity_test_t **slot) {
+	const clarity_test_t *failed = NULL;
+
+	for (size_t i = 0; i < test->prerequisite_count && !failed; i++) {
+		clarity_test_t  *prerequisite = test->prerequisites[i];
+		clarity_test_t **own_slot     = NULL;
+
+		if (prerequisite->outcome == CL_OUTCOME_PENDING) {
+			own_slot = __cl_runner_slot(run->suite, prerequisite);
+			// A pending test outside of the suite is stale, left by an aborted run.
+			if (!own_slot)
+				failed = prerequisite;
+			else if (!cl_runner_execute_in_order(run, prerequisite, own_slot))
+				return false;
+		}
+		while (prerequisite->outcome == CL_OUTCOME_RUNNING && run->loop && !run->aborted)
+			cl_event_loop_run_once(run->loop);
+		if (run->aborted)
+			return false;
+	}
+	if (!failed)
+		failed = cl_test_failed_prerequisite(test);
+	if (!failed)
+		return cl_runner_execute(run, test, slot);
+
+	clarity_test_result_t result;
+	cl_test_skip_for_prerequisite(test, failed);
+	result = test->result;
+	cl_test_settle(test, &result);
+	cl_runner_report_test(run, &result);
+	cl_runner_release_test(run, test, slot);
+	return true;
+}
+
+
+static bool __cl_run_generated_tests(clarity_run_t *run) {
+	clarity_suite_t *suite = run->suite;
+
+	for (size_t i = 0; i < suite->generated_count; i++) {
+		// Without a filter, the tests left are all selected, they need not be generated to be counted.
+		if (!run->filter && cl_test_cancel_deadline()) {
+			size_t left = suite->generated_count - i;
+			run->report.total_tests   += (uint32_t) left;
+			run->report.not_run_tests += (uint32_t) left;
+			atomic_fetch_add(&cancelled_tests, left);
+			break;
+		}
+
+		clarity_test_t *test = suite->generator(i, suite->generator_data);
+		if (test && !cl_runner_matches(run->filter, suite->name, test->name)) {
+			cl_free_test(test);
+			continue;
+		}
+		if (!test) {
+			clarity_test_result_t result = {
+				.name          = "generated test",
+				.error_message = "the generator did not return a test",
+			};
+			cl_runner_report_test(run, &result);
+			continue;
+		}
+
+		if (!cl_runner_execute(run, test, NULL))
+			return false;
+	}
+
+	return true;
+}
+
+
+static bool __cl_run_suite_tests(clarity_run_t *run) {
+	clarity_suite_t *suite = run->suite;
+
+	for (size_t i = 0; i < suite->test_count; i++) {
+		clarity_test_t *test = suite->tests[i];
+		// The tests run earlier as the prerequisites of another one are no longer pending.
+		if (!test || test->outcome != CL_OUTCOME_PENDING)
+			continue;
+		if (!cl_runner_execute_in_order(run, test, &suite->tests[i]))
+			return false;
+	}
+
+	return __cl_run_generated_tests(run);
+}
+
+
+static bool __cl_runner_has_match(const clarity_suite_t *suite, const char *filter) {
+	if (suite->generated_count || (!filter && suite->test_count))
+		return true;
+
+	for (size_t i = 0; filter && i < suite->test_count; i++) {
+		if (suite->tests[i] && cl_runner_matches(filter, suite->name, suite->tests[i]->name))
+			return true;
+	}
+	for (size_t i = 0; i < suite->child_count; i++) {
+		if (__cl_runner_has_match(suite->children[i], filter))
+			return true;
+	}
+	return false;
+}
+
+
+static void __cl_runner_add_report(clarity_suite_report_t *totals, const clarity_suite_report_t *report) {
+	totals->total_tests     += report->total_tests;
+	totals->failed_tests    += report->failed_tests;
+	totals->skipped_tests   += report->skipped_tests;
+	totals->succeeded_tests += report->succeeded_tests;
+	totals->not_run_tests   += report->not_run_tests;
+}
+
+
+/**
+ * @brief Reports the selected tests of a suite and of the suites nested in it as skipped, because a
+ * prerequisite suite did not pass.
+ */
+static void __cl_runner_skip_suite(clarity_run_t *run, clarity_suite_t *suite,
+                                   const clarity_suite_t *prerequisite) {
+	suite->outcome = CL_OUTCOME_NOT_PASSED;
+	for (size_t i = 0; i < suite->test_count; i++) {
+		clarity_test_t *test = suite->tests[i];
+		if (!test || !cl_runner_matches(run->filter, suite->name, test->name))
+			continue;
+
+		test->result.skipped = true;
+		if (!cl_test_set_message(test, "prerequisite suite '%s' did not pass", prerequisite->name))
+			test->result.error_message = "a prerequisite suite did not pass";
+		cl_test_settle(test, &test->result);
+		cl_runner_report_test(run, &test->result);
+	}
+
+	// The generated tests are not even created, they only count as skipped.
+	run->report.total_tests   += (uint32_t) suite->generated_count;
+	run->report.skipped_tests += (uint32_t) suite->generated_count;
+
+	for (size_t i = 0; i < suite->child_count; i++)
+		__cl_runner_skip_suite(run, suite->children[i], prerequisite);
+}
+
+
+bool cl_run_suite(clarity_suite_t *suite) {
+	return cl_runner_run_suite(suite, NULL);
+}
+
+
+bool cl_run_suites(clarity_suite_t **suites, size_t count) {
+	return cl_runner_run_suites(suites, count, NULL, NULL);
+}
+
+
+/**
+ * @brief Runs the suite setups of the ancestors of a suite run on its own, from the outermost one.
+ */
+static bool __cl_runner_setup_ancestors(const clarity_suite_t *suite) {
+	int status = 0;
+
+	if (!suite)
+		return true;
+	if (!__cl_runner_setup_ancestors(suite->parent))
+		return false;
+	return !__cl_runner_fixture_setup(suite->suite_fixture, "suite setup", suite, &status) || !status;
+}
+
+
+static bool __cl_runner_teardown_ancestors(const clarity_suite_t *suite) {
+	int  status = 0;
+	bool state  = true;
+
+	for (; suite; suite = suite->parent) {
+		if (__cl_runner_fixture_teardown(suite->suite_fixture, "suite teardown", suite, &status) && status)
+			state = false;
+	}
+	return state;
+}
+
+
+/**
+ * @brief Counts the tests a run of a suite and of the suites nested in it would select.
+ *
+ * The generated tests are all counted when there is no filter, and none otherwise, not to generate them.
+ */
+static size_t __cl_runner_count_selected(const clarity_suite_t *suite, const char *filter) {
+	size_t count = filter ? 0 : suite->generated_count;
+	for (size_t i = 0; i < suite->test_count; i++) {
+		if (suite->tests[i] && cl_runner_matches(filter, suite->name, suite->tests[i]->name))
+			count++;
+	}
+	for (size_t i = 0; i < suite->child_count; i++)
+		count += __cl_runner_count_selected(suite->children[i], filter);
+	return count;
+}
+
+
+/**
+ * @brief Runs a suite and the suites nested in it, adding its counters to those of its parent.
+ *
+ * @param totals The report of the parent, or NULL for the suite run at the top.
+ */
+static bool __cl_runner_run_tree(clarity_suite_t *suite, const char *filter, clarity_budget_t *budget,
+                                 clarity_suite_report_t *totals) {
+	if (!__cl_runner_has_match(suite, filter))
+		return true;
+	// A cancelled run does not start new suites, their setup could take as long as their tests.
+	if (cl_test_cancel_deadline()) {
+		suite->outcome = CL_OUTCOME_NOT_PASSED;
+		atomic_fetch_add(&cancelled_tests, __cl_runner_count_selected(suite, filter));
+		return true;
+	}
+
+	cl_print_suite_name(suite->name);
+	clarity_run_t run;
+	memset(&run, 0, sizeof run);
+	run.suite       = suite;
+	run.filter      = filter;
+	run.budget      = budget;
+	run.report.name = suite->name;
+
+	suite->outcome = CL_OUTCOME_NOT_PASSED;
+	for (size_t i = 0; i < suite->prerequisite_count; i++) {
+		if (suite->prerequisites[i]->outcome == CL_OUTCOME_NOT_PASSED) {
+			__cl_runner_skip_suite(&run, suite, suite->prerequisites[i]);
+			cl_print_suite_report(&run.report);
+			if (totals)
+				__cl_runner_add_report(totals, &run.report);
+			return true;
+		}
+	}
+	for (size_t i = 0; i < suite->test_count; i++) {
+		clarity_test_t *test = suite->tests[i];
+		if (test)
+			test->outcome = cl_runner_matches(filter, suite->name, test->name) ? CL_OUTCOME_PENDING
+			                                                                   : CL_OUTCOME_NONE;
+	}
+
+	int status = 0;
+	if (__cl_runner_fixture_setup(suite->suite_fixture, "suite setup", suite, &status)) {
+		if (status)
+			return false;
+	}
+
+	clarity_baseline_mode_t baseline_mode = cl_baseline_effective_mode(suite);
+	if (baseline_mode == CL_BASELINE_COMPARE)
+		run.baseline = cl_baseline_load_reference(suite);
+	bool completed = true;
+	if (suite->streaming) {
+		run.stream = cl_stream_create(suite->stream_max_failures, suite->stream_max_slowest);
+		completed  = run.stream != NULL;
+	}
+	// The samples are gone by the end of the run, with the released tests or with the forked processes.
+	if ((suite->streaming || suite->isolated) && baseline_mode == CL_BASELINE_RECORD)
+		baseline_mode = CL_BASELINE_OFF;
+
+	if (completed) {
+		if (suite->isolated)
+			completed = cl_isolation_run_tests(&run);
+		else if (suite->jobs != 1)
+			completed = cl_parallel_run_tests(&run);
+		else
+			completed = __cl_run_suite_tests(&run);
+	}
+	if (run.loop) {
+		cl_event_loop_drain(run.loop);
+		cl_event_loop_free(run.loop);
+		completed &= !run.aborted;
+	}
+	cl_baseline_free(run.baseline);
+
+	// The nested suites run inside the setup of this one, which is paid once for the whole tree. A nested suite
+	// which stopped without reporting anything had a fixture error.
+	for (size_t i = 0; completed && i < suite->child_count; i++) {
+		clarity_suite_report_t nested = { 0 };
+		if (!__cl_runner_run_tree(suite->children[i], filter, budget, &nested) && !nested.failed_tests)
+			completed = false;
+		__cl_runner_add_report(&run.report, &nested);
+	}
+
+	// Once set up, the suite is torn down however its run ended.
+	if (__cl_runner_fixture_teardown(suite->suite_fixture, "suite teardown", suite, &status) && status)
+		completed = false;
+	if (!completed) {
+		cl_stream_free(run.stream);
+		return false;
+	}
+
+	uint64_t trace = cl_trace_now();
+	if (run.stream) {
+		cl_stream_finish(run.stream);
+		cl_print_stream_summary(run.stream);
+		cl_stream_free(run.stream);
+	}
+	cl_print_suite_report(&run.report);
+	cl_trace_span(trace, "report", NULL, suite->name);
+
+	if (baseline_mode == CL_BASELINE_RECORD) {
+		clarity_status_t recorded = cl_baseline_record_suite(suite);
+		if (recorded != CL_SUCCESS) {
+			fprintf(stderr, "CLarity: could not record the baseline of suite '%s' to '%s'\n", suite->name,
+			        suite->baseline_path);
+			return false;
+		}
+	}
+
+	if (totals)
+		__cl_runner_add_report(totals, &run.report);
+	if (run.report.failed_tests == 0)
+		suite->outcome = CL_OUTCOME_PASSED;
+	return run.report.failed_tests == 0;
+}
+
+
+static bool __cl_runner_run_root(clarity_suite_t *suite, const char *filter, clarity_budget_t *budget) {
+	if (!suite || !__cl_runner_has_match(suite, filter))
+		return true;
+
+	// A nested suite run on its own still gets the environment its ancestors set up.
+	if (!__cl_runner_setup_ancestors(suite->parent))
+		return false;
+	bool passed = __cl_runner_run_tree(suite, filter, budget, NULL);
+	return __cl_runner_teardown_ancestors(suite->parent) && passed;
+}
+
+
+/**
+ * @brief Reports the tests a cancellation left out, once the suites it stopped are done, then lifts it.
+ *
+ * The failures are counted from 0 again, for the next suites run in the process to start their tests.
+ */
+static void __cl_runner_report_cancellation(void) {
+	if (!cl_test_cancel_deadline())
+		return;
+	cl_print_cancellation(atomic_load(&max_failures), atomic_exchange(&cancelled_tests, 0));
+
+	atomic_fetch_add(&generation, 1);
+	atomic_store(&failures, 0);
+	cl_test_cancel_all(0);
+}
+
+
+bool cl_runner_run_suite(clarity_suite_t *suite, const char *filter) {
+	bool passed = __cl_runner_run_root(suite, filter, NULL);
+	__cl_runner_report_cancellation();
+	return passed;
+}
+
+
+static void __cl_runner_order_suite(clarity_suite_t **suites, size_t count, size_t index, bool *visited,
+                                    clarity_suite_t **order, size_t *ordered) {
+	visited[index] = true;
+	for (size_t i = 0; i < suites[index]->prerequisite_count; i++) {
+		for (size_t j = 0; j < count; j++) {
+			if (suites[j] == suites[index]->prerequisites[i] && !visited[j])
+				__cl_runner_order_suite(suites, count, j, visited, order, ordered);
+		}
+	}
+	order[(*ordered)++] = suites[index];
+}
+
+
+bool cl_runner_run_suites(clarity_suite_t **suites, size_t count, const char *filter, clarity_budget_t *budget) {
+	clarity_suite_t **order   = calloc(count ? count : 1, sizeof(*order));
+	bool            *visited  = calloc(count ? count : 1, sizeof(*visited));
+	size_t          ordered   = 0;
+	bool            passed    = true;
+
+	if (!order || !visited) {
+		// Without memory to sort them, the suites still run, in the given order.
+		for (size_t i = 0; i < count; i++)
+			passed &= __cl_runner_run_root(suites[i], filter, budget);
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			if (suites[i] && !visited[i])
+				__cl_runner_order_suite(suites, count, i, visited, order, &ordered);
+		}
+		for (size_t i = 0; i < ordered; i++)
+			passed &= __cl_runner_run_root(order[i], filter, budget);
+	}
+
+	free(order);
+	free(visited);
+	__cl_runner_report_cancellation();
+	return passed;
+}
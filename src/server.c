@@ -0,0 +1,210 @@
+#define _GNU_SOURCE
+#include "server.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "runner.h"
+#include "socket.h"
+#include "suite.h"
+#include "test.h"
+#include "wire.h"
+
+typedef struct clarity_server_s {
+	clarity_suite_t  **suites;
+	size_t           suite_count;
+	clarity_run_t    *runs;   /**< The run of every suite, kept across requests. */
+	bool             *broken; /**< Whether the setup of a suite reported an error. */
+	int              client;
+	bool             connected; /**< Whether the client is still there to receive results. */
+	clarity_buffer_t input;
+	clarity_buffer_t output;
+} clarity_server_t;
+
+
+static void __cl_server_setup(clarity_server_t *server) {
+	for (size_t i = 0; i < server->suite_count; i++) {
+		clarity_suite_t *suite = server->suites[i];
+		if (!suite)
+			continue;
+
+		int status = 0;
+		if (cl_fixture_run_setup(suite->suite_fixture, &status) && status)
+			server->broken[i] = true;
+
+		clarity_run_t *run = &server->runs[i];
+		run->suite       = suite;
+		run->report.name = suite->name;
+		if (cl_baseline_effective_mode(suite) == CL_BASELINE_COMPARE)
+			run->baseline = cl_baseline_load_reference(suite);
+	}
+}
+
+
+static bool __cl_server_teardown(clarity_server_t *server) {
+	bool state = true;
+
+	for (size_t i = server->suite_count; i-- > 0;) {
+		clarity_suite_t *suite  = server->suites[i];
+		int             status = 0;
+		if (!suite)
+			continue;
+
+		if (!server->broken[i] && cl_fixture_run_teardown(suite->suite_fixture, &status) && status)
+			state = false;
+		cl_baseline_free(server->runs[i].baseline);
+	}
+	return state;
+}
+
+
+static void __cl_server_send(clarity_server_t *server, const char *type, const char *text) {
+	bool written = cl_wire_begin(&server->output, type)
+	               && (!text || cl_wire_add_string(&server->output, text))
+	               && cl_wire_end(&server->output);
+	if (!written || !cl_buffer_flush(&server->output, server->client))
+		server->connected = false;
+}
+
+
+/**
+ * @brief Runs one test of a suite, and sends its result to the client.
+ *
+ * @return false if a per-test fixture reported an error, in which case the rest of the suite is not run.
+ */
+static bool __cl_server_run_test(clarity_server_t *server, size_t index, clarity_test_t *test) {
+	clarity_test_result_t result = { .name = test ? test->name : "generated test" };
+	bool                  state  = true;
+
+	if (!test) {
+		result.error_message = "the generator did not return a test";
+	} else if (server->broken[index]) {
+		result.error_message = "the suite setup reported an error when the server started";
+	} else {
+		cl_test_reset_result(test);
+		state = cl_runner_run_test(&server->runs[index], test, &result);
+	}
+
+	bool written = cl_wire_begin(&server->output, "RESULT")
+	               && cl_wire_add_result(&server->output, &result)
+	               && cl_wire_end(&server->output);
+	if (!written || !cl_buffer_flush(&server->output, server->client))
+		server->connected = false;
+	return state;
+}
+
+
+static void __cl_server_run_suite(clarity_server_t *server, size_t index, const char *filter) {
+	clarity_suite_t *suite  = server->suites[index];
+	bool            started = false;
+	bool            state   = true;
+
+	for (size_t i = 0; state && server->connected && i < suite->test_count + suite->generated_count; i++) {
+		clarity_test_t *test = NULL;
+		bool           owned = i >= suite->test_count;
+		if (owned)
+			test = suite->generator(i - suite->test_count, suite->generator_data);
+		else
+			test = suite->tests[i];
+
+		if ((!owned && !test) || (test && !cl_runner_matches(filter, suite->name, test->name))) {
+			if (owned)
+				cl_free_test(test);
+			continue;
+		}
+
+		if (!started)
+			__cl_server_send(server, "SUITE", suite->name);
+		started = true;
+		state   = __cl_server_run_test(server, index, test);
+		if (owned)
+			cl_free_test(test);
+	}
+
+	if (started)
+		__cl_server_send(server, "END", NULL);
+}
+
+
+/**
+ * @brief Serves the requests of a client until it disconnects.
+ *
+ * @return true if the client asked the server to stop.
+ */
+static bool __cl_server_serve_client(clarity_server_t *server) {
+	for (;;) {
+		char *line = cl_buffer_next_line(&server->input);
+		if (!line) {
+			if (cl_buffer_fill(&server->input, server->client) <= 0)
+				return false;
+			continue;
+		}
+
+		char   *fields[CL_WIRE_MAX_FIELDS];
+		size_t field_count = cl_wire_split(line, fields, CL_WIRE_MAX_FIELDS);
+		if (!strcmp(fields[0], "STOP")) {
+			__cl_server_send(server, "DONE", NULL);
+			return true;
+		}
+		if (strcmp(fields[0], "RUN") != 0) {
+			__cl_server_send(server, "ERROR", "unknown request");
+			return false;
+		}
+
+		const char *filter = field_count > 1 && fields[1][0] ? fields[1] : NULL;
+		for (size_t i = 0; server->connected && i < server->suite_count; i++) {
+			if (server->suites[i])
+				__cl_server_run_suite(server, i, filter);
+		}
+		__cl_server_send(server, "DONE", NULL);
+		if (!server->connected)
+			return false;
+	}
+}
+
+
+int cl_server_serve(const char *address, clarity_suite_t **suites, size_t suite_count) {
+	clarity_server_t server;
+	memset(&server, 0, sizeof server);
+	server.suites      = suites;
+	server.suite_count = suite_count;
+	server.runs        = calloc(suite_count + 1, sizeof(*server.runs));
+	server.broken      = calloc(suite_count + 1, sizeof(*server.broken));
+	if (!server.runs || !server.broken) {
+		free(server.runs);
+		free(server.broken);
+		return 2;
+	}
+
+	__cl_server_setup(&server);
+
+	int  listener = cl_socket_listen(address);
+	bool stopped  = false;
+	while (listener >= 0 && !stopped) {
+		server.client = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+		if (server.client < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			fprintf(stderr, "CLarity: the server stopped accepting clients: %s\n", strerror(errno));
+			break;
+		}
+
+		server.connected = true;
+		stopped          = __cl_server_serve_client(&server);
+		close(server.client);
+		cl_buffer_free(&server.input);
+		cl_buffer_free(&server.output);
+	}
+	if (listener >= 0)
+		cl_socket_close_listener(listener, address);
+
+	bool torn_down = __cl_server_teardown(&server);
+	free(server.runs);
+	free(server.broken);
+
+	if (listener < 0)
+		return 2;
+	return torn_down ? 0 : 1;
+}
@@ -0,0 +1,371 @@
+#include "simd.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CL_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#define CL_HASH_PRIME_1 0x9e3779b185ebca87ULL
+#define CL_HASH_PRIME_2 0xc2b2ae3d27d4eb4fULL
+#define CL_HASH_PRIME_3 0x165667b19e3779f9ULL
+#define CL_HASH_PRIME_4 0x85ebca77c2b2ae63ULL
+#define CL_HASH_PRIME_5 0x27d4eb2f165667c5ULL
+
+static atomic_int __cl_simd_detected = -1;
+
+
+clarity_simd_level_t cl_simd_level(void) {
+	int level = atomic_load_explicit(&__cl_simd_detected, memory_order_relaxed);
+	if (level >= 0)
+		return (clarity_simd_level_t) level;
+
+	level = CL_SIMD_SCALAR;
+#ifdef CL_SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		level = CL_SIMD_AVX2;
+	else if (__builtin_cpu_supports("sse2"))
+		level = CL_SIMD_SSE2;
+#endif
+
+	const char *cap = getenv(CL_SIMD_ENV);
+	if (cap && !strcmp(cap, "scalar"))
+		level = CL_SIMD_SCALAR;
+	else if (cap && !strcmp(cap, "sse2") && level > CL_SIMD_SSE2)
+		level = CL_SIMD_SSE2;
+
+	// Racing threads detect the same level, whichever store wins is fine.
+	atomic_store_explicit(&__cl_simd_detected, level, memory_order_relaxed);
+	return (clarity_simd_level_t) level;
+}
+
+
+static size_t __cl_mismatch_bytes_scalar(const unsigned char *a, const unsigned char *b, size_t size) {
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t x, y;
+		memcpy(&x, a + i, sizeof x);
+		memcpy(&y, b + i, sizeof y);
+		if (x != y)
+			break;
+	}
+	while (i < size && a[i] == b[i])
+		i++;
+	return i;
+}
+
+
+static size_t __cl_count_bytes_scalar(const unsigned char *a, const unsigned char *b, size_t size) {
+	size_t count = 0;
+	for (size_t i = 0; i < size; i++)
+		count += a[i] != b[i];
+	return count;
+}
+
+
+static size_t __cl_mismatch_floats_scalar(const float *a, const float *b, size_t count, float absolute,
+                                          float relative) {
+	size_t i = 0;
+	for (; i < count; i++) {
+		// Computed in single precision, like the vector kernels, so that every level accepts the same elements.
+		float diff = fabsf(a[i] - b[i]);
+		if (!(a[i] == b[i] || diff <= absolute || diff <= relative * fmaxf(fabsf(a[i]), fabsf(b[i]))))
+			break;
+	}
+	return i;
+}
+
+
+static size_t __cl_mismatch_doubles_scalar(const double *a, const double *b, size_t count, double absolute,
+                                           double relative) {
+	size_t i = 0;
+	for (; i < count; i++) {
+		double diff = fabs(a[i] - b[i]);
+		if (!(a[i] == b[i] || diff <= absolute || diff <= relative * fmax(fabs(a[i]), fabs(b[i]))))
+			break;
+	}
+	return i;
+}
+
+
+#ifdef CL_SIMD_X86
+
+__attribute__((target("sse2")))
+static size_t __cl_mismatch_bytes_sse2(const unsigned char *a, const unsigned char *b, size_t size) {
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		__m128i  x    = _mm_loadu_si128((const __m128i *) (a + i));
+		__m128i  y    = _mm_loadu_si128((const __m128i *) (b + i));
+		unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+		if (mask != 0xffff)
+			return i + (size_t) __builtin_ctz(~mask);
+	}
+	return i + __cl_mismatch_bytes_scalar(a + i, b + i, size - i);
+}
+
+
+__attribute__((target("sse2")))
+static size_t __cl_count_bytes_sse2(const unsigned char *a, const unsigned char *b, size_t size) {
+	size_t count = 0;
+	size_t i     = 0;
+	for (; i + 16 <= size; i += 16) {
+		__m128i  x    = _mm_loadu_si128((const __m128i *) (a + i));
+		__m128i  y    = _mm_loadu_si128((const __m128i *) (b + i));
+		unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+		count += 16 - (size_t) __builtin_popcount(mask);
+	}
+	return count + __cl_count_bytes_scalar(a + i, b + i, size - i);
+}
+
+
+__attribute__((target("sse2")))
+static size_t __cl_mismatch_floats_sse2(const float *a, const float *b, size_t count, float absolute,
+                                        float relative) {
+	const __m128 sign  = _mm_set1_ps(-0.0f);
+	const __m128 limit = _mm_set1_ps(absolute);
+	const __m128 ratio = _mm_set1_ps(relative);
+	size_t       i     = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 x     = _mm_loadu_ps(a + i);
+		__m128 y     = _mm_loadu_ps(b + i);
+		__m128 diff  = _mm_andnot_ps(sign, _mm_sub_ps(x, y));
+		__m128 scale = _mm_max_ps(_mm_andnot_ps(sign, x), _mm_andnot_ps(sign, y));
+		__m128 match = _mm_or_ps(_mm_cmpeq_ps(x, y), _mm_cmple_ps(diff, limit));
+		match        = _mm_or_ps(match, _mm_cmple_ps(diff, _mm_mul_ps(scale, ratio)));
+		unsigned mask = (unsigned) _mm_movemask_ps(match);
+		if (mask != 0xf)
+			return i + (size_t) __builtin_ctz(~mask);
+	}
+	return i + __cl_mismatch_floats_scalar(a + i, b + i, count - i, absolute, relative);
+}
+
+
+__attribute__((target("sse2")))
+static size_t __cl_mismatch_doubles_sse2(const double *a, const double *b, size_t count, double absolute,
+                                         double relative) {
+	const __m128d sign  = _mm_set1_pd(-0.0);
+	const __m128d limit = _mm_set1_pd(absolute);
+	const __m128d ratio = _mm_set1_pd(relative);
+	size_t        i     = 0;
+
+	for (; i + 2 <= count; i += 2) {
+		__m128d x     = _mm_loadu_pd(a + i);
+		__m128d y     = _mm_loadu_pd(b + i);
+		__m128d diff  = _mm_andnot_pd(sign, _mm_sub_pd(x, y));
+		__m128d scale = _mm_max_pd(_mm_andnot_pd(sign, x), _mm_andnot_pd(sign, y));
+		__m128d match = _mm_or_pd(_mm_cmpeq_pd(x, y), _mm_cmple_pd(diff, limit));
+		match         = _mm_or_pd(match, _mm_cmple_pd(diff, _mm_mul_pd(scale, ratio)));
+		unsigned mask = (unsigned) _mm_movemask_pd(match);
+		if (mask != 0x3)
+			return i + (size_t) __builtin_ctz(~mask);
+	}
+	return i + __cl_mismatch_doubles_scalar(a + i, b + i, count - i, absolute, relative);
+}
+
+
+__attribute__((target("avx2")))
+static size_t __cl_mismatch_bytes_avx2(const unsigned char *a, const unsigned char *b, size_t size) {
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		__m256i  x    = _mm256_loadu_si256((const __m256i *) (a + i));
+		__m256i  y    = _mm256_loadu_si256((const __m256i *) (b + i));
+		uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+		if (mask != UINT32_MAX)
+			return i + (size_t) __builtin_ctz(~mask);
+	}
+	return i + __cl_mismatch_bytes_sse2(a + i, b + i, size - i);
+}
+
+
+__attribute__((target("avx2,popcnt")))
+static size_t __cl_count_bytes_avx2(const unsigned char *a, const unsigned char *b, size_t size) {
+	size_t count = 0;
+	size_t i     = 0;
+	for (; i + 32 <= size; i += 32) {
+		__m256i  x    = _mm256_loadu_si256((const __m256i *) (a + i));
+		__m256i  y    = _mm256_loadu_si256((const __m256i *) (b + i));
+		uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+		count += 32 - (size_t) __builtin_popcount(mask);
+	}
+	return count + __cl_count_bytes_sse2(a + i, b + i, size - i);
+}
+
+
+__attribute__((target("avx2")))
+static size_t __cl_mismatch_floats_avx2(const float *a, const float *b, size_t count, float absolute,
+                                        float relative) {
+	const __m256 sign  = _mm256_set1_ps(-0.0f);
+	const __m256 limit = _mm256_set1_ps(absolute);
+	const __m256 ratio = _mm256_set1_ps(relative);
+	size_t       i     = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 x     = _mm256_loadu_ps(a + i);
+		__m256 y     = _mm256_loadu_ps(b + i);
+		__m256 diff  = _mm256_andnot_ps(sign, _mm256_sub_ps(x, y));
+		__m256 scale = _mm256_max_ps(_mm256_andnot_ps(sign, x), _mm256_andnot_ps(sign, y));
+		__m256 match = _mm256_or_ps(_mm256_cmp_ps(x, y, _CMP_EQ_OQ), _mm256_cmp_ps(diff, limit, _CMP_LE_OQ));
+		match        = _mm256_or_ps(match, _mm256_cmp_ps(diff, _mm256_mul_ps(scale, ratio), _CMP_LE_OQ));
+		unsigned mask = (unsigned) _mm256_movemask_ps(match);
+		if (mask != 0xff)
+			return i + (size_t) __builtin_ctz(~mask);
+	}
+	return i + __cl_mismatch_floats_sse2(a + i, b + i, count - i, absolute, relative);
+}
+
+
+__attribute__((target("avx2")))
+static size_t __cl_mismatch_doubles_avx2(const double *a, const double *b, size_t count, double absolute,
+                                         double relative) {
+	const __m256d sign  = _mm256_set1_pd(-0.0);
+	const __m256d limit = _mm256_set1_pd(absolute);
+	const __m256d ratio = _mm256_set1_pd(relative);
+	size_t        i     = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m256d x     = _mm256_loadu_pd(a + i);
+		__m256d y     = _mm256_loadu_pd(b + i);
+		__m256d diff  = _mm256_andnot_pd(sign, _mm256_sub_pd(x, y));
+		__m256d scale = _mm256_max_pd(_mm256_andnot_pd(sign, x), _mm256_andnot_pd(sign, y));
+		__m256d match = _mm256_or_pd(_mm256_cmp_pd(x, y, _CMP_EQ_OQ), _mm256_cmp_pd(diff, limit, _CMP_LE_OQ));
+		match         = _mm256_or_pd(match, _mm256_cmp_pd(diff, _mm256_mul_pd(scale, ratio), _CMP_LE_OQ));
+		unsigned mask = (unsigned) _mm256_movemask_pd(match);
+		if (mask != 0xf)
+			return i + (size_t) __builtin_ctz(~mask);
+	}
+	return i + __cl_mismatch_doubles_sse2(a + i, b + i, count - i, absolute, relative);
+}
+
+#endif
+
+
+size_t cl_simd_mismatch_bytes(const unsigned char *a, const unsigned char *b, size_t size) {
+#ifdef CL_SIMD_X86
+	switch (cl_simd_level()) {
+		case CL_SIMD_AVX2:
+			return __cl_mismatch_bytes_avx2(a, b, size);
+		case CL_SIMD_SSE2:
+			return __cl_mismatch_bytes_sse2(a, b, size);
+		default:
+			break;
+	}
+#endif
+	return __cl_mismatch_bytes_scalar(a, b, size);
+}
+
+
+size_t cl_simd_count_bytes(const unsigned char *a, const unsigned char *b, size_t size) {
+#ifdef CL_SIMD_X86
+	switch (cl_simd_level()) {
+		case CL_SIMD_AVX2:
+			return __cl_count_bytes_avx2(a, b, size);
+		case CL_SIMD_SSE2:
+			return __cl_count_bytes_sse2(a, b, size);
+		default:
+			break;
+	}
+#endif
+	return __cl_count_bytes_scalar(a, b, size);
+}
+
+
+size_t cl_simd_mismatch_floats(const float *a, const float *b, size_t count, float absolute, float relative) {
+#ifdef CL_SIMD_X86
+	switch (cl_simd_level()) {
+		case CL_SIMD_AVX2:
+			return __cl_mismatch_floats_avx2(a, b, count, absolute, relative);
+		case CL_SIMD_SSE2:
+			return __cl_mismatch_floats_sse2(a, b, count, absolute, relative);
+		default:
+			break;
+	}
+#endif
+	return __cl_mismatch_floats_scalar(a, b, count, absolute, relative);
+}
+
+
+size_t cl_simd_mismatch_doubles(const double *a, const double *b, size_t count, double absolute, double relative) {
+#ifdef CL_SIMD_X86
+	switch (cl_simd_level()) {
+		case CL_SIMD_AVX2:
+			return __cl_mismatch_doubles_avx2(a, b, count, absolute, relative);
+		case CL_SIMD_SSE2:
+			return __cl_mismatch_doubles_sse2(a, b, count, absolute, relative);
+		default:
+			break;
+	}
+#endif
+	return __cl_mismatch_doubles_scalar(a, b, count, absolute, relative);
+}
+
+
+static inline uint64_t __cl_hash_rotate(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+
+static inline uint64_t __cl_hash_round(uint64_t lane, uint64_t input) {
+	lane += input * CL_HASH_PRIME_2;
+	return __cl_hash_rotate(lane, 31) * CL_HASH_PRIME_1;
+}
+
+
+static inline uint64_t __cl_hash_merge(uint64_t hash, uint64_t lane) {
+	hash ^= __cl_hash_round(0, lane);
+	return hash * CL_HASH_PRIME_1 + CL_HASH_PRIME_4;
+}
+
+
+static inline uint64_t __cl_hash_read64(const unsigned char *bytes) {
+	uint64_t value;
+	memcpy(&value, bytes, sizeof value);
+	return value;
+}
+
+
+uint64_t cl_simd_hash(const void *data, size_t size) {
+	const unsigned char *bytes = data;
+	const unsigned char *end   = bytes + size;
+	uint64_t            hash;
+
+	if (size >= 32) {
+		uint64_t lanes[4] = { CL_HASH_PRIME_1 + CL_HASH_PRIME_2, CL_HASH_PRIME_2, 0, -CL_HASH_PRIME_1 };
+		for (; end - bytes >= 32; bytes += 32) {
+			lanes[0] = __cl_hash_round(lanes[0], __cl_hash_read64(bytes));
+			lanes[1] = __cl_hash_round(lanes[1], __cl_hash_read64(bytes + 8));
+			lanes[2] = __cl_hash_round(lanes[2], __cl_hash_read64(bytes + 16));
+			lanes[3] = __cl_hash_round(lanes[3], __cl_hash_read64(bytes + 24));
+		}
+		hash = __cl_hash_rotate(lanes[0], 1) + __cl_hash_rotate(lanes[1], 7) + __cl_hash_rotate(lanes[2], 12)
+		       + __cl_hash_rotate(lanes[3], 18);
+		for (int i = 0; i < 4; i++)
+			hash = __cl_hash_merge(hash, lanes[i]);
+	} else {
+		hash = CL_HASH_PRIME_5;
+	}
+	hash += size;
+
+	for (; end - bytes >= 8; bytes += 8)
+		hash = __cl_hash_rotate(hash ^ __cl_hash_round(0, __cl_hash_read64(bytes)), 27) * CL_HASH_PRIME_1
+		       + CL_HASH_PRIME_4;
+	if (end - bytes >= 4) {
+		uint32_t value;
+		memcpy(&value, bytes, sizeof value);
+		hash   = __cl_hash_rotate(hash ^ (value * CL_HASH_PRIME_1), 23) * CL_HASH_PRIME_2 + CL_HASH_PRIME_3;
+		bytes += 4;
+	}
+	for (; bytes < end; bytes++)
+		hash = __cl_hash_rotate(hash ^ (*bytes * CL_HASH_PRIME_5), 11) * CL_HASH_PRIME_1;
+
+	hash ^= hash >> 33;
+	hash *= CL_HASH_PRIME_2;
+	hash ^= hash >> 29;
+	hash *= CL_HASH_PRIME_3;
+	return hash ^ (hash >> 32);
+}
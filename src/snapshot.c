@@ -0,0 +1,156 @@
+#include <CLarity/assertions.h>
+#include <CLarity/test.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "assertions.h"
+#include "files.h"
+#include "simd.h"
+#include "test.h"
+
+#define CL_SNAPSHOT_MAX_PATH 4096
+#define CL_SNAPSHOT_SIDECAR ".hash"
+
+/**
+ * @brief What a sidecar records about its snapshot.
+ */
+typedef struct clarity_sidecar_s {
+	uint64_t hash;
+	uint64_t size;
+} clarity_sidecar_t;
+
+
+static bool __cl_snapshot_path(const char *name, const char *file, char *path, size_t size) {
+	const char *dir = getenv(CL_SNAPSHOT_DIR_ENV);
+	int        len;
+
+	if (dir && *dir) {
+		len = snprintf(path, size, "%s/%s.snap", dir, name);
+	} else {
+		const char *slash = strrchr(file, '/');
+		int        prefix = slash ? (int) (slash - file + 1) : 0;
+		len = snprintf(path, size, "%.*ssnapshots/%s.snap", prefix, file, name);
+	}
+	return len > 0 && (size_t) len + sizeof(CL_SNAPSHOT_SIDECAR) <= size;
+}
+
+
+static bool __cl_snapshot_update_requested(void) {
+	const char *update = getenv(CL_UPDATE_SNAPSHOTS_ENV);
+	return update && *update && strcmp(update, "0") != 0;
+}
+
+
+static bool __cl_newer_or_equal(const struct timespec *a, const struct timespec *b) {
+	return a->tv_sec > b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec >= b->tv_nsec);
+}
+
+
+/**
+ * @brief Reads the sidecar of a snapshot, if it was written after the snapshot and so can be trusted.
+ */
+static bool __cl_sidecar_read(const char *path, const struct stat *snapshot, clarity_sidecar_t *sidecar) {
+	struct stat info;
+	FILE        *file = fopen(path, "r");
+	if (!file)
+		return false;
+
+	bool valid = fstat(fileno(file), &info) == 0 && __cl_newer_or_equal(&info.st_mtim, &snapshot->st_mtim)
+	             && fscanf(file, "%" SCNx64 " %" SCNu64, &sidecar->hash, &sidecar->size) == 2;
+	fclose(file);
+	return valid && sidecar->size == (uint64_t) snapshot->st_size;
+}
+
+
+static bool __cl_sidecar_write(const char *path, uint64_t hash, size_t size) {
+	char text[64];
+	int  len = snprintf(text, sizeof text, "%016" PRIx64 " %zu\n", hash, size);
+	return cl_files_replace(path, NULL, 0, text, (size_t) len);
+}
+
+
+/**
+ * @brief Records the output as the new snapshot. The sidecar is written last, so that it is newer.
+ */
+static bool __cl_snapshot_write(char *path, const char *sidecar, const void *data, size_t size, uint64_t hash) {
+	char *slash = strrchr(path, '/');
+	if (slash) {
+		*slash       = '\0';
+		bool created = cl_files_make_directory(path);
+		*slash       = '/';
+		if (!created)
+			return false;
+	}
+	return cl_files_replace(path, NULL, 0, data, size) && __cl_sidecar_write(sidecar, hash, size);
+}
+
+
+static void __cl_snapshot_fail(clarity_test_t *test, const char *file, size_t line, const char *message) {
+	cl_test_record(test, file, line, false, message, NULL);
+}
+
+
+bool __cl_assert_snapshot(clarity_test_t *test, const void *data, size_t size, const char *name, const char *file,
+                          size_t line) {
+	char path[CL_SNAPSHOT_MAX_PATH];
+	char sidecar_path[CL_SNAPSHOT_MAX_PATH];
+	if (!__cl_snapshot_path(name, file, path, sizeof path)
+	    || snprintf(sidecar_path, sizeof sidecar_path, "%s" CL_SNAPSHOT_SIDECAR, path) >= (int) sizeof sidecar_path) {
+		__cl_snapshot_fail(test, file, line, "the path of the snapshot is too long");
+		return false;
+	}
+
+	uint64_t          hash   = cl_simd_hash(data, size);
+	bool              update = __cl_snapshot_update_requested();
+	struct stat       info;
+	clarity_sidecar_t sidecar;
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0 || fstat(fd, &info) != 0) {
+		if (fd >= 0)
+			close(fd);
+		if (update && __cl_snapshot_write(path, sidecar_path, data, size, hash))
+			return true;
+		__cl_snapshot_fail(test, file, line, update ? "the snapshot could not be written"
+		                                            : "the snapshot does not exist, run with "
+		                                              CL_UPDATE_SNAPSHOTS_ENV "=1 to record it");
+		return false;
+	}
+
+	// A trusted sidecar settles a match without reading the snapshot, which keeps large suites of snapshots cheap.
+	bool trusted = __cl_sidecar_read(sidecar_path, &info, &sidecar);
+	if (trusted && sidecar.hash == hash && sidecar.size == size) {
+		close(fd);
+		return true;
+	}
+
+	size_t        snapshot_size = (size_t) info.st_size;
+	unsigned char *snapshot     = NULL;
+	if (snapshot_size) {
+		snapshot = mmap(NULL, snapshot_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (snapshot == MAP_FAILED) {
+			close(fd);
+			__cl_snapshot_fail(test, file, line, "the snapshot could not be read");
+			return false;
+		}
+	}
+	close(fd);
+
+	bool equal = snapshot_size == size && cl_simd_mismatch_bytes(data, snapshot, size) == size;
+	if (equal && !trusted)
+		__cl_sidecar_write(sidecar_path, hash, size);
+	else if (!equal && update && !(equal = __cl_snapshot_write(path, sidecar_path, data, size, hash)))
+		__cl_snapshot_fail(test, file, line, "the snapshot could not be written");
+	else if (!equal && !update)
+		cl_assert_fail_buffers(test, file, line, "the output differs from the snapshot", data, size, snapshot,
+		                       snapshot_size);
+
+	if (snapshot)
+		munmap(snapshot, snapshot_size);
+	return equal;
+}
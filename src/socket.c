@@ -0,0 +1,151 @@
+#include "socket.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CL_SOCKET_BACKLOG 64
+#define CL_SOCKET_RETRY_MS 50
+
+
+static bool __cl_socket_unix_path(const char *address, const char **path) {
+	if (strncmp(address, "unix:", 5) != 0)
+		return false;
+	*path = address + 5;
+	return true;
+}
+
+
+static int __cl_socket_unix(const char *path, bool listening) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+	if (!*path || strlen(path) >= sizeof addr.sun_path) {
+		errno = EINVAL;
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+
+	if (listening) {
+		unlink(path);
+		if (bind(fd, (struct sockaddr *) &addr, sizeof addr) == 0 && listen(fd, CL_SOCKET_BACKLOG) == 0)
+			return fd;
+	} else if (connect(fd, (struct sockaddr *) &addr, sizeof addr) == 0) {
+		return fd;
+	}
+
+	close(fd);
+	return -1;
+}
+
+
+static int __cl_socket_tcp(const char *address, bool listening) {
+	if (!strncmp(address, "tcp:", 4))
+		address += 4;
+
+	const char *colon = strrchr(address, ':');
+	if (!colon || !colon[1]) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	char host[256];
+	size_t host_len = (size_t) (colon - address);
+	if (host_len >= sizeof host) {
+		errno = EINVAL;
+		return -1;
+	}
+	memcpy(host, address, host_len);
+	host[host_len] = '\0';
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof hints);
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags    = listening ? AI_PASSIVE : 0;
+
+	struct addrinfo *infos;
+	int             error = getaddrinfo(host_len ? host : NULL, colon + 1, &hints, &infos);
+	if (error) {
+		errno = error == EAI_SYSTEM ? errno : EHOSTUNREACH;
+		return -1;
+	}
+
+	int fd = -1;
+	for (struct addrinfo *info = infos; info && fd < 0; info = info->ai_next) {
+		fd = socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC, info->ai_protocol);
+		if (fd < 0)
+			continue;
+
+		int one = 1;
+		bool ok;
+		if (listening) {
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+			ok = bind(fd, info->ai_addr, info->ai_addrlen) == 0 && listen(fd, CL_SOCKET_BACKLOG) == 0;
+		} else {
+			ok = connect(fd, info->ai_addr, info->ai_addrlen) == 0;
+		}
+		if (ok) {
+			// Results are small messages, they must not wait for more data to be sent.
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+		} else {
+			close(fd);
+			fd = -1;
+		}
+	}
+
+	freeaddrinfo(infos);
+	return fd;
+}
+
+
+static int __cl_socket_open(const char *address, bool listening) {
+	const char *path;
+	if (__cl_socket_unix_path(address, &path))
+		return __cl_socket_unix(path, listening);
+	return __cl_socket_tcp(address, listening);
+}
+
+
+int cl_socket_listen(const char *address) {
+	int fd = __cl_socket_open(address, true);
+	if (fd < 0)
+		fprintf(stderr, "CLarity: cannot listen on '%s': %s\n", address, strerror(errno));
+	return fd;
+}
+
+
+int cl_socket_connect(const char *address, unsigned timeout_ms) {
+	for (unsigned waited = 0;; waited += CL_SOCKET_RETRY_MS) {
+		int fd = __cl_socket_open(address, false);
+		if (fd >= 0)
+			return fd;
+		if ((errno != ENOENT && errno != ECONNREFUSED) || waited >= timeout_ms)
+			break;
+
+		struct timespec delay = { 0, CL_SOCKET_RETRY_MS * 1000000L };
+		nanosleep(&delay, NULL);
+	}
+
+	fprintf(stderr, "CLarity: cannot connect to '%s': %s\n", address, strerror(errno));
+	return -1;
+}
+
+
+void cl_socket_close_listener(int fd, const char *address) {
+	const char *path;
+
+	close(fd);
+	if (__cl_socket_unix_path(address, &path))
+		unlink(path);
+}
@@ -0,0 +1,129 @@
+#include "stats.h"
+#include "timing.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct clarity_ranked_sample_s {
+	uint64_t value;
+	bool     current;
+} clarity_ranked_sample_t;
+
+
+static int __cl_compare_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+	return (x > y) - (x < y);
+}
+
+
+static int __cl_compare_ranked(const void *a, const void *b) {
+	return __cl_compare_u64(&((const clarity_ranked_sample_t *) a)->value,
+	                        &((const clarity_ranked_sample_t *) b)->value);
+}
+
+
+static double __cl_quantile(const uint64_t *sorted, size_t count, double q) {
+	double pos   = q * (double) (count - 1);
+	size_t lower = (size_t) pos;
+	if (lower + 1 >= count)
+		return (double) sorted[count - 1];
+	double frac = pos - (double) lower;
+	return (double) sorted[lower] + frac * ((double) sorted[lower + 1] - (double) sorted[lower]);
+}
+
+
+clarity_sample_summary_t cl_stats_summarise(const uint64_t *samples, size_t count) {
+	clarity_sample_summary_t summary;
+	memset(&summary, 0, sizeof summary);
+	if (!samples || !count)
+		return summary;
+
+	uint64_t *sorted = malloc(count * sizeof(*sorted));
+	if (!sorted)
+		return summary;
+	memcpy(sorted, samples, count * sizeof(*sorted));
+	qsort(sorted, count, sizeof(*sorted), __cl_compare_u64);
+
+	double sum = 0;
+	for (size_t i = 0; i < count; i++)
+		sum += (double) sorted[i];
+
+	summary.count  = count;
+	summary.min    = (double) sorted[0];
+	summary.max    = (double) sorted[count - 1];
+	summary.median = __cl_quantile(sorted, count, 0.5);
+	summary.p90    = __cl_quantile(sorted, count, 0.9);
+	summary.mean   = sum / (double) count;
+
+	free(sorted);
+	return summary;
+}
+
+
+char *cl_stats_format_summary(const clarity_sample_summary_t *summary, char *buffer, size_t size) {
+	char min[32], median[32], p90[32], max[32];
+
+	snprintf(buffer, size, "n=%zu min=%s median=%s p90=%s max=%s", summary->count,
+	         cl_timing_format(summary->min, min, sizeof min),
+	         cl_timing_format(summary->median, median, sizeof median),
+	         cl_timing_format(summary->p90, p90, sizeof p90),
+	         cl_timing_format(summary->max, max, sizeof max));
+	return buffer;
+}
+
+
+double cl_stats_mann_whitney(const uint64_t *baseline, size_t n_baseline, const uint64_t *current, size_t n_current,
+                             double *u) {
+	if (u)
+		*u = 0;
+	if (!n_baseline || !n_current)
+		return 1;
+
+	size_t                  total   = n_baseline + n_current;
+	clarity_ranked_sample_t *ranked = malloc(total * sizeof(*ranked));
+	if (!ranked)
+		return 1;
+
+	for (size_t i = 0; i < n_baseline; i++)
+		ranked[i] = (clarity_ranked_sample_t){ baseline[i], false };
+	for (size_t i = 0; i < n_current; i++)
+		ranked[n_baseline + i] = (clarity_ranked_sample_t){ current[i], true };
+	qsort(ranked, total, sizeof(*ranked), __cl_compare_ranked);
+
+	double rank_sum = 0;
+	double ties     = 0;
+	for (size_t i = 0; i < total;) {
+		size_t j = i;
+		while (j < total && ranked[j].value == ranked[i].value)
+			j++;
+
+		// Tied samples share the average of the ranks they span (ranks are 1-based).
+		double rank = ((double) (i + 1) + (double) j) / 2.0;
+		for (size_t k = i; k < j; k++) {
+			if (ranked[k].current)
+				rank_sum += rank;
+		}
+
+		double t = (double) (j - i);
+		ties += t * t * t - t;
+		i = j;
+	}
+	free(ranked);
+
+	double n1 = (double) n_current;
+	double n2 = (double) n_baseline;
+	double n  = n1 + n2;
+	double u1 = rank_sum - n1 * (n1 + 1) / 2.0;
+	if (u)
+		*u = u1;
+
+	double mean     = n1 * n2 / 2.0;
+	double variance = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)));
+	if (variance <= 0)
+		return 1;
+
+	double z = (u1 - mean - 0.5) / sqrt(variance);
+	return 0.5 * erfc(z / sqrt(2.0));
+}
@@ -0,0 +1,128 @@
+#include "stream.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static char *__cl_stream_strdup(const char *text) {
+	return text ? strdup(text) : NULL;
+}
+
+
+static void __cl_stream_entry_clear(clarity_stream_entry_t *entry) {
+	free(entry->name);
+	free(entry->file_name);
+	free(entry->error_message);
+	memset(entry, 0, sizeof(*entry));
+}
+
+
+static void __cl_stream_entry_set(clarity_stream_entry_t *entry, const clarity_test_result_t *result,
+                                  bool with_failure) {
+	entry->name        = __cl_stream_strdup(result->name);
+	entry->duration_ns = result->duration_ns;
+	if (with_failure) {
+		entry->file_name     = __cl_stream_strdup(result->file_name);
+		entry->error_message = __cl_stream_strdup(result->error_message);
+		entry->line_number   = result->line_number;
+	}
+}
+
+
+static void __cl_stream_sift_down(clarity_stream_entry_t *heap, size_t count, size_t i) {
+	for (;;) {
+		size_t smallest = i;
+		size_t left     = 2 * i + 1;
+		size_t right    = left + 1;
+		if (left < count && heap[left].duration_ns < heap[smallest].duration_ns)
+			smallest = left;
+		if (right < count && heap[right].duration_ns < heap[smallest].duration_ns)
+			smallest = right;
+		if (smallest == i)
+			return;
+
+		clarity_stream_entry_t tmp = heap[i];
+		heap[i]        = heap[smallest];
+		heap[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+
+static void __cl_stream_sift_up(clarity_stream_entry_t *heap, size_t i) {
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (heap[parent].duration_ns <= heap[i].duration_ns)
+			return;
+
+		clarity_stream_entry_t tmp = heap[i];
+		heap[i]      = heap[parent];
+		heap[parent] = tmp;
+		i = parent;
+	}
+}
+
+
+static int __cl_stream_compare_slowest(const void *a, const void *b) {
+	uint64_t x = ((const clarity_stream_entry_t *) a)->duration_ns;
+	uint64_t y = ((const clarity_stream_entry_t *) b)->duration_ns;
+	return (x < y) - (x > y);
+}
+
+
+clarity_stream_t *cl_stream_create(size_t max_failures, size_t max_slowest) {
+	clarity_stream_t *stream = calloc(1, sizeof(*stream));
+	if (!stream)
+		return NULL;
+
+	stream->max_failures = max_failures;
+	stream->max_slowest  = max_slowest;
+	stream->failures     = calloc(max_failures ? max_failures : 1, sizeof(*stream->failures));
+	stream->slowest      = calloc(max_slowest ? max_slowest : 1, sizeof(*stream->slowest));
+	if (!stream->failures || !stream->slowest) {
+		cl_stream_free(stream);
+		return NULL;
+	}
+
+	return stream;
+}
+
+
+void cl_stream_record(clarity_stream_t *stream, const clarity_test_result_t *result) {
+	if (!result->passed && !result->skipped) {
+		if (stream->failure_count < stream->max_failures)
+			__cl_stream_entry_set(&stream->failures[stream->failure_count++], result, true);
+		else
+			stream->dropped_failures++;
+	}
+
+	if (result->skipped || !stream->max_slowest)
+		return;
+
+	if (stream->slowest_count < stream->max_slowest) {
+		__cl_stream_entry_set(&stream->slowest[stream->slowest_count], result, false);
+		__cl_stream_sift_up(stream->slowest, stream->slowest_count++);
+	} else if (result->duration_ns > stream->slowest[0].duration_ns) {
+		__cl_stream_entry_clear(&stream->slowest[0]);
+		__cl_stream_entry_set(&stream->slowest[0], result, false);
+		__cl_stream_sift_down(stream->slowest, stream->slowest_count, 0);
+	}
+}
+
+
+void cl_stream_finish(clarity_stream_t *stream) {
+	qsort(stream->slowest, stream->slowest_count, sizeof(*stream->slowest), __cl_stream_compare_slowest);
+}
+
+
+void cl_stream_free(clarity_stream_t *stream) {
+	if (!stream)
+		return;
+
+	for (size_t i = 0; stream->failures && i < stream->failure_count; i++)
+		__cl_stream_entry_clear(&stream->failures[i]);
+	for (size_t i = 0; stream->slowest && i < stream->slowest_count; i++)
+		__cl_stream_entry_clear(&stream->slowest[i]);
+	free(stream->failures);
+	free(stream->slowest);
+	free(stream);
+}
@@ -0,0 +1,152 @@
+#include <CLarity/stress.h>
+#include <stdlib.h>
+#include <string.h>
+#include "printer.h"
+#include "runner.h"
+#include "suite.h"
+#include "test.h"
+#include "threads.h"
+#include "timing.h"
+
+typedef struct clarity_stress_s {
+	clarity_test_t          **copies;
+	clarity_stress_report_t report;
+	char                    *first_error_message;
+	char                    *first_file_name;
+} clarity_stress_t;
+
+
+static void __cl_stress_run_copy(void *context, size_t index) {
+	clarity_stress_t *stress = context;
+	clarity_test_t   *copy   = stress->copies[index];
+
+	cl_test_reset_result(copy);
+	cl_run_test(copy);
+}
+
+
+static void __cl_stress_collect(clarity_stress_t *stress) {
+	clarity_stress_report_t *report = &stress->report;
+
+	report->iterations++;
+	for (uint32_t i = 0; i < report->concurrency; i++) {
+		const clarity_test_result_t *result = &stress->copies[i]->result;
+
+		report->runs++;
+		if (result->skipped) {
+			report->skips++;
+			continue;
+		}
+		if (result->passed)
+			continue;
+
+		report->failures++;
+		if (report->first_failed_iteration)
+			continue;
+
+		report->first_failed_iteration = report->iterations;
+		report->first_failed_copy      = i;
+		report->first_line_number      = result->line_number;
+		stress->first_error_message    = strdup(result->error_message ? result->error_message : "");
+		stress->first_file_name        = result->file_name ? strdup(result->file_name) : NULL;
+	}
+}
+
+
+static clarity_test_t *__cl_stress_find_test(clarity_suite_t *suite, const char *test_name) {
+	for (size_t i = 0; i < suite->test_count; i++) {
+		if (suite->tests[i] && !strcmp(suite->tests[i]->name, test_name))
+			return suite->tests[i];
+	}
+	return NULL;
+}
+
+
+static bool __cl_stress_iterate(clarity_run_t *run, clarity_stress_t *stress, const clarity_stress_options_t *options,
+                                clarity_gang_t *gang) {
+	uint64_t start = cl_timing_now_ns();
+
+	for (uint64_t i = 0; !options->iterations || i < options->iterations; i++) {
+		if (!cl_runner_setup_test(run))
+			return false;
+
+		if (gang)
+			cl_gang_run(gang);
+		else
+			__cl_stress_run_copy(stress, 0);
+
+		// The fixtures only need to run once around the copies, the first one stands for all of them.
+		clarity_test_result_t ignored;
+		bool                  state = cl_runner_finish_test(run, stress->copies[0], &ignored);
+		__cl_stress_collect(stress);
+		if (!state)
+			return false;
+
+		if (options->until_failure && stress->report.failures)
+			break;
+	}
+
+	stress->report.duration_ns = cl_timing_now_ns() - start;
+	return true;
+}
+
+
+bool cl_stress_test(clarity_suite_t *suite, const char *test_name, const clarity_stress_options_t *options) {
+	if (!suite || !test_name || !options)
+		return false;
+
+	clarity_test_t *test = __cl_stress_find_test(suite, test_name);
+	if (!test)
+		return false;
+
+	clarity_stress_options_t effective = *options;
+	if (!effective.concurrency)
+		effective.concurrency = 1;
+	if (!effective.iterations && !effective.until_failure)
+		effective.iterations = 1;
+
+	clarity_stress_t stress;
+	memset(&stress, 0, sizeof stress);
+	stress.report.suite       = suite->name;
+	stress.report.name        = test->name;
+	stress.report.concurrency = effective.concurrency;
+
+	stress.copies = calloc(effective.concurrency, sizeof(*stress.copies));
+	bool ready = stress.copies != NULL;
+	for (uint32_t i = 0; ready && i < effective.concurrency; i++) {
+		stress.copies[i] = cl_test_clone(test);
+		ready            = stress.copies[i] != NULL;
+	}
+
+	clarity_gang_t *gang = NULL;
+	if (ready && effective.concurrency > 1) {
+		gang  = cl_gang_create(effective.concurrency, effective.pin_threads, __cl_stress_run_copy, &stress);
+		ready = gang != NULL;
+	}
+
+	clarity_run_t run;
+	memset(&run, 0, sizeof run);
+	run.suite = suite;
+
+	int  status    = 0;
+	bool completed = false;
+	if (ready && !(cl_fixture_run_setup(suite->suite_fixture, &status) && status)) {
+		completed = __cl_stress_iterate(&run, &stress, &effective, gang);
+		if (cl_fixture_run_teardown(suite->suite_fixture, &status) && status)
+			completed = false;
+	}
+
+	stress.report.first_error_message = stress.first_error_message;
+	stress.report.first_file_name     = stress.first_file_name;
+	if (completed)
+		cl_print_stress_report(&stress.report);
+
+	cl_gang_free(gang);
+	for (uint32_t i = 0; stress.copies && i < effective.concurrency; i++)
+		cl_free_test(stress.copies[i]);
+	free(stress.copies);
+	free(stress.first_error_message);
+	free(stress.first_file_name);
+
+	return completed && !stress.report.failures;
+}
@@ -20,6 +20,39 @@ clarity_suite_t *cl_create_suite(const char *name) {
 	suite->fixture_count    = 0;
 	suite->fixtures         = NULL;
 
+	suite->baseline_path         = NULL;
+	suite->baseline_mode         = CL_BASELINE_OFF;
+	suite->regression_alpha      = CL_DEFAULT_REGRESSION_ALPHA;
+	suite->regression_min_effect = CL_DEFAULT_REGRESSION_MIN_EFFECT;
+
+	suite->generator           = NULL;
+	suite->generator_data      = NULL;
+	suite->generated_count     = 0;
+	suite->streaming           = false;
+	suite->stream_max_failures = CL_DEFAULT_STREAM_MAX_FAILURES;
+	suite->stream_max_slowest  = CL_DEFAULT_STREAM_MAX_SLOWEST;
+
+	suite->async_concurrency = CL_DEFAULT_ASYNC_CONCURRENCY;
+
+	suite->isolated             = false;
+	suite->isolation_batch      = CL_DEFAULT_ISOLATION_BATCH;
+	suite->isolation_children   = 0;
+	suite->isolation_timeout_ms = CL_DEFAULT_ISOLATION_TIMEOUT_MS;
+
+	suite->jobs           = 1;
+	suite->resources      = NULL;
+	suite->resource_count = 0;
+	suite->needs          = NULL;
+	suite->need_count     = 0;
+
+	suite->prerequisites      = NULL;
+	suite->prerequisite_count = 0;
+	suite->outcome            = CL_OUTCOME_NONE;
+
+	suite->parent      = NULL;
+	suite->children    = NULL;
+	suite->child_count = 0;
+
 	return suite;
 }
 
@@ -63,6 +96,13 @@ void cl_free_suite(clarity_suite_t *suite) {
 	free(suite->fixtures);
 
 	cl_free_fixture(suite->suite_fixture);
+	free(suite->resources);
+	free(suite->needs);
+	free(suite->prerequisites);
+
+	for (size_t i = 0; i < suite->child_count; i++)
+		cl_free_suite(suite->children[i]);
+	free(suite->children);
 	free(suite);
 }
 
@@ -98,61 +138,173 @@ clarity_status_t cl_add_test(clarity_suite_t *suite, clarity_test_t *test) {
 }
 
 
-bool cl_run_suite(clarity_suite_t *suite) {
-	if (!suite || !suite->test_count) {
-		return true;
-	}
+clarity_status_t cl_suite_set_baseline(clarity_suite_t *suite, const char *path, clarity_baseline_mode_t mode) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
 
-	cl_print_suite_name(suite->name);
-	clarity_suite_report_t report;
-	memset(&report, 0, sizeof report);
-	report.name = suite->name;
+	suite->baseline_path = path;
+	suite->baseline_mode = mode;
+	return CL_SUCCESS;
+}
 
-	int status = 0;
-	if (cl_fixture_run_setup(suite->suite_fixture, &status)) {
-		if (status)
-			return false;
-	}
 
+clarity_status_t cl_suite_set_regression_threshold(clarity_suite_t *suite, double alpha, double min_effect) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+
+	suite->regression_alpha      = alpha;
+	suite->regression_min_effect = min_effect;
+	return CL_SUCCESS;
+}
 
-	for (size_t i = 0; i < suite->test_count; i++) {
-		for (size_t j = 0; j < suite->fixture_count; j++) {
-			if (cl_fixture_run_setup(suite->fixtures[j], &status)) {
-				if (status) {
-					return false;
-				}
-			}
-		}
 
+clarity_status_t cl_suite_set_generator(clarity_suite_t *suite, size_t count, clarity_test_generator_fn_t fn,
+                                        void *data) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
 
-		clarity_test_result_t result = cl_run_test(suite->tests[i]);
-		cl_print_test_result(&result);
+	suite->generator       = fn;
+	suite->generator_data  = data;
+	suite->generated_count = fn ? count : 0;
+	return CL_SUCCESS;
+}
 
-		report.total_tests++;
-		if (result.skipped)
-			report.skipped_tests++;
-		else if (result.passed)
-			report.succeeded_tests++;
-		else
-			report.failed_tests++;
 
-		bool state = true;
-		for (int64_t          j      = (int64_t) (suite->fixture_count - 1); j >= 0; j--) {
-			if (cl_fixture_run_teardown(suite->fixtures[j], &status) && status)
-				state = false;
-		}
-		if (!state)
-			return false;
+clarity_status_t cl_suite_set_streaming(clarity_suite_t *suite, bool enabled, size_t max_failures,
+                                        size_t max_slowest) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+
+	suite->streaming           = enabled;
+	suite->stream_max_failures = max_failures;
+	suite->stream_max_slowest  = max_slowest;
+	return CL_SUCCESS;
+}
+
+
+clarity_status_t cl_suite_set_async_concurrency(clarity_suite_t *suite, size_t max_in_flight) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+
+	suite->async_concurrency = max_in_flight ? max_in_flight : 1;
+	return CL_SUCCESS;
+}
+
+
+clarity_status_t cl_suite_set_isolation(clarity_suite_t *suite, bool enabled, size_t batch_size,
+                                        size_t max_children) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+
+	suite->isolated           = enabled;
+	suite->isolation_batch    = batch_size ? batch_size : 1;
+	suite->isolation_children = max_children;
+	return CL_SUCCESS;
+}
+
+
+clarity_status_t cl_suite_set_isolation_timeout(clarity_suite_t *suite, uint32_t timeout_ms) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+
+	suite->isolation_timeout_ms = timeout_ms ? timeout_ms : CL_DEFAULT_ISOLATION_TIMEOUT_MS;
+	return CL_SUCCESS;
+}
+
+
+clarity_status_t cl_suite_set_crash_recovery(clarity_suite_t *suite, bool enabled, size_t max_crashes) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+
+	suite->crash_recovery = enabled;
+	suite->max_crashes    = max_crashes ? max_crashes : CL_DEFAULT_MAX_CRASHES;
+	return CL_SUCCESS;
+}
+
+
+clarity_status_t cl_suite_set_jobs(clarity_suite_t *suite, size_t jobs) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+
+	suite->jobs = jobs;
+	return CL_SUCCESS;
+}
+
+
+clarity_status_t cl_suite_add_resource(clarity_suite_t *suite, const char *name, uint64_t capacity) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+	return cl_resource_needs_set(&suite->resources, &suite->resource_count, name, capacity);
+}
+
+
+clarity_status_t cl_suite_require(clarity_suite_t *suite, const char *name, uint64_t amount) {
+	if (!suite)
+		return CL_ERROR_SUITE_NULL;
+	return cl_resource_needs_set(&suite->needs, &suite->need_count, name, amount);
+}
+
+
+/**
+ * @brief Checks whether a suite can be reached from another one by following prerequisites.
+ *
+ * Every suite is visited once per traversal, so that shared prerequisites do not make the walk exponential.
+ */
+static bool __cl_suite_reaches(clarity_suite_t *from, const clarity_suite_t *target, uint64_t visit) {
+	if (from == target)
+		return true;
+	if (from->visit == visit)
+		return false;
+
+	from->visit = visit;
+	for (size_t i = 0; i < from->prerequisite_count; i++) {
+		if (__cl_suite_reaches(from->prerequisites[i], target, visit))
+			return true;
 	}
+	return false;
+}
+
 
-	if (cl_fixture_run_teardown(suite->suite_fixture, &status)) {
-		if (status)
-			return false;
+clarity_status_t cl_suite_depends_on(clarity_suite_t *suite, clarity_suite_t *prerequisite) {
+	// The dependencies are declared while building the suites, from a single thread.
+	static uint64_t visits;
+
+	if (!suite || !prerequisite)
+		return CL_ERROR_SUITE_NULL;
+	if (__cl_suite_reaches(prerequisite, suite, ++visits))
+		return CL_ERROR_CYCLE;
+
+	for (size_t i = 0; i < suite->prerequisite_count; i++) {
+		if (suite->prerequisites[i] == prerequisite)
+			return CL_SUCCESS;
 	}
 
-	cl_print_suite_report(&report);
+	clarity_suite_t **grown = realloc(suite->prerequisites, (suite->prerequisite_count + 1) * sizeof(*grown));
+	if (!grown)
+		return CL_ERROR_MEMORY;
+	grown[suite->prerequisite_count++] = prerequisite;
+	suite->prerequisites               = grown;
+	return CL_SUCCESS;
+}
+
 
-	return report.failed_tests == 0;
+clarity_status_t cl_suite_add_child(clarity_suite_t *parent, clarity_suite_t *child) {
+	if (!parent || !child)
+		return CL_ERROR_SUITE_NULL;
+	if (child->parent)
+		return CL_ERROR_CYCLE;
+	for (const clarity_suite_t *ancestor = parent; ancestor; ancestor = ancestor->parent) {
+		if (ancestor == child)
+			return CL_ERROR_CYCLE;
+	}
+
+	clarity_suite_t **grown = realloc(parent->children, (parent->child_count + 1) * sizeof(*grown));
+	if (!grown)
+		return CL_ERROR_MEMORY;
+	grown[parent->child_count++] = child;
+	parent->children             = grown;
+	child->parent                = parent;
+	return CL_SUCCESS;
 }
 
 
@@ -1,5 +1,15 @@
 #include <CLarity/test.h>
+#include <CLarity/benchmark.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "arena.h"
+#include "clock.h"
+#include "event_loop.h"
 #include "test.h"
+#include "timing.h"
+#include "trace.h"
 
 clarity_test_t *cl_create_test(const char *name, clarity_test_fn_t fn, void *data) {
 	if (!fn || !name)
@@ -31,35 +41,363 @@ void *cl_get_test_data(clarity_test_t *test) {
 	return test->user_data;
 }
 
+clarity_test_t *cl_create_benchmark(const char *name, clarity_test_fn_t fn, void *data, uint32_t samples) {
+	if (!samples)
+		return NULL;
+
+	clarity_test_t *test = cl_create_test(name, fn, data);
+	if (!test)
+		return NULL;
+
+	test->samples   = samples;
+	test->sample_ns = calloc(samples, sizeof(*test->sample_ns));
+	if (!test->sample_ns) {
+		free(test);
+		return NULL;
+	}
+
+	return test;
+}
+
+clarity_test_t *cl_create_async_test(const char *name, clarity_async_test_fn_t fn, void *data, uint32_t timeout_ms) {
+	if (!fn || !name)
+		return NULL;
+
+	clarity_test_t *test = calloc(1, sizeof(*test));
+	if (!test)
+		return NULL;
+
+	test->name           = name;
+	test->async_fn       = fn;
+	test->user_data      = data;
+	test->timeout_ms     = timeout_ms ? timeout_ms : CL_DEFAULT_ASYNC_TIMEOUT_MS;
+	test->result.name    = test->name;
+	test->result.skipped = false;
+	test->result.passed  = true;
+
+	return test;
+}
+
 void cl_free_test(clarity_test_t *test) {
+	if (!test)
+		return;
+	free(test->sample_ns);
+	free(test->owned_message);
+	free(test->needs);
+	free(test->prerequisites);
+	cl_test_clear_expectations(test);
+	cl_arena_reset(&test->arena);
+	cl_clock_free(test->clock);
+	if (test->free_data)
+		test->free_data(test->user_data);
 	free(test);
 }
 
+/**
+ * @brief Runs an asynchronous test to completion on a private event loop.
+ */
+static clarity_test_result_t __cl_run_async_test(clarity_test_t *test) {
+	clarity_event_loop_t *loop = cl_event_loop_create(1, NULL, NULL);
+	if (!loop || cl_event_loop_submit(loop, test, NULL) != CL_SUCCESS) {
+		cl_event_loop_free(loop);
+		test->result.passed        = false;
+		test->result.error_message = "could not start the event loop of the test";
+		return test->result;
+	}
+
+	cl_event_loop_drain(loop);
+	cl_event_loop_free(loop);
+	return test->result;
+}
+
 clarity_test_result_t cl_run_test(clarity_test_t *test) {
 	if (!test)
-		return (clarity_test_result_t){ NULL, NULL, 0, false, false};
+		return (clarity_test_result_t){ .passed = false };
 
 	if (test->result.skipped)
 		return test->result;
 
-	test->test_fn(test, test->user_data);
+	if (test->async_fn)
+		return __cl_run_async_test(test);
+
+	uint32_t samples = test->sample_ns ? test->samples : 1;
+	uint64_t trace   = cl_trace_now();
+	uint64_t start   = cl_timing_now_ns();
+
+	test->sample_count = 0;
+	for (uint32_t i = 0; i < samples; i++) {
+		if (test->clock)
+			cl_clock_reset(test->clock, test->virtual_time);
+		uint64_t begin = cl_timing_now_ns();
+		test->test_fn(test, test->user_data);
+		uint64_t end = cl_timing_now_ns();
+		cl_test_flush_expectations(test);
+		cl_arena_reset(&test->arena);
+
+		if (test->sample_ns)
+			test->sample_ns[test->sample_count++] = end - begin;
+		if (!test->result.passed || test->result.skipped)
+			break;
+	}
+	test->result.duration_ns = cl_timing_now_ns() - start;
+	if (test->clock)
+		cl_clock_reset(test->clock, test->virtual_time);
+	cl_trace_span(trace, "test", NULL, test->name);
+
 	return test->result;
 }
 
+void cl_test_reset_result(clarity_test_t *test) {
+	free(test->owned_message);
+	test->owned_message = NULL;
+	test->sample_count  = 0;
+	test->result        = (clarity_test_result_t){ .name = test->name, .passed = true };
+}
+
+
+clarity_test_t *cl_test_clone(const clarity_test_t *test) {
+	clarity_test_t *clone;
+	if (test->async_fn)
+		clone = cl_create_async_test(test->name, test->async_fn, test->user_data, test->timeout_ms);
+	else if (test->sample_ns)
+		clone = cl_create_benchmark(test->name, test->test_fn, test->user_data, test->samples);
+	else
+		clone = cl_create_test(test->name, test->test_fn, test->user_data);
+
+	for (size_t i = 0; clone && i < test->need_count; i++) {
+		if (cl_test_require(clone, test->needs[i].name, test->needs[i].amount) != CL_SUCCESS) {
+			cl_free_test(clone);
+			return NULL;
+		}
+	}
+	if (clone && cl_test_use_virtual_time(clone, test->virtual_time) != CL_SUCCESS) {
+		cl_free_test(clone);
+		return NULL;
+	}
+	if (clone)
+		clone->expectations.max = test->expectations.max;
+	return clone;
+}
+
+const uint64_t *cl_test_samples(const clarity_test_t *test, size_t *count) {
+	if (test->sample_ns) {
+		*count = test->sample_count;
+		return test->sample_ns;
+	}
+	*count = 1;
+	return &test->result.duration_ns;
+}
+
+/**
+ * @brief The point marked last by the calling thread, until a failure or a skip of its test records it.
+ *
+ * Threads failing the same test each record the point they marked themselves.
+ */
+static _Thread_local struct {
+	const clarity_test_t *test;
+	const char           *file;
+	size_t               line;
+} marked;
+
+
+void cl_test_lock(clarity_test_t *test) {
+	while (atomic_flag_test_and_set_explicit(&test->result_lock, memory_order_acquire))
+		;
+}
+
+
+void cl_test_unlock(clarity_test_t *test) {
+	atomic_flag_clear_explicit(&test->result_lock, memory_order_release);
+}
+
+
+bool cl_test_set_message(clarity_test_t *test, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+	if (len < 0)
+		return false;
+
+	char *message = malloc((size_t) len + 1);
+	if (!message)
+		return false;
+
+	va_start(args, format);
+	vsnprintf(message, (size_t) len + 1, format, args);
+	va_end(args);
+
+	cl_test_lock(test);
+	char *previous = test->owned_message;
+	test->owned_message        = message;
+	test->result.error_message = message;
+	cl_test_unlock(test);
+	free(previous);
+	return true;
+}
+
+void cl_test_record(clarity_test_t *test, const char *file, size_t line, bool skipped, const char *message,
+                    char *owned) {
+	char *previous = NULL;
+
+	cl_test_lock(test);
+	if (!file && marked.test == test) {
+		file        = marked.file;
+		line        = marked.line;
+		marked.test = NULL;
+	}
+	if (file) {
+		test->result.file_name   = file;
+		test->result.line_number = line;
+	}
+	if (skipped)
+		test->result.skipped = true;
+	else
+		test->result.passed = false;
+	if (owned) {
+		previous            = test->owned_message;
+		test->owned_message = owned;
+		message             = owned;
+	}
+	test->result.error_message = message;
+	cl_test_unlock(test);
+	free(previous);
+}
+
 void __cl_test_mark_point(clarity_test_t *test, const char *file, size_t line) {
 	if (!test)
 		return;
 
-	test->result.line_number = line;
-	test->result.file_name = file;
+	marked.test = test;
+	marked.file = file;
+	marked.line = line;
 }
 
 void __cl_fail_test(clarity_test_t *test, const char *message) {
-	test->result.passed = false;
-	test->result.error_message = message;
+	cl_test_record(test, NULL, 0, false, message, NULL);
 }
 
 void __cl_skip_test(clarity_test_t *test, const char *message) {
+	cl_test_record(test, NULL, 0, true, message, NULL);
+}
+
+
+clarity_status_t cl_resource_needs_set(clarity_resource_need_t **needs, size_t *count, const char *name,
+                                       uint64_t amount) {
+	for (size_t i = 0; i < *count; i++) {
+		if (!strcmp((*needs)[i].name, name)) {
+			(*needs)[i].amount = amount;
+			return CL_SUCCESS;
+		}
+	}
+
+	clarity_resource_need_t *grown = realloc(*needs, (*count + 1) * sizeof(**needs));
+	if (!grown)
+		return CL_ERROR_MEMORY;
+	grown[*count] = (clarity_resource_need_t){ .name = name, .amount = amount };
+	*needs        = grown;
+	(*count)++;
+	return CL_SUCCESS;
+}
+
+
+clarity_status_t cl_test_require(clarity_test_t *test, const char *name, uint64_t amount) {
+	if (!test)
+		return CL_SUCCESS;
+	return cl_resource_needs_set(&test->needs, &test->need_count, name, amount);
+}
+
+
+/**
+ * @brief Checks whether a test can be reached from another one by following prerequisites.
+ *
+ * Every test is visited once per traversal, so that shared prerequisites do not make the walk exponential.
+ */
+static bool __cl_test_reaches(clarity_test_t *from, const clarity_test_t *target, uint64_t visit) {
+	if (from == target)
+		return true;
+	if (from->visit == visit)
+		return false;
+
+	from->visit = visit;
+	for (size_t i = 0; i < from->prerequisite_count; i++) {
+		if (__cl_test_reaches(from->prerequisites[i], target, visit))
+			return true;
+	}
+	return false;
+}
+
+
+clarity_status_t cl_test_depends_on(clarity_test_t *test, clarity_test_t *prerequisite) {
+	// The dependencies are declared while building the suites, from a single thread.
+	static uint64_t visits;
+
+	if (!test || !prerequisite)
+		return CL_SUCCESS;
+	if (__cl_test_reaches(prerequisite, test, ++visits))
+		return CL_ERROR_CYCLE;
+
+	for (size_t i = 0; i < test->prerequisite_count; i++) {
+		if (test->prerequisites[i] == prerequisite)
+			return CL_SUCCESS;
+	}
+
+	clarity_test_t **grown = realloc(test->prerequisites, (test->prerequisite_count + 1) * sizeof(*grown));
+	if (!grown)
+		return CL_ERROR_MEMORY;
+	grown[test->prerequisite_count++] = prerequisite;
+	test->prerequisites               = grown;
+	prerequisite->dependent_count++;
+	return CL_SUCCESS;
+}
+
+
+void cl_test_settle(clarity_test_t *test, const clarity_test_result_t *result) {
+	test->outcome = result->passed && !result->skipped ? CL_OUTCOME_PASSED : CL_OUTCOME_NOT_PASSED;
+}
+
+
+const clarity_test_t *cl_test_failed_prerequisite(const clarity_test_t *test) {
+	for (size_t i = 0; i < test->prerequisite_count; i++) {
+		if (test->prerequisites[i]->outcome == CL_OUTCOME_NOT_PASSED)
+			return test->prerequisites[i];
+	}
+	return NULL;
+}
+
+
+void cl_test_skip_for_prerequisite(clarity_test_t *test, const clarity_test_t *prerequisite) {
 	test->result.skipped = true;
-	test->result.error_message = message;
-}
\ No newline at end of file
+	if (!cl_test_set_message(test, "prerequisite '%s' did not pass", prerequisite->name))
+		test->result.error_message = "a prerequisite did not pass";
+}
+
+
+/**
+ * @brief When the cancelled tests must be stopped, 0 while the tests are not cancelled.
+ */
+static atomic_uint_least64_t cancel_deadline_ns;
+
+
+bool cl_test_cancelled(const clarity_test_t *test) {
+	(void) test;
+	return atomic_load_explicit(&cancel_deadline_ns, memory_order_relaxed) != 0;
+}
+
+
+void cl_test_cancel_all(uint64_t deadline_ns) {
+	atomic_store(&cancel_deadline_ns, deadline_ns);
+}
+
+
+clarity_status_t cl_test_own_data(clarity_test_t *test, clarity_cleanup_fn_t fn) {
+	if (!test)
+		return CL_SUCCESS;
+	test->free_data = fn;
+	return CL_SUCCESS;
+}
+
+
+uint64_t cl_test_cancel_deadline(void) {
+	return atomic_load_explicit(&cancel_deadline_ns, memory_order_relaxed);
+}
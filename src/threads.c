@@ -0,0 +1,138 @@
+#define _GNU_SOURCE
+#include "threads.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+typedef struct clarity_gang_member_s {
+	clarity_gang_t *gang;
+	size_t         index;
+	pthread_t      thread;
+} clarity_gang_member_t;
+
+struct clarity_gang_s {
+	size_t                size;
+	bool                  pin;
+	bool                  stopping;
+	clarity_gang_fn_t     fn;
+	void                  *context;
+	pthread_mutex_t       creating;
+	pthread_barrier_t     start;
+	pthread_barrier_t     end;
+	clarity_gang_member_t *members;
+};
+
+
+static void *__cl_gang_member_main(void *arg) {
+	clarity_gang_member_t *member = arg;
+	clarity_gang_t        *gang   = member->gang;
+
+	// Wait for all the members to be created, the barriers are only valid once they all exist.
+	pthread_mutex_lock(&gang->creating);
+	pthread_mutex_unlock(&gang->creating);
+	if (gang->stopping)
+		return NULL;
+
+	if (gang->pin)
+		cl_thread_pin(member->index);
+
+	for (;;) {
+		pthread_barrier_wait(&gang->start);
+		if (gang->stopping)
+			return NULL;
+		gang->fn(gang->context, member->index);
+		pthread_barrier_wait(&gang->end);
+	}
+}
+
+
+clarity_gang_t *cl_gang_create(size_t size, bool pin, clarity_gang_fn_t fn, void *context) {
+	clarity_gang_t *gang = calloc(1, sizeof(*gang));
+	if (!gang)
+		return NULL;
+
+	gang->size    = size;
+	gang->pin     = pin;
+	gang->fn      = fn;
+	gang->context = context;
+	gang->members = calloc(size, sizeof(*gang->members));
+	if (!gang->members) {
+		free(gang);
+		return NULL;
+	}
+
+	pthread_mutex_init(&gang->creating, NULL);
+	pthread_mutex_lock(&gang->creating);
+	for (size_t i = 0; i < size; i++) {
+		gang->members[i].gang  = gang;
+		gang->members[i].index = i;
+		if (pthread_create(&gang->members[i].thread, NULL, __cl_gang_member_main, &gang->members[i]) != 0) {
+			gang->stopping = true;
+			pthread_mutex_unlock(&gang->creating);
+			for (size_t j = 0; j < i; j++)
+				pthread_join(gang->members[j].thread, NULL);
+			pthread_mutex_destroy(&gang->creating);
+			free(gang->members);
+			free(gang);
+			return NULL;
+		}
+	}
+
+	// The calling thread takes part in both barriers, to release the round and to wait for its end.
+	pthread_barrier_init(&gang->start, NULL, (unsigned) size + 1);
+	pthread_barrier_init(&gang->end, NULL, (unsigned) size + 1);
+	pthread_mutex_unlock(&gang->creating);
+
+	return gang;
+}
+
+
+void cl_gang_run(clarity_gang_t *gang) {
+	pthread_barrier_wait(&gang->start);
+	pthread_barrier_wait(&gang->end);
+}
+
+
+void cl_gang_free(clarity_gang_t *gang) {
+	if (!gang)
+		return;
+
+	gang->stopping = true;
+	pthread_barrier_wait(&gang->start);
+	for (size_t i = 0; i < gang->size; i++)
+		pthread_join(gang->members[i].thread, NULL);
+
+	pthread_barrier_destroy(&gang->start);
+	pthread_barrier_destroy(&gang->end);
+	pthread_mutex_destroy(&gang->creating);
+	free(gang->members);
+	free(gang);
+}
+
+
+bool cl_thread_pin(size_t index) {
+#ifdef __linux__
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof allowed, &allowed) != 0)
+		return false;
+
+	int count = CPU_COUNT(&allowed);
+	if (count <= 0)
+		return false;
+
+	int target = (int) (index % (size_t) count);
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &allowed) || target--)
+			continue;
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0;
+	}
+	return false;
+#else
+	(void) index;
+	return false;
+#endif
+}
@@ -0,0 +1,27 @@
+#include "timing.h"
+#include <stdio.h>
+#include <time.h>
+
+uint64_t cl_timing_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+uint64_t cl_timing_thread_cpu_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+char *cl_timing_format(double ns, char *buffer, size_t size) {
+	if (ns < 1e3)
+		snprintf(buffer, size, "%.0f ns", ns);
+	else if (ns < 1e6)
+		snprintf(buffer, size, "%.2f us", ns / 1e3);
+	else if (ns < 1e9)
+		snprintf(buffer, size, "%.2f ms", ns / 1e6);
+	else
+		snprintf(buffer, size, "%.2f s", ns / 1e9);
+	return buffer;
+}
@@ -0,0 +1,246 @@
+#include "trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "files.h"
+#include "timing.h"
+
+/**
+ * @brief A block of events of a thread.
+ */
+typedef struct clarity_trace_block_s {
+	struct clarity_trace_block_s *next;
+	size_t                       count;
+	clarity_trace_event_t        events[CL_TRACE_BLOCK_EVENTS];
+} clarity_trace_block_t;
+
+/**
+ * @brief The events recorded by a thread, only ever written by the thread owning the buffer.
+ *
+ * Buffers are never freed: the buffer of a thread which exits is adopted by the next thread needing one, so a
+ * pool of workers started for every suite keeps recording to the same tracks.
+ */
+typedef struct clarity_trace_buffer_s {
+	struct clarity_trace_buffer_s *next;  /**< The buffer registered before this one. */
+	atomic_bool                   owned;  /**< Whether a thread records to the buffer. */
+	uint32_t                      track;  /**< The identifier of the track of the buffer, from 1. */
+	clarity_trace_block_t         *first; /**< The first block of events. */
+	clarity_trace_block_t         *last;  /**< The block receiving the events. */
+} clarity_trace_buffer_t;
+
+static atomic_bool                      recording;
+static uint64_t                         origin_ns;
+static uint32_t                         main_track;
+static _Atomic(clarity_trace_buffer_t *) buffers;
+static atomic_uint                      tracks;
+static pthread_key_t                    buffer_key;
+static pthread_once_t                   buffer_once = PTHREAD_ONCE_INIT;
+static _Thread_local clarity_trace_buffer_t *local;
+
+
+static void __cl_trace_disown(void *data) {
+	clarity_trace_buffer_t *buffer = data;
+	atomic_store_explicit(&buffer->owned, false, memory_order_release);
+}
+
+
+static void __cl_trace_init(void) {
+	pthread_key_create(&buffer_key, __cl_trace_disown);
+}
+
+
+/**
+ * @brief Get the buffer of the calling thread, adopting the buffer of a thread which exited if there is one.
+ *
+ * @return The buffer, or NULL if it could not be allocated.
+ */
+static clarity_trace_buffer_t *__cl_trace_buffer(void) {
+	if (local)
+		return local;
+
+	clarity_trace_buffer_t *buffer = atomic_load_explicit(&buffers, memory_order_acquire);
+	for (; buffer; buffer = buffer->next) {
+		bool owned = false;
+		if (atomic_compare_exchange_strong_explicit(&buffer->owned, &owned, true, memory_order_acquire,
+		                                            memory_order_relaxed))
+			break;
+	}
+	if (!buffer) {
+		buffer = calloc(1, sizeof(*buffer));
+		if (!buffer)
+			return NULL;
+		atomic_init(&buffer->owned, true);
+		buffer->track = atomic_fetch_add_explicit(&tracks, 1, memory_order_relaxed) + 1;
+		buffer->next  = atomic_load_explicit(&buffers, memory_order_relaxed);
+		while (!atomic_compare_exchange_weak_explicit(&buffers, &buffer->next, buffer, memory_order_release,
+		                                              memory_order_relaxed))
+			;
+	}
+
+	pthread_once(&buffer_once, __cl_trace_init);
+	pthread_setspecific(buffer_key, buffer);
+	local = buffer;
+	return buffer;
+}
+
+
+/**
+ * @brief Copies a name into an event, truncated on a character boundary.
+ */
+static void __cl_trace_copy_name(char *destination, const char *name) {
+	size_t length = strnlen(name, CL_TRACE_NAME_SIZE);
+	if (length == CL_TRACE_NAME_SIZE) {
+		length--;
+		while (length && ((unsigned char) name[length] & 0xc0) == 0x80)
+			length--;
+	}
+	memcpy(destination, name, length);
+	destination[length] = '\0';
+}
+
+
+uint64_t cl_trace_now(void) {
+	if (!atomic_load_explicit(&recording, memory_order_relaxed))
+		return 0;
+	return cl_timing_now_ns();
+}
+
+
+void cl_trace_span(uint64_t start_ns, const char *category, const char *label, const char *name) {
+	if (!start_ns || !atomic_load_explicit(&recording, memory_order_relaxed))
+		return;
+
+	uint64_t               end_ns = cl_timing_now_ns();
+	clarity_trace_buffer_t *buffer = __cl_trace_buffer();
+	if (!buffer)
+		return;
+
+	clarity_trace_block_t *block = buffer->last;
+	if (!block || block->count == CL_TRACE_BLOCK_EVENTS) {
+		block = malloc(sizeof(*block));
+		if (!block)
+			return;
+		block->next  = NULL;
+		block->count = 0;
+		if (buffer->last)
+			buffer->last->next = block;
+		else
+			buffer->first = block;
+		buffer->last = block;
+	}
+
+	clarity_trace_event_t *event = &block->events[block->count++];
+	event->start_ns    = start_ns;
+	event->duration_ns = end_ns - start_ns;
+	event->category    = category;
+	event->label       = label;
+	__cl_trace_copy_name(event->name, name ? name : "");
+}
+
+
+clarity_status_t cl_trace_start(void) {
+	clarity_trace_buffer_t *buffer = __cl_trace_buffer();
+
+	main_track = buffer ? buffer->track : 0;
+	origin_ns  = cl_timing_now_ns();
+	atomic_store_explicit(&recording, true, memory_order_release);
+	return CL_SUCCESS;
+}
+
+
+static void __cl_trace_write_string(FILE *stream, const char *text) {
+	for (; *text; text++) {
+		unsigned char c = (unsigned char) *text;
+		if (c == '"' || c == '\\')
+			fprintf(stream, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(stream, "\\u%04x", c);
+		else
+			fputc(c, stream);
+	}
+}
+
+
+/**
+ * @brief Writes a timestamp relative to the start of the recording, in microseconds as the format expects.
+ */
+static void __cl_trace_write_time(FILE *stream, const char *key, uint64_t ns) {
+	fprintf(stream, ",\"%s\":%llu.%03llu", key, (unsigned long long) (ns / 1000), (unsigned long long) (ns % 1000));
+}
+
+
+/**
+ * @brief Writes one event: a complete event on the track of its thread, or a pair of async events for an
+ * asynchronous test, which overlap with the other tests in flight on the same thread.
+ */
+static void __cl_trace_write_event(FILE *stream, uint32_t track, const clarity_trace_event_t *event,
+                                   uint64_t id) {
+	uint64_t start = event->start_ns > origin_ns ? event->start_ns - origin_ns : 0;
+	bool     async = !strcmp(event->category, "async");
+
+	for (int part = 0; part < (async ? 2 : 1); part++) {
+		fputs(",\n{\"name\":\"", stream);
+		if (event->label) {
+			__cl_trace_write_string(stream, event->label);
+			fputc(' ', stream);
+		}
+		__cl_trace_write_string(stream, event->name);
+		fprintf(stream, "\",\"cat\":\"%s\",\"pid\":1,\"tid\":%u", event->category, track);
+		if (!async) {
+			fputs(",\"ph\":\"X\"", stream);
+			__cl_trace_write_time(stream, "ts", start);
+			__cl_trace_write_time(stream, "dur", event->duration_ns);
+		} else {
+			fprintf(stream, ",\"ph\":\"%s\",\"id\":%llu", part ? "e" : "b", (unsigned long long) id);
+			__cl_trace_write_time(stream, "ts", part ? start + event->duration_ns : start);
+		}
+		fputc('}', stream);
+	}
+}
+
+
+clarity_status_t cl_trace_stop(const char *path) {
+	atomic_store_explicit(&recording, false, memory_order_release);
+
+	char   *text = NULL;
+	size_t len   = 0;
+	FILE   *stream = open_memstream(&text, &len);
+	bool   written = false;
+	if (stream) {
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+		      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CLarity\"}}", stream);
+		uint64_t id = 0;
+		for (clarity_trace_buffer_t *buffer = atomic_load_explicit(&buffers, memory_order_acquire); buffer;
+		     buffer = buffer->next) {
+			if (!buffer->first)
+				continue;
+			if (buffer->track == main_track)
+				fprintf(stream, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+				                "\"args\":{\"name\":\"main\"}}", buffer->track);
+			else
+				fprintf(stream, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+				                "\"args\":{\"name\":\"worker %u\"}}", buffer->track, buffer->track);
+			for (clarity_trace_block_t *block = buffer->first; block; block = block->next) {
+				for (size_t i = 0; i < block->count; i++)
+					__cl_trace_write_event(stream, buffer->track, &block->events[i], ++id);
+			}
+		}
+		fputs("\n]}\n", stream);
+		written = !fclose(stream) && cl_files_replace(path, NULL, 0, text, len);
+	}
+	free(text);
+
+	for (clarity_trace_buffer_t *buffer = atomic_load_explicit(&buffers, memory_order_acquire); buffer;
+	     buffer = buffer->next) {
+		while (buffer->first) {
+			clarity_trace_block_t *block = buffer->first;
+			buffer->first = block->next;
+			free(block);
+		}
+		buffer->last = NULL;
+	}
+	return written ? CL_SUCCESS : CL_ERROR_IO;
+}
@@ -0,0 +1,219 @@
+#include "wire.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define CL_BUFFER_MIN_CAPACITY 4096
+
+
+static bool __cl_buffer_reserve(clarity_buffer_t *buffer, size_t extra) {
+	if (buffer->consumed && buffer->length + extra > buffer->capacity) {
+		memmove(buffer->data, buffer->data + buffer->consumed, buffer->length - buffer->consumed);
+		buffer->length -= buffer->consumed;
+		buffer->consumed = 0;
+	}
+	if (buffer->length + extra <= buffer->capacity)
+		return true;
+
+	size_t new_capacity = buffer->capacity ? buffer->capacity : CL_BUFFER_MIN_CAPACITY;
+	while (new_capacity < buffer->length + extra)
+		new_capacity *= 2;
+
+	char *data = realloc(buffer->data, new_capacity);
+	if (!data)
+		return false;
+	buffer->data     = data;
+	buffer->capacity = new_capacity;
+	return true;
+}
+
+
+bool cl_buffer_append(clarity_buffer_t *buffer, const void *data, size_t length) {
+	if (!__cl_buffer_reserve(buffer, length))
+		return false;
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+	return true;
+}
+
+
+void cl_buffer_free(clarity_buffer_t *buffer) {
+	free(buffer->data);
+	memset(buffer, 0, sizeof(*buffer));
+}
+
+
+ssize_t cl_buffer_fill(clarity_buffer_t *buffer, int fd) {
+	if (!__cl_buffer_reserve(buffer, CL_BUFFER_MIN_CAPACITY))
+		return -1;
+
+	ssize_t len;
+	do {
+		len = read(fd, buffer->data + buffer->length, buffer->capacity - buffer->length);
+	} while (len < 0 && errno == EINTR);
+	if (len > 0)
+		buffer->length += (size_t) len;
+	return len;
+}
+
+
+char *cl_buffer_next_line(clarity_buffer_t *buffer) {
+	// Nothing may have been read yet, in which case there is no data to search.
+	if (buffer->consumed == buffer->length)
+		return NULL;
+
+	char *start = buffer->data + buffer->consumed;
+	char *end   = memchr(start, '\n', buffer->length - buffer->consumed);
+	if (!end)
+		return NULL;
+
+	*end = '\0';
+	buffer->consumed += (size_t) (end - start) + 1;
+	return start;
+}
+
+
+bool cl_buffer_flush(clarity_buffer_t *buffer, int fd) {
+	size_t written = buffer->consumed;
+	bool   state   = true;
+	while (state && written < buffer->length) {
+		ssize_t len = send(fd, buffer->data + written, buffer->length - written, MSG_NOSIGNAL);
+		if (len < 0 && errno == ENOTSOCK)
+			len = write(fd, buffer->data + written, buffer->length - written);
+		if (len < 0 && errno == EINTR)
+			continue;
+		state = len > 0;
+		written += state ? (size_t) len : 0;
+	}
+	buffer->length   = 0;
+	buffer->consumed = 0;
+	return state;
+}
+
+
+static const char *__cl_wire_escape(char c) {
+	if (c == '\t')
+		return "\\t";
+	if (c == '\n')
+		return "\\n";
+	if (c == '\\')
+		return "\\\\";
+	return NULL;
+}
+
+
+bool cl_wire_begin(clarity_buffer_t *buffer, const char *type) {
+	return cl_buffer_append(buffer, type, strlen(type));
+}
+
+
+bool cl_wire_add_string(clarity_buffer_t *buffer, const char *text) {
+	if (!cl_buffer_append(buffer, "\t", 1))
+		return false;
+
+	for (; text && *text; text++) {
+		const char *escaped = __cl_wire_escape(*text);
+		if (!(escaped ? cl_buffer_append(buffer, escaped, 2) : cl_buffer_append(buffer, text, 1)))
+			return false;
+	}
+	return true;
+}
+
+
+bool cl_wire_add_u64(clarity_buffer_t *buffer, uint64_t value) {
+	char text[24];
+	snprintf(text, sizeof text, "%" PRIu64, value);
+	return cl_wire_add_string(buffer, text);
+}
+
+
+bool cl_wire_end(clarity_buffer_t *buffer) {
+	return cl_buffer_append(buffer, "\n", 1);
+}
+
+
+static size_t __cl_wire_unescape_into(char *out, const char *text, size_t length) {
+	size_t j = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (text[i] == '\\' && i + 1 < length) {
+			i++;
+			out[j++] = text[i] == 't' ? '\t' : text[i] == 'n' ? '\n' : text[i];
+		} else {
+			out[j++] = text[i];
+		}
+	}
+	out[j] = '\0';
+	return j;
+}
+
+
+size_t cl_wire_split(char *line, char **fields, size_t max) {
+	size_t count = 0;
+	char   *start = line;
+
+	while (count < max) {
+		char *end = strchr(start, '\t');
+		if (end)
+			*end = '\0';
+		fields[count++] = start;
+		__cl_wire_unescape_into(start, start, strlen(start));
+		if (!end)
+			break;
+		start = end + 1;
+	}
+	return count;
+}
+
+
+uint64_t cl_wire_u64(const char *field) {
+	return strtoull(field, NULL, 10);
+}
+
+
+void cl_wire_fputs_escaped(FILE *stream, const char *text) {
+	for (; *text; text++) {
+		const char *escaped = __cl_wire_escape(*text);
+		if (escaped)
+			fputs(escaped, stream);
+		else
+			fputc(*text, stream);
+	}
+}
+
+
+char *cl_wire_unescape(const char *text, size_t length) {
+	char *result = malloc(length + 1);
+	if (!result)
+		return NULL;
+
+	__cl_wire_unescape_into(result, text, length);
+	return result;
+}
+
+
+bool cl_wire_add_result(clarity_buffer_t *buffer, const clarity_test_result_t *result) {
+	const char *status = result->not_run ? "N" : result->skipped ? "S" : result->passed ? "P" : "F";
+
+	return cl_wire_add_string(buffer, result->name)
+	       && cl_wire_add_string(buffer, status)
+	       && cl_wire_add_u64(buffer, result->duration_ns)
+	       && cl_wire_add_u64(buffer, result->line_number)
+	       && cl_wire_add_string(buffer, result->file_name)
+	       && cl_wire_add_string(buffer, result->error_message);
+}
+
+
+void cl_wire_read_result(char **fields, clarity_test_result_t *result) {
+	memset(result, 0, sizeof(*result));
+	result->name          = fields[0];
+	result->not_run       = fields[1][0] == 'N';
+	result->skipped       = fields[1][0] == 'S' || result->not_run;
+	result->passed        = fields[1][0] != 'F';
+	result->duration_ns   = cl_wire_u64(fields[2]);
+	result->line_number   = (size_t) cl_wire_u64(fields[3]);
+	result->file_name     = fields[4][0] ? fields[4] : NULL;
+	result->error_message = fields[5][0] ? fields[5] : NULL;
+}
@@ -0,0 +1,80 @@
+#ifndef CLARITY_TEST_CAPTURE_H
+#define CLARITY_TEST_CAPTURE_H
+
+#include <CLarity/clarity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * @brief A function whose standard output is captured, returning its status.
+ */
+typedef int (*capture_fn_t)(void *data);
+
+
+/**
+ * @brief Runs a function with its standard output captured, then echoes the output.
+ *
+ * @param fn The function to run.
+ * @param data The data passed to the function.
+ * @param status Receives the status returned by the function.
+ *
+ * @return The captured output, to be freed by the caller, or NULL if it could not be captured, in which case the
+ *         function was not run.
+ */
+static inline char *capture_stdout(capture_fn_t fn, void *data, int *status) {
+	FILE *capture = tmpfile();
+	if (!capture) {
+		perror("tmpfile");
+		return NULL;
+	}
+	fflush(stdout);
+	int saved = dup(STDOUT_FILENO);
+	if (saved < 0 || dup2(fileno(capture), STDOUT_FILENO) < 0) {
+		perror("dup");
+		if (saved >= 0)
+			close(saved);
+		fclose(capture);
+		return NULL;
+	}
+	*status = fn(data);
+	fflush(stdout);
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+
+	long size = ftell(capture);
+	char *text = size >= 0 ? (char *) calloc(1, (size_t) size + 1) : NULL;
+	rewind(capture);
+	if (text && fread(text, 1, (size_t) size, capture) != (size_t) size) {
+		perror("fread");
+		free(text);
+		text = NULL;
+	}
+	fclose(capture);
+	if (text)
+		fputs(text, stdout);
+	return text;
+}
+
+
+static inline int __capture_run_suite(void *suite) {
+	return cl_run_suite((clarity_suite_t *) suite);
+}
+
+
+/**
+ * @brief Runs a suite with its standard output captured, then echoes the output.
+ *
+ * @param suite The suite to run.
+ * @param passed Receives whether the suite passed, false if the output could not be captured.
+ *
+ * @return The captured output, to be freed by the caller, or NULL if it could not be captured.
+ */
+static inline char *run_captured(clarity_suite_t *suite, bool *passed) {
+	int  status = 0;
+	char *text  = capture_stdout(__capture_run_suite, suite, &status);
+	*passed     = text && status;
+	return text;
+}
+
+#endif
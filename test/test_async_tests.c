@@ -0,0 +1,88 @@
+#include <CLarity/clarity.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ASYNC_TESTS 200
+#define SERVER_LATENCY_MS 50
+
+typedef struct exchange_s {
+	int fds[2];
+} exchange_t;
+
+
+void on_reply(clarity_test_t *t, clarity_async_t *async, int fd, uint32_t events, void *data) {
+	exchange_t *exchange = data;
+	char       buffer[16];
+
+	(void) events;
+	ssize_t len = read(fd, buffer, sizeof buffer);
+	if (len != 4 || memcmp(buffer, "pong", 4) != 0)
+		cl_fail_test(t, "unexpected reply from the server");
+
+	close(exchange->fds[0]);
+	close(exchange->fds[1]);
+	cl_async_done(async);
+}
+
+
+void server_reply(clarity_test_t *t, clarity_async_t *async, void *data) {
+	exchange_t *exchange = data;
+
+	(void) async;
+	if (write(exchange->fds[1], "pong", 4) != 4)
+		cl_fail_test(t, "the server could not reply");
+}
+
+
+void ping(clarity_test_t *t, clarity_async_t *async, void *data) {
+	exchange_t *exchange = data;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, exchange->fds) < 0) {
+		cl_fail_test(t, "could not create the socket pair");
+		cl_async_done(async);
+		return;
+	}
+	cl_async_watch_fd(async, exchange->fds[0], CL_ASYNC_READABLE, on_reply, exchange);
+	cl_async_set_timer(async, SERVER_LATENCY_MS, server_reply, exchange);
+}
+
+
+void never_replies(clarity_test_t *t, clarity_async_t *async, void *data) {
+	exchange_t *exchange = data;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, exchange->fds) < 0) {
+		cl_fail_test(t, "could not create the socket pair");
+		cl_async_done(async);
+		return;
+	}
+	cl_async_watch_fd(async, exchange->fds[0], CL_ASYNC_READABLE, on_reply, exchange);
+}
+
+
+int main() {
+	static exchange_t exchanges[ASYNC_TESTS + 1];
+	struct timespec   start, end;
+
+	clarity_suite_t *suite   = cl_create_suite("Asynchronous tests");
+	clarity_suite_t *timeout = cl_create_suite("Asynchronous test timeout");
+	for (size_t i = 0; i < ASYNC_TESTS; i++)
+		cl_add_test(suite, cl_create_async_test("ping the server", ping, &exchanges[i], 0));
+	cl_add_test(timeout,
+	            cl_create_async_test("the server never replies", never_replies, &exchanges[ASYNC_TESTS], 100));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	bool passed = cl_run_suite(suite);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	bool timed_out = !cl_run_suite(timeout);
+
+	cl_free_suite(suite);
+	cl_free_suite(timeout);
+	close(exchanges[ASYNC_TESTS].fds[0]);
+	close(exchanges[ASYNC_TESTS].fds[1]);
+
+	// The tests wait concurrently: the suite takes about one server latency, not one per test.
+	double elapsed_ms = (double) (end.tv_sec - start.tv_sec) * 1e3 + (double) (end.tv_nsec - start.tv_nsec) / 1e6;
+	return !(passed && timed_out && elapsed_ms < ASYNC_TESTS * SERVER_LATENCY_MS / 10);
+}
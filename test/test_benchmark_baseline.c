@@ -0,0 +1,95 @@
+#include <CLarity/clarity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SUITE_NAME "Benchmark baseline"
+#define SAMPLES 10
+
+static char path[256];
+
+
+void pause_briefly(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+
+	// Every sample lasts at least a millisecond, whatever the load of the machine.
+	struct timespec pause = { .tv_nsec = 1000000 };
+	nanosleep(&pause, NULL);
+}
+
+
+static bool run(clarity_baseline_mode_t mode) {
+	clarity_suite_t *suite = cl_create_suite(SUITE_NAME);
+
+	cl_add_test(suite, cl_create_benchmark("pause", pause_briefly, NULL, SAMPLES));
+	cl_suite_set_baseline(suite, path, mode);
+	cl_suite_set_regression_threshold(suite, CL_DEFAULT_REGRESSION_ALPHA, 0.5);
+
+	bool result = cl_run_suite(suite);
+
+	cl_free_suite(suite);
+	return result;
+}
+
+
+static bool write_baseline(const char *content) {
+	FILE *file = fopen(path, "w");
+	if (!file)
+		return false;
+	bool written = fputs(content, file) >= 0;
+	return fclose(file) == 0 && written;
+}
+
+
+static bool write_samples(unsigned long long nanoseconds) {
+	char content[512];
+	int  length = snprintf(content, sizeof content, "# CLarity baseline v1\n" SUITE_NAME "\tpause\t%d\t", SAMPLES);
+	for (int i = 0; i < SAMPLES && length > 0 && (size_t) length < sizeof content; i++)
+		length += snprintf(content + length, sizeof content - (size_t) length, i ? ",%llu" : "%llu", nanoseconds + i);
+	if (length <= 0 || (size_t) length >= sizeof content - 1)
+		return false;
+	content[length++] = '\n';
+	content[length]   = '\0';
+	return write_baseline(content);
+}
+
+
+static bool recorded(void) {
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return false;
+
+	char header[64], entry[512];
+	bool found = fgets(header, sizeof header, file) && fgets(entry, sizeof entry, file);
+	fclose(file);
+	return found && strcmp(header, "# CLarity baseline v1\n") == 0 &&
+	       strncmp(entry, SUITE_NAME "\tpause\t10\t", strlen(SUITE_NAME "\tpause\t10\t")) == 0;
+}
+
+
+int main() {
+	char dir[] = "/tmp/clarity-baseline-XXXXXX";
+	if (!mkdtemp(dir))
+		return 1;
+	snprintf(path, sizeof path, "%s/baseline.txt", dir);
+
+	// A missing baseline is warned about, and compares nothing.
+	bool missing = run(CL_BASELINE_COMPARE);
+
+	bool fresh = run(CL_BASELINE_RECORD) && recorded();
+
+	// Samples of a minute each are far slower than the current ones, samples of a microsecond far faster.
+	bool faster    = write_samples(60000000000ULL) && run(CL_BASELINE_COMPARE);
+	bool regressed = write_samples(1000) && !run(CL_BASELINE_COMPARE);
+
+	// A malformed baseline compares nothing, and is replaced when recording.
+	bool malformed = write_baseline("# CLarity baseline v1\nnot a baseline entry\n") && run(CL_BASELINE_COMPARE);
+	bool replaced  = run(CL_BASELINE_RECORD) && recorded();
+
+	bool cleaned = unlink(path) == 0 && rmdir(dir) == 0;
+
+	return !(missing && fresh && faster && regressed && malformed && replaced && cleaned);
+}
@@ -0,0 +1,129 @@
+#include <CLarity/clarity.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "capture.h"
+
+#define STRINGIFY(x) #x
+#define LINE_STRING(x) STRINGIFY(x)
+// The message names the line of the failure, for the report to show whether they were recorded together.
+#define FAIL_HERE(t) cl_fail_test(t, "line " LINE_STRING(__LINE__))
+
+#define RACING_THREADS 4
+#define RACING_FAILURES 20000
+
+static atomic_long counter;
+static atomic_bool release_stuck;
+
+
+static void *fail_repeatedly(void *data) {
+	clarity_test_t *t = data;
+	for (int i = 0; i < RACING_FAILURES; i++) {
+		if (i % 2) {
+			FAIL_HERE(t);
+		} else {
+			FAIL_HERE(t);
+		}
+	}
+	return NULL;
+}
+
+
+void failures_from_threads(clarity_test_t *t, void *data) {
+	(void) data;
+	pthread_t threads[RACING_THREADS];
+	for (int i = 0; i < RACING_THREADS; i++)
+		pthread_create(&threads[i], NULL, fail_repeatedly, t);
+	for (int i = 0; i < RACING_THREADS; i++)
+		pthread_join(threads[i], NULL);
+}
+
+
+static void increment(clarity_test_t *t, size_t thread, uint64_t iteration, void *data) {
+	(void) thread;
+	(void) iteration;
+	(void) data;
+	long *scratch = cl_test_alloc(t, sizeof(long), 0);
+	*scratch      = atomic_fetch_add(&counter, 1);
+}
+
+
+void all_threads_pass(clarity_test_t *t, void *data) {
+	(void) data;
+	if (!cl_run_concurrently(t, increment, NULL, 4, 10000, 0) || atomic_load(&counter) != 40000)
+		cl_fail_test(t, "the threads did not all go through their iterations");
+}
+
+
+static void fail_on_thread_two(clarity_test_t *t, size_t thread, uint64_t iteration, void *data) {
+	(void) data;
+	if (thread == 2 && iteration == 5)
+		cl_fail_test(t, "thread two failed");
+}
+
+
+void one_thread_fails(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_run_concurrently(t, fail_on_thread_two, NULL, 4, 1000000, 0);
+}
+
+
+static void block_thread_one(clarity_test_t *t, size_t thread, uint64_t iteration, void *data) {
+	(void) t;
+	(void) iteration;
+	(void) data;
+	struct timespec delay = { .tv_nsec = 1000000 };
+	while (thread == 1 && !atomic_load(&release_stuck))
+		nanosleep(&delay, NULL);
+}
+
+
+void one_thread_is_stuck(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_run_concurrently(t, block_thread_one, NULL, 2, 1, 50);
+}
+
+
+/**
+ * The failure of the racing test must be one of the two, with its own line.
+ */
+static bool recorded_together(const char *output) {
+	const char *message = strstr(output, "\tline ");
+	const char *file    = message ? strstr(message, "File: ") : NULL;
+	const char *line    = file ? strstr(file, ".c:") : NULL;
+	if (!line)
+		return false;
+	return atoi(message + 6) == atoi(line + 3);
+}
+
+
+int main() {
+	bool passed;
+
+	clarity_suite_t *racing = cl_create_suite("Failures from threads");
+	cl_add_test(racing, cl_create_test("threads failing at once", failures_from_threads, NULL));
+	char *racing_output = run_captured(racing, &passed);
+	bool  consistent    = racing_output && !passed && recorded_together(racing_output);
+
+	clarity_suite_t *harness = cl_create_suite("Concurrent runs");
+	cl_add_test(harness, cl_create_test("all threads pass", all_threads_pass, NULL));
+	cl_add_test(harness, cl_create_test("one thread fails", one_thread_fails, NULL));
+	cl_add_test(harness, cl_create_test("one thread is stuck", one_thread_is_stuck, NULL));
+	char *harness_output = run_captured(harness, &passed);
+	bool  reported       = harness_output && !passed && strstr(harness_output, "thread 2, iteration 5: thread two failed") &&
+	                       strstr(harness_output, "1 of 2 threads did not finish within 50 ms") &&
+	                       strstr(harness_output, "Succeeded: 1 ");
+
+	// The stuck thread still runs, on data which outlives it.
+	atomic_store(&release_stuck, true);
+
+	free(racing_output);
+	free(harness_output);
+	cl_free_suite(racing);
+	cl_free_suite(harness);
+	return !(consistent && reported);
+}
@@ -0,0 +1,94 @@
+#include <CLarity/clarity.hpp>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "capture.h"
+
+namespace {
+
+int instances;
+int destroyed;
+
+/**
+ * A callable counting its copies still alive, which the tests must destroy along with them.
+ */
+struct counted {
+	int *runs;
+
+	explicit counted(int *runs) : runs(runs) { instances++; }
+	counted(const counted &other) : runs(other.runs) { instances++; }
+	~counted() { destroyed++; }
+
+	void operator()(clarity_test_t *t) const {
+		(void) t;
+		++*runs;
+	}
+};
+
+struct square {
+	int input;
+	int expected;
+};
+
+constexpr std::array<square, 3> squares = { { { 2, 4 }, { -3, 9 }, { 0, 0 } } };
+constexpr square                wrong_squares[] = { { 3, 9 }, { 4, 15 } };
+
+} // namespace
+
+
+int main() {
+	int              runs     = 0;
+	int              typed    = 0;
+	int              rows     = 0;
+	std::vector<int> captured = { 1, 2, 3 };
+
+	clarity_suite_t *suite = cl_create_suite("C++ tests");
+	clarity::add_test(suite, "lambda", [&runs, captured = std::move(captured)](clarity_test_t *t) {
+		runs++;
+		if (captured.size() != 3 || captured[2] != 3)
+			cl_fail_test(t, "the captured vector was not kept with the test");
+	});
+	clarity::add_test(suite, "callable", counted(&runs));
+	clarity::add_typed_tests(suite, "sum", clarity::types<int, long, double>{}, [&typed](clarity_test_t *t, auto type) {
+		using T = typename decltype(type)::type;
+		typed++;
+		if (T(2) + T(2) != T(4))
+			cl_fail_test(t, "2 + 2 is not 4");
+	});
+	clarity::add_table_tests(suite, "square", squares, [&rows](clarity_test_t *t, const square &row) {
+		rows++;
+		if (row.input * row.input != row.expected)
+			cl_fail_test(t, "wrong square");
+	});
+
+	clarity_test_t *named = clarity::make_test("named", [](clarity_test_t *) {});
+	bool names = !std::strcmp(cl_get_test_name(named), "named");
+	cl_add_test(suite, named);
+
+	clarity_suite_t *failing = cl_create_suite("C++ failures");
+	clarity::add_table_tests(failing, "square", wrong_squares, [](clarity_test_t *t, const square &row) {
+		if (row.input * row.input != row.expected)
+			cl_fail_test(t, "wrong square");
+	});
+
+	// An exception escaping a test fails it, without reaching the runner.
+	clarity_suite_t *throwing = cl_create_suite("C++ exceptions");
+	clarity::add_test(throwing, "standard", [](clarity_test_t *) { throw std::runtime_error("disk full"); });
+	clarity::add_test(throwing, "other", [](clarity_test_t *) { throw 42; });
+
+	bool passed = cl_run_suite(suite);
+	bool failed = !cl_run_suite(failing);
+
+	bool thrown_passed;
+	char *output = run_captured(throwing, &thrown_passed);
+	bool thrown  = output && !thrown_passed && std::strstr(output, "uncaught exception: disk full") &&
+	               std::strstr(output, "Failed: 2 ");
+	free(output);
+
+	cl_free_suite(suite);
+	cl_free_suite(failing);
+	cl_free_suite(throwing);
+
+	return !(passed && failed && thrown && names && runs == 2 && typed == 3 && rows == 3 && instances == destroyed);
+}
@@ -0,0 +1,69 @@
+#include <CLarity/clarity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "capture.h"
+
+#define SPIN_NS 2000000
+
+
+static void add_numbers(void *data) {
+	volatile unsigned *sum = data;
+	for (unsigned i = 0; i < 100; i++)
+		*sum += i;
+}
+
+
+/**
+ * Spins on the CPU clock of the thread, for the region to take the same CPU time on every machine.
+ */
+static void spin(void *data) {
+	(void) data;
+	struct timespec start, now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+	do {
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000000000L + (now.tv_nsec - start.tv_nsec) < SPIN_NS);
+}
+
+
+void fast_region(clarity_test_t *t, void *data) {
+	(void) data;
+	unsigned sum = 0;
+	cl_assert_cpu_time_below(t, 10000000, add_numbers, &sum);
+}
+
+
+void slow_region(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_assert_cpu_time_below(t, 100000, spin, NULL);
+}
+
+
+int main() {
+	bool passed;
+
+	clarity_suite_t *fast = cl_create_suite("Within budget");
+	cl_add_test(fast, cl_create_test("fast region", fast_region, NULL));
+	bool within = cl_run_suite(fast);
+
+	clarity_suite_t *slow = cl_create_suite("Above budget");
+	cl_add_test(slow, cl_create_test("slow region", slow_region, NULL));
+	char *output   = run_captured(slow, &passed);
+	bool  reported = output && !passed && strstr(output, "CPU time above its budget") && strstr(output, "median=");
+
+	// The slack of slower machines lets the same region through.
+	setenv(CL_PERF_SLACK_ENV, "100", 1);
+	clarity_suite_t *slower = cl_create_suite("Above budget, on a slower machine");
+	cl_add_test(slower, cl_create_test("slow region", slow_region, NULL));
+	bool slack = cl_run_suite(slower);
+	unsetenv(CL_PERF_SLACK_ENV);
+
+	free(output);
+	cl_free_suite(fast);
+	cl_free_suite(slow);
+	cl_free_suite(slower);
+	return !(within && reported && slack);
+}
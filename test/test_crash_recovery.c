@@ -0,0 +1,100 @@
+#include <CLarity/clarity.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+static atomic_int teardowns;
+static atomic_int late_runs;
+static atomic_int passes;
+
+
+int count_teardown(void *data) {
+	(void) data;
+	atomic_fetch_add(&teardowns, 1);
+	return 0;
+}
+
+
+void passes_test(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	atomic_fetch_add(&passes, 1);
+}
+
+
+void dereferences_null(clarity_test_t *t, void *data) {
+	(void) data;
+	volatile int *volatile pointer = NULL;
+	cl_test_alloc(t, 128, 0);
+	*pointer = 1;
+}
+
+
+void divides_by_zero(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	raise(SIGFPE);
+}
+
+
+void aborts(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	abort();
+}
+
+
+static int recurse(volatile int depth) {
+	volatile char frame[1024];
+	frame[0] = (char) depth;
+	// Any stack overflows long before the end, which keeps the compiler from reporting an infinite recursion.
+	if (depth == INT_MAX)
+		return frame[0];
+	return recurse(depth + 1) + frame[0];
+}
+
+
+void overflows_the_stack(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	recurse(0);
+}
+
+
+void runs_late(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	atomic_fetch_add(&late_runs, 1);
+}
+
+
+int main() {
+	// The third crash stops the suite: the last test is reported as not run.
+	clarity_suite_t *stopped = cl_create_suite("Crash recovery");
+	cl_suite_set_crash_recovery(stopped, true, 3);
+	cl_suite_add_fixture(stopped, cl_create_fixture(NULL, NULL, count_teardown, NULL));
+	cl_add_test(stopped, cl_create_test("passes", passes_test, NULL));
+	cl_add_test(stopped, cl_create_test("dereferences NULL", dereferences_null, NULL));
+	cl_add_test(stopped, cl_create_test("divides by zero", divides_by_zero, NULL));
+	cl_add_test(stopped, cl_create_test("passes again", passes_test, NULL));
+	cl_add_test(stopped, cl_create_test("aborts", aborts, NULL));
+	cl_add_test(stopped, cl_create_test("runs after the third crash", runs_late, NULL));
+
+	// Every worker thread gets a stack to recover from an overflow on.
+	clarity_suite_t *parallel = cl_create_suite("Parallel crash recovery");
+	cl_suite_set_crash_recovery(parallel, true, 0);
+	cl_suite_set_jobs(parallel, 2);
+	for (int i = 0; i < 4; i++) {
+		cl_add_test(parallel, cl_create_test("overflows the stack", overflows_the_stack, NULL));
+		cl_add_test(parallel, cl_create_test("passes", passes_test, NULL));
+	}
+
+	bool stopped_passed  = cl_run_suite(stopped);
+	bool parallel_passed = cl_run_suite(parallel);
+	cl_free_suite(stopped);
+	cl_free_suite(parallel);
+
+	return !(!stopped_passed && !parallel_passed && atomic_load(&teardowns) == 5 && atomic_load(&late_runs) == 0
+	         && atomic_load(&passes) == 6);
+}
@@ -0,0 +1,130 @@
+#include <CLarity/clarity.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// One worker is taken down by the crashing test, so the other one has to connect to finish the run.
+#define WORKERS 2
+
+// Shared by the coordinator and the workers, which are forked processes.
+typedef struct counters_s {
+	atomic_uint runs[4];
+	atomic_uint crashes;
+} counters_t;
+
+static counters_t *counters;
+
+
+void counted(clarity_test_t *t, void *data) {
+	(void) t;
+	atomic_fetch_add(&counters->runs[(size_t) data], 1);
+}
+
+
+void failing(clarity_test_t *t, void *data) {
+	counted(t, data);
+	cl_fail_test(t, "expected failure");
+}
+
+
+void crashing_once(clarity_test_t *t, void *data) {
+	counted(t, data);
+	// Takes its worker down the first time, the coordinator must give it to another worker.
+	if (atomic_fetch_add(&counters->crashes, 1) == 0)
+		_exit(3);
+}
+
+
+void hanging(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	pause();
+}
+
+
+/**
+ * A worker stuck in a test does not hold the coordinator forever: its test is failed once the timeout is over.
+ */
+static bool stuck_worker_times_out(void) {
+	clarity_suite_t *stuck    = cl_create_suite("Distributed stuck suite");
+	clarity_suite_t *suites[] = { stuck };
+	cl_add_test(stuck, cl_create_test("hanging test", hanging, NULL));
+
+	char coordinator_option[80], worker_option[80];
+	snprintf(coordinator_option, sizeof coordinator_option, "--coordinator=unix:/tmp/clarity-stuck-%d.sock",
+	         (int) getpid());
+	snprintf(worker_option, sizeof worker_option, "--worker=unix:/tmp/clarity-stuck-%d.sock", (int) getpid());
+	char *coordinator_args[] = { "coordinator", coordinator_option, "--worker-timeout=1" };
+	char *worker_args[]      = { "worker", worker_option };
+
+	fflush(stdout);
+	pid_t worker = fork();
+	if (worker == 0)
+		_exit(cl_main(2, worker_args, suites, 1));
+
+	int coordinator_status = cl_main(3, coordinator_args, suites, 1);
+
+	int status;
+	kill(worker, SIGKILL);
+	waitpid(worker, &status, 0);
+	cl_free_suite(stuck);
+	return coordinator_status == 1;
+}
+
+
+int main() {
+	counters = mmap(NULL, sizeof(*counters), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (counters == MAP_FAILED)
+		return 1;
+
+	clarity_suite_t *first    = cl_create_suite("Distributed first suite");
+	clarity_suite_t *second   = cl_create_suite("Distributed second suite");
+	clarity_suite_t *suites[] = { first, second };
+
+	cl_add_test(first, cl_create_test("first test", counted, (void *) 0));
+	cl_add_test(first, cl_create_test("crashing test", crashing_once, (void *) 1));
+	cl_add_test(second, cl_create_test("failing test", failing, (void *) 2));
+	cl_add_test(second, cl_create_test("last test", counted, (void *) 3));
+
+	char coordinator_option[80], worker_option[80];
+	snprintf(coordinator_option, sizeof coordinator_option, "--coordinator=unix:/tmp/clarity-distributed-%d.sock",
+	         (int) getpid());
+	snprintf(worker_option, sizeof worker_option, "--worker=unix:/tmp/clarity-distributed-%d.sock", (int) getpid());
+	char *coordinator_args[] = { "coordinator", coordinator_option, "--batch=1" };
+	char *worker_args[]      = { "worker", worker_option, "--batch=1" };
+
+	fflush(stdout);
+	pid_t workers[WORKERS];
+	for (int i = 0; i < WORKERS; i++) {
+		workers[i] = fork();
+		if (workers[i] == 0)
+			_exit(cl_main(3, worker_args, suites, 2));
+	}
+
+	int coordinator_status = cl_main(3, coordinator_args, suites, 2);
+
+	int released = 0;
+	int crashed  = 0;
+	for (int i = 0; i < WORKERS; i++) {
+		int status;
+		waitpid(workers[i], &status, 0);
+		released += WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		crashed += WIFEXITED(status) && WEXITSTATUS(status) == 3;
+	}
+
+	bool ran_once = atomic_load(&counters->runs[0]) == 1 && atomic_load(&counters->runs[2]) == 1
+	                && atomic_load(&counters->runs[3]) == 1;
+	bool rescheduled = atomic_load(&counters->runs[1]) == 2;
+
+	cl_free_suite(first);
+	cl_free_suite(second);
+	munmap(counters, sizeof(*counters));
+
+	bool timed_out = stuck_worker_times_out();
+
+	return !(coordinator_status == 1 && released == WORKERS - 1 && crashed == 1 && ran_once && rescheduled &&
+	         timed_out);
+}
@@ -0,0 +1,191 @@
+#include <CLarity/clarity.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static atomic_int setups;
+static atomic_int teardowns;
+static atomic_int late_runs;
+static atomic_bool saw_cancellation;
+
+
+int count_setup(void *data) {
+	(void) data;
+	atomic_fetch_add(&setups, 1);
+	return 0;
+}
+
+
+int count_teardown(void *data) {
+	(void) data;
+	atomic_fetch_add(&teardowns, 1);
+	return 0;
+}
+
+
+void passes(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+}
+
+
+void fails(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_fail_test(t, "failed on purpose");
+}
+
+
+void late(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	atomic_fetch_add(&late_runs, 1);
+}
+
+
+void fails_soon(clarity_test_t *t, void *data) {
+	(void) data;
+	struct timespec delay = { .tv_nsec = 20000000 };
+	nanosleep(&delay, NULL);
+	cl_fail_test(t, "failed while another test was running");
+}
+
+
+void polls_cancellation(clarity_test_t *t, void *data) {
+	(void) data;
+	struct timespec delay = { .tv_nsec = 1000000 };
+	// A second at most, the failure of the other test cancels the run long before.
+	for (int i = 0; i < 1000; i++) {
+		if (cl_test_cancelled(t)) {
+			atomic_store(&saw_cancellation, true);
+			cl_skip_test(t, "cancelled");
+			return;
+		}
+		nanosleep(&delay, NULL);
+	}
+}
+
+
+void ignores_cancellation(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	struct timespec delay = { .tv_sec = 2 };
+	nanosleep(&delay, NULL);
+}
+
+
+void keep_waiting(clarity_test_t *t, clarity_async_t *async, void *data) {
+	(void) t;
+	(void) data;
+	cl_async_set_timer(async, 10000, keep_waiting, NULL);
+}
+
+
+static double elapsed_ms(const struct timespec *start) {
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (double) (end.tv_sec - start->tv_sec) * 1e3 + (double) (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+
+/**
+ * Runs a test ignoring the cancellation in a child, which the watchdog exits after summarising the run on stderr.
+ */
+static bool summarised_on_exit(void) {
+	int channel[2];
+	if (pipe(channel) != 0)
+		return false;
+
+	fflush(stdout);
+	pid_t child = fork();
+	if (child < 0)
+		return false;
+	if (child == 0) {
+		close(channel[0]);
+		dup2(channel[1], STDERR_FILENO);
+		clarity_suite_t *stuck = cl_create_suite("Stuck suite");
+		cl_suite_set_jobs(stuck, 2);
+		cl_add_test(stuck, cl_create_test("ignores the cancellation", ignores_cancellation, NULL));
+		cl_add_test(stuck, cl_create_test("fails soon", fails_soon, NULL));
+		cl_set_max_failures(1, 50);
+		cl_run_suite(stuck);
+		_exit(0);
+	}
+
+	char    text[512];
+	size_t  length = 0;
+	ssize_t got;
+	close(channel[1]);
+	while (length < sizeof text - 1 && (got = read(channel[0], text + length, sizeof text - 1 - length)) > 0)
+		length += (size_t) got;
+	text[length] = '\0';
+	close(channel[0]);
+
+	int status;
+	return waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 1 &&
+	       strstr(text, "stopped after 1 failure, 0 tests not run so far") && strstr(text, "did not stop within");
+}
+
+
+int main() {
+	struct timespec start;
+
+	// The run stops at the second failure: the last test is not run, and neither is the second suite, which is
+	// not even set up, but the first suite is still torn down.
+	clarity_suite_t *first  = cl_create_suite("Stopped suite");
+	clarity_suite_t *second = cl_create_suite("Suite not started");
+	cl_suite_register_teardown(first, count_teardown, NULL);
+	cl_add_test(first, cl_create_test("passes", passes, NULL));
+	cl_add_test(first, cl_create_test("first failure", fails, NULL));
+	cl_add_test(first, cl_create_test("second failure", fails, NULL));
+	cl_add_test(first, cl_create_test("after the limit", late, NULL));
+	cl_suite_register_setup(second, count_setup, NULL);
+	cl_add_test(second, cl_create_test("never runs", late, NULL));
+
+	cl_set_max_failures(2, 0);
+	clarity_suite_t *suites[] = { first, second };
+	bool stopped = !cl_run_suites(suites, 2);
+
+	// The cancellation is lifted once reported, the next run starts its tests.
+	clarity_suite_t *after = cl_create_suite("Run after the cancellation");
+	cl_add_test(after, cl_create_test("runs", late, NULL));
+	bool lifted = cl_run_suite(after) && late_runs == 1;
+
+	// A test running on another worker sees the cancellation and returns early.
+	clarity_suite_t *parallel = cl_create_suite("Cooperative cancellation");
+	cl_suite_set_jobs(parallel, 2);
+	cl_add_test(parallel, cl_create_test("long test", polls_cancellation, NULL));
+	cl_add_test(parallel, cl_create_test("fails soon", fails_soon, NULL));
+
+	cl_set_max_failures(1, 0);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	bool cancelled = !cl_run_suite(parallel);
+	double cooperative_ms = elapsed_ms(&start);
+
+	// An asynchronous test ignoring the cancellation is failed once the grace period is over.
+	clarity_suite_t *async = cl_create_suite("Grace period");
+	cl_add_test(async, cl_create_async_test("waits for ten seconds", keep_waiting, NULL, 20000));
+	cl_add_test(async, cl_create_test("fails", fails, NULL));
+
+	cl_set_max_failures(1, 50);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	bool stopped_async = !cl_run_suite(async);
+	double grace_ms = elapsed_ms(&start);
+
+	// Lifting the limit lets the suites run again.
+	cl_set_max_failures(0, 0);
+	bool resumed = cl_run_suite(second);
+
+	bool summarised = summarised_on_exit();
+
+	cl_free_suite(first);
+	cl_free_suite(second);
+	cl_free_suite(parallel);
+	cl_free_suite(async);
+	cl_free_suite(after);
+
+	return !(stopped && lifted && late_runs == 2 && setups == 1 && teardowns == 1 && cancelled && saw_cancellation &&
+	         cooperative_ms < 500 && stopped_async && grace_ms < 1000 && resumed && summarised);
+}
@@ -0,0 +1,110 @@
+#include <CLarity/clarity.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TABLE_SIZE 4096
+
+static int builds;
+
+
+void *build_table(size_t *size, void *data) {
+	uint32_t  seed  = *(uint32_t *) data;
+	uint32_t *table = malloc(TABLE_SIZE * sizeof(*table));
+	if (!table)
+		return NULL;
+
+	builds++;
+	for (uint32_t i = 0; i < TABLE_SIZE; i++)
+		table[i] = i * seed;
+	*size = TABLE_SIZE * sizeof(*table);
+	return table;
+}
+
+
+static bool check_table(const clarity_blob_t *blob, uint32_t seed) {
+	const uint32_t *table = blob->data;
+	if (blob->size != TABLE_SIZE * sizeof(*table))
+		return false;
+	for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+		if (table[i] != i * seed)
+			return false;
+	}
+	return true;
+}
+
+
+/**
+ * Leaves the temporary file another process would be writing the blob of the key to.
+ */
+static bool add_temporary(const char *dir, char *path, size_t size) {
+	DIR           *entries = opendir(dir);
+	struct dirent *entry   = NULL;
+	while (entries && (entry = readdir(entries)) && entry->d_name[0] == '.')
+		;
+	int length = entry ? snprintf(path, size, "%s/%s.99999.tmp", dir, entry->d_name) : -1;
+	if (entries)
+		closedir(entries);
+	if (length < 0 || (size_t) length >= size)
+		return false;
+
+	FILE *file = fopen(path, "w");
+	return file && fclose(file) == 0;
+}
+
+
+static int count_files(const char *dir) {
+	DIR *entries = opendir(dir);
+	int count    = 0;
+	for (struct dirent *entry; entries && (entry = readdir(entries));)
+		count += entry->d_name[0] != '.';
+	if (entries)
+		closedir(entries);
+	return count;
+}
+
+
+int main() {
+	char dir[] = "/tmp/clarity-cache-XXXXXX";
+	if (!mkdtemp(dir))
+		return 1;
+	setenv(CL_CACHE_DIR_ENV, dir, 1);
+
+	uint32_t            seed = 7;
+	clarity_cache_key_t key  = { .name = "lookup table", .version = 1, .input_hash = cl_cache_hash(&seed, 4, 0) };
+	clarity_blob_t      cold, warm, rebuilt;
+
+	// The first load builds the blob, the second one maps the cached file.
+	bool ok = cl_cache_load(&key, build_table, &seed, &cold) == CL_SUCCESS && check_table(&cold, seed);
+	ok &= cl_cache_load(&key, build_table, &seed, &warm) == CL_SUCCESS && check_table(&warm, seed);
+	ok &= builds == 1;
+
+	char temporary[512];
+	ok &= add_temporary(dir, temporary, sizeof temporary);
+
+	// Another input invalidates the cached blob, and replaces its file, but not the file being written by another
+	// process.
+	seed           = 13;
+	key.input_hash = cl_cache_hash(&seed, 4, 0);
+	ok &= cl_cache_load(&key, build_table, &seed, &rebuilt) == CL_SUCCESS && check_table(&rebuilt, seed);
+	ok &= builds == 2 && count_files(dir) == 2 && access(temporary, F_OK) == 0;
+
+	cl_cache_release(&cold);
+	cl_cache_release(&warm);
+	cl_cache_release(&rebuilt);
+
+	DIR *entries = opendir(dir);
+	for (struct dirent *entry; entries && (entry = readdir(entries));) {
+		char path[512];
+		int  length = snprintf(path, sizeof path, "%s/%s", dir, entry->d_name);
+		if (entry->d_name[0] != '.' && length > 0 && (size_t) length < sizeof path)
+			unlink(path);
+	}
+	if (entries)
+		closedir(entries);
+	rmdir(dir);
+
+	return !ok;
+}
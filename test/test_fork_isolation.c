@@ -0,0 +1,103 @@
+#include <CLarity/clarity.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define MUTATING_TESTS 5
+
+typedef struct fixture_s {
+	pid_t parent;
+	int   setups;
+	int   value;
+} fixture_t;
+
+static fixture_t   fixture;
+static atomic_uint *passes;
+static atomic_uint *batched_passes;
+
+
+int expensive_setup(void *data) {
+	(void) data;
+	fixture.parent = getpid();
+	fixture.setups++;
+	fixture.value = 42;
+	return 0;
+}
+
+
+void mutating(clarity_test_t *t, void *data) {
+	(void) data;
+
+	// Every test starts from the state left by the setup, whatever the previous tests did to it.
+	if (getpid() == fixture.parent || fixture.value != 42) {
+		cl_fail_test(t, "the test does not run in a fresh copy of the suite");
+		return;
+	}
+	fixture.value = 0;
+	atomic_fetch_add(passes, 1);
+}
+
+
+void batched(clarity_test_t *t, void *data) {
+	(void) t;
+	atomic_fetch_add(data ? (atomic_uint *) data : batched_passes, 1);
+}
+
+
+void crashing(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	abort();
+}
+
+
+void hanging(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	pause();
+}
+
+
+int main() {
+	passes = mmap(NULL, 3 * sizeof(*passes), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (passes == MAP_FAILED)
+		return 1;
+	batched_passes = passes + 1;
+	atomic_uint *after_hang = passes + 2;
+
+	clarity_suite_t *suite = cl_create_suite("Isolated suite");
+	cl_suite_register_setup(suite, expensive_setup, NULL);
+	cl_suite_set_isolation(suite, true, 1, 3);
+	for (int i = 0; i < MUTATING_TESTS; i++)
+		cl_add_test(suite, cl_create_test("mutating test", mutating, NULL));
+
+	// The crashing test takes its batch down, the test after it must be run by another process.
+	clarity_suite_t *batched_suite = cl_create_suite("Batched isolated suite");
+	cl_suite_set_isolation(batched_suite, true, 3, 0);
+	cl_add_test(batched_suite, cl_create_test("test before the crash", batched, NULL));
+	cl_add_test(batched_suite, cl_create_test("crashing test", crashing, NULL));
+	cl_add_test(batched_suite, cl_create_test("test after the crash", batched, NULL));
+
+	// The hanging test is killed once past the timeout, the test after it must be run by another process.
+	clarity_suite_t *hanging_suite = cl_create_suite("Hanging isolated suite");
+	cl_suite_set_isolation(hanging_suite, true, 2, 1);
+	cl_suite_set_isolation_timeout(hanging_suite, 100);
+	cl_add_test(hanging_suite, cl_create_test("hanging test", hanging, NULL));
+	cl_add_test(hanging_suite, cl_create_test("test after the hang", batched, after_hang));
+
+	bool result         = cl_run_suite(suite);
+	bool batched_result = cl_run_suite(batched_suite);
+	bool hanging_result = cl_run_suite(hanging_suite);
+
+	cl_free_suite(suite);
+	cl_free_suite(batched_suite);
+	cl_free_suite(hanging_suite);
+
+	bool isolated    = fixture.setups == 1 && fixture.value == 42 && atomic_load(passes) == MUTATING_TESTS;
+	bool rescheduled = atomic_load(batched_passes) == 2;
+	bool killed      = atomic_load(after_hang) == 1;
+	munmap(passes, 3 * sizeof(*passes));
+
+	return !(result && !batched_result && isolated && rescheduled && !hanging_result && killed);
+}
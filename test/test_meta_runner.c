@@ -0,0 +1,94 @@
+#include <CLarity/clarity.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "capture.h"
+
+#define BINARY_COUNT 4
+
+static const char *binaries[BINARY_COUNT] = { "pass_test", "fail_test", "crash_test", "hang_test" };
+
+
+void passes(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+}
+
+
+void fails(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_fail_test(t, "failed on purpose");
+}
+
+
+/**
+ * The binary plays the test binary it was started as, through a link named after it.
+ */
+static int run_as(const char *name) {
+	if (!strcmp(name, "crash_test"))
+		abort();
+	if (!strcmp(name, "hang_test"))
+		sleep(30);
+
+	bool            failing = !strcmp(name, "fail_test");
+	clarity_suite_t *suite  = cl_create_suite(failing ? "Failing suite" : "Passing suite");
+	cl_add_test(suite, cl_create_test("passes", passes, NULL));
+	cl_add_test(suite, cl_create_test(failing ? "fails" : "passes too", failing ? fails : passes, NULL));
+	bool passed = cl_run_suite(suite);
+	cl_free_suite(suite);
+	return !passed;
+}
+
+
+static int run_driver(void *argv) {
+	return cl_driver_main(4, argv);
+}
+
+
+int main(int argc, char **argv) {
+	(void) argc;
+	const char *name = strrchr(argv[0], '/');
+	name             = name ? name + 1 : argv[0];
+	for (size_t i = 0; i < BINARY_COUNT; i++) {
+		if (!strcmp(name, binaries[i]))
+			return run_as(name);
+	}
+
+	char self[PATH_MAX];
+	char directory[] = "/tmp/clarity-run-XXXXXX";
+	char links[BINARY_COUNT + 1][PATH_MAX + 32];
+	ssize_t length   = readlink("/proc/self/exe", self, sizeof self - 1);
+	if (length < 0 || !mkdtemp(directory))
+		return 1;
+	self[length] = '\0';
+	for (size_t i = 0; i < BINARY_COUNT; i++) {
+		snprintf(links[i], sizeof links[i], "%s/%s", directory, binaries[i]);
+		symlink(self, links[i]);
+	}
+	// Only the executables whose name matches are test binaries.
+	snprintf(links[BINARY_COUNT], sizeof links[BINARY_COUNT], "%s/helper", directory);
+	symlink(self, links[BINARY_COUNT]);
+
+	int  status;
+	char *driver_argv[] = { "clarity-run", "--jobs=4", "--timeout=1", directory, NULL };
+	char *output        = capture_stdout(run_driver, driver_argv, &status);
+	bool reported       = output && status == 1 && strstr(output, "4 test binaries, 3 failed") &&
+	                      strstr(output, "Total: 4 ") && strstr(output, "Failed: 1 ") &&
+	                      strstr(output, "pass_test] =====> PASS") && strstr(output, "1 of 2 tests failed") &&
+	                      strstr(output, "[Failing suite/fails] failed on purpose (test_meta_runner.c:") &&
+	                      strstr(output, "killed by signal 6") && strstr(output, "timed out after 1 s");
+	// The output of a binary which passed is not printed, the output of the others comes whole before their outcome.
+	const char *start    = output ? strstr(output, "Failing suite") : NULL;
+	const char *outcome  = output ? strstr(output, "fail_test] =====> FAIL") : NULL;
+	const char *other    = start ? strstr(start, directory) : NULL;
+	bool        captured = start && outcome && other && !strstr(output, "Passing suite") &&
+	                       other + strlen(directory) + 1 == outcome;
+
+	for (size_t i = 0; i <= BINARY_COUNT; i++)
+		unlink(links[i]);
+	rmdir(directory);
+	free(output);
+	return !(reported && captured);
+}
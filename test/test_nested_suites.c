@@ -0,0 +1,127 @@
+#include <CLarity/clarity.h>
+#include <stdbool.h>
+#include <string.h>
+
+static int  root_setups;
+static int  root_teardowns;
+static int  child_setups;
+static bool misordered;
+static char trace[8];
+
+
+int setup_root(void *data) {
+	(void) data;
+	root_setups++;
+	return 0;
+}
+
+
+int teardown_root(void *data) {
+	(void) data;
+	root_teardowns++;
+	return 0;
+}
+
+
+int setup_child(void *data) {
+	(void) data;
+	// The child is always set up inside its parent.
+	if (root_setups == root_teardowns)
+		misordered = true;
+	child_setups++;
+	return 0;
+}
+
+
+int enter_outer(void *data) {
+	(void) data;
+	strcpy(trace, "O");
+	return 0;
+}
+
+
+int enter_inner(void *data) {
+	(void) data;
+	strncat(trace, "I", sizeof trace - strlen(trace) - 1);
+	return 0;
+}
+
+
+void outer_test(clarity_test_t *t, void *data) {
+	(void) data;
+	if (strcmp(trace, "O"))
+		cl_fail_test(t, "the per-test fixtures of the root did not run alone");
+}
+
+
+void inner_test(clarity_test_t *t, void *data) {
+	(void) data;
+	if (strcmp(trace, "OI"))
+		cl_fail_test(t, "the per-test fixtures did not compose from the outermost suite");
+}
+
+
+int break_setup(void *data) {
+	(void) data;
+	return 1;
+}
+
+
+void passes(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+}
+
+
+void fails(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_fail_test(t, "expected failure");
+}
+
+
+int main() {
+	clarity_suite_t *root  = cl_create_suite("Root suite");
+	clarity_suite_t *child = cl_create_suite("Child suite");
+	clarity_suite_t *wide  = cl_create_suite("Parallel child suite");
+	clarity_suite_t *leaf  = cl_create_suite("Grandchild suite");
+
+	cl_suite_register_setup(root, setup_root, NULL);
+	cl_suite_register_teardown(root, teardown_root, NULL);
+	cl_suite_register_setup(child, setup_child, NULL);
+	cl_suite_add_fixture(root, cl_create_fixture(enter_outer, NULL, NULL, NULL));
+	cl_suite_add_fixture(child, cl_create_fixture(enter_inner, NULL, NULL, NULL));
+
+	cl_add_test(root, cl_create_test("outer", outer_test, NULL));
+	cl_add_test(child, cl_create_test("inner", inner_test, NULL));
+	cl_suite_set_jobs(wide, 4);
+	for (int i = 0; i < 8; i++)
+		cl_add_test(wide, cl_create_test("passes", passes, NULL));
+	cl_add_test(leaf, cl_create_test("passes", passes, NULL));
+
+	bool attached = cl_suite_add_child(root, child) == CL_SUCCESS && cl_suite_add_child(root, wide) == CL_SUCCESS
+	                && cl_suite_add_child(child, leaf) == CL_SUCCESS;
+	bool cycle    = cl_suite_add_child(leaf, root) == CL_ERROR_CYCLE && cl_suite_add_child(wide, leaf) == CL_ERROR_CYCLE;
+
+	bool passed = cl_run_suite(root);
+	bool shared = root_setups == 1 && root_teardowns == 1 && child_setups == 1;
+
+	// A nested suite run on its own is set up inside its ancestors, and a failure rolls up to them.
+	cl_add_test(leaf, cl_create_test("fails", fails, NULL));
+	bool alone  = !cl_run_suite(leaf) && root_setups == 2 && child_setups == 2 && root_teardowns == 2;
+	bool rolled = !cl_run_suite(root);
+
+	// A suite set up is torn down even when a nested suite stopped its run on a fixture error.
+	clarity_suite_t *holder = cl_create_suite("Set up suite");
+	clarity_suite_t *broken = cl_create_suite("Broken child suite");
+	cl_suite_register_setup(holder, setup_root, NULL);
+	cl_suite_register_teardown(holder, teardown_root, NULL);
+	cl_suite_add_fixture(broken, cl_create_fixture(break_setup, NULL, NULL, NULL));
+	cl_add_test(holder, cl_create_test("passes", passes, NULL));
+	cl_add_test(broken, cl_create_test("passes", passes, NULL));
+	cl_suite_add_child(holder, broken);
+	bool torn_down = !cl_run_suite(holder) && root_setups == 4 && root_teardowns == 4;
+
+	cl_free_suite(root);
+	cl_free_suite(holder);
+	return !(attached && cycle && passed && shared && alone && rolled && torn_down && !misordered);
+}
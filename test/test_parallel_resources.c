@@ -0,0 +1,104 @@
+#include <CLarity/clarity.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#define MEMORY_CAPACITY 4
+#define MEMORY_PER_TEST 2
+
+typedef struct usage_s {
+	atomic_int running;
+	atomic_int max_running;
+	atomic_int ports;
+	atomic_int memory;
+	bool       violated;
+} usage_t;
+
+static usage_t    usage;
+static atomic_int oversized_runs;
+
+
+static void __raise_max(atomic_int *max, int value) {
+	int seen = atomic_load(max);
+	while (value > seen && !atomic_compare_exchange_weak(max, &seen, value))
+		;
+}
+
+
+static void occupy(int port, int memory) {
+	__raise_max(&usage.max_running, atomic_fetch_add(&usage.running, 1) + 1);
+	if (atomic_fetch_add(&usage.ports, port) + port > 1
+	    || atomic_fetch_add(&usage.memory, memory) + memory > MEMORY_CAPACITY)
+		usage.violated = true;
+
+	usleep(20000);
+
+	atomic_fetch_sub(&usage.memory, memory);
+	atomic_fetch_sub(&usage.ports, port);
+	atomic_fetch_sub(&usage.running, 1);
+}
+
+
+void binds_port(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	occupy(1, 0);
+}
+
+
+void needs_memory(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	occupy(0, MEMORY_PER_TEST);
+}
+
+
+void unconstrained(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	occupy(0, 0);
+}
+
+
+void oversized(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	atomic_fetch_add(&oversized_runs, 1);
+}
+
+
+static clarity_test_t *with_need(clarity_test_t *test, const char *name, uint64_t amount) {
+	cl_test_require(test, name, amount);
+	return test;
+}
+
+
+int main() {
+	// The port tests come first: the others must overtake them rather than wait behind them.
+	clarity_suite_t *suite = cl_create_suite("Resource-aware parallel suite");
+	cl_suite_set_jobs(suite, 4);
+	cl_suite_add_resource(suite, "memory", MEMORY_CAPACITY);
+	for (int i = 0; i < 4; i++)
+		cl_add_test(suite, with_need(cl_create_test("binds port 8080", binds_port, NULL), "port 8080", 1));
+	for (int i = 0; i < 6; i++)
+		cl_add_test(suite, with_need(cl_create_test("needs memory", needs_memory, NULL), "memory", MEMORY_PER_TEST));
+	for (int i = 0; i < 6; i++)
+		cl_add_test(suite, cl_create_test("unconstrained", unconstrained, NULL));
+	bool result = cl_run_suite(suite);
+	cl_free_suite(suite);
+	bool packed = atomic_load(&usage.max_running) > 1;
+
+	// A suite-wide exclusive resource serialises every test of the suite.
+	atomic_store(&usage.max_running, 0);
+	clarity_suite_t *exclusive = cl_create_suite("Exclusive parallel suite");
+	cl_suite_set_jobs(exclusive, 4);
+	cl_suite_require(exclusive, "database", CL_RESOURCE_ALL);
+	for (int i = 0; i < 4; i++)
+		cl_add_test(exclusive, cl_create_test("unconstrained", unconstrained, NULL));
+	cl_add_test(exclusive, with_need(cl_create_test("oversized", oversized, NULL), "database", 2));
+	bool exclusive_result = cl_run_suite(exclusive);
+	cl_free_suite(exclusive);
+	bool serialised = atomic_load(&usage.max_running) == 1;
+
+	return !(result && packed && !usage.violated && !exclusive_result && serialised && !oversized_runs);
+}
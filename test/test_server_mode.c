@@ -0,0 +1,101 @@
+#include <CLarity/clarity.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Shared by the server, which is a forked process, and the client.
+typedef struct counters_s {
+	atomic_uint suite_setups;
+	atomic_uint suite_teardowns;
+	atomic_uint test_setups;
+	atomic_uint runs;
+} counters_t;
+
+static counters_t *counters;
+
+
+int suite_setup(void *data) {
+	(void) data;
+	atomic_fetch_add(&counters->suite_setups, 1);
+	return 0;
+}
+
+
+int suite_teardown(void *data) {
+	(void) data;
+	atomic_fetch_add(&counters->suite_teardowns, 1);
+	return 0;
+}
+
+
+int test_setup(void *data) {
+	(void) data;
+	atomic_fetch_add(&counters->test_setups, 1);
+	return 0;
+}
+
+
+void passing(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	atomic_fetch_add(&counters->runs, 1);
+}
+
+
+void failing(clarity_test_t *t, void *data) {
+	(void) data;
+	atomic_fetch_add(&counters->runs, 1);
+	cl_fail_test(t, "expected failure");
+}
+
+
+int main() {
+	counters = mmap(NULL, sizeof(*counters), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (counters == MAP_FAILED)
+		return 1;
+
+	clarity_suite_t *suite    = cl_create_suite("Server suite");
+	clarity_suite_t *suites[] = { suite };
+
+	cl_suite_register_setup(suite, suite_setup, NULL);
+	cl_suite_register_teardown(suite, suite_teardown, NULL);
+	cl_suite_add_fixture(suite, cl_create_fixture(test_setup, NULL, NULL, NULL));
+	cl_add_test(suite, cl_create_test("quick test", passing, NULL));
+	cl_add_test(suite, cl_create_test("other test", passing, NULL));
+	cl_add_test(suite, cl_create_test("broken test", failing, NULL));
+
+	char address[64], serve_option[80];
+	snprintf(address, sizeof address, "unix:/tmp/clarity-server-%d.sock", (int) getpid());
+	snprintf(serve_option, sizeof serve_option, "--serve=%s", address);
+
+	fflush(stdout);
+	pid_t server = fork();
+	if (server == 0) {
+		char *server_args[] = { "server", serve_option };
+		_exit(cl_main(2, server_args, suites, 1));
+	}
+
+	char *quick[] = { "clarity-client", address, "--test=quick*" };
+	char *all[]   = { "clarity-client", address };
+	char *stop[]  = { "clarity-client", address, "--stop" };
+
+	int first_status  = cl_client_main(3, quick);
+	int second_status = cl_client_main(3, quick);
+	int all_status    = cl_client_main(2, all);
+	int stop_status   = cl_client_main(3, stop);
+
+	int server_status;
+	waitpid(server, &server_status, 0);
+
+	// The suite is set up once for all the requests, the per-test fixtures run for every test.
+	bool warm = atomic_load(&counters->suite_setups) == 1 && atomic_load(&counters->suite_teardowns) == 1
+	            && atomic_load(&counters->test_setups) == 5 && atomic_load(&counters->runs) == 5;
+
+	cl_free_suite(suite);
+	munmap(counters, sizeof(*counters));
+
+	return !(first_status == 0 && second_status == 0 && all_status == 1 && stop_status == 0 && warm
+	         && WIFEXITED(server_status) && WEXITSTATUS(server_status) == 0);
+}
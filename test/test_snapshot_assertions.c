@@ -0,0 +1,80 @@
+#include <CLarity/clarity.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SNAPSHOT_NAME "render/frame"
+
+typedef struct step_s {
+	const char *output;
+	bool       matches;
+} step_t;
+
+static int unexpected;
+
+
+void check_output(clarity_test_t *t, void *data) {
+	step_t *step = data;
+	if (cl_assert_snapshot(t, step->output, strlen(step->output), SNAPSHOT_NAME) != step->matches)
+		unexpected++;
+}
+
+
+static void run_step(const char *output, bool matches, bool update) {
+	if (update)
+		setenv(CL_UPDATE_SNAPSHOTS_ENV, "1", 1);
+	else
+		unsetenv(CL_UPDATE_SNAPSHOTS_ENV);
+
+	step_t          step  = { output, matches };
+	clarity_suite_t *suite = cl_create_suite("Snapshot assertions");
+	cl_add_test(suite, cl_create_test(output, check_output, &step));
+	if (cl_run_suite(suite) != matches)
+		unexpected++;
+	cl_free_suite(suite);
+}
+
+
+int main() {
+	char dir[] = "/tmp/clarity-snapshots-XXXXXX";
+	if (!mkdtemp(dir))
+		return 1;
+	setenv(CL_SNAPSHOT_DIR_ENV, dir, 1);
+
+	char snapshot[256];
+	snprintf(snapshot, sizeof snapshot, "%s/" SNAPSHOT_NAME ".snap", dir);
+
+	// A missing snapshot fails, unless it is being recorded.
+	run_step("first frame", false, false);
+	run_step("first frame", true, true);
+	run_step("first frame", true, false);
+	run_step("second frame", false, false);
+
+	// A snapshot edited after its sidecar is compared in full, not trusted on the stale hash.
+	FILE *file = fopen(snapshot, "w");
+	if (!file)
+		return 1;
+	fputs("edited frame", file);
+	fclose(file);
+	struct timespec later[2] = { { .tv_nsec = UTIME_OMIT }, { .tv_sec = time(NULL) + 60 } };
+	utimensat(AT_FDCWD, snapshot, later, 0);
+	run_step("first frame", false, false);
+	run_step("edited frame", true, false);
+
+	// Updating rewrites a differing snapshot.
+	run_step("third frame", true, true);
+	run_step("third frame", true, false);
+	run_step("edited frame", false, false);
+
+	char sidecar[300];
+	snprintf(sidecar, sizeof sidecar, "%s.hash", snapshot);
+	bool cleaned = unlink(sidecar) == 0 && unlink(snapshot) == 0;
+	snprintf(snapshot, sizeof snapshot, "%s/render", dir);
+	cleaned &= rmdir(snapshot) == 0 && rmdir(dir) == 0;
+
+	return !(cleaned && !unexpected);
+}
@@ -0,0 +1,81 @@
+#include <CLarity/clarity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "capture.h"
+
+typedef struct row_s {
+	const char *input;
+	int        length;
+} row_t;
+
+static const row_t rows[] = {
+	{ "", 0 }, { "a", 1 }, { "ab", 3 }, { "abc", 3 }, { "abcd", 5 }, { "abcde", 5 }, { "abcdef", 7 },
+};
+
+
+void table(clarity_test_t *t, void *data) {
+	(void) data;
+	for (size_t i = 0; i < sizeof rows / sizeof *rows; i++)
+		cl_expectf(t, (int) strlen(rows[i].input) == rows[i].length, "row %zu: '%s'", i, rows[i].input);
+}
+
+
+void typed_checks(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_expect_int_eq(t, -2 * 3, -6);
+	cl_expect_uint_eq(t, sizeof(uint32_t), 4);
+	cl_expect_str_eq(t, "abc", "abc");
+	cl_expect_near(t, 0.1 + 0.2, 0.3, 1e-12);
+	cl_expect(t, 1 + 1 == 2);
+}
+
+
+void capped(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_test_set_max_expectations(t, 2);
+	for (int i = 0; i < 5; i++)
+		cl_expect_int_eq(t, i, -1);
+}
+
+
+void skipped_after_failing(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_expect_str_eq(t, "left", NULL);
+	cl_skip_test(t, "skipped");
+}
+
+
+void failed_after_expecting(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_expect(t, 1 > 2);
+	cl_fail_test(t, "hard failure");
+}
+
+
+int main() {
+	bool passed;
+
+	clarity_suite_t *passing = cl_create_suite("Expectations met");
+	cl_add_test(passing, cl_create_test("typed checks", typed_checks, NULL));
+	bool met = cl_run_suite(passing);
+
+	clarity_suite_t *failing = cl_create_suite("Expectations failed");
+	cl_add_test(failing, cl_create_test("table", table, NULL));
+	cl_add_test(failing, cl_create_test("capped", capped, NULL));
+	cl_add_test(failing, cl_create_test("skipped after failing", skipped_after_failing, NULL));
+	cl_add_test(failing, cl_create_test("failed after expecting", failed_after_expecting, NULL));
+	char *output = run_captured(failing, &passed);
+
+	bool reported = output && !passed && strstr(output, "3 expectations failed") && strstr(output, "row 2: 'ab'") &&
+	                strstr(output, "row 4: 'abcd'") && strstr(output, "row 6: 'abcdef'") &&
+	                strstr(output, "5 expectations failed") && strstr(output, "+3 more") &&
+	                strstr(output, "got \"left\" and NULL") && strstr(output, "hard failure\n  1 expectation failed") &&
+	                strstr(output, "Failed: 4 ");
+
+	free(output);
+	cl_free_suite(passing);
+	cl_free_suite(failing);
+	return !(met && reported);
+}
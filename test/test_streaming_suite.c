@@ -0,0 +1,53 @@
+#include <CLarity/clarity.h>
+#include <stdlib.h>
+#include <string.h>
+#include "capture.h"
+
+#define GENERATED_TESTS 100000
+#define FAILURE_MESSAGE "every 10000th generated test should fail"
+
+
+void generated(clarity_test_t *t, void *data) {
+	size_t index = (size_t) (uintptr_t) data;
+
+	if (index % 10000 == 9999)
+		cl_fail_test(t, FAILURE_MESSAGE);
+}
+
+
+void registered(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+}
+
+
+clarity_test_t *generate(size_t index, void *data) {
+	(void) data;
+	return cl_create_test("generated test", generated, (void *) (uintptr_t) index);
+}
+
+
+int main() {
+	clarity_suite_t *suite = cl_create_suite("Streaming suite");
+
+	cl_add_test(suite, cl_create_test("registered test", registered, NULL));
+	cl_suite_set_generator(suite, GENERATED_TESTS, generate, NULL);
+	cl_suite_set_streaming(suite, true, 4, CL_DEFAULT_STREAM_MAX_SLOWEST);
+
+	bool passed;
+	char *output = run_captured(suite, &passed);
+
+	// Every failure is printed as it happens, but only the first ones are kept in memory for the summary.
+	const char *summary = output ? strstr(output, "Failures:") : NULL;
+	int        listed   = 0;
+	for (const char *next = summary; next && (next = strstr(next, FAILURE_MESSAGE)); next++)
+		listed++;
+	bool reported = summary && !passed && listed == 4 && strstr(output, "+6 more") &&
+	                strstr(output, "Total: 100001 ") && strstr(output, "Succeeded: 99991 ") &&
+	                strstr(output, "Failed: 10 ");
+
+	free(output);
+	cl_free_suite(suite);
+
+	return !reported;
+}
@@ -0,0 +1,38 @@
+#include <CLarity/clarity.h>
+#include <stdatomic.h>
+
+static atomic_uint runs;
+
+
+void flaky(clarity_test_t *t, void *data) {
+	(void) data;
+
+	// Fails once, on the 37th run, like a race showing up once in a while.
+	if (atomic_fetch_add(&runs, 1) == 36)
+		cl_fail_test(t, "lost an update");
+}
+
+
+void stable(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+}
+
+
+int main() {
+	clarity_suite_t *suite    = cl_create_suite("Stress mode");
+	clarity_suite_t *suites[] = { suite };
+
+	cl_add_test(suite, cl_create_test("flaky test", flaky, NULL));
+	cl_add_test(suite, cl_create_test("stable test", stable, NULL));
+
+	char *repeat_stable[] = { "stress", "--test=Stress mode/stable*", "--repeat=100", "--concurrency=4", "--pin" };
+	char *until_failure[] = { "stress", "--test=flaky*", "--until-failure", "--repeat=1000", "--concurrency=4" };
+
+	int stable_status = cl_main(5, repeat_stable, suites, 1);
+	int flaky_status  = cl_main(5, until_failure, suites, 1);
+
+	cl_free_suite(suite);
+
+	return !(stable_status == 0 && flaky_status == 1 && atomic_load(&runs) < 1000 * 4);
+}
@@ -0,0 +1,78 @@
+#include <CLarity/clarity.h>
+#include <stdint.h>
+#include <string.h>
+
+static char trace[16];
+static void *first_buffer[2];
+static int  buffer_index;
+
+
+static void record(void *data) {
+	strncat(trace, data, sizeof trace - strlen(trace) - 1);
+}
+
+
+void fails_early(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_test_defer(t, record, "a");
+	char *buffer = cl_test_alloc(t, 100, 0);
+	first_buffer[buffer_index++] = buffer;
+	cl_test_defer(t, record, "b");
+
+	double *aligned = cl_test_alloc(t, 3 * sizeof(double), 64);
+	if (!buffer || !aligned || (uintptr_t) aligned % 64 != 0) {
+		cl_fail_test(t, "the arena did not honour the alignment");
+		return;
+	}
+	if (cl_test_alloc(t, 8, 3)) {
+		cl_fail_test(t, "an alignment which is not a power of two was accepted");
+		return;
+	}
+
+	// Larger than a region, and the allocations around it still come from the current one.
+	char *large = cl_test_alloc(t, 1u << 20, 0);
+	char *after = cl_test_alloc(t, 16, 1);
+	if (!large || !after || after < (char *) (aligned + 3) || after > (char *) (aligned + 3) + 16) {
+		cl_fail_test(t, "the large allocation did not get a region of its own");
+		return;
+	}
+	memset(large, 0xa5, 1u << 20);
+
+	cl_fail_test(t, "expected failure, the cleanups still run");
+}
+
+
+void skips(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_test_defer(t, record, "c");
+	first_buffer[buffer_index++] = cl_test_alloc(t, 100, 0);
+	cl_skip_test(t, "the cleanups run for skipped tests too");
+}
+
+
+void complete(clarity_test_t *t, clarity_async_t *async, void *data) {
+	(void) t;
+	(void) data;
+	cl_async_done(async);
+}
+
+
+void completes_later(clarity_test_t *t, clarity_async_t *async, void *data) {
+	(void) data;
+	cl_test_defer(t, record, "d");
+	cl_async_set_timer(async, 1, complete, NULL);
+}
+
+
+int main() {
+	clarity_suite_t *suite = cl_create_suite("Test arena");
+	cl_add_test(suite, cl_create_test("fails early", fails_early, NULL));
+	cl_add_test(suite, cl_create_test("skips", skips, NULL));
+	cl_add_test(suite, cl_create_async_test("completes later", completes_later, NULL, 0));
+
+	bool passed = cl_run_suite(suite);
+	cl_free_suite(suite);
+
+	// The second test reuses the region released by the first one on the same thread.
+	return !(!passed && strcmp(trace, "bacd") == 0 && first_buffer[0] == first_buffer[1]);
+}
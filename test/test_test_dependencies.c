@@ -0,0 +1,102 @@
+#include <CLarity/clarity.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+static atomic_int dependent_runs;
+static atomic_int clock_ticks;
+static atomic_int schema_tick;
+static atomic_int query_tick;
+static bool       out_of_order;
+
+
+void fails(clarity_test_t *t, void *data) {
+	(void) data;
+	cl_fail_test(t, "the setup failed");
+}
+
+
+void must_not_run(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	atomic_fetch_add(&dependent_runs, 1);
+}
+
+
+void creates_schema(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	usleep(10000);
+	atomic_store(&schema_tick, atomic_fetch_add(&clock_ticks, 1) + 1);
+}
+
+
+void queries(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	if (!atomic_load(&schema_tick))
+		out_of_order = true;
+	atomic_store(&query_tick, atomic_fetch_add(&clock_ticks, 1) + 1);
+}
+
+
+void passes(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+}
+
+
+static bool run_ordered(size_t jobs) {
+	atomic_store(&schema_tick, 0);
+	atomic_store(&query_tick, 0);
+
+	// The dependents come first, the runner must hold them back until the schema exists.
+	clarity_suite_t *suite  = cl_create_suite("Ordered suite");
+	clarity_test_t  *schema = cl_create_test("creates schema", creates_schema, NULL);
+	cl_suite_set_jobs(suite, jobs);
+	for (int i = 0; i < 4; i++) {
+		clarity_test_t *query = cl_create_test("queries", queries, NULL);
+		cl_test_depends_on(query, schema);
+		cl_add_test(suite, query);
+	}
+	cl_add_test(suite, schema);
+	bool passed = cl_run_suite(suite);
+	cl_free_suite(suite);
+	return passed && atomic_load(&query_tick) > atomic_load(&schema_tick);
+}
+
+
+int main() {
+	// A failing prerequisite skips its dependents, and theirs, without running them.
+	clarity_suite_t *failing = cl_create_suite("Failing prerequisite");
+	clarity_test_t  *setup   = cl_create_test("fails", fails, NULL);
+	cl_suite_set_jobs(failing, 4);
+	clarity_test_t  *first   = cl_create_test("dependent", must_not_run, NULL);
+	clarity_test_t  *second  = cl_create_test("transitive dependent", must_not_run, NULL);
+	cl_test_depends_on(first, setup);
+	cl_test_depends_on(second, first);
+	bool cycle = cl_test_depends_on(setup, second) == CL_ERROR_CYCLE;
+	cl_add_test(failing, second);
+	cl_add_test(failing, first);
+	cl_add_test(failing, setup);
+
+	// A suite whose prerequisite suite failed is skipped as a whole, it is moved after it to find out.
+	clarity_suite_t *dependent = cl_create_suite("Dependent suite");
+	clarity_suite_t *unrelated = cl_create_suite("Unrelated suite");
+	cl_add_test(dependent, cl_create_test("dependent", must_not_run, NULL));
+	cl_add_test(unrelated, cl_create_test("passes", passes, NULL));
+	cl_suite_depends_on(dependent, failing);
+	bool suite_cycle = cl_suite_depends_on(failing, dependent) == CL_ERROR_CYCLE;
+
+	clarity_suite_t *suites[] = { dependent, unrelated, failing };
+	bool            all       = cl_run_suites(suites, sizeof(suites) / sizeof(*suites));
+	cl_free_suite(dependent);
+	cl_free_suite(unrelated);
+	cl_free_suite(failing);
+
+	bool sequential = run_ordered(1);
+	bool parallel   = run_ordered(4);
+
+	return !(cycle && suite_cycle && sequential && parallel && !out_of_order && !all
+	         && !atomic_load(&dependent_runs));
+}
@@ -0,0 +1,182 @@
+#include <CLarity/clarity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "capture.h"
+
+static char trace[16];
+static int  late_runs;
+
+
+static void record(const char *mark) {
+	strncat(trace, mark, sizeof trace - strlen(trace) - 1);
+}
+
+
+void stable(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	record("s");
+}
+
+
+void slow(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	record("S");
+}
+
+
+void flaky(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	record("f");
+}
+
+
+void fresh(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	record("n");
+}
+
+
+void sleeper(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	usleep(20000);
+}
+
+
+void late(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	late_runs++;
+}
+
+
+typedef struct main_args_s {
+	char            **argv;
+	clarity_suite_t *suite;
+} main_args_t;
+
+
+static int run_main(void *data) {
+	main_args_t *args = data;
+	return cl_main(3, args->argv, &args->suite, 1);
+}
+
+
+/**
+ * Runs the suites as directed by the arguments, and keeps the last report, which is the one of the root suite.
+ */
+static int run_reported(char **argv, clarity_suite_t *suite, char *report, size_t size) {
+	main_args_t args   = { argv, suite };
+	int         status = -1;
+	char        *text  = capture_stdout(run_main, &args, &status);
+
+	const char *total = NULL;
+	for (const char *next = text; next && (next = strstr(next, "Total:")); next++)
+		total = next;
+	const char *line = total;
+	while (line && line > text && line[-1] != '\n')
+		line--;
+	report[0] = '\0';
+	if (line)
+		snprintf(report, size, "%.*s", (int) strcspn(line, "\n"), line);
+	free(text);
+	return status;
+}
+
+
+static bool write_history(const char *path, const char *content) {
+	FILE *file = fopen(path, "w");
+	if (!file)
+		return false;
+	fputs("# CLarity history v1\n", file);
+	fputs(content, file);
+	return fclose(file) == 0;
+}
+
+
+static bool history_contains(const char *path, const char *line) {
+	char  text[1024] = { 0 };
+	FILE  *file      = fopen(path, "r");
+	if (!file)
+		return false;
+	size_t len = fread(text, 1, sizeof text - 1, file);
+	fclose(file);
+	text[len] = '\0';
+	return strstr(text, line) != NULL;
+}
+
+
+int main() {
+	char dir[] = "/tmp/clarity-budget-XXXXXX";
+	if (!mkdtemp(dir))
+		return 1;
+	char ranked_path[64], late_path[64], nested_path[64];
+	snprintf(ranked_path, sizeof ranked_path, "%s/ranked.tsv", dir);
+	snprintf(late_path, sizeof late_path, "%s/late.tsv", dir);
+	snprintf(nested_path, sizeof nested_path, "%s/nested.tsv", dir);
+
+	// The slow test cannot fit, the new and the recently failing tests are the most likely to fail.
+	bool written = write_history(ranked_path, "Budget suite\tstable\t64\t0\t1000000\n"
+	                                          "Budget suite\tslow\t64\t0\t5000000000\n"
+	                                          "Budget suite\tflaky\t10\t5\t1000000\n")
+	               && write_history(late_path, "Late suite\tsleeper\t64\t0\t1\n"
+	                                           "Late suite\tlate\t64\t0\t1\n")
+	               && write_history(nested_path, "Root suite\tstable\t64\t0\t1000000\n"
+	                                             "Nested suite\tslow\t64\t0\t5000000000\n"
+	                                             "Nested suite\tslow too\t64\t0\t5000000000\n");
+
+	clarity_suite_t *suite = cl_create_suite("Budget suite");
+	cl_add_test(suite, cl_create_test("stable", stable, NULL));
+	cl_add_test(suite, cl_create_test("slow", slow, NULL));
+	cl_add_test(suite, cl_create_test("flaky", flaky, NULL));
+	cl_add_test(suite, cl_create_test("fresh", fresh, NULL));
+
+	char budget_arg[]  = "--budget=1000";
+	char history_arg[96];
+	snprintf(history_arg, sizeof history_arg, "--history=%s", ranked_path);
+	char *argv[]       = { "test_time_budget", budget_arg, history_arg, NULL };
+	int  status        = cl_main(3, argv, &suite, 1);
+	cl_free_suite(suite);
+
+	bool ranked   = status == 0 && !strcmp(trace, "nfs");
+	bool recorded = history_contains(ranked_path, "Budget suite\tfresh\t1\t0\t")
+	                && history_contains(ranked_path, "Budget suite\tslow\t64\t0\t5000000000\n");
+
+	// The second test is predicted to fit, but the budget runs out while the first one sleeps.
+	clarity_suite_t *sleepy = cl_create_suite("Late suite");
+	cl_add_test(sleepy, cl_create_test("sleeper", sleeper, NULL));
+	cl_add_test(sleepy, cl_create_test("late", late, NULL));
+
+	char short_budget_arg[] = "--budget=5";
+	snprintf(history_arg, sizeof history_arg, "--history=%s", late_path);
+	argv[1]                 = short_budget_arg;
+	int late_status         = cl_main(3, argv, &sleepy, 1);
+	cl_free_suite(sleepy);
+
+	// The tests of a nested suite left out by the budget are counted in the report of its parent.
+	clarity_suite_t *root   = cl_create_suite("Root suite");
+	clarity_suite_t *nested = cl_create_suite("Nested suite");
+	cl_add_test(root, cl_create_test("stable", stable, NULL));
+	cl_add_test(nested, cl_create_test("slow", slow, NULL));
+	cl_add_test(nested, cl_create_test("slow too", slow, NULL));
+	cl_suite_add_child(root, nested);
+
+	char report[256];
+	snprintf(history_arg, sizeof history_arg, "--history=%s", nested_path);
+	argv[1]           = budget_arg;
+	int  tree_status  = run_reported(argv, root, report, sizeof report);
+	bool rolled_up    = tree_status == 0 && strstr(report, "Total: 3 ") && strstr(report, "Not run: 2 ");
+	cl_free_suite(root);
+
+	unlink(ranked_path);
+	unlink(late_path);
+	unlink(nested_path);
+	rmdir(dir);
+	return !(written && ranked && recorded && late_status == 0 && !late_runs && rolled_up);
+}
@@ -0,0 +1,101 @@
+#include <CLarity/clarity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_PATH "clarity-trace-test.json"
+
+
+int setup(void *data) {
+	(void) data;
+	return 0;
+}
+
+
+int teardown(void *data) {
+	(void) data;
+	return 0;
+}
+
+
+void work(clarity_test_t *t, void *data) {
+	(void) t;
+	(void) data;
+	usleep(1000);
+}
+
+
+void complete(clarity_test_t *t, clarity_async_t *async, void *data) {
+	(void) t;
+	(void) data;
+	cl_async_done(async);
+}
+
+
+void wait_a_bit(clarity_test_t *t, clarity_async_t *async, void *data) {
+	(void) t;
+	(void) data;
+	cl_async_set_timer(async, 1, complete, NULL);
+}
+
+
+static char *read_trace(void) {
+	FILE *file = fopen(TRACE_PATH, "r");
+	if (!file)
+		return NULL;
+
+	static char content[1 << 16];
+	size_t      len = fread(content, 1, sizeof content - 1, file);
+	content[len] = '\0';
+	fclose(file);
+	return content;
+}
+
+
+int main() {
+	clarity_suite_t *suite = cl_create_suite("Traced");
+	cl_suite_register_setup(suite, setup, NULL);
+	cl_suite_register_teardown(suite, teardown, NULL);
+	cl_suite_add_fixture(suite, cl_create_fixture(setup, NULL, teardown, NULL));
+	cl_suite_set_jobs(suite, 2);
+	for (int i = 0; i < 4; i++)
+		cl_add_test(suite, cl_create_test("a \"quoted\" test", work, NULL));
+	cl_add_test(suite, cl_create_async_test("waits a bit", wait_a_bit, NULL, 0));
+
+	cl_trace_start();
+	bool passed = cl_run_suite(suite);
+	bool written = cl_trace_stop(TRACE_PATH) == CL_SUCCESS;
+	// Nothing is recorded once stopped.
+	cl_run_suite(suite);
+	cl_free_suite(suite);
+
+	char *trace = read_trace();
+	remove(TRACE_PATH);
+	if (!passed || !written || !trace)
+		return 1;
+
+	const char *expected[] = {
+		"\"traceEvents\":[",
+		"{\"name\":\"suite setup Traced\",\"cat\":\"fixture\"",
+		"{\"name\":\"suite teardown Traced\",\"cat\":\"fixture\"",
+		"{\"name\":\"setup Traced\",\"cat\":\"fixture\"",
+		"{\"name\":\"a \\\"quoted\\\" test\",\"cat\":\"test\"",
+		"{\"name\":\"waits a bit\",\"cat\":\"async\",\"pid\":1,\"tid\":1,\"ph\":\"b\"",
+		"{\"name\":\"Traced\",\"cat\":\"report\"",
+		"\"args\":{\"name\":\"main\"}",
+		"\"args\":{\"name\":\"worker ",
+	};
+	for (size_t i = 0; i < sizeof expected / sizeof *expected; i++) {
+		if (!strstr(trace, expected[i])) {
+			fprintf(stderr, "missing from the timeline: %s\n", expected[i]);
+			return 1;
+		}
+	}
+
+	// Four tests, recorded once.
+	size_t tests = 0;
+	for (const char *at = trace; (at = strstr(at, "\"cat\":\"test\"")); at++)
+		tests++;
+	return tests != 4;
+}
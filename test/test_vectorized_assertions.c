@@ -0,0 +1,155 @@
+#include <CLarity/clarity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_BYTES 130
+#define MAX_ELEMENTS 40
+
+static unsigned missed;
+static unsigned detected;
+static unsigned expected_detections;
+
+
+static float next_float(float value, uint32_t steps) {
+	// Positive floats are ordered like their bits.
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof bits);
+	bits += steps;
+	memcpy(&value, &bits, sizeof bits);
+	return value;
+}
+
+
+void equal_buffers(clarity_test_t *t, void *data) {
+	(void) data;
+	unsigned char a[MAX_BYTES], b[MAX_BYTES];
+	for (size_t i = 0; i < MAX_BYTES; i++)
+		a[i] = b[i] = (unsigned char) (i * 31 + 7);
+
+	// Every size, so that each kernel goes through its vector loop and its tail.
+	for (size_t size = 0; size <= MAX_BYTES; size++) {
+		if (!cl_assert_mem_eq(t, a, b, size))
+			return;
+	}
+}
+
+
+void close_arrays(clarity_test_t *t, void *data) {
+	(void) data;
+	float  a[MAX_ELEMENTS], b[MAX_ELEMENTS];
+	double c[MAX_ELEMENTS], d[MAX_ELEMENTS];
+	for (size_t i = 0; i < MAX_ELEMENTS; i++) {
+		a[i] = (float) i * 1.5f + 0.5f;
+		b[i] = next_float(a[i], 3);
+		c[i] = a[i] * 1000.0;
+		d[i] = c[i] + 1e-3;
+	}
+	a[5] = b[5] = NAN;
+	a[6]        = -0.0f;
+	b[6]        = 0.0f;
+
+	for (size_t count = 0; count <= MAX_ELEMENTS; count++) {
+		if (!cl_assert_float_array_near(t, a, b, count, (clarity_float_tolerance_t) { .ulps = 3 })
+		    || !cl_assert_float_array_near(t, a, b, count, (clarity_float_tolerance_t) { .relative = 1e-5 })
+		    || !cl_assert_double_array_near(t, c, d, count, (clarity_float_tolerance_t) { .absolute = 2e-3 }))
+			return;
+	}
+}
+
+
+void differences(clarity_test_t *t, void *data) {
+	(void) data;
+	unsigned char a[MAX_BYTES], b[MAX_BYTES];
+	for (size_t i = 0; i < MAX_BYTES; i++)
+		a[i] = b[i] = (unsigned char) i;
+
+	for (size_t size = 1; size <= MAX_BYTES; size++) {
+		for (size_t at = 0; at < size; at++) {
+			b[at] ^= 0x10;
+			expected_detections++;
+			if (cl_assert_mem_eq(t, a, b, size))
+				missed++;
+			else
+				detected++;
+			b[at] ^= 0x10;
+		}
+	}
+
+	float  x[MAX_ELEMENTS], y[MAX_ELEMENTS];
+	double z[MAX_ELEMENTS], w[MAX_ELEMENTS];
+	for (size_t i = 0; i < MAX_ELEMENTS; i++) {
+		x[i] = y[i] = (float) i + 0.25f;
+		z[i] = w[i] = (double) i * 3.0;
+	}
+
+	for (size_t count = 1; count <= MAX_ELEMENTS; count++) {
+		for (size_t at = 0; at < count; at++) {
+			float  saved_float  = y[at];
+			double saved_double = w[at];
+			bool   found        = true;
+
+			y[at] = next_float(saved_float, 5);
+			found &= !cl_assert_float_array_near(t, x, y, count, (clarity_float_tolerance_t) { .ulps = 4 });
+			y[at] = NAN;
+			found &= !cl_assert_float_array_near(t, x, y, count, (clarity_float_tolerance_t) { .relative = 1.0 });
+			y[at] = saved_float;
+
+			w[at] = saved_double + 0.5;
+			found &= !cl_assert_double_array_near(t, z, w, count, (clarity_float_tolerance_t) { .absolute = 0.25 });
+			w[at] = saved_double;
+
+			expected_detections++;
+			if (found)
+				detected++;
+			else
+				missed++;
+		}
+	}
+}
+
+
+static int run_with_level(const char *level) {
+	setenv(CL_SIMD_ENV, level, 1);
+
+	clarity_suite_t *passing = cl_create_suite("Vectorized assertions passing");
+	cl_add_test(passing, cl_create_test("equal buffers", equal_buffers, NULL));
+	cl_add_test(passing, cl_create_test("close arrays", close_arrays, NULL));
+
+	clarity_suite_t *failing = cl_create_suite("Vectorized assertions failing");
+	cl_add_test(failing, cl_create_test("differences", differences, NULL));
+
+	bool passed = cl_run_suite(passing);
+	bool failed = !cl_run_suite(failing);
+
+	cl_free_suite(passing);
+	cl_free_suite(failing);
+
+	return !(passed && failed && !missed && detected == expected_detections);
+}
+
+
+int main() {
+	// The instruction set is detected once per process, each level gets its own.
+	const char *levels[] = { "scalar", "sse2", "avx2" };
+	int         status   = 0;
+
+	for (size_t i = 0; i < sizeof(levels) / sizeof(*levels); i++) {
+		pid_t child = fork();
+		if (child < 0)
+			return 1;
+		if (child == 0) {
+			int result = run_with_level(levels[i]);
+			fflush(stdout);
+			_exit(result);
+		}
+
+		int child_status;
+		if (waitpid(child, &child_status, 0) != child || !WIFEXITED(child_status) || WEXITSTATUS(child_status))
+			status = 1;
+	}
+	return status;
+}
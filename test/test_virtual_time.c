@@ -0,0 +1,154 @@
+#include <CLarity/clarity.h>
+#include <string.h>
+#include <time.h>
+
+#define SECOND_NS 1000000000ull
+
+static char trace[16];
+
+
+static void record(clarity_clock_t *clock, void *data) {
+	(void) clock;
+	strncat(trace, data, sizeof trace - strlen(trace) - 1);
+}
+
+
+/**
+ * The code under test: retries an operation failing a number of times, doubling the delay between attempts.
+ */
+static int retry_with_backoff(clarity_clock_t *clock, int failures) {
+	uint64_t delay_ns = SECOND_NS;
+	int      attempts = 1;
+	for (; attempts <= failures; attempts++) {
+		cl_sleep(clock, delay_ns);
+		delay_ns *= 2;
+	}
+	return attempts;
+}
+
+
+void backoff(clarity_test_t *t, void *data) {
+	(void) data;
+	clarity_clock_t *clock = cl_test_clock(t);
+
+	if (retry_with_backoff(clock, 10) != 11)
+		cl_fail_test(t, "the operation was not retried ten times");
+	if (cl_now(clock) != 1023 * SECOND_NS)
+		cl_fail_test(t, "the virtual clock did not move by the whole backoff");
+}
+
+
+void timers_in_order(clarity_test_t *t, void *data) {
+	(void) data;
+	clarity_clock_t *clock = cl_test_clock(t);
+	uint64_t        cancelled;
+
+	trace[0] = '\0';
+	cl_clock_add_timer(clock, 3 * SECOND_NS, record, "c", NULL);
+	cl_clock_add_timer(clock, SECOND_NS, record, "a", NULL);
+	cl_clock_add_timer(clock, 2 * SECOND_NS, record, "x", &cancelled);
+	cl_clock_add_timer(clock, SECOND_NS, record, "b", NULL);
+	cl_clock_add_timer(clock, 10 * SECOND_NS, record, "z", NULL);
+	cl_clock_cancel_timer(clock, cancelled);
+
+	cl_sleep(clock, 5 * SECOND_NS);
+	if (strcmp(trace, "abc") != 0)
+		cl_fail_test(t, "the timers did not fire in the order of their deadlines");
+	if (cl_now(clock) != 5 * SECOND_NS)
+		cl_fail_test(t, "the sleep did not end at its deadline");
+}
+
+
+void real_clock(clarity_test_t *t, void *data) {
+	(void) data;
+	clarity_clock_t *clock = cl_test_clock(t);
+	uint64_t        start  = cl_now(clock);
+
+	trace[0] = '\0';
+	cl_clock_add_timer(clock, 1000000, record, "r", NULL);
+	cl_sleep(clock, 2000000);
+	if (strcmp(trace, "r") != 0)
+		cl_fail_test(t, "the timer of the real clock did not fire during the sleep");
+	if (cl_now(clock) - start < 2000000)
+		cl_fail_test(t, "the real clock did not sleep");
+}
+
+
+void heartbeat(clarity_test_t *t, clarity_async_t *async, void *data) {
+	int *beats = data;
+
+	if (++*beats < 5) {
+		cl_async_set_timer(async, 60000, heartbeat, beats);
+		return;
+	}
+	if (cl_now(cl_test_clock(t)) != 4 * 60 * SECOND_NS)
+		cl_fail_test(t, "the heartbeats were not a minute apart in virtual time");
+	cl_async_done(async);
+}
+
+
+void start_heartbeat(clarity_test_t *t, clarity_async_t *async, void *data) {
+	*(int *) data = 0;
+	heartbeat(t, async, data);
+}
+
+
+static void finish_later(clarity_test_t *t, clarity_async_t *async, void *data) {
+	(void) t;
+	(void) data;
+	cl_async_done(async);
+}
+
+
+void start_finish_later(clarity_test_t *t, clarity_async_t *async, void *data) {
+	(void) t;
+	cl_async_set_timer(async, 1000, finish_later, data);
+}
+
+
+/**
+ * A generated test is freed as soon as it completes, which it does from a timer of its own clock.
+ */
+static clarity_test_t *generate_finish_later(size_t index, void *data) {
+	(void) index;
+	clarity_test_t *test = cl_create_async_test("finishes from a timer", start_finish_later, data, 1000);
+	cl_test_use_virtual_time(test, true);
+	return test;
+}
+
+
+int main() {
+	struct timespec start, end;
+	int             beats[2];
+
+	clarity_suite_t *suite = cl_create_suite("Virtual time");
+	clarity_suite_t *real  = cl_create_suite("Real time");
+	clarity_test_t  *tests[] = {
+		cl_create_test("retry with backoff", backoff, NULL),
+		cl_create_test("timers in order", timers_in_order, NULL),
+		cl_create_async_test("heartbeat every minute", start_heartbeat, &beats[0], 1000),
+	};
+	for (size_t i = 0; i < sizeof tests / sizeof *tests; i++) {
+		cl_test_use_virtual_time(tests[i], true);
+		cl_add_test(suite, tests[i]);
+	}
+	cl_add_test(suite, cl_create_test("real clock", real_clock, NULL));
+	cl_add_test(real, cl_create_async_test("heartbeat in real time", start_heartbeat, &beats[1], 100));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	bool passed = cl_run_suite(suite);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	// The same heartbeat times out long before its four minutes in real time.
+	bool timed_out = !cl_run_suite(real);
+
+	clarity_suite_t *generated = cl_create_suite("Generated virtual time");
+	cl_suite_set_generator(generated, 3, generate_finish_later, NULL);
+	bool released = cl_run_suite(generated);
+
+	cl_free_suite(suite);
+	cl_free_suite(real);
+	cl_free_suite(generated);
+
+	double elapsed_ms = (double) (end.tv_sec - start.tv_sec) * 1e3 + (double) (end.tv_nsec - start.tv_nsec) / 1e6;
+	return !(passed && timed_out && released && beats[0] == 5 && beats[1] == 1 && elapsed_ms < 1000);
+}
@@ -0,0 +1,5 @@
+#include <CLarity/cli.h>
+
+int main(int argc, char **argv) {
+	return cl_driver_main(argc, argv);
+}